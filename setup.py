@@ -10,11 +10,17 @@
 # the Cython wrappers of TrackStar's backend, which is implemented in C in
 # the directory ./trackstar/core/src. TrackStar also exhibits dynamic behavior
 # at compile time based on whether or not the user is enabling parallel
-# processing by linking with the OpenMP library. This behavior is implemented
-# here as well.
+# processing by linking with the OpenMP library, on whether or not the user is
+# linking with a BLAS and LAPACK library for linear algebra, on whether or not
+# the user is linking with an MPI library to spread samples across processes,
+# on whether or not the user is offloading the likelihood to an accelerator,
+# and on which instruction sets the compiler is able to build the vectorized
+# chi-squared kernels for. This behavior is implemented here as well.
 
 from setuptools import setup, Extension
 from subprocess import Popen, PIPE
+import tempfile
+import shlex
 import glob
 import sys
 import os
@@ -37,12 +43,14 @@ def get_extensions(path = "./trackstar"):
 	extensions : ``list``
 		The list of ``setuptools.Extension`` objects, each of which has the
 		appropriate include directories, library directories, extra compiler
-		and linker flags supplied from the openmp_linker routines.
+		and linker flags supplied from the openmp_linker, blas_linker,
+		mpi_linker, offload_linker, simd_compiler, and profile_compiler
+		routines.
 	"""
 	kwargs = {
 		"include_dirs": ["%s/core/src" % (path)],
 		"library_dirs": [],
-		"extra_compile_args": [],
+		"extra_compile_args": simd_compiler.compiler_flags(),
 		"extra_link_args": []
 	}
 	if openmp_linker.link_openmp():
@@ -59,6 +67,25 @@ def get_extensions(path = "./trackstar"):
 			kwargs["library_dirs"].append(libomp_library)
 		else: pass
 	else: pass
+	if blas_linker.link_blas():
+		compile_args, link_args = blas_linker.compiler_flags()
+		kwargs["extra_compile_args"].extend(compile_args)
+		kwargs["extra_link_args"].extend(link_args)
+	else: pass
+	if mpi_linker.link_mpi():
+		compile_args, link_args = mpi_linker.compiler_flags()
+		kwargs["extra_compile_args"].extend(compile_args)
+		kwargs["extra_link_args"].extend(link_args)
+	else: pass
+	if offload_linker.link_offload():
+		compile_args, link_args = offload_linker.compiler_flags()
+		kwargs["extra_compile_args"].extend(compile_args)
+		kwargs["extra_link_args"].extend(link_args)
+	else: pass
+	if profile_compiler.enable_profiling():
+		kwargs["extra_compile_args"].extend(
+			profile_compiler._PROFILE_COMPILE_FLAGS_)
+	else: pass
 	cython_sources = glob.glob("%s/core/*.pyx" % (path))
 	c_sources = glob.glob("%s/core/src/*.c" % (path))
 	extensions = []
@@ -175,7 +202,7 @@ Must be either gcc or clang.""" % (os.environ["CC"]))
 		allowed_compiler = False
 		for test in openmp_linker._SUPPORTED_COMPILERS_:
 			# use startswith as opposed to == to catch, e.g., "gcc-10"
-			allowed_compiler |= comipler.startswith(test)
+			allowed_compiler |= compiler.startswith(test)
 		if not allowed_compiler: return False
 		kwargs = {
 			"stdout": PIPE,
@@ -198,7 +225,7 @@ Must be either gcc or clang.""" % (os.environ["CC"]))
 		# Now check that ``compiler --version`` runs properly and has
 		# either "gcc" or "clang" along with a version number
 		with Popen("%s --version" % (compiler), **kwargs) as proc:
-			out, err = proc.commjunicate()
+			out, err = proc.communicate()
 			# should catch all typos that didn't already cause an error
 			if err != "" and "command not found" in err: return None
 			# should catch anything that isn't a command-line entry
@@ -208,7 +235,7 @@ Must be either gcc or clang.""" % (os.environ["CC"]))
 			has_version_number = False
 			for word in out.split():
 				for test in openmp_linker._SUPPORTED_COMPILERS_:
-					if word.starswith(test):
+					if word.startswith(test):
 						compiler = word
 						recognized = True
 					else: pass
@@ -325,4 +352,491 @@ https://github.com/giganano/TrackStar/issues."""
 				else:
 					raise RuntimeError(msg)
 
+
+class blas_linker:
+
+	r"""
+	A class implementing utility functions for linking TrackStar with a BLAS
+	and LAPACK library at compile time, which then handles the linear algebra
+	for matrices and data with many dimensions. The hand-written routines in
+	trackstar/core/src/matrix.c and kernels.c remain the fallback.
+	"""
+
+	# candidate libraries, in order of preference
+	_LIBRARIES_ = [
+		["-lopenblas"],
+		["-lmkl_rt"],
+		["-llapack", "-lblas"]
+	]
+	_BLAS_COMPILE_FLAGS_ = ["-DTRACKSTAR_BLAS"]
+
+	# every routine that trackstar/core/src/blas.h declares must be called
+	_BLAS_TEST_ = """\
+#include <cblas.h>
+extern void dgetrf_(const int *m, const int *n, double *a, const int *lda, \
+	int *ipiv, int *info);
+extern void dgetri_(const int *n, double *a, const int *lda, \
+	const int *ipiv, double *work, const int *lwork, int *info);
+extern void dpotrf_(const char *uplo, const int *n, double *a, \
+	const int *lda, int *info);
+extern void dpotri_(const char *uplo, const int *n, double *a, \
+	const int *lda, int *info);
+int main(void) {
+	double a = 4, b = 0, work = 0;
+	int n = 1, ipiv = 0, info = 0;
+	cblas_dgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, 1, 1, 1, 1, &a, 1, \
+		&a, 1, 0, &b, 1);
+	dgetrf_(&n, &n, &b, &n, &ipiv, &info);
+	dgetri_(&n, &b, &n, &ipiv, &work, &n, &info);
+	dpotrf_("U", &n, &a, &n, &info);
+	dpotri_("U", &n, &a, &n, &info);
+	return (b == 0.0625 && a == 0.25 && info == 0) ? 0 : 1;
+}
+"""
+
+	@staticmethod
+	def link_blas():
+		r"""
+		Determines if the currently running installation is to be linked with
+		a BLAS library or not based on the presence and value of the
+		environment variable "TRACKSTAR_ENABLE_BLAS". Returns the
+		corresponding boolean value.
+		"""
+		return ("TRACKSTAR_ENABLE_BLAS" in os.environ.keys() and
+			os.environ["TRACKSTAR_ENABLE_BLAS"].lower() == "true")
+
+
+	@staticmethod
+	def compiler_flags():
+		r"""
+		Determine the flags to pass to the C compiler for both compiling and
+		linking with the first of the candidate libraries that a test program
+		links against and runs correctly with. The directories in the
+		environment variables "BLAS_INCLUDE_DIR" and "BLAS_LIBRARY_DIR" are
+		searched first, if they exist. Returns them as lists of strings.
+
+		Raises
+		------
+		RuntimeError
+			None of the candidate libraries were found.
+		"""
+		compile_args = list(blas_linker._BLAS_COMPILE_FLAGS_)
+		link_args = []
+		if "BLAS_INCLUDE_DIR" in os.environ.keys():
+			compile_args.append("-I%s" % (os.environ["BLAS_INCLUDE_DIR"]))
+		else: pass
+		if "BLAS_LIBRARY_DIR" in os.environ.keys():
+			link_args.append("-L%s" % (os.environ["BLAS_LIBRARY_DIR"]))
+			link_args.append("-Wl,-rpath,%s" % (os.environ["BLAS_LIBRARY_DIR"]))
+		else: pass
+		for libraries in blas_linker._LIBRARIES_:
+			if blas_linker.check_library(compile_args[1:],
+				link_args + libraries):
+				return [compile_args, link_args + libraries]
+			else: pass
+		raise RuntimeError("""\
+TRACKSTAR_ENABLE_BLAS is "true", but none of OpenBLAS, MKL, or the reference \
+BLAS and LAPACK libraries could be found. Please install one of them (e.g., \
+OpenBLAS, which most package managers provide), or point the environment \
+variables BLAS_INCLUDE_DIR and BLAS_LIBRARY_DIR to the directories containing \
+cblas.h and the library before reattempting your TrackStar installation. To \
+install without a BLAS library, unset TRACKSTAR_ENABLE_BLAS.""")
+
+
+	@staticmethod
+	def check_library(compile_args, link_args):
+		r"""
+		Determine whether or not a test program calling each of the BLAS and
+		LAPACK routines that TrackStar uses compiles, links, and runs
+		correctly with the given flags.
+
+		Parameters
+		----------
+		compile_args : ``list``
+			The flags to pass to the C compiler for compiling.
+		link_args : ``list``
+			The flags to pass to the C compiler for linking.
+
+		Returns
+		-------
+		found : ``bool``
+			``True`` if the test program returns successfully and ``False``
+			otherwise.
+		"""
+		kwargs = {
+			"stdout": PIPE,
+			"stderr": PIPE,
+			"shell": True,
+			"text": True
+		}
+		with tempfile.TemporaryDirectory() as tmpdir:
+			source = os.path.join(tmpdir, "blas.c")
+			executable = os.path.join(tmpdir, "blas")
+			with open(source, "w") as f:
+				f.write(blas_linker._BLAS_TEST_)
+			with Popen("%s %s %s -o %s %s" % (openmp_linker.compiler(),
+				" ".join(compile_args), source, executable,
+				" ".join(link_args)), **kwargs) as proc:
+				proc.communicate()
+				if proc.returncode: return False
+			with Popen(executable, **kwargs) as proc:
+				proc.communicate()
+				return proc.returncode == 0
+
+
+class mpi_linker:
+
+	r"""
+	A class implementing utility functions for linking TrackStar with an MPI
+	library at compile time, which then computes the likelihood of samples
+	whose data are spread across the processes of an MPI job (see
+	trackstar/core/src/distributed.h). Without it, every process computes
+	the likelihood of its own data alone.
+	"""
+
+	_MPI_COMPILE_FLAGS_ = ["-DTRACKSTAR_MPI"]
+
+	# every routine that trackstar/core/src/distributed.c calls must link
+	_MPI_TEST_ = """\
+#include <mpi.h>
+int main(void) {
+	int flag = 0, provided = 0, rank = 0, size = 1;
+	double x = 1, y = 0;
+	MPI_Initialized(&flag);
+	MPI_Init_thread(NULL, NULL, MPI_THREAD_SERIALIZED, &provided);
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+	MPI_Comm_size(MPI_COMM_WORLD, &size);
+	MPI_Bcast(&x, 1, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+	MPI_Allreduce(&x, &y, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+	MPI_Finalized(&flag);
+	MPI_Finalize();
+	return 0;
+}
+"""
+
+	@staticmethod
+	def link_mpi():
+		r"""
+		Determines if the currently running installation is to be linked with
+		an MPI library or not based on the presence and value of the
+		environment variable "TRACKSTAR_ENABLE_MPI". Returns the corresponding
+		boolean value.
+		"""
+		return ("TRACKSTAR_ENABLE_MPI" in os.environ.keys() and
+			os.environ["TRACKSTAR_ENABLE_MPI"].lower() == "true")
+
+
+	@staticmethod
+	def compiler_flags():
+		r"""
+		Determine the flags to pass to the C compiler for both compiling and
+		linking with MPI from the compiler wrapper that the MPI library
+		provides, which is ``mpicc`` unless specified otherwise through the
+		environment variable "MPICC". Its ``-show`` flag, which Open MPI,
+		MPICH, and Intel MPI all support, prints the underlying compiler
+		command, whose include directories and macros are used for compiling
+		and whose remaining flags are used for linking. Returns them as lists
+		of strings.
+
+		Raises
+		------
+		RuntimeError
+			The compiler wrapper was not found, or a test program does not
+			compile and link with the flags it reports.
+		"""
+		wrapper = os.environ["MPICC"] if "MPICC" in os.environ.keys() else (
+			"mpicc")
+		kwargs = {
+			"stdout": PIPE,
+			"stderr": PIPE,
+			"shell": True,
+			"text": True
+		}
+		with Popen("%s -show" % (wrapper), **kwargs) as proc:
+			out, err = proc.communicate()
+			command = out.split() if not proc.returncode else []
+		compile_args = list(mpi_linker._MPI_COMPILE_FLAGS_)
+		link_args = []
+		# the first word is the underlying compiler itself
+		for flag in command[1:]:
+			if flag.startswith("-I") or flag.startswith("-D"):
+				compile_args.append(flag)
+			elif flag == "-pthread":
+				compile_args.append(flag)
+				link_args.append(flag)
+			elif flag != "-c":
+				link_args.append(flag)
+			else: pass
+		if command and mpi_linker.check_library(compile_args[1:], link_args):
+			return [compile_args, link_args]
+		else:
+			raise RuntimeError("""\
+TRACKSTAR_ENABLE_MPI is "true", but the MPI compiler wrapper %s either could \
+not be found or does not report the flags to compile and link with MPI. \
+Please install an MPI library (e.g., Open MPI or MPICH, which most package \
+managers provide), or point the environment variable MPICC to its compiler \
+wrapper before reattempting your TrackStar installation. To install without \
+MPI, unset TRACKSTAR_ENABLE_MPI.""" % (wrapper))
+
+
+	@staticmethod
+	def check_library(compile_args, link_args):
+		r"""
+		Determine whether or not a test program calling each of the MPI
+		routines that TrackStar uses compiles and links with the given flags.
+		It is not run, because a program that initializes MPI may need to be
+		launched by ``mpirun``.
+
+		Parameters
+		----------
+		compile_args : ``list``
+			The flags to pass to the C compiler for compiling.
+		link_args : ``list``
+			The flags to pass to the C compiler for linking.
+
+		Returns
+		-------
+		found : ``bool``
+			``True`` if the test program compiles and links successfully and
+			``False`` otherwise.
+		"""
+		kwargs = {
+			"stdout": PIPE,
+			"stderr": PIPE,
+			"shell": True,
+			"text": True
+		}
+		with tempfile.TemporaryDirectory() as tmpdir:
+			source = os.path.join(tmpdir, "mpi.c")
+			with open(source, "w") as f:
+				f.write(mpi_linker._MPI_TEST_)
+			with Popen("%s %s %s -o %s %s" % (openmp_linker.compiler(),
+				" ".join(compile_args), source, os.path.join(tmpdir, "mpi"),
+				" ".join(link_args)), **kwargs) as proc:
+				proc.communicate()
+				return proc.returncode == 0
+
+
+class offload_linker:
+
+	r"""
+	A class implementing utility functions for compiling TrackStar with
+	OpenMP's target offloading, which then computes the likelihood of a
+	sample on an accelerator (see trackstar/core/src/device.h). NVIDIA GPUs
+	are targeted through the compiler's nvptx backend and AMD GPUs through
+	its amdgcn backend. This requires OpenMP to be enabled as well, and a
+	compiler built with support for the target (e.g., gcc with the
+	gcc-offload-nvptx package installed).
+	"""
+
+	_OFFLOAD_COMPILE_FLAGS_ = ["-DTRACKSTAR_OFFLOAD"]
+	_GCC_OFFLOAD_TARGETS_ = {
+		"nvptx": "nvptx-none",
+		"amdgcn": "amdgcn-amdhsa"
+	}
+	_CLANG_OFFLOAD_TARGETS_ = {
+		"nvptx": "nvptx64-nvidia-cuda",
+		"amdgcn": "amdgcn-amd-amdhsa"
+	}
+
+	# a target region calling the math library, as the device kernels do
+	_OFFLOAD_TEST_ = """\
+#include <math.h>
+int main(void) {
+	double x = 0;
+	#pragma omp target teams distribute parallel for map(tofrom: x) \\
+		reduction(+: x)
+	for (int i = 0; i < 100; i++) x += exp(-0.5 * i) * erfc(0.01 * i);
+	return !(x > 0);
+}
+"""
+
+	@staticmethod
+	def link_offload():
+		r"""
+		Determines if the currently running installation is to be compiled
+		with target offloading or not based on the presence and value of the
+		environment variable "TRACKSTAR_ENABLE_OFFLOAD". Returns the
+		corresponding boolean value.
+		"""
+		return ("TRACKSTAR_ENABLE_OFFLOAD" in os.environ.keys() and
+			os.environ["TRACKSTAR_ENABLE_OFFLOAD"].lower() == "true")
+
+
+	@staticmethod
+	def compiler_flags():
+		r"""
+		Determine the flags to pass to the C compiler for both compiling and
+		linking with target offloading. The target is taken from the
+		environment variable "TRACKSTAR_OFFLOAD_TARGET", which must be either
+		"nvptx" (the default) or "amdgcn", and the architecture of the device
+		(e.g., "sm_80" or "gfx90a") optionally from the environment variable
+		"TRACKSTAR_OFFLOAD_ARCH". Returns them as lists of strings.
+
+		Raises
+		------
+		RuntimeError
+			OpenMP is not enabled, the target is not recognized, or a test
+			program does not compile and link with the flags.
+		"""
+		if not openmp_linker.link_openmp(): raise RuntimeError("""\
+TRACKSTAR_ENABLE_OFFLOAD is "true", but offloading requires OpenMP. Please \
+set TRACKSTAR_ENABLE_OPENMP to "true" as well.""")
+		target = os.environ["TRACKSTAR_OFFLOAD_TARGET"].lower() if (
+			"TRACKSTAR_OFFLOAD_TARGET" in os.environ.keys()) else "nvptx"
+		if target not in offload_linker._GCC_OFFLOAD_TARGETS_.keys():
+			raise RuntimeError("""\
+Unrecognized offload target from environment variable \"TRACKSTAR_OFFLOAD_\
+TARGET\": %s. Must be either nvptx or amdgcn.""" % (target))
+		else: pass
+		arch = os.environ["TRACKSTAR_OFFLOAD_ARCH"] if (
+			"TRACKSTAR_OFFLOAD_ARCH" in os.environ.keys()) else None
+		compiler = openmp_linker.compiler()
+		if compiler.startswith("clang"):
+			triple = offload_linker._CLANG_OFFLOAD_TARGETS_[target]
+			flags = ["-fopenmp-targets=%s" % (triple)]
+			if arch is not None: flags.extend([
+				"-Xopenmp-target=%s" % (triple), "-march=%s" % (arch)])
+		else:
+			triple = offload_linker._GCC_OFFLOAD_TARGETS_[target]
+			flags = ["-foffload=%s" % (triple)]
+			options = "-lm" if arch is None else "-lm -march=%s" % (arch)
+			flags.append("-foffload-options=%s=%s" % (triple, options))
+		compile_args = offload_linker._OFFLOAD_COMPILE_FLAGS_ + flags
+		link_args = list(flags)
+		openmp_compile, openmp_link = openmp_linker.compiler_flags()
+		if offload_linker.check_compiler(openmp_compile + flags,
+			openmp_link + flags):
+			return [compile_args, link_args]
+		else:
+			raise RuntimeError("""\
+TRACKSTAR_ENABLE_OFFLOAD is "true", but %s could not compile a target region \
+for %s. Please install a compiler with support for offloading to it (e.g., \
+the gcc-offload-nvptx or gcc-offload-amdgcn package for gcc), or set \
+TRACKSTAR_OFFLOAD_TARGET to the other target, before reattempting your \
+TrackStar installation. To install without offloading, unset \
+TRACKSTAR_ENABLE_OFFLOAD.""" % (compiler, triple))
+
+
+	@staticmethod
+	def check_compiler(compile_args, link_args):
+		r"""
+		Determine whether or not a test program with a target region compiles
+		and links with the given flags. It is not run, because the machine
+		compiling TrackStar need not have the accelerator itself.
+
+		Parameters
+		----------
+		compile_args : ``list``
+			The flags to pass to the C compiler for compiling.
+		link_args : ``list``
+			The flags to pass to the C compiler for linking.
+
+		Returns
+		-------
+		supported : ``bool``
+			``True`` if the test program compiles and links successfully and
+			``False`` otherwise.
+		"""
+		kwargs = {
+			"stdout": PIPE,
+			"stderr": PIPE,
+			"shell": True,
+			"text": True
+		}
+		with tempfile.TemporaryDirectory() as tmpdir:
+			source = os.path.join(tmpdir, "offload.c")
+			with open(source, "w") as f:
+				f.write(offload_linker._OFFLOAD_TEST_)
+			# the options for the device compiler may contain spaces
+			with Popen("%s %s %s -o %s %s -lm" % (openmp_linker.compiler(),
+				" ".join(map(shlex.quote, compile_args)), source,
+				os.path.join(tmpdir, "offload"),
+				" ".join(map(shlex.quote, link_args))), **kwargs) as proc:
+				proc.communicate()
+				return proc.returncode == 0
+
+
+class profile_compiler:
+
+	r"""
+	A class implementing utility functions for compiling TrackStar's
+	profiling instrumentation (see trackstar/core/src/profiling.h), which
+	records timers and event counts within the likelihood calculation for
+	``trackstar.profile``. It is compiled out entirely unless requested.
+	"""
+
+	_PROFILE_COMPILE_FLAGS_ = ["-DTRACKSTAR_PROFILE"]
+
+	@staticmethod
+	def enable_profiling():
+		r"""
+		Determines if the currently running installation is to be compiled
+		with the profiling instrumentation or not based on the presence and
+		value of the environment variable "TRACKSTAR_ENABLE_PROFILE". Returns
+		the corresponding boolean value.
+		"""
+		return ("TRACKSTAR_ENABLE_PROFILE" in os.environ.keys() and
+			os.environ["TRACKSTAR_ENABLE_PROFILE"].lower() == "true")
+
+
+class simd_compiler:
+
+	r"""
+	A class implementing utility functions for compiling TrackStar's
+	vectorized chi-squared kernels (see trackstar/core/src/kernels.c).
+	"""
+
+	_OPENMP_SIMD_FLAGS_ = ["-fopenmp-simd", "-DTRACKSTAR_OPENMP_SIMD"]
+	_TARGET_CLONES_FLAGS_ = ["-DTRACKSTAR_TARGET_CLONES"]
+
+	# must match the TARGET_CLONES macro in trackstar/core/src/kernels.h
+	_TARGET_CLONES_TEST_ = """\
+__attribute__((target_clones("arch=skylake-avx512", "arch=haswell", \\
+	"default")))
+double twice(double x) { return 2 * x; }
+int main(void) { return twice(1) == 2 ? 0 : 1; }
+"""
+
+	@staticmethod
+	def compiler_flags():
+		r"""
+		Determine the flags to pass to the C compiler for vectorizing the
+		chi-squared kernels. The OpenMP SIMD directives require neither the
+		OpenMP library nor multithreading, so they are always enabled.
+		Returns them as a list of strings.
+		"""
+		compile_args = list(simd_compiler._OPENMP_SIMD_FLAGS_)
+		if simd_compiler.target_clones():
+			compile_args.extend(simd_compiler._TARGET_CLONES_FLAGS_)
+		else: pass
+		return compile_args
+
+
+	@staticmethod
+	def target_clones():
+		r"""
+		Determine whether or not the compiler is able to build copies of a
+		function for several instruction sets, of which the fastest one that
+		the CPU supports is selected when TrackStar is imported. This requires
+		gcc or a recent version of clang on x86-64 Linux. On ARM, NEON
+		instructions are always available, so nothing is lost when this is not
+		supported. Returns the corresponding boolean value.
+		"""
+		kwargs = {
+			"stdout": PIPE,
+			"stderr": PIPE,
+			"shell": True,
+			"text": True
+		}
+		with tempfile.TemporaryDirectory() as tmpdir:
+			source = os.path.join(tmpdir, "target_clones.c")
+			with open(source, "w") as f:
+				f.write(simd_compiler._TARGET_CLONES_TEST_)
+			with Popen("%s -Werror %s -o %s" % (openmp_linker.compiler(),
+				source, os.path.join(tmpdir, "target_clones")),
+				**kwargs) as proc:
+				proc.communicate()
+				return proc.returncode == 0
+
 if __name__ == "__main__": setup(ext_modules = get_extensions())
@@ -4,10 +4,15 @@
 # at: https://github.com/giganano/TrackStar.git.
 
 __all__ = ["matrix", "covariance_matrix", "datum", "track", "sample",
-	"openmp_linked"]
+	"openmp_linked", "blas_linked", "offload_linked", "profile",
+	"distributed"]
 from .matrix import matrix
 from .covariance_matrix import covariance_matrix
 from .datum import datum
 from .track import track
 from .sample import sample
 from .multithread import openmp_linked
+from .blas import blas_linked
+from .device import offload_linked
+from .profiling import profile
+from . import distributed
@@ -0,0 +1,20 @@
+# cython: language_level = 3, boundscheck = False
+#
+# This file is part of the TrackStar package.
+# Copyright (C) 2023 James W. Johnson (giganano9@gmail.com)
+# License: MIT License. See LICENSE in top-level directory
+# at: https://github.com/giganano/TrackStar.git.
+
+__all__ = ["blas_linked"]
+from . cimport blas
+
+def blas_linked():
+	r"""
+	Returns ``True`` if TrackStar was linked with a BLAS and LAPACK library,
+	which then handles the linear algebra for data with many dimensions, and
+	``False`` otherwise.
+
+	If you would like to make use of such a library, follow the instructions
+	for linking with BLAS under TrackStar's :doc:`install guide <../install>`.
+	"""
+	return bool(blas_enabled())
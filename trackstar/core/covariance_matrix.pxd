@@ -14,8 +14,12 @@ cdef extern from "./src/matrix.h":
 		unsigned short n_cols
 		MATRIX *inv
 		char **labels
+		double logdet
 
 	void covariance_matrix_free(COVARIANCE_MATRIX *cov)
+	unsigned short covariance_matrix_update(COVARIANCE_MATRIX *cov)
 
 cdef class covariance_matrix(matrix):
 	cdef COVARIANCE_MATRIX *_cov
+	@staticmethod
+	cdef covariance_matrix _borrow_(COVARIANCE_MATRIX *cov, object owner)
@@ -8,12 +8,16 @@
 __all__ = ["covariance_matrix"]
 import textwrap
 import numbers
-from .utils import copy_cstring
-from .utils cimport copy_pystring, strindex
+from .utils import copy_cstring, _UNINITIALIZED_
+from .utils cimport copy_pystring, strindex, flag_modification
 from libc.stdlib cimport realloc, free
 from libc.string cimport strlen
 from . cimport covariance_matrix
 from .matrix cimport matrix_initialize
+from .profiling cimport profile_share, shared_profile_counters
+
+# every module records to the counters reported by trackstar.profile
+profile_share(shared_profile_counters())
 
 cdef class covariance_matrix(matrix):
 
@@ -38,6 +42,7 @@ cdef class covariance_matrix(matrix):
 	"""
 
 	def __cinit__(self, arr):
+		if arr is _UNINITIALIZED_: return
 		self._cov = <COVARIANCE_MATRIX *> realloc (self._m,
 			sizeof(COVARIANCE_MATRIX))
 
@@ -52,11 +57,25 @@ cdef class covariance_matrix(matrix):
 
 	def __init__(self, arr):
 		super().__init__(arr)
-		matrix_invert(self._m[0], self._cov[0].inv)
+		covariance_matrix_update(self._cov)
 
 
 	def __dealloc__(self):
-		covariance_matrix_free(self._cov)
+		if not self._borrowed: covariance_matrix_free(self._cov)
+
+
+	@staticmethod
+	cdef covariance_matrix _borrow_(COVARIANCE_MATRIX *cov, object owner):
+		# Wrap a covariance matrix that belongs to a C-owned datum without
+		# copying it. The wrapper keeps ``owner`` alive, and it never frees
+		# ``cov`` itself.
+		cdef covariance_matrix result = covariance_matrix.__new__(
+			covariance_matrix, _UNINITIALIZED_)
+		result._borrowed = True
+		result._owner = owner
+		result._cov = cov
+		result._m = <MATRIX *> cov
+		return result
 
 
 	def __repr__(self):
@@ -106,7 +125,8 @@ Diagonal elements of covariance matrix must be positive.""")
 		else:
 			raise TypeError("""\
 Item assignment requires a real number. Got: %s""" % (type(value)))
-		matrix_invert(self._m[0], self._cov[0].inv)
+		covariance_matrix_update(self._cov)
+		flag_modification()
 
 
 	def _indices_from_labels_(self, keys):
@@ -160,6 +180,19 @@ Covariance matrix indices must be either a string or an integer. Got: %s""" % (
 		return inv
 
 
+	@property
+	def logdet(self):
+		r"""
+		Type : ``float``
+
+		The natural logarithm of the determinant of this covariance matrix,
+		:math:`\ln|C|`. Like the inverse, this value is computed once whenever
+		the matrix is modified and cached for use in likelihood calculations.
+		``nan`` if the determinant is not positive.
+		"""
+		return self._cov[0].logdet
+
+
 	def keys(self):
 		r"""
 		Get the dictionary labels, if applicable.
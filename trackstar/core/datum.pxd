@@ -16,8 +16,11 @@ cdef extern from "./src/datum.h":
 		unsigned short n_cols
 		COVARIANCE_MATRIX *cov
 		char **labels
+		unsigned short *ids
+		unsigned long mask
 
 	DATUM *datum_initialize(unsigned short dim)
+	void datum_set_label(DATUM *d, unsigned short index, const char *label)
 	void datum_free(DATUM *d)
 	void datum_free_everything(DATUM *d)
 	double datum_get_item(DATUM d, char *label)
@@ -26,7 +29,17 @@ cdef extern from "./src/datum.h":
 
 
 cdef extern from "./src/likelihood.h":
-	double loglikelihood_datum(DATUM d, TRACK *t)
+	ctypedef struct LIKELIHOOD_CONTEXT:
+		unsigned short n_threads
+		unsigned short parallel_policy
+		unsigned short normalize_weights
+		unsigned short use_line_segment_corrections
+		unsigned short precision
+
+	LIKELIHOOD_CONTEXT *likelihood_context_initialize(const TRACK *t)
+	void likelihood_context_free(LIKELIHOOD_CONTEXT *c)
+	double loglikelihood_datum(DATUM d, const TRACK *t)
+	double loglikelihood_context_datum(LIKELIHOOD_CONTEXT *c, DATUM d) nogil
 
 
 cdef class datum:
@@ -35,3 +48,7 @@ cdef class datum:
 	cdef covariance_matrix _cov
 	cdef object _extra
 	cdef set _shadow_keys
+	cdef bint _borrowed
+	cdef object _owner
+	@staticmethod
+	cdef datum _borrow_(DATUM *d, object owner)
@@ -7,14 +7,23 @@
 
 __all__ = ["datum"]
 import numbers
-from .utils import copy_array_like_object, copy_cstring
-from .utils cimport copy_pystring, strindex
+from .utils import copy_array_like_object, copy_cstring, _UNINITIALIZED_
+from .utils cimport copy_pystring, strindex, flag_modification
+from .utils cimport label_registry_share, shared_label_registry
+from .profiling cimport profile_share, shared_profile_counters
 from libc.stdlib cimport malloc, free
-from libc.string cimport strlen, strcpy
+from libc.string cimport strlen
 from .matrix cimport matrix
+from .covariance_matrix cimport covariance_matrix_update
 from .track cimport track
 from . cimport datum
 
+# label IDs are only comparable if they come from the same registry
+label_registry_share(shared_label_registry())
+
+# every module records to the counters reported by trackstar.profile
+profile_share(shared_profile_counters())
+
 
 cdef class datum:
 
@@ -30,6 +39,7 @@ cdef class datum:
 	"""
 
 	def __cinit__(self, vector, extra = {}):
+		if vector is _UNINITIALIZED_: return
 		if not isinstance(vector, dict):
 			raise TypeError("""\
 Datum initialization requires type dict. Got: %s""" % (type(vector)))
@@ -73,7 +83,7 @@ input vector has no such label.""" % (label))
 		for i in range(len(qtys)):
 			copy = copy_pystring(qtys[i])
 			try:
-				strcpy(self._d[0].labels[i], copy)
+				datum_set_label(self._d, i, copy)
 			finally:
 				free(copy)
 			self._d[0].vector[0][i] = vector[qtys[i]]
@@ -82,6 +92,9 @@ input vector has no such label.""" % (label))
 			elif "err_%s" % (qtys[i]) in keys:
 				self._d[0].cov[0].matrix[i][i] = vector["err_%s" % (qtys[i])]**2
 			else: pass
+		# the diagonal was assigned directly, so the cached inverse and
+		# log-determinant need to be refreshed here.
+		covariance_matrix_update(self._d[0].cov)
 		self.extra = extra
 		self._shadow_keys = set([])
 
@@ -91,7 +104,24 @@ input vector has no such label.""" % (label))
 		Free up the memory stored by a ``datum`` object. User access strongly
 		discouraged.
 		"""
-		datum_free(self._d)
+		# a borrowed datum belongs to the sample that constructed it
+		if not self._borrowed: datum_free(self._d)
+
+
+	@staticmethod
+	cdef datum _borrow_(DATUM *d, object owner):
+		# Wrap a datum owned by the C library (see sample.from_arrays) without
+		# copying it. The wrapper keeps ``owner`` alive, and it never frees
+		# ``d`` itself.
+		cdef datum result = datum.__new__(datum, _UNINITIALIZED_)
+		result._borrowed = True
+		result._owner = owner
+		result._d = d
+		result._m = <MATRIX *> d
+		result._cov = covariance_matrix._borrow_(d[0].cov, owner)
+		result.extra = {}
+		result._shadow_keys = set([])
+		return result
 
 
 	def __enter__(self):
@@ -151,6 +181,7 @@ input vector has no such label.""" % (label))
 					free(copy)
 				if idx != -1:
 					self._d[0].vector[0][idx] = <double> value
+					flag_modification()
 				else:
 					raise KeyError("""\
 Unrecognized datum label: %s. If additional vector components are to be added, \
@@ -307,26 +338,30 @@ Attribte 'extra' must be of type dict. Got: %s""" % (value))
 		normalize_weights = True, use_line_segment_corrections = False):
 		cdef DATUM *sub
 		cdef char **labels
-		if isinstance(normalize_weights, bool):
-			t._t[0].normalize_weights = int(normalize_weights)
-		else:
+		cdef LIKELIHOOD_CONTEXT *context
+		cdef double result
+		if not isinstance(normalize_weights, bool):
 			raise TypeError("""\
 Keyword arg 'normalize_weights' must be of type bool. Got: %s""" % (
 				type(normalize_weights)))
+		else: pass
 		if isinstance(use_line_segment_corrections, bool):
-			t._t[0].use_line_segment_corrections = int(
-				use_line_segment_corrections)
+			# True -> closed form, False -> none (see ./src/likelihood.h)
+			corrections = int(use_line_segment_corrections)
+		elif use_line_segment_corrections == "quad":
+			# numerical quadrature, to validate the closed form
+			corrections = 2
 		else:
 			raise TypeError("""\
-Keyword arg 'use_line_segment_corrections' must be of type bool. Got: %s""" % (
-				type(use_line_segment_corrections)))
+Keyword arg 'use_line_segment_corrections' must be of type bool or the \
+string "quad". Got: %s""" % (type(use_line_segment_corrections)))
 		self_keys = self.keys()
 		track_keys = t.keys()
 		if quantities is None:
 			for key in self_keys:
 				if key not in track_keys: raise ValueError("""\
 Track does not have predictions for quantity labeled %s.""" % (key))
-			return loglikelihood_datum(self._d[0], t._t)
+			sub = self._d
 		elif isinstance(quantities, list) or isinstance(quantities, tuple):
 			for qty in quantities:
 				if not isinstance(qty, str): raise TypeError("""\
@@ -340,17 +375,25 @@ Track does not have predictions for quantity labeled %s.""" % (qty))
 			for i in range(len(quantities)):
 				labels[i] = copy_pystring(quantities[i])
 			sub = datum_specific_quantities(self._d[0], labels, len(quantities))
-			try:
-				return loglikelihood_datum(sub[0], t._t)
-			finally:
-				datum_free_everything(sub)
-				for i in range(len(quantities)): free(labels[i])
-				free(labels)
+			for i in range(len(quantities)): free(labels[i])
+			free(labels)
 		else:
 			raise TypeError("""\
 Keyword arg 'quantities' must be of type list, tuple, or None. Got: %s""" % (
 				type(quantities)))
 
+		# see comment in sample.loglikelihood
+		context = likelihood_context_initialize(t._t)
+		context[0].normalize_weights = int(normalize_weights)
+		context[0].use_line_segment_corrections = corrections
+		try:
+			with nogil:
+				result = loglikelihood_context_datum(context, sub[0])
+			return result
+		finally:
+			likelihood_context_free(context)
+			if sub != self._d: datum_free_everything(sub)
+
 
 	def keys(self):
 		r"""
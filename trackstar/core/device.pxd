@@ -0,0 +1,10 @@
+# cython: language_level = 3, boundscheck = False
+#
+# This file is part of the TrackStar package.
+# Copyright (C) 2023 James W. Johnson (giganano9@gmail.com)
+# License: MIT License. See LICENSE in top-level directory
+# at: https://github.com/giganano/TrackStar.git.
+
+cdef extern from "./src/device.h":
+	unsigned short offload_enabled()
+	unsigned short device_available()
@@ -0,0 +1,23 @@
+# cython: language_level = 3, boundscheck = False
+#
+# This file is part of the TrackStar package.
+# Copyright (C) 2023 James W. Johnson (giganano9@gmail.com)
+# License: MIT License. See LICENSE in top-level directory
+# at: https://github.com/giganano/TrackStar.git.
+
+__all__ = ["offload_linked"]
+from . cimport device
+
+def offload_linked():
+	r"""
+	Returns ``True`` if TrackStar was compiled with OpenMP's target
+	offloading, which lets ``trackstar.sample.loglikelihood`` compute the
+	likelihood on an accelerator (e.g., a GPU) with ``backend = "device"``,
+	and ``False`` otherwise. The likelihood is computed on an accelerator
+	only if the OpenMP runtime also finds one at run time.
+
+	If you would like to make use of these features, follow the instructions
+	for enabling offloading under TrackStar's :doc:`install guide
+	<../install>`.
+	"""
+	return bool(offload_enabled())
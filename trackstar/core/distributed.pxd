@@ -0,0 +1,29 @@
+# cython: language_level = 3, boundscheck = False
+#
+# This file is part of the TrackStar package.
+# Copyright (C) 2023 James W. Johnson (giganano9@gmail.com)
+# License: MIT License. See LICENSE in top-level directory
+# at: https://github.com/giganano/TrackStar.git.
+
+from .datum cimport LIKELIHOOD_CONTEXT
+from .track cimport TRACK
+from .sample cimport PACKED_SAMPLE
+from .sample cimport sample as local_sample
+
+cdef extern from "./src/distributed.h":
+	unsigned short DISTRIBUTED_SUCCESS
+	unsigned short DISTRIBUTED_TRACK_MISMATCH
+	unsigned short mpi_enabled()
+	unsigned short distributed_initialize()
+	void distributed_finalize()
+	unsigned int distributed_rank()
+	unsigned int distributed_size()
+	unsigned short distributed_any(const unsigned short flag)
+	unsigned short distributed_broadcast_track(TRACK *t,
+		const unsigned int root)
+	double loglikelihood_distributed(LIKELIHOOD_CONTEXT *c,
+		const PACKED_SAMPLE *shard, const unsigned int root)
+
+
+cdef class sample:
+	cdef local_sample _local
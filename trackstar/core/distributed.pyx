@@ -0,0 +1,238 @@
+# cython: language_level = 3, boundscheck = False
+#
+# This file is part of the TrackStar package.
+# Copyright (C) 2023 James W. Johnson (giganano9@gmail.com)
+# License: MIT License. See LICENSE in top-level directory
+# at: https://github.com/giganano/TrackStar.git.
+
+__all__ = ["sample", "mpi_linked", "rank", "size", "shard"]
+import atexit
+import numbers
+from .sample import _line_segment_corrections_
+from .datum cimport likelihood_context_initialize, likelihood_context_free
+from .sample cimport SAMPLE, sample_pack, sample_free_everything
+from .track cimport track
+from . cimport distributed
+
+# MPI is initialized the first time it is needed, unless some other package
+# (e.g. mpi4py) has done so already, in which case that package finalizes it.
+_initialized = False
+
+def _initialize_():
+	global _initialized
+	if not _initialized:
+		if distributed_initialize(): atexit.register(_finalize_)
+		_initialized = True
+	else: pass
+
+
+def _finalize_():
+	distributed_finalize()
+
+
+def mpi_linked():
+	r"""
+	Returns ``True`` if TrackStar was linked with an MPI library, in which
+	case the likelihood of a ``trackstar.distributed.sample`` is computed
+	across every process of an MPI job, and ``False`` otherwise.
+
+	If you would like to make use of these features, follow the instructions
+	for enabling MPI under TrackStar's :doc:`install guide <../install>`.
+	"""
+	return bool(mpi_enabled())
+
+
+def rank():
+	r"""
+	Returns the rank of the calling process within the MPI job, from 0 up to
+	but not including ``trackstar.distributed.size()``. Always 0 if
+	TrackStar was not linked with an MPI library.
+	"""
+	_initialize_()
+	return distributed_rank()
+
+
+def size():
+	r"""
+	Returns the number of processes in the MPI job. Always 1 if TrackStar was
+	not linked with an MPI library.
+	"""
+	_initialize_()
+	return distributed_size()
+
+
+def shard(n):
+	r"""
+	Determine which of the data in a sample the calling process should hold.
+
+	Parameters
+	----------
+	n : ``int``
+		The number of data in the whole sample.
+
+	Returns
+	-------
+	start, stop : ``tuple``
+		The indices of the first datum and one past the last datum of the
+		calling process's shard. The shards of consecutive ranks are
+		consecutive, and their sizes differ by at most one.
+	"""
+	if not isinstance(n, numbers.Number) or n % 1 != 0 or n < 0:
+		raise TypeError("""\
+Number of data must be a non-negative integer. Got: %s""" % (n))
+	else: pass
+	n = int(n)
+	return (rank() * n // size(), (rank() + 1) * n // size())
+
+
+cdef class sample:
+
+	r"""
+	.. class:: trackstar.distributed.sample(local)
+
+	A sample whose data are split into shards across the processes of an MPI
+	job, each process holding one of them.
+
+	Parameters
+	----------
+	local : ``trackstar.sample`` or ``dict``
+		The shard of the calling process, or the dictionary to construct it
+		from (see ``trackstar.sample``). Shards may be of any size, including
+		empty.
+
+	The shard is not copied; modifying ``local`` modifies the shard as well.
+	To split a sample that every process has in full, use
+	``trackstar.distributed.sample.from_sample``. Loading only the data of
+	the calling process instead (e.g., with ``trackstar.sample.load`` from
+	one file per shard) keeps the memory of each process proportional to the
+	size of its shard.
+
+	Every method of this class that computes a likelihood must be called by
+	every process at once, with the same arguments except for the track,
+	which need only have the same number of points and the same labels in
+	the same order.
+	"""
+
+	def __init__(self, local):
+		if isinstance(local, local_sample):
+			self._local = local
+		elif isinstance(local, dict):
+			self._local = local_sample(local)
+		else:
+			raise TypeError("""\
+Distributed sample initialization requires a trackstar.sample or a dict. \
+Got: %s""" % (type(local)))
+
+
+	@staticmethod
+	def from_sample(local_sample s):
+		r"""
+		Split a sample that every process has in full into shards, keeping
+		only that of the calling process (see ``trackstar.distributed.shard``).
+
+		Parameters
+		----------
+		s : ``trackstar.sample``
+			The whole sample, identical on every process.
+
+		Returns
+		-------
+		dist : ``trackstar.distributed.sample``
+			The distributed sample, whose shard shares the memory of ``s``.
+		"""
+		start, stop = shard(len(s))
+		return sample(s[start:stop])
+
+
+	def __repr__(self):
+		r"""Returns a string representation of the distributed sample."""
+		return "distributed.sample(rank = %d of %d, N = %d)" % (rank(),
+			size(), len(self._local))
+
+
+	@property
+	def local(self):
+		r"""
+		Type : ``trackstar.sample``
+
+		The shard of the sample held by the calling process.
+		"""
+		return self._local
+
+
+	def loglikelihood(self, track t, quantities = None,
+		normalize_weights = True, use_line_segment_corrections = False,
+		root = 0):
+		r"""
+		Compute natural logarithm of the likelihood that the whole sample
+		would be observed by the model predicted track ``t``, on every
+		process.
+
+		The predictions and weights of the track of the process with rank
+		``root``, along with its ``pruning_threshold``, ``normalize_weights``,
+		and ``use_line_segment_corrections``, are broadcast to every other
+		process, whose tracks are overwritten. Each process then computes the
+		likelihood of its shard as ``trackstar.sample.loglikelihood`` would,
+		with ``t.n_threads`` threads of its own, after which the results are
+		summed across the processes. ``quantities`` is interpreted as in
+		``trackstar.sample.loglikelihood`` for each shard, each of which must
+		have measurements of every quantity listed unless it is empty.
+
+		If any process raises an error before the likelihood is computed,
+		every other process raises a ``RuntimeError``, rather than waiting for
+		it indefinitely.
+
+		.. note::
+
+			The GIL is held throughout, so MPI is never called from more than
+			one python thread at a time.
+		"""
+		cdef SAMPLE *sub = NULL
+		cdef LIKELIHOOD_CONTEXT *context
+		_initialize_()
+		error = None
+		try:
+			if not isinstance(root, numbers.Number) or root % 1 != 0:
+				raise TypeError("""\
+Keyword arg 'root' must be an integer. Got: %s""" % (type(root)))
+			elif not 0 <= root < size():
+				raise ValueError("""\
+Keyword arg 'root' must be a rank between 0 and %d. Got: %d""" % (
+					size() - 1, root))
+			else: pass
+			root = int(root)
+			corrections = _line_segment_corrections_(normalize_weights,
+				use_line_segment_corrections)
+			# an empty shard has no measurements to restrict
+			sub = self._local._restrict_(quantities if len(self._local) else (
+				None), [t])
+		except (TypeError, ValueError) as exc:
+			error = exc
+
+		# every process must agree to proceed before any collective operation
+		if distributed_any(error is not None):
+			if error is None:
+				if sub != self._local._s: sample_free_everything(sub)
+				raise RuntimeError("""\
+Likelihood calculation failed on another process.""")
+			else:
+				raise error
+		else: pass
+		try:
+			if distributed_broadcast_track(t._t, root):
+				raise ValueError("""\
+The track of some process has a different number of points or different \
+labels than that of the root process (rank %d).""" % (root))
+			elif distributed_rank() != root:
+				t._revision += 1
+			else: pass
+			context = likelihood_context_initialize(t._t)
+			context[0].normalize_weights = int(normalize_weights)
+			context[0].use_line_segment_corrections = corrections
+			try:
+				return loglikelihood_distributed(context, sample_pack(sub),
+					root)
+			finally:
+				likelihood_context_free(context)
+		finally:
+			if sub != self._local._s: sample_free_everything(sub)
@@ -13,6 +13,7 @@ cdef extern from "./src/matrix.h":
 
 	MATRIX *matrix_initialize(unsigned short n_rows, unsigned short n_cols)
 	void matrix_free(MATRIX *m)
+	double *matrix_elements(const MATRIX m)
 	MATRIX *matrix_add(MATRIX m1, MATRIX m2, MATRIX *result)
 	MATRIX *matrix_subtract(MATRIX m1, MATRIX m2, MATRIX *result)
 	MATRIX *matrix_multiply(MATRIX m1, MATRIX m2, MATRIX *result)
@@ -22,4 +23,6 @@ cdef extern from "./src/matrix.h":
 
 cdef class matrix:
 	cdef MATRIX *_m
+	cdef bint _borrowed
+	cdef object _owner
 
@@ -7,8 +7,12 @@
 
 __all__ = ["matrix"]
 import numbers
-from .utils import copy_array_like_object, linked_list
+from .utils import copy_array_like_object, linked_list, _UNINITIALIZED_
 from . cimport matrix
+from .profiling cimport profile_share, shared_profile_counters
+
+# every module records to the counters reported by trackstar.profile
+profile_share(shared_profile_counters())
 
 cdef class matrix:
 
@@ -278,6 +282,7 @@ cdef class matrix:
 		Allocate memory for a matrix. User access of this function strongly
 		discouraged.
 		"""
+		if arr is _UNINITIALIZED_: return
 		msg = """\
 Matrix or vector must be a 1-dimensional or rectangular 2-dimensional \
 array-like object containing only numerical values."""
@@ -333,7 +338,8 @@ Matrix or vector must contain only numerical values.""")
 		Free up the memory stored by a ``matrix`` object. User access strongly
 		discouraged.
 		"""
-		matrix_free(self._m)
+		# a borrowed matrix belongs to whichever object its owner wraps
+		if not self._borrowed: matrix_free(self._m)
 
 
 	def __enter__(self):
@@ -0,0 +1,23 @@
+# cython: language_level = 3, boundscheck = False
+#
+# This file is part of the TrackStar package.
+# Copyright (C) 2023 James W. Johnson (giganano9@gmail.com)
+# License: MIT License. See LICENSE in top-level directory
+# at: https://github.com/giganano/TrackStar.git.
+
+cdef extern from "./src/profiling.h":
+	enum: PROFILE_MAX_THREADS
+	enum: PROFILE_N_TIMERS
+	enum: PROFILE_N_EVENTS
+
+	ctypedef struct PROFILE_COUNTERS:
+		unsigned long long ticks[PROFILE_N_TIMERS]
+		unsigned long long events[PROFILE_N_EVENTS]
+
+	PROFILE_COUNTERS *profile_counters()
+	void profile_share(PROFILE_COUNTERS *counters)
+	void profile_reset()
+	double profile_ticks_per_second()
+	unsigned short profiling_enabled()
+
+cdef PROFILE_COUNTERS *shared_profile_counters()
@@ -0,0 +1,130 @@
+# cython: language_level = 3, boundscheck = False
+#
+# This file is part of the TrackStar package.
+# Copyright (C) 2023 James W. Johnson (giganano9@gmail.com)
+# License: MIT License. See LICENSE in top-level directory
+# at: https://github.com/giganano/TrackStar.git.
+
+__all__ = ["profile"]
+from . cimport profiling
+
+# indexed by the PROFILE_* timer and event macros in ./src/profiling.h
+_TIMERS_ = ["likelihood", "track_projection", "data", "chi_squared",
+	"corrective_factor", "quadrature", "covariance_update"]
+_EVENTS_ = ["kernel_evaluations", "quad_refinements", "points_pruned",
+	"bytes_allocated"]
+
+def profile(reset = True):
+	r"""
+	Obtain a breakdown of the time spent within, and the work done by,
+	TrackStar's likelihood calculations.
+
+	Parameters
+	----------
+	reset : ``bool`` [default : ``True``]
+		Whether or not to set every timer and count to zero afterwards, such
+		that the next call reports only what happened in between.
+
+	Returns
+	-------
+	breakdown : ``dict``
+		Two dictionaries, under the keys "seconds" and "events". Each maps
+		the name of a timer or an event count to a list with one value per
+		thread, as long as the largest thread number that recorded anything.
+		The timers are
+
+		- "likelihood": Whole likelihood calculations, on the calling thread.
+		- "track_projection": Projecting the track onto the quantities
+		  measured for each group of data with the same measured quantities.
+		- "data": The work on individual data, on the thread that does it.
+		  Differences between threads indicate that the work was not shared
+		  out evenly (see ``track.parallel_policy``).
+		- "chi_squared": Computing :math:`\chi^2` for each datum and point
+		  along the track.
+		- "corrective_factor": The line segment corrective factors (see
+		  ``track.use_line_segment_corrections``).
+		- "quadrature": Numerical integration, which only the quadrature
+		  method of the corrective factors uses.
+		- "covariance_update": Inverting covariance matrices and computing
+		  their determinants, which happens whenever one is modified.
+
+		Every timer except "covariance_update" runs within
+		"likelihood", and "chi_squared", "corrective_factor", and
+		"quadrature" run within "data". The event counts are
+
+		- "kernel_evaluations": The number of values of :math:`\chi^2`
+		  computed.
+		- "quad_refinements": The number of times an integral was refined by
+		  doubling its number of quadrature bins.
+		- "points_pruned": The number of points skipped because they could
+		  not contribute significantly to the likelihood of observing a datum
+		  (see ``track.pruning_threshold``).
+		- "bytes_allocated": The number of bytes of memory allocated for
+		  matrices and for scratch space by the likelihood calculation.
+
+	Raises
+	------
+	RuntimeError
+		- TrackStar was not compiled with profiling enabled.
+
+	Notes
+	-----
+	The timers and counts are recorded only if TrackStar was compiled with
+	the environment variable ``TRACKSTAR_ENABLE_PROFILE`` set to "true" (see
+	the :doc:`install guide <../install>`), which slows down the likelihood
+	calculation slightly. Otherwise, this instrumentation is compiled out
+	entirely.
+
+	Likelihoods computed at the same time from separate python threads are
+	all recorded as if by the first thread, in which case some events may
+	be lost.
+
+	Example Code
+	------------
+	>>> import trackstar as ts
+	>>> ts.profile() # discard anything recorded so far
+	>>> logl = sample.loglikelihood(track)
+	>>> breakdown = ts.profile()
+	>>> breakdown["seconds"]["data"]
+	[0.0531, 0.0498, 0.0524, 0.0502]
+	>>> breakdown["events"]["kernel_evaluations"]
+	[25000, 25000, 25000, 25000]
+	"""
+	if not profiling_enabled(): raise RuntimeError("""\
+TrackStar was not compiled with profiling enabled. Reinstall with the \
+environment variable TRACKSTAR_ENABLE_PROFILE set to "true".""")
+	cdef PROFILE_COUNTERS *counters = profile_counters()
+	cdef unsigned short i, j
+	n_threads = 1
+	for i in range(PROFILE_MAX_THREADS):
+		for j in range(PROFILE_N_TIMERS):
+			if counters[i].ticks[j]: n_threads = i + 1
+		for j in range(PROFILE_N_EVENTS):
+			if counters[i].events[j]: n_threads = i + 1
+	rate = profile_ticks_per_second()
+	result = {
+		"seconds": {},
+		"events": {}
+	}
+	for j in range(PROFILE_N_TIMERS):
+		result["seconds"][_TIMERS_[j]] = [counters[i].ticks[j] / rate
+			for i in range(n_threads)]
+	for j in range(PROFILE_N_EVENTS):
+		result["events"][_EVENTS_[j]] = [counters[i].events[j]
+			for i in range(n_threads)]
+	if reset: profile_reset()
+	return result
+
+
+cdef PROFILE_COUNTERS *shared_profile_counters():
+	r"""
+	Returns
+	-------
+	counters : ``PROFILE_COUNTERS *``
+		The counters of this module's copy of the C library, which every
+		other module adopts at import time via ``profile_share`` so that
+		``profile`` reports what each of them recorded.
+
+	.. seealso:: ``profile_share`` in ./src/profiling.c
+	"""
+	return profile_counters()
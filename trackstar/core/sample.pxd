@@ -5,30 +5,137 @@
 # License: MIT License. See LICENSE in top-level directory
 # at: https://github.com/giganano/TrackStar.git.
 
-from .datum cimport DATUM, datum
-from .track cimport TRACK
+from .datum cimport DATUM, datum, LIKELIHOOD_CONTEXT
+from .datum cimport likelihood_context_initialize, likelihood_context_free
+from .track cimport TRACK, track
 
 cdef extern from "./src/sample.h":
+	ctypedef struct PACKED_GROUP:
+		unsigned short dim
+		char **labels
+		unsigned short *ids
+
+	ctypedef struct PACKED_SAMPLE:
+		PACKED_GROUP *groups
+		unsigned long n_groups
+		unsigned long n_vectors
+		unsigned long *locations
+
 	ctypedef struct SAMPLE:
 		DATUM **data
 		unsigned long n_vectors
+		PACKED_SAMPLE *packed
 
 	SAMPLE *sample_initialize()
 	void sample_free(SAMPLE *s)
 	void sample_free_everything(SAMPLE *s)
 	void sample_add_datum(SAMPLE *s, DATUM *d)
+	SAMPLE *sample_from_arrays(const double *values, const double *errors,
+		const unsigned char *mask, char **labels, const unsigned long n_data,
+		const unsigned short n_labels)
+	PACKED_SAMPLE *sample_pack(SAMPLE *s)
+	void packed_sample_single(PACKED_SAMPLE *p)
+	void sample_invalidate(SAMPLE *s)
+	DATUM *sample_datum(SAMPLE *s, const unsigned long index)
 	SAMPLE *sample_specific_quantities(SAMPLE s, char **labels,
 		unsigned short n_labels)
 	unsigned long *sample_filter_indices(SAMPLE s, char *label,
 		unsigned short condition_indicator, double value,
 		unsigned short keep_missing_measurements)
+	unsigned short SAMPLE_FILTER_ALL
+	unsigned short SAMPLE_FILTER_ANY
+	ctypedef struct SAMPLE_CONDITION:
+		char *label
+		unsigned short condition_indicator
+		double value
+		unsigned short keep_missing_measurements
+	unsigned long *sample_filter_compound(SAMPLE *s,
+		const SAMPLE_CONDITION *conditions, const unsigned short n_conditions,
+		const unsigned short combine)
+	SAMPLE *sample_view(SAMPLE *s, const unsigned long *indices)
+	void sample_column(SAMPLE *s, const char *label, double *values)
+	double **sample_column_pointers(SAMPLE *s, const char *label)
+	double sample_uncertainty_scale(SAMPLE *s, const char *label)
+
+
+cdef extern from "./src/samplefile.h":
+	unsigned short SAMPLE_FILE_SUCCESS
+	unsigned short SAMPLE_FILE_IO_ERROR
+	unsigned short SAMPLE_FILE_FORMAT_ERROR
+	unsigned short SAMPLE_FILE_VERSION_ERROR
+	unsigned short sample_save(SAMPLE *s, const char *path)
+	SAMPLE *sample_load(const char *path, const unsigned short use_mmap,
+		unsigned short *status)
 
 
 cdef extern from "./src/likelihood.h":
-	double loglikelihood_sample(SAMPLE s, TRACK *t)
+	ctypedef struct KERNEL_CACHE:
+		unsigned long n_data
+		unsigned short n_points
+		unsigned short n_threads
+
+	unsigned short LIKELIHOOD_PRECISION_SINGLE
+	double loglikelihood_sample(SAMPLE *s, const TRACK *t)
+	double loglikelihood_context_sample(LIKELIHOOD_CONTEXT *c,
+		const PACKED_SAMPLE *p) nogil
+	void loglikelihood_context_batch(LIKELIHOOD_CONTEXT **contexts,
+		const unsigned long n_contexts, const PACKED_SAMPLE *p,
+		double *out) nogil
+	KERNEL_CACHE *kernel_cache_initialize(LIKELIHOOD_CONTEXT *c,
+		const PACKED_SAMPLE *p) nogil
+	void kernel_cache_free(KERNEL_CACHE *k)
+	double loglikelihood_kernel_cache(const KERNEL_CACHE *k,
+		const TRACK *t, const unsigned short normalize_weights) nogil
+	double loglikelihood_context_sample_gradient(LIKELIHOOD_CONTEXT *c,
+		const PACKED_SAMPLE *p, double *grad_predictions,
+		double *grad_weights) nogil
+
+
+cdef extern from "./src/engine.h":
+	ctypedef struct LIKELIHOOD_ENGINE:
+		unsigned short n_threads
+		unsigned long n_vectors
+
+	LIKELIHOOD_ENGINE *likelihood_engine_initialize(const PACKED_SAMPLE *p,
+		const unsigned short n_threads) nogil
+	void likelihood_engine_free(LIKELIHOOD_ENGINE *e)
+	double loglikelihood_engine(LIKELIHOOD_ENGINE *e,
+		const LIKELIHOOD_CONTEXT *c) nogil
+
+
+cdef extern from "./src/device.h":
+	ctypedef struct DEVICE_SAMPLE:
+		int device
+		PACKED_SAMPLE *packed
+
+	unsigned short device_available()
+	DEVICE_SAMPLE *device_sample_upload(const PACKED_SAMPLE *p) nogil
+	void device_sample_free(DEVICE_SAMPLE *d)
+	double loglikelihood_device(DEVICE_SAMPLE *d,
+		LIKELIHOOD_CONTEXT *c) nogil
 
 
 cdef class sample:
 	cdef SAMPLE *_s
 	cdef list _data
+	cdef list _keys
+	cdef sample _parent
+	cdef unsigned long _modifications
+	cdef KERNEL_CACHE *_cache
+	cdef object _cache_track
+	cdef object _cache_key
+	cdef LIKELIHOOD_ENGINE *_engine
+	cdef object _engine_key
+	cdef DEVICE_SAMPLE *_device
+	cdef object _device_key
+	@staticmethod
+	cdef sample _own_(SAMPLE *s)
+	cdef sample _view_(self, const unsigned long *indices)
+	cdef void _refresh_(self)
+	cdef datum _datum_(self, unsigned long index, keys)
+	cdef SAMPLE *_restrict_(self, quantities, list tracks) except NULL
+	cdef KERNEL_CACHE *_kernel_cache_(self, track t, quantities,
+		unsigned short corrections) except NULL
+	cdef LIKELIHOOD_ENGINE *_engine_(self, track t, quantities) except NULL
+	cdef DEVICE_SAMPLE *_device_(self, track t, quantities) except NULL
 
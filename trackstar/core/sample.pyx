@@ -9,16 +9,27 @@ __all__ = ["sample"]
 import math as m
 import warnings
 import numbers
+import os
 from .datum import datum_extra
 from .utils import copy_array_like_object, copy_cstring
-from .utils cimport copy_pystring, strindex, linked_list
+from .utils cimport copy_pystring, strindex, linked_list, modifications
+from .utils cimport flag_modification
+from .utils cimport label_registry_share, shared_label_registry
+from .profiling cimport profile_share, shared_profile_counters
 from .matrix cimport matrix_free
 from .covariance_matrix cimport covariance_matrix_free
 from .datum cimport datum
 from . cimport sample
 from .track cimport track
-from libc.stdlib cimport malloc, free
+from libc.stdlib cimport malloc, calloc, free
 from libc.stdint cimport uintptr_t
+from libc.errno cimport errno
+
+# label IDs are only comparable if they come from the same registry
+label_registry_share(shared_label_registry())
+
+# every module records to the counters reported by trackstar.profile
+profile_share(shared_profile_counters())
 
 cdef class sample:
 
@@ -70,6 +81,16 @@ single argument of type dict. Got: %d arguments.""" % (len(args)))
 
 		self._s = sample_initialize()
 		self._data = []
+		self._keys = None
+		self._parent = None
+		self._modifications = modifications()
+		self._cache = NULL
+		self._cache_track = None
+		self._cache_key = None
+		self._engine = NULL
+		self._engine_key = None
+		self._device = NULL
+		self._device_key = None
 
 
 	def __init__(self, *args, extra = {}):
@@ -106,9 +127,267 @@ Keyword arg \'extra\' must be of type dict. Got: %s""" % (type(extra)))
 		Frees up the memory stored by a ``sample`` object. User access strongly
 		discouraged.
 		"""
+		# data constructed in C belong to the sample's arena, which this frees
+		kernel_cache_free(self._cache)
+		likelihood_engine_free(self._engine)
+		device_sample_free(self._device)
 		sample_free(self._s)
 
 
+	@staticmethod
+	def from_arrays(values, labels, errors = None, mask = None):
+		r"""
+		Construct a sample from contiguous arrays of measurements.
+
+		Parameters
+		----------
+		values : ``array-like`` [2-dimensional]
+			The measurements, with one row per datum and one column per
+			quantity. Must support the buffer protocol with C-contiguous
+			64-bit floating point elements (e.g., a ``numpy.ndarray`` of
+			``dtype`` ``float64``), which are read without copying them into
+			python objects. ``nan`` marks a quantity that was not measured for
+			a given datum.
+		labels : ``list`` or ``tuple``
+			The label of each column of ``values``.
+		errors : ``array-like`` [2-dimensional] [default : ``None``]
+			The measurement uncertainties, with the same shape and layout as
+			``values``. Each datum gets a diagonal covariance matrix with the
+			squares of these values along the diagonal. Where this is ``None``
+			or ``nan``, the variance is 1, as for a datum constructed with no
+			uncertainty.
+		mask : ``array-like`` [2-dimensional] [default : ``None``]
+			An array of booleans or single-byte integers with the same shape
+			as ``values``. If provided, only the measurements at which it is
+			nonzero are included in the sample.
+
+		Returns
+		-------
+		s : ``sample``
+			The new sample, equivalent to one constructed by passing the same
+			columns to ``sample.__init__`` in a dictionary.
+
+		Raises
+		------
+		TypeError
+			- ``values`` or ``errors`` do not support the buffer protocol
+			  with C-contiguous 64-bit floating point elements.
+			- ``mask`` does not support the buffer protocol with single-byte
+			  elements.
+			- ``labels`` is not a list or tuple of strings.
+		ValueError
+			- The shapes of ``values``, ``errors``, ``mask``, and ``labels``
+			  do not match.
+			- ``labels`` contains duplicates.
+			- A row of ``values`` has no valid measurements at all.
+
+		Notes
+		-----
+		The data are built in a single pass in C and are owned by the sample.
+		The ``datum`` object for a given row is only constructed if it is
+		accessed from python (e.g., ``s[0]`` or ``s.filter(...)``).
+		"""
+		cdef const double[:, ::1] _values
+		cdef const double[:, ::1] _errors
+		cdef const unsigned char[:, ::1] _mask
+		cdef const double *errors_ptr = NULL
+		cdef const unsigned char *mask_ptr = NULL
+		cdef char **_labels
+		cdef SAMPLE *s
+		cdef sample result
+		try:
+			_values = values
+		except (TypeError, ValueError, BufferError):
+			raise TypeError("""\
+Argument 'values' must be a 2-dimensional, C-contiguous array of 64-bit \
+floating point numbers. Got: %s""" % (type(values)))
+		if not isinstance(labels, list) and not isinstance(labels, tuple):
+			raise TypeError("""\
+Argument 'labels' must be of type list or tuple. Got: %s""" % (type(labels)))
+		elif not all([isinstance(_, str) for _ in labels]):
+			raise TypeError("Elements of 'labels' must all be of type str.")
+		elif len(labels) != _values.shape[1]:
+			raise ValueError("""\
+Got %d labels for %d columns of values.""" % (len(labels), _values.shape[1]))
+		elif len(set(labels)) != len(labels):
+			raise ValueError("Argument 'labels' contains duplicates.")
+		else: pass
+		if errors is not None:
+			try:
+				_errors = errors
+			except (TypeError, ValueError, BufferError):
+				raise TypeError("""\
+Keyword arg 'errors' must be a 2-dimensional, C-contiguous array of 64-bit \
+floating point numbers. Got: %s""" % (type(errors)))
+			if (_errors.shape[0] != _values.shape[0] or
+				_errors.shape[1] != _values.shape[1]):
+				raise ValueError("""\
+Keyword arg 'errors' must have the same shape as argument 'values'.""")
+			elif _values.shape[0] and _values.shape[1]:
+				errors_ptr = &_errors[0, 0]
+			else: pass
+		else: pass
+		if mask is not None:
+			try:
+				# numpy exposes booleans with format "?", which is not a
+				# Cython type, so the mask is recast as unsigned bytes.
+				mask = memoryview(mask)
+				if mask.itemsize != 1: raise TypeError
+				_mask = mask.cast("B").cast("B", mask.shape)
+			except (TypeError, ValueError, BufferError):
+				raise TypeError("""\
+Keyword arg 'mask' must be a C-contiguous array of booleans or single-byte \
+integers.""")
+			if (_mask.shape[0] != _values.shape[0] or
+				_mask.shape[1] != _values.shape[1]):
+				raise ValueError("""\
+Keyword arg 'mask' must have the same shape as argument 'values'.""")
+			elif _values.shape[0] and _values.shape[1]:
+				mask_ptr = &_mask[0, 0]
+			else: pass
+		else: pass
+
+		result = sample.__new__(sample)
+		if not _values.shape[0]: return result
+		if not _values.shape[1]: raise ValueError("""\
+Every row of argument 'values' must have at least one valid measurement.""")
+		_labels = <char **> malloc (len(labels) * sizeof(char *))
+		for i in range(len(labels)): _labels[i] = copy_pystring(labels[i])
+		try:
+			s = sample_from_arrays(&_values[0, 0], errors_ptr, mask_ptr,
+				_labels, _values.shape[0], _values.shape[1])
+		finally:
+			for i in range(len(labels)): free(_labels[i])
+			free(_labels)
+		if s is NULL: raise ValueError("""\
+Every row of argument 'values' must have at least one valid measurement.""")
+		return sample._own_(s)
+
+
+	@staticmethod
+	def load(path, mmap = True):
+		r"""
+		Read a sample from a binary file written by ``sample.save``.
+
+		Parameters
+		----------
+		path : ``str`` or ``os.PathLike``
+			The path to the file.
+		mmap : ``bool`` [default : ``True``]
+			If ``True``, the file is mapped into memory rather than read, and
+			the likelihood is computed directly from the mapping.
+
+		Returns
+		-------
+		s : ``sample``
+			The sample stored in the file.
+
+		Raises
+		------
+		TypeError
+			- ``mmap`` is not of type ``bool``.
+		OSError
+			- The file could not be opened, read, or mapped into memory.
+		ValueError
+			- The file is not a sample file, is corrupted, or was written by
+			  a newer version of TrackStar or on a machine with a different
+			  byte order.
+
+		Notes
+		-----
+		Loading a file does not construct any of the data: each is
+		reconstructed from the file the first time it is accessed, and the
+		covariance matrices are not inverted again. Processes that map the
+		same file share its pages through the operating system's page cache,
+		so many concurrent likelihood evaluations of a large sample (e.g.
+		one per process in an MCMC) do not each hold a copy of it in memory.
+
+		The components of each datum are in the order of the first datum
+		saved with the same quantities, and the ``extra`` information of the
+		data is not stored in the file.
+		"""
+		cdef SAMPLE *s
+		cdef unsigned short status
+		if not isinstance(mmap, bool): raise TypeError("""\
+Keyword arg 'mmap' must be of type bool. Got: %s""" % (type(mmap)))
+		encoded = os.fsencode(path)
+		s = sample_load(encoded, int(mmap), &status)
+		if status == SAMPLE_FILE_IO_ERROR:
+			raise OSError(errno, os.strerror(errno), path)
+		elif status == SAMPLE_FILE_FORMAT_ERROR:
+			raise ValueError("Not a valid sample file: %s" % (path))
+		elif status == SAMPLE_FILE_VERSION_ERROR:
+			raise ValueError("""\
+Sample file was written by a newer version of TrackStar or on a machine with \
+a different byte order: %s""" % (path))
+		else: pass
+		return sample._own_(s)
+
+
+	def save(self, path):
+		r"""
+		Write the sample to a binary file, which ``sample.load`` reads back.
+
+		Parameters
+		----------
+		path : ``str`` or ``os.PathLike``
+			The path to the file, which is overwritten if it exists.
+
+		Raises
+		------
+		OSError
+			- The file could not be written.
+
+		Notes
+		-----
+		The file stores the data in the same packed layout that the
+		likelihood is computed from, along with their inverse covariance
+		matrices, such that loading it requires no computation. The
+		``extra`` information of the data is not stored. The file is written
+		under a temporary name and then renamed, so other processes that have
+		loaded a previous version of it are unaffected.
+		"""
+		self._refresh_()
+		encoded = os.fsencode(path)
+		if sample_save(self._s, encoded) != SAMPLE_FILE_SUCCESS:
+			raise OSError(errno, os.strerror(errno), path)
+		else: pass
+
+
+	@staticmethod
+	cdef sample _own_(SAMPLE *s):
+		# A sample wrapping data constructed in C, which belong to the arena
+		# of ``s``. Their python wrappers are only constructed as they're
+		# needed.
+		cdef sample result = sample.__new__(sample)
+		sample_free(result._s)
+		result._s = s
+		result._data = s[0].n_vectors * [None]
+		return result
+
+
+	cdef sample _view_(self, const unsigned long *indices):
+		# A sample of some of the data of this one, in the format returned by
+		# sample_filter_compound, sharing their memory and python wrappers.
+		# Data constructed in C belong to this sample's arena, so the view
+		# keeps a reference to it.
+		cdef sample result = sample.__new__(sample)
+		sample_free(result._s)
+		result._s = sample_view(self._s, indices)
+		result._data = [self._data[indices[i + 1]] for i in range(indices[0])]
+		result._parent = self
+		return result
+
+
+	cdef void _refresh_(self):
+		# Discard the packed copy of the sample if some datum has been
+		# modified since it was packed.
+		if self._modifications != modifications():
+			sample_invalidate(self._s)
+			self._modifications = modifications()
+		else: pass
+
+
 	def __enter__(self):
 		r"""Opens a with statement."""
 		return self
@@ -149,26 +428,22 @@ Keyword arg \'extra\' must be of type dict. Got: %s""" % (type(extra)))
 		"""
 		cdef double **copies
 		cdef char *label
+		cdef unsigned long *indices
 		if isinstance(key, numbers.Number):
 			if key % 1 == 0:
 				key = int(key)
 				if -self.size <= key < 0: key += self.size
 				if not 0 <= key < self.size: raise IndexError("""\
 Index %d out of range for sample of size N = %d.""" % (key, self.size))
-				return self._data[key]
+				return self._datum_(key, None)
 			else: raise IndexError("Sample index must be an integer, not float.")
 		elif isinstance(key, str):
 			if key in self.keys():
-				copies = <double **> malloc (self.size * sizeof(double *))
-				for i in range(self.size):
-					label = copy_pystring(key)
-					idx = strindex(self._s[0].data[i][0].labels, label,
-						self._s[0].data[i][0].n_cols)
-					if idx != -1:
-						copies[i] = &self._s[0].data[i][0].vector[0][idx]
-					else:
-						copies[i] = <double *> malloc (sizeof(double))
-						copies[i][0] = float("nan")
+				label = copy_pystring(key)
+				try:
+					copies = sample_column_pointers(self._s, label)
+				finally:
+					free(label)
 				return linked_list(<uintptr_t> copies, self.size)
 			else:
 				raise KeyError("Sample quantity label %s not recognized." % (
@@ -195,10 +470,15 @@ string. Got: %s, %s""" % (type(key[0]), type(key[1])))
 Sample indexing requires at most two parameters. Got: %d""" % (len(key)))
 		elif isinstance(key, slice):
 			sl = linked_list._indexing_handle_slice_(key)
-			vectors = self._data[sl]
-			subset = sample()
-			for v in vectors: subset.add_datum(v)
-			return subset
+			rows = range(self.size)[sl]
+			indices = <unsigned long *> malloc (
+				(len(rows) + 1) * sizeof(unsigned long))
+			try:
+				indices[0] = len(rows)
+				for i in range(len(rows)): indices[i + 1] = rows[i]
+				return self._view_(indices)
+			finally:
+				free(indices)
 		else:
 			raise IndexError("""\
 Sample index must be either a data vector index (int) or a quantity label \
@@ -207,25 +487,27 @@ Sample index must be either a data vector index (int) or a quantity label \
 
 	def __setitem__(self, index, value):
 		cdef char *copy
+		cdef DATUM *d
 		if isinstance(index, numbers.Number):
 			if index % 1 == 0:
 				index = int(index)
 				if -self.size <= index < 0: index += self.size
 				if not 0 <= index < self.size: raise IndexError("""\
 Index %d out of bounds for sample of size N = %d.""" % (index, self.size))
+				row = self._datum_(index, None)
 				if isinstance(value, datum):
-					if set(value.keys()) == set(self._data[index].keys()):
+					if set(value.keys()) == set(row.keys()):
 						for key in value.keys():
-							self._data[index][key] = value[key]
+							row[key] = value[key]
 					else:
 						raise ValueError("""\
 Sample item assignment by row number requires dictionary or datum keys to \
 match.""")
 				elif isinstance(value, dict):
-					if set(value.keys()) == set(self._data[index].keys()):
+					if set(value.keys()) == set(row.keys()):
 						for key in value.keys():
 							if isinstance(value[key], numbers.Number):
-								self._data[index][key] = value[key]
+								row[key] = value[key]
 							else:
 								raise TypeError("""\
 Sample only supports real numbers. Got: %s""" % (type(value[key])))
@@ -254,10 +536,11 @@ Array length mismatch: %d for sample of size %d.""" % (len(value), self.size))
 			if all([isinstance(_, numbers.Number) for _ in value]):
 				copy = copy_pystring(index)
 				for i in range(self.size):
-					idx = strindex(self._s[0].data[i][0].labels, copy,
-						self._s[0].data[i][0].n_cols)
+					d = sample_datum(self._s, i)
+					idx = strindex(d[0].labels, copy, d[0].n_cols)
 					if idx != -1 and not m.isnan(value[i]):
-						self._s[0].data[i][0].vector[0][idx] = value[i]
+						d[0].vector[0][idx] = value[i]
+						flag_modification()
 					elif idx != -1 and m.isnan(value[i]):
 						raise ValueError("""\
 Datum at index %d stores a quantity labeled %s. Cannot assign item at this \
@@ -287,9 +570,10 @@ Index %d out of bounds for sample of size N = %d.""" % (row, self.size))
 						if not isinstance(value, numbers.Number):
 							raise TypeError("""\
 Sample item assignment requires a real number. Got: %s""" % (type(value)))
-						if index[0] in self._data[row].keys():
+						this = self._datum_(row, None)
+						if index[0] in this.keys():
 							if not m.isnan(value):
-								self._data[row][index[0]] = value
+								this[index[0]] = value
 							else:
 								raise ValueError("""\
 Datum at index %d stores a quantity labeled %s. Cannot assign item at this \
@@ -323,52 +607,392 @@ combination of the two. Got: %s""" % (type(index)))
 		r"""
 		Add a data vector to the sample.
 		"""
+		# Only the new datum and any quantities it introduces need shadow
+		# keys, so that building a sample one datum at a time isn't quadratic
+		# in the sample size.
+		keys = self.keys()
+		own_keys = measurement.keys()
+		new_keys = [key for key in own_keys if key not in keys]
 		sample_add_datum(self._s, measurement._d)
+		for key in keys:
+			if key not in own_keys: measurement._shadow_keys.add(key)
+		if len(new_keys):
+			for i in range(len(self._data)):
+				# unconstructed wrappers get their shadow keys in _datum_
+				if self._data[i] is None: pass
+				else:
+					for key in new_keys: self._data[i]._shadow_keys.add(key)
+		else: pass
 		self._data.append(measurement)
-		for key in self.keys():
-			for i in range(self.size):
-				if (key not in self._data[i].keys() and
-					key not in self._data[i]._shadow_keys):
-					self._data[i]._shadow_keys.add(key)
+		self._keys = keys + new_keys
+
+
+	cdef datum _datum_(self, unsigned long index, keys):
+		# The python wrapper of the datum at some index, which for data built
+		# by sample.from_arrays or sample.load is only constructed the first
+		# time it's needed. ``keys`` are those of the whole sample, if already
+		# at hand.
+		cdef datum d = self._data[index]
+		if d is None:
+			d = datum._borrow_(sample_datum(self._s, index), self)
+			if keys is None: keys = self.keys()
+			own_keys = d.keys()
+			for key in keys:
+				if key not in own_keys: d._shadow_keys.add(key)
+			self._data[index] = d
+		else: pass
+		return d
 
 
 	def loglikelihood(self, track t, quantities = None,
-		normalize_weights = True, use_line_segment_corrections = False):
+		normalize_weights = True, use_line_segment_corrections = False,
+		cache_kernel = False, return_grad = False, pin_threads = False,
+		backend = "cpu", precision = "double"):
 		r"""
 		Compute natural logarithm of the likelihood that this sample would be
 		observed by the model predicted track ``t``.
 
-		.. todo::
+		If ``cache_kernel`` is ``True``, the contribution of each point along
+		the track to the likelihood of observing each datum is stored, without
+		the weights of the points, the first time the likelihood is computed.
+		Subsequent calls with the same track, the same ``quantities`` and
+		``use_line_segment_corrections``, and the same
+		``t.pruning_threshold`` then reuse these values with the current
+		weights of the track, which costs only one sparse matrix-vector
+		product. The values are recomputed automatically if the predictions of
+		the track or any of the data are modified. This is intended for models
+		in which only the weights vary between evaluations (e.g. the
+		star formation history). Without pruning, the cache takes 10 bytes
+		per datum per point along the track. With pruning, contributions
+		below the threshold without the weights are left out, so the result
+		is approximate if the weights vary by a comparable factor along the
+		track.
+
+		.. note::
+
+			Only one kernel cache and one set of partitions are stored per
+			sample, and the GIL is held while either is used.
+
+		If ``return_grad`` is ``True``, the derivatives of the log-likelihood
+		with respect to the predictions and the weights of the track are
+		computed along with it, as gradient-based samplers (e.g. Hamiltonian
+		Monte Carlo) require, and a tuple ``(logl, grad_predictions,
+		grad_weights)`` is returned. ``grad_predictions`` is a NumPy array of
+		shape ``(t.n_vectors, len(t.keys()))``, with columns in the order of
+		``t.keys()``, and ``grad_weights`` has one element per point along the
+		track. Predictions for quantities not measured by the sample have
+		derivatives of zero. This costs a few likelihood calculations rather
+		than the two per prediction and per weight that finite differences
+		would, and it cannot be combined with ``cache_kernel``. With
+		``t.pruning_threshold`` non-negative, pruned points contribute to
+		neither the likelihood nor its derivatives, so the result may differ
+		slightly from the one computed without ``return_grad``.
+
+		If ``pin_threads`` is ``True``, the data are split into
+		``t.n_threads`` partitions the first time the likelihood is computed,
+		each of which is copied by the thread that computes its share of the
+		likelihood. Subsequent calls with the same ``quantities`` and
+		``t.n_threads`` reuse the partitions, the threads, and the memory
+		each thread works in, for any track. On machines with more than one
+		processor socket, memory is placed on the socket of the thread that
+		first writes to it, so each thread then reads its data from memory
+		local to it, provided that the OpenMP runtime binds threads to
+		processors (e.g. with the environment variable
+		``OMP_PLACES=cores``), in which case the threads are spread across
+		the sockets. The partitions are rebuilt automatically if any of the
+		data are modified. ``t.parallel_policy`` does not apply; the data are
+		always parallelized over. This cannot be combined with
+		``cache_kernel`` or ``return_grad``.
 
-			Error handling for case where the input track does not have
-			predictions for each quantity in the sample. This causes a
-			segmentation fault in the C library, because ``track_subset``
-			in ./likelihood.c returns ``NULL``.
+		If ``backend`` is ``"device"`` rather than ``"cpu"`` (the default),
+		the likelihood is computed on an accelerator (e.g., a GPU) with
+		OpenMP's target offloading. The data are copied to the device the
+		first time the likelihood is computed and stay there, so subsequent
+		calls with the same ``quantities`` only transfer the predictions and
+		weights of the track, projected onto the measured quantities. They
+		are copied again automatically if any of the data are modified. Each
+		datum is assigned to a device thread, and every point along the track
+		contributes to it, so ``t.pruning_threshold`` does not apply. The
+		likelihood is computed on the CPU as usual if TrackStar was not
+		compiled with offloading (see ``trackstar.offload_linked``), if the
+		OpenMP runtime does not find a device, or with
+		``use_line_segment_corrections = "quad"``. This cannot be combined
+		with ``cache_kernel``, ``return_grad``, or ``pin_threads``.
+
+		.. note::
+
+			Only one copy of a sample is stored on the device, and the GIL is
+			held while it is made.
+
+		If ``precision`` is ``"single"`` rather than ``"double"`` (the
+		default), :math:`\chi^2` between each datum and each point along the
+		track is computed in single precision, which fits twice as many
+		points into each SIMD instruction and halves the memory that the
+		projected track occupies. The benefit grows with the number of
+		measured quantities, because the contribution of each point is
+		still exponentiated in double precision. The data vectors and inverse
+		covariance matrices are copied to single precision the first time, and
+		the copies are kept until the data are modified. The sums over the track
+		and over the data are still accumulated in double precision, the
+		latter with compensated summation, so the error in the log-likelihood
+		of each datum is of the order of the rounding error of a single
+		precision :math:`\chi^2`, roughly ``1e-7`` times :math:`\chi^2`
+		itself. ``trackstar/core/src/benchmarks`` reports this error
+		alongside the time per calculation. Groups of data that share a
+		covariance matrix are still computed in double precision, since the
+		track is transformed into their whitened frame, where :math:`\chi^2`
+		is a plain squared distance and is cheaper than a single precision
+		quadratic form. This cannot be combined with
+		``cache_kernel``, ``return_grad``, ``pin_threads``, or ``backend =
+		"device"``.
+
+		Raises
+		------
+		TypeError
+			- ``quantities`` is not a list, tuple, or ``None``, or one of its
+			  elements is not a string.
+		ValueError
+			- ``t`` does not have predictions for one of the quantities
+			  considered (i.e., every quantity measured for the sample if
+			  ``quantities`` is ``None``).
+			- ``quantities`` lists a quantity that no datum measures.
 
 		.. todo:: Raise a warning when normalize_weights is False
 		"""
 		cdef SAMPLE *sub
-		cdef char **labels
-		if isinstance(normalize_weights, bool):
-			t._t[0].normalize_weights = int(normalize_weights)
-		else:
+		cdef LIKELIHOOD_CONTEXT *context
+		cdef PACKED_SAMPLE *packed
+		cdef KERNEL_CACHE *cache
+		cdef LIKELIHOOD_ENGINE *engine
+		cdef DEVICE_SAMPLE *device
+		cdef double result
+		corrections = _line_segment_corrections_(normalize_weights,
+			use_line_segment_corrections)
+		if not isinstance(backend, str): raise TypeError("""\
+Keyword arg 'backend' must be of type str. Got: %s""" % (type(backend)))
+		elif backend not in ["cpu", "device"]: raise ValueError("""\
+Keyword arg 'backend' must be either "cpu" or "device". Got: %s""" % (
+			backend))
+		elif backend == "device" and (cache_kernel is True or
+			return_grad is True or pin_threads is True):
+			raise ValueError("""\
+Keyword arg 'backend' cannot be "device" with 'cache_kernel', 'return_grad', \
+or 'pin_threads'.""")
+		else: pass
+		if not isinstance(precision, str): raise TypeError("""\
+Keyword arg 'precision' must be of type str. Got: %s""" % (type(precision)))
+		elif precision not in ["double", "single"]: raise ValueError("""\
+Keyword arg 'precision' must be either "double" or "single". Got: %s""" % (
+			precision))
+		elif precision == "single" and (cache_kernel is True or
+			return_grad is True or pin_threads is True or backend == "device"):
+			raise ValueError("""\
+Keyword arg 'precision' cannot be "single" with 'cache_kernel', \
+'return_grad', 'pin_threads', or 'backend = "device"'.""")
+		else: pass
+		if not isinstance(pin_threads, bool): raise TypeError("""\
+Keyword arg 'pin_threads' must be of type bool. Got: %s""" % (
+			type(pin_threads)))
+		elif pin_threads and (cache_kernel is True or return_grad is True):
+			raise ValueError("""\
+Keyword arg 'pin_threads' cannot be combined with 'cache_kernel' or \
+'return_grad'.""")
+		else: pass
+		if not isinstance(return_grad, bool): raise TypeError("""\
+Keyword arg 'return_grad' must be of type bool. Got: %s""" % (
+			type(return_grad)))
+		elif return_grad:
+			if cache_kernel is True: raise ValueError("""\
+Keyword args 'cache_kernel' and 'return_grad' cannot both be True.""")
+			return self._loglikelihood_gradient_(t, quantities,
+				normalize_weights, corrections)
+		else: pass
+		if not isinstance(cache_kernel, bool): raise TypeError("""\
+Keyword arg 'cache_kernel' must be of type bool. Got: %s""" % (
+			type(cache_kernel)))
+		elif cache_kernel:
+			cache = self._kernel_cache_(t, quantities, corrections)
+			cache[0].n_threads = t._t[0].n_threads
+			return loglikelihood_kernel_cache(cache, t._t,
+				int(normalize_weights))
+		else: pass
+		if pin_threads:
+			engine = self._engine_(t, quantities)
+			context = likelihood_context_initialize(t._t)
+			context[0].normalize_weights = int(normalize_weights)
+			context[0].use_line_segment_corrections = corrections
+			try:
+				return loglikelihood_engine(engine, context)
+			finally:
+				likelihood_context_free(context)
+		else: pass
+		if backend == "device" and corrections < 2 and device_available():
+			device = self._device_(t, quantities)
+			context = likelihood_context_initialize(t._t)
+			context[0].normalize_weights = int(normalize_weights)
+			context[0].use_line_segment_corrections = corrections
+			try:
+				with nogil:
+					result = loglikelihood_device(device, context)
+				return result
+			finally:
+				likelihood_context_free(context)
+		else: pass
+		sub = self._restrict_(quantities, [t])
+
+		# The per-call settings live in the context rather than on the track,
+		# and packing modifies the sample, so both are taken care of while
+		# holding the GIL. The likelihood itself touches neither the track nor
+		# the sample, so other python threads are free to run meanwhile.
+		context = likelihood_context_initialize(t._t)
+		context[0].normalize_weights = int(normalize_weights)
+		context[0].use_line_segment_corrections = corrections
+		try:
+			packed = sample_pack(sub)
+			if precision == "single":
+				context[0].precision = LIKELIHOOD_PRECISION_SINGLE
+				packed_sample_single(packed)
+			else: pass
+			with nogil:
+				result = loglikelihood_context_sample(context, packed)
+			return result
+		finally:
+			likelihood_context_free(context)
+			if sub != self._s: sample_free_everything(sub)
+
+
+	def _loglikelihood_gradient_(self, track t, quantities, normalize_weights,
+		unsigned short corrections):
+		r"""
+		Computes the log-likelihood and its derivatives for
+		``loglikelihood(..., return_grad = True)``, whose arguments have
+		already been validated.
+		"""
+		cdef SAMPLE *sub
+		cdef LIKELIHOOD_CONTEXT *context
+		cdef PACKED_SAMPLE *packed
+		cdef double[:, ::1] _grad_predictions
+		cdef double[::1] _grad_weights
+		cdef double result
+		try:
+			import numpy as np
+		except ModuleNotFoundError:
+			raise ModuleNotFoundError("""\
+Cannot return the gradient of the likelihood as NumPy arrays because NumPy \
+was not found.""")
+		grad_predictions = np.zeros((t._t[0].n_vectors, t._t[0].dim),
+			dtype = np.float64)
+		grad_weights = np.zeros(t._t[0].n_vectors, dtype = np.float64)
+		_grad_predictions = grad_predictions
+		_grad_weights = grad_weights
+		sub = self._restrict_(quantities, [t])
+
+		# see comment in loglikelihood
+		context = likelihood_context_initialize(t._t)
+		context[0].normalize_weights = int(normalize_weights)
+		context[0].use_line_segment_corrections = corrections
+		try:
+			packed = sample_pack(sub)
+			with nogil:
+				result = loglikelihood_context_sample_gradient(context, packed,
+					&_grad_predictions[0, 0], &_grad_weights[0])
+			return (result, grad_predictions, grad_weights)
+		finally:
+			likelihood_context_free(context)
+			if sub != self._s: sample_free_everything(sub)
+
+
+	def loglikelihood_many(self, tracks, quantities = None,
+		normalize_weights = True, use_line_segment_corrections = False):
+		r"""
+		Compute the natural logarithm of the likelihood that this sample would
+		be observed by each of several model predicted tracks, as when an
+		ensemble sampler proposes many models at once.
+
+		Parameters
+		----------
+		tracks : ``list`` or ``tuple``
+			The ``track`` objects to compute the likelihood with. They need not
+			have the same number of points or list their predicted quantities
+			in the same order.
+		quantities, normalize_weights, use_line_segment_corrections
+			As in ``loglikelihood``, applied to every track.
+
+		Returns
+		-------
+		logl : ``list``
+			The natural logarithm of the likelihood of observation given each
+			track, in the same order as ``tracks``. Each element is equal to
+			what ``loglikelihood`` returns for that track.
+
+		.. note::
+
+			This is faster than calling ``loglikelihood`` once per track,
+			because each datum is compared against every track in turn while
+			it is in cache, and the combinations of data and tracks are
+			computed in parallel with the largest ``n_threads`` among the
+			tracks. The GIL is released while doing so.
+		"""
+		cdef SAMPLE *sub
+		cdef LIKELIHOOD_CONTEXT **contexts
+		cdef PACKED_SAMPLE *packed
+		cdef double *out
+		cdef unsigned long n_tracks
+		cdef track t
+		if not isinstance(tracks, list) and not isinstance(tracks, tuple):
 			raise TypeError("""\
-Keyword arg 'normalize_weights' must be of type bool. Got: %s""" % (
-				type(normalize_weights)))
-		if isinstance(use_line_segment_corrections, bool):
-			t._t[0].use_line_segment_corrections = int(
-				use_line_segment_corrections)
+Argument 'tracks' must be of type list or tuple. Got: %s""" % (type(tracks)))
 		else:
-			raise TypeError("""\
-Keyword arg 'use_line_segment_corrections' must be of type bool. Got: %s""" % (
-				type(use_line_segment_corrections)))
+			tracks = list(tracks)
+		for t_ in tracks:
+			if not isinstance(t_, track): raise TypeError("""\
+Elements of argument 'tracks' must all be of type track. Got: %s""" % (
+				type(t_)))
+		corrections = _line_segment_corrections_(normalize_weights,
+			use_line_segment_corrections)
+		sub = self._restrict_(quantities, tracks)
+
+		# see comment in loglikelihood
+		n_tracks = len(tracks)
+		contexts = <LIKELIHOOD_CONTEXT **> malloc (
+			n_tracks * sizeof(LIKELIHOOD_CONTEXT *))
+		out = <double *> malloc (n_tracks * sizeof(double))
+		for i in range(n_tracks):
+			t = tracks[i]
+			contexts[i] = likelihood_context_initialize(t._t)
+			contexts[i][0].normalize_weights = int(normalize_weights)
+			contexts[i][0].use_line_segment_corrections = corrections
+		try:
+			packed = sample_pack(sub)
+			with nogil:
+				loglikelihood_context_batch(contexts, n_tracks, packed, out)
+			return [out[i] for i in range(n_tracks)]
+		finally:
+			for i in range(n_tracks): likelihood_context_free(contexts[i])
+			free(contexts)
+			free(out)
+			if sub != self._s: sample_free_everything(sub)
+
+
+	cdef SAMPLE *_restrict_(self, quantities, list tracks) except NULL:
+		r"""
+		Check that each of the tracks predicts the quantities that a
+		likelihood calculation is to consider. Returns either this sample,
+		repacked if any of its data have been modified, or a new sample
+		restricted to ``quantities``, in which case the caller is responsible
+		for freeing it.
+		"""
+		cdef char **labels
+		cdef SAMPLE *sub
 		self_keys = self.keys()
-		track_keys = t.keys()
 		if quantities is None:
-			for key in self_keys:
-				if key not in track_keys: raise ValueError("""\
+			for t in tracks:
+				track_keys = t.keys()
+				for key in self_keys:
+					if key not in track_keys: raise ValueError("""\
 Track does not have predictions for quantity labeled %s.""" % (key))
-			return loglikelihood_sample(self._s[0], t._t)
+			self._refresh_()
+			return self._s
 		elif isinstance(quantities, list) or isinstance(quantities, tuple):
 			for qty in quantities:
 				if not isinstance(qty, str): raise TypeError("""\
@@ -376,7 +1000,8 @@ Elements of keyword arg 'quantities' must all be of type str. Got: %s""" % (
 					type(qty)))
 				if qty not in self_keys: raise ValueError("""\
 Sample does not have measurements for quantity labeled %s.""" % (qty))
-				if qty not in track_keys: raise ValueError("""\
+				for t in tracks:
+					if qty not in t.keys(): raise ValueError("""\
 Track does not have predictions for quantity labeled %s.""" % (qty))
 			labels = <char **> malloc (
 				len(quantities) * sizeof(char *))
@@ -384,18 +1009,114 @@ Track does not have predictions for quantity labeled %s.""" % (qty))
 				labels[i] = copy_pystring(quantities[i])
 			sub = sample_specific_quantities(self._s[0], labels,
 				len(quantities))
-			try:
-				return loglikelihood_sample(sub[0], t._t)
-			finally:
-				sample_free_everything(sub)
-				for i in range(len(quantities)): free(labels[i])
-				free(labels)
+			for i in range(len(quantities)): free(labels[i])
+			free(labels)
+			return sub
 		else:
 			raise TypeError("""\
 Keyword arg 'quantities' must be of type list, tuple, or None. Got: %s""" % (
 				type(quantities)))
 
 
+	cdef KERNEL_CACHE *_kernel_cache_(self, track t, quantities,
+		unsigned short corrections) except NULL:
+		r"""
+		Returns the kernel cache for the track ``t`` and the given settings,
+		rebuilding it if the track, its predictions, the settings, or any data
+		have changed since it was last built.
+		"""
+		cdef SAMPLE *sub
+		cdef LIKELIHOOD_CONTEXT *context
+		cdef PACKED_SAMPLE *packed
+		cdef KERNEL_CACHE *cache
+		if isinstance(quantities, list): quantities = tuple(quantities)
+		key = (t._revision, self.size, modifications(), quantities,
+			corrections, t._t[0].pruning_threshold)
+		if (self._cache is not NULL and self._cache_track is t and
+			self._cache_key == key):
+			return self._cache
+		else: pass
+		sub = self._restrict_(quantities, [t])
+		context = likelihood_context_initialize(t._t)
+		context[0].use_line_segment_corrections = corrections
+		try:
+			packed = sample_pack(sub)
+			with nogil:
+				cache = kernel_cache_initialize(context, packed)
+		finally:
+			likelihood_context_free(context)
+			if sub != self._s: sample_free_everything(sub)
+		kernel_cache_free(self._cache)
+		self._cache = cache
+		self._cache_track = t
+		self._cache_key = key
+		return self._cache
+
+
+	cdef LIKELIHOOD_ENGINE *_engine_(self, track t, quantities) except NULL:
+		r"""
+		Returns the engine partitioning the data among ``t.n_threads``
+		threads, rebuilding it if the number of threads, ``quantities``, or
+		any data have changed since it was last built.
+		"""
+		cdef SAMPLE *sub
+		cdef PACKED_SAMPLE *packed
+		cdef LIKELIHOOD_ENGINE *engine
+		cdef unsigned short n_threads = t._t[0].n_threads
+		if isinstance(quantities, list): quantities = tuple(quantities)
+		key = (self.size, modifications(), quantities, n_threads)
+		if self._engine is not NULL and self._engine_key == key:
+			# the engine works with any track that predicts the quantities
+			track_keys = t.keys()
+			for qty in (self.keys() if quantities is None else quantities):
+				if qty not in track_keys: raise ValueError("""\
+Track does not have predictions for quantity labeled %s.""" % (qty))
+			return self._engine
+		else: pass
+		sub = self._restrict_(quantities, [t])
+		try:
+			packed = sample_pack(sub)
+			with nogil:
+				engine = likelihood_engine_initialize(packed, n_threads)
+		finally:
+			if sub != self._s: sample_free_everything(sub)
+		likelihood_engine_free(self._engine)
+		self._engine = engine
+		self._engine_key = key
+		return self._engine
+
+
+	cdef DEVICE_SAMPLE *_device_(self, track t, quantities) except NULL:
+		r"""
+		Returns the copy of the data on the accelerator, making it anew if
+		``quantities`` or any data have changed since it was last made.
+		"""
+		cdef SAMPLE *sub
+		cdef PACKED_SAMPLE *packed
+		cdef DEVICE_SAMPLE *device
+		if isinstance(quantities, list): quantities = tuple(quantities)
+		key = (self.size, modifications(), quantities)
+		if self._device is not NULL and self._device_key == key:
+			# the copy works with any track that predicts the quantities
+			track_keys = t.keys()
+			for qty in (self.keys() if quantities is None else quantities):
+				if qty not in track_keys: raise ValueError("""\
+Track does not have predictions for quantity labeled %s.""" % (qty))
+			return self._device
+		else: pass
+		sub = self._restrict_(quantities, [t])
+		try:
+			packed = sample_pack(sub)
+			with nogil:
+				device = device_sample_upload(packed)
+		finally:
+			if sub != self._s: sample_free_everything(sub)
+		device_sample_free(self._device)
+		self._device = device
+		self._device_key = key
+		return self._device
+
+
 	@property
 	def size(self):
 		r"""
@@ -408,67 +1129,277 @@ Keyword arg 'quantities' must be of type list, tuple, or None. Got: %s""" % (
 
 	@property
 	def extra(self):
-		return sample_extra([self._data[i].extra for i in range(self.size)])
+		keys = self.keys()
+		return sample_extra([self._datum_(i, keys).extra for i in range(
+			self.size)])
 
 
 	def keys(self):
+		# Labels are unique by ID, so those already found can be tracked
+		# without constructing the python wrapper of every datum. Data of a
+		# loaded sample that have not been reconstructed carry the labels of
+		# their group, in the same order. The labels of a datum never change,
+		# so the result is kept until another datum is added.
+		cdef DATUM *d
+		cdef PACKED_GROUP *g
+		cdef unsigned short *ids
+		cdef char **labels
+		cdef unsigned short n_cols
+		cdef unsigned long i
+		cdef unsigned short j
+		cdef unsigned char *found
+		if self._keys is not None: return list(self._keys)
+		found = <unsigned char *> calloc (65536u, sizeof(unsigned char))
 		_keys = []
-		for i in range(self.size):
-			for test in self._data[i].keys():
-				if test not in _keys: _keys.append(test)
-		return _keys
+		try:
+			for i in range(self._s[0].n_vectors):
+				d = self._s[0].data[i]
+				if d is NULL:
+					g = &self._s[0].packed[0].groups[
+						self._s[0].packed[0].locations[2 * i]]
+					ids = g[0].ids
+					labels = g[0].labels
+					n_cols = g[0].dim
+				else:
+					ids = d[0].ids
+					labels = d[0].labels
+					n_cols = d[0].n_cols
+				for j in range(n_cols):
+					if not found[ids[j]]:
+						found[ids[j]] = 1
+						_keys.append(copy_cstring(labels[j]))
+					else: pass
+		finally:
+			free(found)
+		self._keys = _keys
+		return list(_keys)
 
 
-	def filter(self, label, condition, value,
-		keep_missing_measurements = False):
+	def filter(self, label, condition = None, value = None,
+		keep_missing_measurements = False, combine = "and"):
 		r"""
 		Filter the sample based on some condition applied to one specific
-		column.
+		column, or on several such conditions at once.
+
+		Parameters
+		----------
+		label : ``str`` or ``list``
+			The label of the quantity to filter based on. Alternatively, a
+			list of ``(label, condition, value)`` tuples, one per condition,
+			in which case ``condition`` and ``value`` are omitted.
+		condition : ``str``
+			The condition to apply: one of "=", "==", "<", "<=", ">", or ">=".
+		value : real number
+			The value to condition based on.
+		keep_missing_measurements : ``bool`` [default : ``False``]
+			Whether or not data without a measurement of the quantity that a
+			condition is based on satisfy that condition.
+		combine : ``str`` [default : "and"]
+			"and" to keep the data that satisfy every condition, or "or" to
+			keep those that satisfy at least one.
+
+		Returns
+		-------
+		sub : ``sample``
+			The data that pass the filter, in the same order. They are shared
+			with this sample rather than copied, so modifying a datum of one
+			modifies it in both.
+
+		Raises
+		------
+		TypeError
+			- ``label``, ``condition``, or ``value`` is of the wrong type, or
+			  a list of conditions contains anything other than tuples of
+			  three elements.
+			- ``condition`` or ``value`` is given along with a list of
+			  conditions.
+			- ``keep_missing_measurements`` is not a ``bool``.
+		ValueError
+			- A condition or ``combine`` is not recognized.
+
+		Notes
+		-----
+		All of the conditions are evaluated in the C library in a single pass
+		over the packed copy of the sample, which is constructed first if
+		necessary and is reused by subsequent likelihood calculations.
+
+		Example Code
+		------------
+		>>> import trackstar as ts
+		>>> import numpy as np
+		>>> s = ts.sample.from_arrays(np.random.random((1000, 2)), ["x", "y"])
+		>>> sub = s.filter([("x", ">", 0.5), ("y", "<=", 0.1)], combine = "or")
 		"""
-		cdef char *copy
+		cdef SAMPLE_CONDITION *conditions
 		cdef unsigned long *indices
-		if isinstance(label, str):
-			if isinstance(condition, str):
-				if isinstance(value, numbers.Number):
-					if isinstance(keep_missing_measurements, bool):
-						indicators = {
-							"=":   1,
-							"==":  1,
-							"<":   2,
-							"<=":  3,
-							">":   4,
-							">=":  5
-						}
-						if condition in indicators.keys():
-							copy = copy_pystring(label)
-							indices = sample_filter_indices(self._s[0],
-								copy, indicators[condition], value,
-								int(keep_missing_measurements))
-							assert indices is not NULL, "Internal Error."
-						else:
-							raise ValueError("""\
-Argument \'condition\' must be either \'=\', \'==\', \'<\', \'<=\', \'>\', \
-or \'>=\'. Got: %s""" % (condition))
-						sub = sample()
-						for i in range(1, indices[0]):
-							sub.add_datum(self._data[indices[i]])
-						if not sub.size: warnings.warn(
-							"Filter resulted in an empty sample.",
-							UserWarning)
-						return sub
-					else:
-						raise TypeError("""\
-Keyword arg \'keep_missing_measurements\' must be a boolean. Got: %s""" % (
-							type(keep_missing_measurements)))
-				else:
-					raise TypeError("""\
-Argument \'value\' must be a real number. Got: %s""" % (type(value)))
-			else:
-				raise TypeError("""\
-Argument \'condition\' must be a string. Got: %s""" % (type(condition)))
+		cdef sample sub
+		if isinstance(label, list):
+			if condition is not None or value is not None: raise TypeError("""\
+Arguments \'condition\' and \'value\' must be omitted when filtering on a \
+list of conditions.""")
+			else: pass
+			specs = label
 		else:
+			specs = [(label, condition, value)]
+		for spec in specs:
+			if not isinstance(spec, tuple) or len(spec) != 3:
+				raise TypeError("""\
+Each filter condition must be a tuple of a label, a condition, and a value. \
+Got: %s""" % (repr(spec)))
+			else: pass
+		indicators = [_filter_condition_(*spec) for spec in specs]
+		if not isinstance(keep_missing_measurements, bool):
 			raise TypeError("""\
+Keyword arg \'keep_missing_measurements\' must be a boolean. Got: %s""" % (
+				type(keep_missing_measurements)))
+		elif combine not in ["and", "or"]:
+			raise ValueError("""\
+Keyword arg \'combine\' must be either \'and\' or \'or\'. Got: %s""" % (
+				combine))
+		else: pass
+
+		self._refresh_()
+		conditions = <SAMPLE_CONDITION *> calloc (len(specs) + 1,
+			sizeof(SAMPLE_CONDITION))
+		try:
+			for i in range(len(specs)):
+				conditions[i].label = copy_pystring(specs[i][0])
+				conditions[i].condition_indicator = indicators[i]
+				conditions[i].value = specs[i][2]
+				conditions[i].keep_missing_measurements = int(
+					keep_missing_measurements)
+			indices = sample_filter_compound(self._s, conditions, len(specs),
+				SAMPLE_FILTER_ALL if combine == "and" else SAMPLE_FILTER_ANY)
+		finally:
+			for i in range(len(specs)): free(conditions[i].label)
+			free(conditions)
+		assert indices is not NULL, "Internal Error."
+		try:
+			sub = self._view_(indices)
+		finally:
+			free(indices)
+		if not sub.size: warnings.warn("Filter resulted in an empty sample.",
+			UserWarning)
+		return sub
+
+
+	def column(self, label):
+		r"""
+		Extract the measurements of one quantity for every datum in the
+		sample as a NumPy array.
+
+		Parameters
+		----------
+		label : ``str``
+			The label of the quantity.
+
+		Returns
+		-------
+		values : ``numpy.ndarray``
+			The measurements, in the order of the data in the sample, with
+			``NaN`` for the data without a measurement of ``label``. Unlike
+			``sample[label]``, this is a copy, so modifying it does not modify
+			the sample.
+
+		Raises
+		------
+		ModuleNotFoundError
+			- NumPy is not installed.
+		TypeError
+			- ``label`` is not a string.
+		KeyError
+			- No datum has a measurement of ``label``.
+		"""
+		cdef double[::1] _values
+		cdef char *copy
+		try:
+			import numpy as np
+		except ModuleNotFoundError:
+			raise ModuleNotFoundError("""\
+Cannot extract sample column as a NumPy array because NumPy was not found.""")
+		if not isinstance(label, str): raise TypeError("""\
+Sample column label must be of type str. Got: %s""" % (type(label)))
+		elif label not in self.keys(): raise KeyError(
+			"Sample quantity label %s not recognized." % (label))
+		else: pass
+		values = np.empty(self.size, dtype = np.float64)
+		if self.size:
+			self._refresh_()
+			_values = values
+			copy = copy_pystring(label)
+			try:
+				sample_column(self._s, copy, &_values[0])
+			finally:
+				free(copy)
+		else: pass
+		return values
+
+
+	def _uncertainty_scale_(self, labels):
+		# The smallest uncertainty on each of a list of quantities among the
+		# data (see sample_uncertainty_scale in ./src/sample.h), which
+		# trackstar.track.compress measures distances in units of. Quantities
+		# that no datum measures get float("inf").
+		cdef char *copy
+		self._refresh_()
+		scales = []
+		for label in labels:
+			copy = copy_pystring(label)
+			try:
+				scales.append(sample_uncertainty_scale(self._s, copy))
+			finally:
+				free(copy)
+		return scales
+
+
+def _filter_condition_(label, condition, value):
+	# Validates one condition passed to sample.filter, returning its
+	# condition indicator in the C library (see ./src/sample.h)
+	indicators = {
+		"=":   1,
+		"==":  1,
+		"<":   2,
+		"<=":  3,
+		">":   4,
+		">=":  5
+	}
+	if not isinstance(label, str):
+		raise TypeError("""\
 Argument \'label\' must be a string. Got: %s""" % (type(label)))
+	elif not isinstance(condition, str):
+		raise TypeError("""\
+Argument \'condition\' must be a string. Got: %s""" % (type(condition)))
+	elif not isinstance(value, numbers.Number):
+		raise TypeError("""\
+Argument \'value\' must be a real number. Got: %s""" % (type(value)))
+	elif condition not in indicators.keys():
+		raise ValueError("""\
+Argument \'condition\' must be either \'=\', \'==\', \'<\', \'<=\', \'>\', \
+or \'>=\'. Got: %s""" % (condition))
+	else:
+		return indicators[condition]
+
+
+def _line_segment_corrections_(normalize_weights,
+	use_line_segment_corrections):
+	# Validates the keyword args common to sample.loglikelihood and
+	# sample.loglikelihood_many, returning the value of
+	# use_line_segment_corrections in the C library (see ./src/likelihood.h)
+	if not isinstance(normalize_weights, bool):
+		raise TypeError("""\
+Keyword arg 'normalize_weights' must be of type bool. Got: %s""" % (
+			type(normalize_weights)))
+	else: pass
+	if isinstance(use_line_segment_corrections, bool):
+		# True -> closed form, False -> none
+		return int(use_line_segment_corrections)
+	elif use_line_segment_corrections == "quad":
+		# numerical quadrature, to validate the closed form
+		return 2
+	else:
+		raise TypeError("""\
+Keyword arg 'use_line_segment_corrections' must be of type bool or the \
+string "quad". Got: %s""" % (type(use_line_segment_corrections)))
 
 
 class sample_extra(list):
@@ -0,0 +1,104 @@
+/*
+This file is part of the TrackStar package.
+Copyright (C) 2023 James W. Johnson (giganano9@gmail.com)
+License: MIT License. See LICENSE in top-level directory
+at: https://github.com/giganano/TrackStar.git.
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include "arena.h"
+#include "debug.h"
+
+
+/*
+.. c:function:: extern ARENA *arena_initialize(void);
+
+	Allocate memory for and return a pointer to an :c:type:`ARENA` object,
+	which reserves no blocks until the first allocation is made from it.
+
+	Returns
+	-------
+	a : ``ARENA *``
+		The newly constructed arena.
+*/
+extern ARENA *arena_initialize(void) {
+
+	ARENA *a = (ARENA *) malloc (sizeof(ARENA));
+	a -> blocks = NULL;
+	a -> n_blocks = 0ul;
+	a -> size = 0ul;
+	a -> used = 0ul;
+	return a;
+
+}
+
+
+/*
+.. c:function:: extern void *arena_allocate(ARENA *a, const unsigned long n_bytes);
+
+	Allocate memory from an arena.
+
+	Parameters
+	----------
+	a : ``ARENA *``
+		The arena to allocate from.
+	n_bytes : ``const unsigned long``
+		The number of bytes to allocate.
+
+	Returns
+	-------
+	ptr : ``void *``
+		A pointer to ``n_bytes`` of memory, all of which are zero, aligned to
+		:c:macro:`ARENA_ALIGNMENT`. It must not be passed to ``free`` or
+		``realloc``; it remains valid until :c:func:`arena_free` is called.
+*/
+extern void *arena_allocate(ARENA *a, const unsigned long n_bytes) {
+
+	unsigned long n = (n_bytes + ARENA_ALIGNMENT - 1ul) / (
+		ARENA_ALIGNMENT) * ARENA_ALIGNMENT;
+	if (n > (*a).size - (*a).used) {
+		/*
+		The remainder of the current block is abandoned. Doubling the block
+		size keeps the fraction of memory lost this way small.
+		*/
+		unsigned long size = (*a).size ? 2ul * (*a).size : ARENA_BLOCK_SIZE;
+		if (size < n) size = n;
+		char *block = (char *) calloc (size, sizeof(char));
+		if (block == NULL) fatal_print("%s\n", "Arena allocation failed.");
+		a -> blocks = (char **) realloc (a -> blocks,
+			((*a).n_blocks + 1ul) * sizeof(char *));
+		a -> blocks[a -> n_blocks++] = block;
+		a -> size = size;
+		a -> used = 0ul;
+	} else {}
+	void *ptr = (*a).blocks[(*a).n_blocks - 1ul] + (*a).used;
+	a -> used += n;
+	return ptr;
+
+}
+
+
+/*
+.. c:function:: extern void arena_free(ARENA *a);
+
+	Free up the memory stored by an :c:type:`ARENA` object, including every
+	allocation that has been made from it.
+
+	Parameters
+	----------
+	a : ``ARENA *``
+		The arena to be freed. May be ``NULL``, in which case this function
+		does nothing.
+*/
+extern void arena_free(ARENA *a) {
+
+	if (a != NULL) {
+		for (unsigned long i = 0ul; i < (*a).n_blocks; i++) {
+			free(a -> blocks[i]);
+		}
+		free(a -> blocks);
+		free(a);
+	} else {}
+
+}
@@ -0,0 +1,131 @@
+/*
+This file is part of the TrackStar package.
+Copyright (C) 2023 James W. Johnson (giganano9@gmail.com)
+License: MIT License. See LICENSE in top-level directory
+at: https://github.com/giganano/TrackStar.git.
+
+**Source File**: ``trackstar/core/src/arena.c``
+*/
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+.. c:macro:: ARENA_ALIGNMENT
+
+	``16ul``. The alignment in bytes of every allocation made by
+	:c:func:`arena_allocate`, which suffices for any of the types stored in
+	TrackStar's objects.
+*/
+#define ARENA_ALIGNMENT 16ul
+
+/*
+.. c:macro:: ARENA_BLOCK_SIZE
+
+	``65536ul``. The size in bytes of the first block of memory reserved by an
+	:c:type:`ARENA`. Each subsequent block is twice as large as the one before
+	it, so building an object of :math:`N` elements takes
+	:math:`\mathcal{O}(\log N)` calls to ``calloc``.
+*/
+#define ARENA_BLOCK_SIZE 65536ul
+
+typedef struct arena {
+
+	/*
+	.. c:type:: ARENA
+
+		A bump allocator: a list of large blocks of memory from which many
+		small objects are allocated in turn, all of which are released
+		together by :c:func:`arena_free`.
+
+		Objects that make up a :c:type:`SAMPLE` (its data, their covariance
+		matrices, and their labels) are allocated from an arena owned by the
+		sample when they are constructed in the C library (see
+		:c:member:`SAMPLE.arena`). This replaces several calls to ``malloc``
+		and ``free`` per datum with a handful per sample, and it keeps the
+		data of a sample close together in memory rather than fragmenting the
+		heap of a long-running process.
+
+		.. c:member:: char **blocks
+
+			The blocks of memory themselves, each allocated with ``calloc``
+			such that all memory handed out by the arena starts as zero.
+
+		.. c:member:: unsigned long n_blocks
+
+			The number of elements in :c:member:`blocks`.
+
+		.. c:member:: unsigned long size
+
+			The size in bytes of the most recent block.
+
+		.. c:member:: unsigned long used
+
+			The number of bytes of the most recent block that have already
+			been allocated.
+	*/
+
+	char **blocks;
+	unsigned long n_blocks;
+	unsigned long size;
+	unsigned long used;
+
+} ARENA;
+
+/*
+.. c:function:: extern ARENA *arena_initialize(void);
+
+	Allocate memory for and return a pointer to an :c:type:`ARENA` object,
+	which reserves no blocks until the first allocation is made from it.
+
+	Returns
+	-------
+	a : ``ARENA *``
+		The newly constructed arena.
+*/
+extern ARENA *arena_initialize(void);
+
+/*
+.. c:function:: extern void *arena_allocate(ARENA *a, const unsigned long n_bytes);
+
+	Allocate memory from an arena.
+
+	Parameters
+	----------
+	a : ``ARENA *``
+		The arena to allocate from.
+	n_bytes : ``const unsigned long``
+		The number of bytes to allocate.
+
+	Returns
+	-------
+	ptr : ``void *``
+		A pointer to ``n_bytes`` of memory, all of which are zero, aligned to
+		:c:macro:`ARENA_ALIGNMENT`. It must not be passed to ``free`` or
+		``realloc``; it remains valid until :c:func:`arena_free` is called.
+*/
+extern void *arena_allocate(ARENA *a, const unsigned long n_bytes);
+
+/*
+.. c:function:: extern void arena_free(ARENA *a);
+
+	Free up the memory stored by an :c:type:`ARENA` object, including every
+	allocation that has been made from it.
+
+	Parameters
+	----------
+	a : ``ARENA *``
+		The arena to be freed. May be ``NULL``, in which case this function
+		does nothing.
+*/
+extern void arena_free(ARENA *a);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* ARENA_H */
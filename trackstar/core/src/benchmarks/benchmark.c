@@ -0,0 +1,819 @@
+/*
+This file is part of the TrackStar package.
+Copyright (C) 2023 James W. Johnson (giganano9@gmail.com)
+License: MIT License. See LICENSE in top-level directory
+at: https://github.com/giganano/TrackStar.git.
+
+Benchmarks of TrackStar's C library, timed natively without the python
+interpreter. Each benchmark is repeated a number of times after a warm-up
+call, and the percentiles of the time per call are written to a JSON file,
+which ``compare.py`` compares against a baseline. See the Makefile in this
+directory for the targets that run them.
+
+Usage: ``./benchmark [-r repeat] [-o output] [-f filter]``
+
+	- ``-r``: The number of timed samples of each benchmark (default: 25).
+	- ``-o``: The JSON file to write to (default: standard output).
+	- ``-f``: Only run the benchmarks whose names contain this string.
+
+The ``loglikelihood_precision`` benchmarks also record the log-likelihood
+computed in each precision and its error relative to double precision, which
+``compare.py`` lists after the timings.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include <math.h>
+#include "../multithread.h"
+#include "../blas.h"
+#include "../matrix.h"
+#include "../datum.h"
+#include "../sample.h"
+#include "../track.h"
+#include "../likelihood.h"
+#include "../engine.h"
+#include "../quadrature.h"
+
+/*
+The version of the JSON format written by this program, which compare.py
+checks before comparing two files.
+*/
+#define BENCHMARK_FORMAT_VERSION 1u
+
+/*
+The minimum duration of each timed sample in nanoseconds. Functions that
+return faster than this are called repeatedly within each sample, and the
+time per call is reported.
+*/
+#define BENCHMARK_MIN_SAMPLE_NS 1000000ull
+
+/* The longest name or parameter list of a benchmark. */
+#define BENCHMARK_NAME_SIZE 256u
+
+typedef struct benchmark_output {
+
+	/*
+	The destination of the results and the settings of the run.
+
+	stream : The JSON file.
+	repeat : The number of timed samples of each benchmark.
+	filter : Only benchmarks whose names contain this string are run. NULL
+		to run every benchmark.
+	n_results : The number of benchmarks written so far.
+	*/
+
+	FILE *stream;
+	unsigned short repeat;
+	const char *filter;
+	unsigned long n_results;
+
+} BENCHMARK_OUTPUT;
+
+/*
+The state of a benchmark of loglikelihood_sample or loglikelihood_datum: a
+sample (of which only the first datum is used for the latter) and a track.
+*/
+struct likelihood_state {
+	SAMPLE *sample;
+	TRACK *track;
+};
+
+/*
+The state of a benchmark of loglikelihood_engine: an engine partitioning the
+sample of a likelihood_state, and a context with its track.
+*/
+struct engine_state {
+	LIKELIHOOD_ENGINE *engine;
+	LIKELIHOOD_CONTEXT *context;
+};
+
+/*
+The state of a benchmark of loglikelihood_context_sample at a given
+precision: a packed sample, with its single precision copies made, and a
+context with the track of a likelihood_state.
+*/
+struct precision_state {
+	const PACKED_SAMPLE *packed;
+	LIKELIHOOD_CONTEXT *context;
+};
+
+/* The state of a benchmark of matrix_multiply or matrix_invert. */
+struct matrix_state {
+	MATRIX *a;
+	MATRIX *b;
+	MATRIX *result;
+};
+
+/* ---------- static function comment headers not duplicated here ---------- */
+static void benchmark_matrix_multiply(BENCHMARK_OUTPUT *out);
+static void benchmark_matrix_invert(BENCHMARK_OUTPUT *out);
+static void benchmark_quad(BENCHMARK_OUTPUT *out);
+static void benchmark_loglikelihood_datum(BENCHMARK_OUTPUT *out);
+static void benchmark_loglikelihood_sample(BENCHMARK_OUTPUT *out);
+static void benchmark_precision(BENCHMARK_OUTPUT *out);
+static void benchmark_sample_threads(BENCHMARK_OUTPUT *out,
+	const unsigned long n_data, const unsigned short n_points,
+	const double missing);
+static void benchmark_engine(BENCHMARK_OUTPUT *out, const char *name,
+	const char *parameters, struct likelihood_state *state,
+	const unsigned short n_threads);
+static void run_matrix_multiply(void *state);
+static void run_matrix_invert(void *state);
+static void run_quad(void *state);
+static void run_loglikelihood_datum(void *state);
+static void run_loglikelihood_sample(void *state);
+static void run_loglikelihood_engine(void *state);
+static void run_loglikelihood_precision(void *state);
+static double gaussian_integrand(double *args);
+static MATRIX *random_covariance(const unsigned short dim,
+	unsigned long *seed);
+static void likelihood_state_initialize(struct likelihood_state *state,
+	const unsigned long n_data, const unsigned short dim,
+	const unsigned short n_points, const double missing,
+	const unsigned short full_covariance);
+static void likelihood_state_free(struct likelihood_state *state);
+static unsigned short selected(const BENCHMARK_OUTPUT *out,
+	const char *name);
+static void measure(BENCHMARK_OUTPUT *out, const char *name,
+	const char *function, const char *parameters, void (*run)(void *),
+	void *state, const char *extra);
+static double percentile(const double *sorted, const unsigned short n,
+	const double q);
+static int compare_doubles(const void *a, const void *b);
+static unsigned long long nanoseconds(void);
+static double uniform(unsigned long *seed);
+
+/* The grids of each benchmark. */
+static const unsigned short MATRIX_SIZES[] = {3u, 8u, 16u, 32u, 64u};
+static const double QUAD_TOLERANCES[] = {1e-4, 1e-8, 1e-12};
+static const unsigned short DATUM_TRACK_SIZES[] = {100u, 1000u, 10000u};
+static const unsigned short DATUM_DIMENSIONS[] = {3u, 10u};
+static const unsigned long SAMPLE_SIZES[] = {1000ul, 10000ul};
+static const unsigned short SAMPLE_TRACK_SIZES[] = {100u, 1000u};
+static const unsigned short SAMPLE_THREADS[] = {1u, 2u, 4u};
+static const double SAMPLE_MISSING[] = {0, 0.25, 0.5};
+static const unsigned short PRECISIONS[] = {
+	LIKELIHOOD_PRECISION_DOUBLE, LIKELIHOOD_PRECISION_SINGLE
+};
+static const char *PRECISION_NAMES[] = {"double", "single"};
+#define GRID_SIZE(grid) (sizeof(grid) / sizeof(grid[0]))
+
+
+int main(int argc, char **argv) {
+
+	BENCHMARK_OUTPUT out;
+	out.stream = stdout;
+	out.repeat = 25u;
+	out.filter = NULL;
+	out.n_results = 0ul;
+	for (int i = 1; i < argc - 1; i += 2) {
+		if (!strcmp(argv[i], "-r")) {
+			out.repeat = (unsigned short) atoi(argv[i + 1]);
+		} else if (!strcmp(argv[i], "-o")) {
+			out.stream = fopen(argv[i + 1], "w");
+			if (out.stream == NULL) {
+				fprintf(stderr, "Could not open file: %s\n", argv[i + 1]);
+				return 1;
+			} else {}
+		} else if (!strcmp(argv[i], "-f")) {
+			out.filter = argv[i + 1];
+		} else {
+			fprintf(stderr, "Unrecognized option: %s\n", argv[i]);
+			return 1;
+		}
+	}
+	if (!out.repeat) out.repeat = 1u;
+
+	fprintf(out.stream, "{\n");
+	fprintf(out.stream, "\t\"version\": %u,\n", BENCHMARK_FORMAT_VERSION);
+	fprintf(out.stream, "\t\"openmp\": %s,\n",
+		multithreading_enabled() ? "true" : "false");
+	fprintf(out.stream, "\t\"blas\": %s,\n", blas_enabled() ? "true" : "false");
+	fprintf(out.stream, "\t\"repeat\": %u,\n", out.repeat);
+	fprintf(out.stream, "\t\"results\": [");
+	benchmark_matrix_multiply(&out);
+	benchmark_matrix_invert(&out);
+	benchmark_quad(&out);
+	benchmark_loglikelihood_datum(&out);
+	benchmark_loglikelihood_sample(&out);
+	benchmark_precision(&out);
+	fprintf(out.stream, "\n\t]\n}\n");
+	if (out.stream != stdout) fclose(out.stream);
+	return 0;
+
+}
+
+
+/*
+Benchmark matrix_multiply on square matrices of each of MATRIX_SIZES.
+*/
+static void benchmark_matrix_multiply(BENCHMARK_OUTPUT *out) {
+
+	char name[BENCHMARK_NAME_SIZE], parameters[BENCHMARK_NAME_SIZE];
+	unsigned long seed = 1ul;
+	for (unsigned short i = 0u; i < GRID_SIZE(MATRIX_SIZES); i++) {
+		const unsigned short n = MATRIX_SIZES[i];
+		snprintf(name, BENCHMARK_NAME_SIZE, "matrix_multiply/n=%u", n);
+		if (selected(out, name)) {
+			struct matrix_state state;
+			state.a = random_covariance(n, &seed);
+			state.b = random_covariance(n, &seed);
+			state.result = matrix_initialize(n, n);
+			snprintf(parameters, BENCHMARK_NAME_SIZE, "{\"n\": %u}", n);
+			measure(out, name, "matrix_multiply", parameters,
+				&run_matrix_multiply, &state, NULL);
+			matrix_free(state.a);
+			matrix_free(state.b);
+			matrix_free(state.result);
+		} else {}
+	}
+
+}
+
+
+/*
+Benchmark matrix_invert on symmetric positive definite matrices of each of
+MATRIX_SIZES.
+*/
+static void benchmark_matrix_invert(BENCHMARK_OUTPUT *out) {
+
+	char name[BENCHMARK_NAME_SIZE], parameters[BENCHMARK_NAME_SIZE];
+	unsigned long seed = 2ul;
+	for (unsigned short i = 0u; i < GRID_SIZE(MATRIX_SIZES); i++) {
+		const unsigned short n = MATRIX_SIZES[i];
+		snprintf(name, BENCHMARK_NAME_SIZE, "matrix_invert/n=%u", n);
+		if (selected(out, name)) {
+			struct matrix_state state;
+			state.a = random_covariance(n, &seed);
+			state.b = NULL;
+			state.result = matrix_initialize(n, n);
+			snprintf(parameters, BENCHMARK_NAME_SIZE, "{\"n\": %u}", n);
+			measure(out, name, "matrix_invert", parameters, &run_matrix_invert,
+				&state, NULL);
+			matrix_free(state.a);
+			matrix_free(state.result);
+		} else {}
+	}
+
+}
+
+
+/*
+Benchmark quad on the integral of a Gaussian from 0 to 3 at each of
+QUAD_TOLERANCES.
+*/
+static void benchmark_quad(BENCHMARK_OUTPUT *out) {
+
+	char name[BENCHMARK_NAME_SIZE], parameters[BENCHMARK_NAME_SIZE];
+	for (unsigned short i = 0u; i < GRID_SIZE(QUAD_TOLERANCES); i++) {
+		snprintf(name, BENCHMARK_NAME_SIZE, "quad/tolerance=%g",
+			QUAD_TOLERANCES[i]);
+		if (selected(out, name)) {
+			INTEGRAL intgrl;
+			intgrl.func = &gaussian_integrand;
+			intgrl.lower = 0;
+			intgrl.upper = 3;
+			intgrl.tolerance = QUAD_TOLERANCES[i];
+			intgrl.n_min = 64ul;
+			intgrl.n_max = 1ul << 24u;
+			intgrl.extra_args = NULL;
+			intgrl.n_extra_args = 0u;
+			snprintf(parameters, BENCHMARK_NAME_SIZE, "{\"tolerance\": %g}",
+				QUAD_TOLERANCES[i]);
+			measure(out, name, "quad", parameters, &run_quad, &intgrl, NULL);
+		} else {}
+	}
+
+}
+
+
+/*
+Benchmark loglikelihood_datum for a datum with a full covariance matrix
+against tracks of each of DATUM_TRACK_SIZES, in each of DATUM_DIMENSIONS.
+*/
+static void benchmark_loglikelihood_datum(BENCHMARK_OUTPUT *out) {
+
+	char name[BENCHMARK_NAME_SIZE], parameters[BENCHMARK_NAME_SIZE];
+	for (unsigned short i = 0u; i < GRID_SIZE(DATUM_TRACK_SIZES); i++) {
+		for (unsigned short j = 0u; j < GRID_SIZE(DATUM_DIMENSIONS); j++) {
+			snprintf(name, BENCHMARK_NAME_SIZE,
+				"loglikelihood_datum/n_points=%u/dim=%u",
+				DATUM_TRACK_SIZES[i], DATUM_DIMENSIONS[j]);
+			if (selected(out, name)) {
+				struct likelihood_state state;
+				likelihood_state_initialize(&state, 1ul, DATUM_DIMENSIONS[j],
+					DATUM_TRACK_SIZES[i], 0, 1u);
+				snprintf(parameters, BENCHMARK_NAME_SIZE,
+					"{\"n_points\": %u, \"dim\": %u}", DATUM_TRACK_SIZES[i],
+					DATUM_DIMENSIONS[j]);
+				measure(out, name, "loglikelihood_datum", parameters,
+					&run_loglikelihood_datum, &state, NULL);
+				likelihood_state_free(&state);
+			} else {}
+		}
+	}
+
+}
+
+
+/*
+Benchmark loglikelihood_sample for three-dimensional samples of each of
+SAMPLE_SIZES against tracks of each of SAMPLE_TRACK_SIZES, with each fraction
+of SAMPLE_MISSING of the measurements of the second and third quantities
+missing at random.
+*/
+static void benchmark_loglikelihood_sample(BENCHMARK_OUTPUT *out) {
+
+	for (unsigned short i = 0u; i < GRID_SIZE(SAMPLE_SIZES); i++) {
+		for (unsigned short j = 0u; j < GRID_SIZE(SAMPLE_TRACK_SIZES); j++) {
+			for (unsigned short k = 0u; k < GRID_SIZE(SAMPLE_MISSING); k++) {
+				benchmark_sample_threads(out, SAMPLE_SIZES[i],
+					SAMPLE_TRACK_SIZES[j], SAMPLE_MISSING[k]);
+			}
+		}
+	}
+
+}
+
+
+/*
+Benchmark loglikelihood_sample and loglikelihood_engine for one sample and
+track with each of SAMPLE_THREADS (only one without OpenMP), constructing them
+only if at least one of these benchmarks is selected.
+
+out : The output.
+n_data : The number of data in the sample.
+n_points : The number of points along the track.
+missing : The probability that each measurement of the second and third
+	quantities is missing.
+*/
+static void benchmark_sample_threads(BENCHMARK_OUTPUT *out,
+	const unsigned long n_data, const unsigned short n_points,
+	const double missing) {
+
+	char name[BENCHMARK_NAME_SIZE], parameters[BENCHMARK_NAME_SIZE];
+	const unsigned short n_thread_counts = multithreading_enabled() ?
+		GRID_SIZE(SAMPLE_THREADS) : 1u;
+	struct likelihood_state state;
+	state.sample = NULL;
+	for (unsigned short i = 0u; i < n_thread_counts; i++) {
+		snprintf(parameters, BENCHMARK_NAME_SIZE,
+			"{\"n_data\": %lu, \"n_points\": %u, \"threads\": %u, "
+			"\"missing\": %g}", n_data, n_points, SAMPLE_THREADS[i],
+			missing);
+		snprintf(name, BENCHMARK_NAME_SIZE,
+			"loglikelihood_sample/n_data=%lu/n_points=%u/threads=%u/"
+			"missing=%g", n_data, n_points, SAMPLE_THREADS[i], missing);
+		if (selected(out, name)) {
+			if (state.sample == NULL) {
+				likelihood_state_initialize(&state, n_data, 3u, n_points,
+					missing, 0u);
+			} else {}
+			state.track -> n_threads = SAMPLE_THREADS[i];
+			measure(out, name, "loglikelihood_sample", parameters,
+				&run_loglikelihood_sample, &state, NULL);
+		} else {}
+		snprintf(name, BENCHMARK_NAME_SIZE,
+			"loglikelihood_engine/n_data=%lu/n_points=%u/threads=%u/"
+			"missing=%g", n_data, n_points, SAMPLE_THREADS[i], missing);
+		if (selected(out, name)) {
+			if (state.sample == NULL) {
+				likelihood_state_initialize(&state, n_data, 3u, n_points,
+					missing, 0u);
+			} else {}
+			benchmark_engine(out, name, parameters, &state,
+				SAMPLE_THREADS[i]);
+		} else {}
+	}
+	if (state.sample != NULL) likelihood_state_free(&state);
+
+}
+
+
+/*
+Benchmark loglikelihood_context_sample with one thread in each of PRECISIONS
+for three-dimensional samples of each of SAMPLE_SIZES against tracks of each
+of SAMPLE_TRACK_SIZES, with a quarter of the measurements of the second and
+third quantities missing. Each result also records the log-likelihood and
+its error relative to the one computed in double precision.
+*/
+static void benchmark_precision(BENCHMARK_OUTPUT *out) {
+
+	char name[BENCHMARK_NAME_SIZE], parameters[BENCHMARK_NAME_SIZE];
+	char extra[BENCHMARK_NAME_SIZE];
+	for (unsigned short i = 0u; i < GRID_SIZE(SAMPLE_SIZES); i++) {
+		for (unsigned short j = 0u; j < GRID_SIZE(SAMPLE_TRACK_SIZES); j++) {
+			struct likelihood_state state;
+			struct precision_state precision;
+			double reference = 0;
+			state.sample = NULL;
+			for (unsigned short k = 0u; k < GRID_SIZE(PRECISIONS); k++) {
+				snprintf(name, BENCHMARK_NAME_SIZE,
+					"loglikelihood_precision/n_data=%lu/n_points=%u/"
+					"precision=%s", SAMPLE_SIZES[i], SAMPLE_TRACK_SIZES[j],
+					PRECISION_NAMES[k]);
+				if (selected(out, name)) {
+					if (state.sample == NULL) {
+						likelihood_state_initialize(&state, SAMPLE_SIZES[i],
+							3u, SAMPLE_TRACK_SIZES[j], 0.25, 0u);
+						PACKED_SAMPLE *packed = sample_pack(state.sample);
+						packed_sample_single(packed);
+						precision.packed = packed;
+						precision.context = likelihood_context_initialize(
+							state.track);
+						reference = loglikelihood_context_sample(
+							precision.context, precision.packed);
+					} else {}
+					precision.context -> precision = PRECISIONS[k];
+					const double logl = loglikelihood_context_sample(
+						precision.context, precision.packed);
+					snprintf(parameters, BENCHMARK_NAME_SIZE,
+						"{\"n_data\": %lu, \"n_points\": %u, "
+						"\"precision\": \"%s\"}", SAMPLE_SIZES[i],
+						SAMPLE_TRACK_SIZES[j], PRECISION_NAMES[k]);
+					snprintf(extra, BENCHMARK_NAME_SIZE,
+						"\"accuracy\": {\"logl\": %.17g, "
+						"\"reference\": %.17g, \"relative_error\": %.6g}",
+						logl, reference, fabs(logl - reference) / fabs(
+						reference));
+					measure(out, name, "loglikelihood_context_sample",
+						parameters, &run_loglikelihood_precision, &precision,
+						extra);
+				} else {}
+			}
+			if (state.sample != NULL) {
+				likelihood_context_free(precision.context);
+				likelihood_state_free(&state);
+			} else {}
+		}
+	}
+
+}
+
+
+/*
+Benchmark loglikelihood_engine for the sample and track of a likelihood
+benchmark, partitioning the sample beforehand.
+
+out : The output.
+name : The name of the benchmark.
+parameters : The parameters of the benchmark, as a JSON object.
+state : The sample and track.
+n_threads : The number of threads to partition the sample among.
+*/
+static void benchmark_engine(BENCHMARK_OUTPUT *out, const char *name,
+	const char *parameters, struct likelihood_state *state,
+	const unsigned short n_threads) {
+
+	struct engine_state engine;
+	engine.engine = likelihood_engine_initialize(sample_pack((*state).sample),
+		n_threads);
+	engine.context = likelihood_context_initialize((*state).track);
+	measure(out, name, "loglikelihood_engine", parameters,
+		&run_loglikelihood_engine, &engine, NULL);
+	likelihood_context_free(engine.context);
+	likelihood_engine_free(engine.engine);
+
+}
+
+
+/*
+Multiply the two matrices of a benchmark state.
+*/
+static void run_matrix_multiply(void *state) {
+
+	struct matrix_state *s = (struct matrix_state *) state;
+	matrix_multiply(*(*s).a, *(*s).b, (*s).result);
+
+}
+
+
+/*
+Invert the first matrix of a benchmark state.
+*/
+static void run_matrix_invert(void *state) {
+
+	struct matrix_state *s = (struct matrix_state *) state;
+	matrix_invert(*(*s).a, (*s).result);
+
+}
+
+
+/*
+Evaluate the integral of a benchmark.
+*/
+static void run_quad(void *state) {
+
+	quad((INTEGRAL *) state);
+
+}
+
+
+/*
+Compute the likelihood of the first datum of a benchmark state.
+*/
+static void run_loglikelihood_datum(void *state) {
+
+	struct likelihood_state *s = (struct likelihood_state *) state;
+	loglikelihood_datum(*sample_datum((*s).sample, 0ul), (*s).track);
+
+}
+
+
+/*
+Compute the likelihood of the sample of a benchmark state.
+*/
+static void run_loglikelihood_sample(void *state) {
+
+	struct likelihood_state *s = (struct likelihood_state *) state;
+	loglikelihood_sample((*s).sample, (*s).track);
+
+}
+
+
+/*
+Compute the likelihood of the sample of an engine benchmark.
+*/
+static void run_loglikelihood_engine(void *state) {
+
+	struct engine_state *s = (struct engine_state *) state;
+	loglikelihood_engine((*s).engine, (*s).context);
+
+}
+
+
+/*
+Compute the likelihood of the packed sample of a precision benchmark with
+the precision of its context.
+*/
+static void run_loglikelihood_precision(void *state) {
+
+	struct precision_state *s = (struct precision_state *) state;
+	loglikelihood_context_sample((*s).context, (*s).packed);
+
+}
+
+
+/*
+The integrand exp(-x^2 / 2), with x = args[0].
+*/
+static double gaussian_integrand(double *args) {
+
+	return exp(-0.5 * args[0] * args[0]);
+
+}
+
+
+/*
+Construct a random symmetric positive definite matrix: a diagonal of
+variances between 0.01 and 0.04 with correlations of up to 0.5 / dim between
+every pair of components, which keeps it diagonally dominant.
+*/
+static MATRIX *random_covariance(const unsigned short dim,
+	unsigned long *seed) {
+
+	MATRIX *m = matrix_initialize(dim, dim);
+	double *sigma = (double *) malloc (dim * sizeof(double));
+	for (unsigned short i = 0u; i < dim; i++) {
+		sigma[i] = 0.1 + 0.1 * uniform(seed);
+	}
+	for (unsigned short i = 0u; i < dim; i++) {
+		m -> matrix[i][i] = sigma[i] * sigma[i];
+		for (unsigned short j = 0u; j < i; j++) {
+			const double rho = (uniform(seed) - 0.5) / dim;
+			m -> matrix[i][j] = rho * sigma[i] * sigma[j];
+			m -> matrix[j][i] = (*m).matrix[i][j];
+		}
+	}
+	free(sigma);
+	return m;
+
+}
+
+
+/*
+Construct a random sample and a track through the same space, along the
+curve x_k = q^(k + 1) for 0 <= q <= 1 with weights that increase along it.
+
+state : The benchmark state to fill.
+n_data : The number of data.
+dim : The number of quantities.
+n_points : The number of points along the track.
+missing : The probability that each measurement other than the first
+	quantity is missing.
+full_covariance : Nonzero to give every datum a random, correlated covariance
+	matrix, and zero for diagonal covariance matrices constructed with
+	sample_from_arrays.
+*/
+static void likelihood_state_initialize(struct likelihood_state *state,
+	const unsigned long n_data, const unsigned short dim,
+	const unsigned short n_points, const double missing,
+	const unsigned short full_covariance) {
+
+	unsigned long seed = 12345ul;
+	char **labels = (char **) malloc (dim * sizeof(char *));
+	for (unsigned short k = 0u; k < dim; k++) {
+		labels[k] = (char *) malloc (MAX_LABEL_SIZE * sizeof(char));
+		snprintf(labels[k], MAX_LABEL_SIZE, "x%u", k);
+	}
+
+	const unsigned long n = n_data * dim;
+	double *values = (double *) malloc (n * sizeof(double));
+	double *errors = (double *) malloc (n * sizeof(double));
+	unsigned char *mask = (unsigned char *) malloc (n * sizeof(unsigned char));
+	for (unsigned long i = 0ul; i < n_data; i++) {
+		const double q = uniform(&seed);
+		for (unsigned short k = 0u; k < dim; k++) {
+			errors[i * dim + k] = 0.02 + 0.03 * uniform(&seed);
+			values[i * dim + k] = pow(q, k + 1u) + errors[i * dim + k] * (
+				uniform(&seed) - 0.5);
+			mask[i * dim + k] = !k || uniform(&seed) >= missing;
+		}
+	}
+	state -> sample = sample_from_arrays(values, errors, mask, labels, n_data,
+		dim);
+	if (full_covariance) {
+		for (unsigned long i = 0ul; i < n_data; i++) {
+			DATUM *d = sample_datum((*state).sample, i);
+			MATRIX *cov = random_covariance((*d).n_cols, &seed);
+			for (unsigned short j = 0u; j < (*d).n_cols; j++) {
+				for (unsigned short k = 0u; k < (*d).n_cols; k++) {
+					d -> cov -> matrix[j][k] = (*cov).matrix[j][k];
+				}
+			}
+			covariance_matrix_update(d -> cov);
+			matrix_free(cov);
+		}
+		sample_invalidate((*state).sample);
+	} else {}
+
+	state -> track = track_initialize(n_points, dim);
+	for (unsigned short k = 0u; k < dim; k++) {
+		track_set_label((*state).track, k, labels[k]);
+	}
+	for (unsigned short j = 0u; j < n_points; j++) {
+		const double q = (double) j / (n_points - 1u);
+		for (unsigned short k = 0u; k < dim; k++) {
+			state -> track -> predictions[j][k] = pow(q, k + 1u);
+		}
+		state -> track -> weights[j] = 1 + q;
+	}
+
+	for (unsigned short k = 0u; k < dim; k++) free(labels[k]);
+	free(labels);
+	free(values);
+	free(errors);
+	free(mask);
+
+}
+
+
+/*
+Free the sample and the track of a benchmark of the likelihood.
+*/
+static void likelihood_state_free(struct likelihood_state *state) {
+
+	sample_free_everything(state -> sample);
+	track_free(state -> track);
+	state -> sample = NULL;
+	state -> track = NULL;
+
+}
+
+
+/*
+Determine whether or not to run the benchmark with a given name according to
+the filter of the run.
+*/
+static unsigned short selected(const BENCHMARK_OUTPUT *out,
+	const char *name) {
+
+	return (*out).filter == NULL || strstr(name, (*out).filter) != NULL;
+
+}
+
+
+/*
+Time a benchmark and write its results to the output.
+
+out : The output.
+name : The name of the benchmark, which identifies it in compare.py.
+function : The name of the function being benchmarked.
+parameters : A JSON object of the parameters of the benchmark.
+run : A function that executes the benchmark once.
+state : The argument to pass to run.
+extra : Additional members of the JSON object of the result (e.g.,
+	"\"accuracy\": {...}"), or NULL if there are none.
+
+After one warm-up call, the number of calls per sample is doubled until a
+single sample takes at least BENCHMARK_MIN_SAMPLE_NS. Each of out -> repeat
+samples is then timed, and the time per call within each is summarized by
+its minimum, maximum, mean, and 10th, 50th, 90th, and 99th percentiles.
+*/
+static void measure(BENCHMARK_OUTPUT *out, const char *name,
+	const char *function, const char *parameters, void (*run)(void *),
+	void *state, const char *extra) {
+
+	run(state);
+	unsigned long iterations = 1ul;
+	unsigned long long start, elapsed;
+	do {
+		start = nanoseconds();
+		for (unsigned long i = 0ul; i < iterations; i++) run(state);
+		elapsed = nanoseconds() - start;
+		if (elapsed < BENCHMARK_MIN_SAMPLE_NS) iterations *= 2ul;
+	} while (elapsed < BENCHMARK_MIN_SAMPLE_NS);
+
+	double *samples = (double *) malloc ((*out).repeat * sizeof(double));
+	double mean = 0;
+	for (unsigned short i = 0u; i < (*out).repeat; i++) {
+		start = nanoseconds();
+		for (unsigned long j = 0ul; j < iterations; j++) run(state);
+		samples[i] = (double) (nanoseconds() - start) / iterations;
+		mean += samples[i] / (*out).repeat;
+	}
+	qsort(samples, (*out).repeat, sizeof(double), &compare_doubles);
+
+	fprintf((*out).stream, "%s\n\t\t{\n", (*out).n_results ? "," : "");
+	fprintf((*out).stream, "\t\t\t\"name\": \"%s\",\n", name);
+	fprintf((*out).stream, "\t\t\t\"function\": \"%s\",\n", function);
+	fprintf((*out).stream, "\t\t\t\"parameters\": %s,\n", parameters);
+	fprintf((*out).stream, "\t\t\t\"iterations\": %lu,\n", iterations);
+	fprintf((*out).stream, "\t\t\t\"ns\": {\"min\": %.6g, \"p10\": %.6g, "
+		"\"p50\": %.6g, \"p90\": %.6g, \"p99\": %.6g, \"max\": %.6g, "
+		"\"mean\": %.6g}", samples[0],
+		percentile(samples, (*out).repeat, 0.1),
+		percentile(samples, (*out).repeat, 0.5),
+		percentile(samples, (*out).repeat, 0.9),
+		percentile(samples, (*out).repeat, 0.99),
+		samples[(*out).repeat - 1u], mean);
+	if (extra != NULL) {
+		fprintf((*out).stream, ",\n\t\t\t%s\n", extra);
+	} else {
+		fprintf((*out).stream, "\n");
+	}
+	fprintf((*out).stream, "\t\t}");
+	fflush((*out).stream);
+	fprintf(stderr, "%-72s %12.6g ns\n", name,
+		percentile(samples, (*out).repeat, 0.5));
+	out -> n_results++;
+	free(samples);
+
+}
+
+
+/*
+Compute a percentile of n sorted values, interpolating linearly between
+them.
+*/
+static double percentile(const double *sorted, const unsigned short n,
+	const double q) {
+
+	const double position = q * (n - 1u);
+	const unsigned short below = (unsigned short) position;
+	if (below + 1u < n) {
+		return sorted[below] + (position - below) * (
+			sorted[below + 1u] - sorted[below]);
+	} else {
+		return sorted[n - 1u];
+	}
+
+}
+
+
+/*
+Compare two doubles for qsort.
+*/
+static int compare_doubles(const void *a, const void *b) {
+
+	const double x = *((const double *) a), y = *((const double *) b);
+	return (x > y) - (x < y);
+
+}
+
+
+/*
+Read the monotonic clock in nanoseconds.
+*/
+static unsigned long long nanoseconds(void) {
+
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return 1000000000ull * (unsigned long long) t.tv_sec + (
+		unsigned long long) t.tv_nsec;
+
+}
+
+
+/*
+Draw a pseudo-random number uniformly between 0 and 1 from a linear
+congruential generator, such that every run benchmarks the same data.
+*/
+static double uniform(unsigned long *seed) {
+
+	*seed = *seed * 6364136223846793005ul + 1442695040888963407ul;
+	return (double) (*seed >> 11u) / (double) (1ul << 53u);
+
+}
@@ -0,0 +1,153 @@
+#!/usr/bin/env python
+#
+# This file is part of the TrackStar package.
+# Copyright (C) 2023 James W. Johnson (giganano9@gmail.com)
+# License: MIT License. See LICENSE in top-level directory
+# at: https://github.com/giganano/TrackStar.git.
+r"""
+Compares the results of the native benchmarks in this directory against a
+baseline, matching benchmarks by name and comparing the median time per call.
+Exits with status 1 if any benchmark is slower than the baseline by more than
+the tolerance.
+
+Usage: ``python compare.py baseline.json results.json [--tolerance 0.1]``
+"""
+
+import argparse
+import json
+import sys
+
+_FORMAT_VERSION_ = 1
+
+
+def main(argv = None):
+	parser = argparse.ArgumentParser(
+		description = "Compare native benchmark results against a baseline.")
+	parser.add_argument("baseline", help = "The baseline JSON file.")
+	parser.add_argument("results", help = "The JSON file of new results.")
+	parser.add_argument("--tolerance", type = float, default = 0.1,
+		help = "The largest fractional slowdown of the median time per call \
+that is not a regression (default: 0.1).")
+	args = parser.parse_args(argv)
+	baseline = load(args.baseline)
+	results = load(args.results)
+	for key in ["openmp", "blas"]:
+		if baseline[key] != results[key]:
+			print("Warning: %s is %s in the baseline but %s in the results." % (
+				key, baseline[key], results[key]))
+		else: pass
+	regressions = compare(baseline, results, args.tolerance)
+	accuracy(results)
+	if regressions:
+		print("%d benchmark(s) slower than the baseline by more than %g%%." % (
+			len(regressions), 100 * args.tolerance))
+		return 1
+	else:
+		print("No regressions beyond %g%%." % (100 * args.tolerance))
+		return 0
+
+
+def load(filename):
+	r"""
+	Read the results of a run of the native benchmarks.
+
+	Parameters
+	----------
+	filename : ``str``
+		The JSON file written by ``benchmark``.
+
+	Returns
+	-------
+	results : ``dict``
+		The contents of the file, with the list of results replaced by a
+		dictionary from the name of each benchmark to its result.
+
+	Raises
+	------
+	* ValueError
+		- The file was written by an incompatible version of ``benchmark``.
+	"""
+	with open(filename, "r") as f:
+		contents = json.load(f)
+	if contents.get("version") != _FORMAT_VERSION_:
+		raise ValueError("%s: Unrecognized format version: %s" % (filename,
+			contents.get("version")))
+	else: pass
+	contents["results"] = dict((result["name"], result) for result in
+		contents["results"])
+	return contents
+
+
+def compare(baseline, results, tolerance):
+	r"""
+	Print a table comparing the median time per call of each benchmark
+	against the baseline.
+
+	Parameters
+	----------
+	baseline : ``dict``
+		The baseline, as returned by ``load``.
+	results : ``dict``
+		The new results, as returned by ``load``.
+	tolerance : ``float``
+		The largest fractional slowdown that is not a regression.
+
+	Returns
+	-------
+	regressions : ``list``
+		The names of the benchmarks slower than the baseline by more than
+		the tolerance.
+	"""
+	regressions = []
+	width = max([len(name) for name in results["results"]] + [9])
+	print("%-*s %14s %14s %8s" % (width, "benchmark", "baseline [ns]",
+		"result [ns]", "ratio"))
+	for name, result in results["results"].items():
+		if name in baseline["results"]:
+			before = baseline["results"][name]["ns"]["p50"]
+			after = result["ns"]["p50"]
+			ratio = after / before if before > 0 else float("inf")
+			if ratio > 1 + tolerance:
+				flag = "  REGRESSION"
+				regressions.append(name)
+			elif ratio < 1 - tolerance:
+				flag = "  improvement"
+			else:
+				flag = ""
+			print("%-*s %14.6g %14.6g %8.3f%s" % (width, name, before, after,
+				ratio, flag))
+		else:
+			print("%-*s %14s %14.6g %8s" % (width, name, "-",
+				result["ns"]["p50"], "new"))
+	for name in baseline["results"]:
+		if name not in results["results"]:
+			print("%-*s %14.6g %14s %8s" % (width, name,
+				baseline["results"][name]["ns"]["p50"], "-", "missing"))
+		else: pass
+	return regressions
+
+
+def accuracy(results):
+	r"""
+	Print the error relative to double precision of each benchmark that
+	records one (i.e., the ``loglikelihood_precision`` benchmarks).
+
+	Parameters
+	----------
+	results : ``dict``
+		The results, as returned by ``load``.
+	"""
+	names = [name for name, result in results["results"].items() if
+		"accuracy" in result]
+	if names:
+		width = max([len(name) for name in names] + [9])
+		print("%-*s %24s %14s" % (width, "benchmark", "logl",
+			"relative error"))
+		for name in names:
+			result = results["results"][name]["accuracy"]
+			print("%-*s %24.17g %14.3e" % (width, name, result["logl"],
+				result["relative_error"]))
+	else: pass
+
+
+if __name__ == "__main__": sys.exit(main())
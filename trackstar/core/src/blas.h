@@ -0,0 +1,69 @@
+/*
+This file is part of the TrackStar package.
+Copyright (C) 2023 James W. Johnson (giganano9@gmail.com)
+License: MIT License. See LICENSE in top-level directory
+at: https://github.com/giganano/TrackStar.git.
+*/
+
+#ifndef BLAS_H
+#define BLAS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+.. c:macro:: BLAS_MIN_DIMENSION
+
+	``9u``. The smallest dimension of a matrix for which the routines in
+	``matrix.c`` call the BLAS and LAPACK libraries, if TrackStar was linked
+	with them at compile time (see :c:func:`blas_enabled`). Below this size,
+	the hand-written routines are faster than the overhead of the library
+	call, and they remain the only implementation when TrackStar is not
+	linked with a BLAS library. The chi-squared kernels use BLAS for exactly
+	the dimensionalities without an unrolled kernel (see
+	:c:macro:`CHI_SQUARED_MAX_UNROLLED`).
+*/
+#ifndef BLAS_MIN_DIMENSION
+#define BLAS_MIN_DIMENSION 9u
+#endif /* BLAS_MIN_DIMENSION */
+
+#if defined(TRACKSTAR_BLAS)
+	#include <cblas.h>
+
+	/*
+	Not every BLAS distribution ships the lapacke.h header, so the few LAPACK
+	routines that TrackStar calls are declared with their Fortran interface,
+	which every distribution exports. All arguments are passed by reference
+	and matrices are column-major.
+	*/
+	extern void dgetrf_(const int *m, const int *n, double *a, const int *lda,
+		int *ipiv, int *info);
+	extern void dgetri_(const int *n, double *a, const int *lda,
+		const int *ipiv, double *work, const int *lwork, int *info);
+	extern void dpotrf_(const char *uplo, const int *n, double *a,
+		const int *lda, int *info);
+	extern void dpotri_(const char *uplo, const int *n, double *a,
+		const int *lda, int *info);
+#endif /* TRACKSTAR_BLAS */
+
+/*
+.. c:function:: inline unsigned short blas_enabled();
+
+	Returns 1 if TrackStar was linked with a BLAS and LAPACK library at
+	compile time and 0 otherwise. The setup script defines
+	``TRACKSTAR_BLAS`` when it finds one (see :ref:`blas`).
+*/
+inline unsigned short blas_enabled(void) {
+	#if defined(TRACKSTAR_BLAS)
+		return 1u;
+	#else
+		return 0u;
+	#endif
+}
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* BLAS_H */
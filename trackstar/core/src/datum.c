@@ -10,6 +10,8 @@ at: https://github.com/giganano/TrackStar.git.
 #include <stdio.h>
 #include "datum.h"
 #include "matrix.h"
+#include "arena.h"
+#include "labels.h"
 #include "utils.h"
 
 
@@ -34,15 +36,75 @@ extern DATUM *datum_initialize(unsigned short dim) {
 	DATUM *d = (DATUM *) matrix_initialize(1u, dim);
 	d = (DATUM *) realloc (d, sizeof(DATUM));
 	d -> labels = (char **) malloc (dim * sizeof(char *));
+	d -> ids = (unsigned short *) malloc (dim * sizeof(unsigned short));
 	for (unsigned short i = 0u; i < dim; i++) {
-		d -> labels[i] = (char *) malloc (MAX_LABEL_SIZE * sizeof(char));
-		memset(d -> labels[i], '\0', MAX_LABEL_SIZE);
+		d -> labels[i] = NULL;
+		d -> ids[i] = 0u;
 	}
+	d -> mask = 0ul;
 	return d;
 
 }
 
 
+/*
+.. c:function:: extern DATUM *datum_arena_initialize(ARENA *a, const unsigned short dim);
+
+	Allocate a :c:type:`DATUM` and its labels from an arena.
+
+	Parameters
+	----------
+	a : ``ARENA *``
+		The arena to allocate from.
+	dim : ``const unsigned short``
+		The dimensionality of the data vector.
+
+	Returns
+	-------
+	d : ``DATUM *``
+		The newly constructed data vector, initialized like one constructed by
+		:c:func:`datum_initialize`, and with :c:member:`cov` set to ``NULL``.
+		It belongs to the arena, and so should its covariance matrix (see
+		:c:func:`covariance_matrix_arena_initialize`); neither must be passed
+		to :c:func:`datum_free` or :c:func:`datum_free_everything`.
+*/
+extern DATUM *datum_arena_initialize(ARENA *a, const unsigned short dim) {
+
+	DATUM *d = (DATUM *) matrix_arena_initialize(a, sizeof(DATUM), 1u, dim);
+	d -> labels = (char **) arena_allocate(a, dim * sizeof(char *));
+	d -> ids = (unsigned short *) arena_allocate(a,
+		dim * sizeof(unsigned short));
+	return d;
+
+}
+
+
+/*
+.. c:function:: extern void datum_set_label(DATUM *d, unsigned short index, const char *label);
+
+	Assign the label of one of the components of a data vector.
+
+	Parameters
+	----------
+	d : ``DATUM *``
+		The datum whose label is to be assigned.
+	index : ``unsigned short``
+		The component of the data vector that ``label`` describes.
+	label : ``const char *``
+		The label itself, which is interned by :c:func:`label_intern`.
+		:c:member:`DATUM.labels`, :c:member:`DATUM.ids`, and
+		:c:member:`DATUM.mask` are all updated accordingly.
+*/
+extern void datum_set_label(DATUM *d, unsigned short index,
+	const char *label) {
+
+	d -> ids[index] = label_intern(label);
+	d -> labels[index] = label_name((*d).ids[index]);
+	d -> mask = label_mask((*d).ids, (*d).n_cols);
+
+}
+
+
 /*
 .. c:function:: extern void datum_free(DATUM *d);
 
@@ -72,12 +134,9 @@ extern void datum_free(DATUM *d) {
 
 	if (d != NULL) {
 
-		if ((*d).labels != NULL) {
-			for (unsigned short i = 0u; i < (*d).n_cols; i++) {
-				free(d -> labels[i]);
-			}
-			free(d -> labels);
-		} else {}
+		/* The label strings themselves belong to the label registry. */
+		if ((*d).labels != NULL) free(d -> labels);
+		if ((*d).ids != NULL) free(d -> ids);
 		free(d);
 
 	} else {}
@@ -109,14 +168,10 @@ extern void datum_free(DATUM *d) {
 */
 extern void datum_free_everything(DATUM *d) {
 
-	covariance_matrix_free_everything(d -> cov);
 	if (d != NULL) {
-		if ((*d).labels != NULL) {
-			for (unsigned short i = 0u; i < (*d).n_cols; i++) {
-				free(d -> labels[i]);
-			}
-			free(d -> labels);
-		}
+		covariance_matrix_free_everything(d -> cov);
+		if ((*d).labels != NULL) free(d -> labels);
+		if ((*d).ids != NULL) free(d -> ids);
 		matrix_free((MATRIX *) d);
 	} else {}
 
@@ -151,25 +206,62 @@ extern DATUM *datum_specific_quantities(DATUM d, char **labels,
 	unsigned short n_labels) {
 
 	/*
-	Start by grabbing the integer indices of each label in the data vector.
-	Copy their label strings while we're at it.
+	Labels that have never been interned can't be measured for this datum, so
+	they're simply dropped here.
 	*/
-	unsigned short n_indices = 0u, *indices = NULL;
-	char **label_copies = NULL;
+	unsigned short n_ids = 0u;
+	unsigned short *ids = (unsigned short *) malloc (n_labels *
+		sizeof(unsigned short));
 	for (unsigned short i = 0u; i < n_labels; i++) {
-		signed short idx = strindex(d.labels, labels[i], d.n_cols);
+		signed short id = label_lookup(labels[i]);
+		if (id >= 0) ids[n_ids++] = (unsigned short) id;
+	}
+	DATUM *sub = datum_specific_ids(d, ids, n_ids, NULL);
+	free(ids);
+	return sub;
+
+}
+
+
+/*
+.. c:function:: extern DATUM *datum_specific_ids(DATUM d, const unsigned short *ids, unsigned short n_ids, ARENA *a);
+
+	The integer ID analog of :c:func:`datum_specific_quantities`.
+
+	Parameters
+	----------
+	d : ``DATUM``
+		The input data vector.
+	ids : ``const unsigned short *``
+		The IDs of the labels to pull from the datum object, as assigned by
+		:c:func:`label_intern`.
+	n_ids : ``unsigned short``
+		The number of elements in ``ids``.
+	a : ``ARENA *``
+		The arena to allocate the new datum from, or ``NULL`` to allocate it
+		from the heap as :c:func:`datum_initialize` does.
+
+	Returns
+	-------
+	sub : ``DATUM *``
+		A new :c:type:`DATUM`, containing only the labels, vector components,
+		and covariance matrix entries associated with particular measurements.
+		``NULL`` if ``d`` has no measurements for any of the labels in ``ids``.
+*/
+extern DATUM *datum_specific_ids(DATUM d, const unsigned short *ids,
+	unsigned short n_ids, ARENA *a) {
+
+	/* Start by grabbing the integer indices of each label in the data vector. */
+	unsigned short n_indices = 0u, *indices = NULL;
+	for (unsigned short i = 0u; i < n_ids; i++) {
+		signed short idx = (d.mask & LABEL_BIT(ids[i])) ?
+			idindex(d.ids, ids[i], d.n_cols) : -1;
 		if (idx >= 0) {
 			if (indices == NULL) {
-				indices = (unsigned short *) malloc (sizeof(unsigned short));
-				label_copies = (char **) malloc (sizeof(char *));
-			} else {
-				indices = (unsigned short *) realloc (indices,
-					(n_indices + 1u) * sizeof(unsigned short));
-				label_copies = (char **) realloc (label_copies,
-					(n_indices + 1u) * sizeof(char));
-			}
-			indices[n_indices] = (unsigned) idx;
-			label_copies[n_indices++] = d.labels[idx];
+				indices = (unsigned short *) malloc (n_ids *
+					sizeof(unsigned short));
+			} else {}
+			indices[n_indices++] = (unsigned short) idx;
 		} else {
 			/*
 			Doing nothing allows ``sample.loglikelihood`` to work as intended,
@@ -183,26 +275,29 @@ extern DATUM *datum_specific_quantities(DATUM d, char **labels,
 
 	/*
 	Now just amass all of the information needed for ``datum_intialize``, and
-	once we've got it, copy the covariance matrix over and invert it.
+	once we've got it, copy the covariance matrix over and invert it. The
+	labels are already interned, so they're copied over by ID.
 	*/
 	if (indices == NULL) return NULL; /* see note in else block above */
-	DATUM *sub = datum_initialize(n_indices);
+	DATUM *sub = (a != NULL) ? datum_arena_initialize(a, n_indices) :
+		datum_initialize(n_indices);
 	for (unsigned short i = 0u; i < n_indices; i++) {
 		sub -> vector[0][i] = d.vector[0][indices[i]];
-		strcpy(sub -> labels[i], label_copies[i]);
+		sub -> labels[i] = d.labels[indices[i]];
+		sub -> ids[i] = d.ids[indices[i]];
 	}
-	sub -> cov = covariance_matrix_initialize(n_indices);
+	sub -> mask = label_mask((*sub).ids, n_indices);
+	sub -> cov = (a != NULL) ? covariance_matrix_arena_initialize(a,
+		n_indices) : covariance_matrix_initialize(n_indices);
 
 	for (unsigned short i = 0u; i < n_indices; i++) {
 		for (unsigned short j = 0u; j < n_indices; j++) {
 			sub -> cov -> matrix[i][j] = (*d.cov).matrix[indices[i]][indices[j]];
 		}
 	}
-	sub -> cov -> inv = matrix_invert( *((MATRIX *) (*sub).cov), NULL );
-	free(label_copies);
+	covariance_matrix_update(sub -> cov);
 	free(indices);
 
 	return sub;
 
 }
-
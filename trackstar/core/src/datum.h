@@ -18,6 +18,7 @@ extern "C" {
 #endif /* __cplusplus */
 
 #include "matrix.h"
+#include "arena.h"
 
 #ifndef MAX_LABEL_SIZE
 /*
@@ -58,7 +59,18 @@ typedef struct datum {
 		.. c:member:: char **labels
 
 			An array of string labels describing the quantities that are
-			measured for this datum.
+			measured for this datum. Each element points to the interned copy
+			of the label owned by the :c:type:`LABEL_REGISTRY`, and should be
+			assigned with :c:func:`datum_set_label`.
+
+		.. c:member:: unsigned short *ids
+
+			The integer ID of each element of :c:member:`labels`, as assigned
+			by :c:func:`label_intern`.
+
+		.. c:member:: unsigned long mask
+
+			The bitmask of :c:member:`ids` (see :c:func:`label_mask`).
 
 		.. note::
 
@@ -77,6 +89,8 @@ typedef struct datum {
 	unsigned short n_cols;
 	COVARIANCE_MATRIX *cov;
 	char **labels;
+	unsigned short *ids;
+	unsigned long mask;
 
 } DATUM;
 
@@ -98,6 +112,48 @@ typedef struct datum {
 */
 extern DATUM *datum_initialize(unsigned short dim);
 
+/*
+.. c:function:: extern DATUM *datum_arena_initialize(ARENA *a, const unsigned short dim);
+
+	Allocate a :c:type:`DATUM` and its labels from an arena.
+
+	Parameters
+	----------
+	a : ``ARENA *``
+		The arena to allocate from.
+	dim : ``const unsigned short``
+		The dimensionality of the data vector.
+
+	Returns
+	-------
+	d : ``DATUM *``
+		The newly constructed data vector, initialized like one constructed by
+		:c:func:`datum_initialize`, and with :c:member:`cov` set to ``NULL``.
+		It belongs to the arena, and so should its covariance matrix (see
+		:c:func:`covariance_matrix_arena_initialize`); neither must be passed
+		to :c:func:`datum_free` or :c:func:`datum_free_everything`.
+*/
+extern DATUM *datum_arena_initialize(ARENA *a, const unsigned short dim);
+
+/*
+.. c:function:: extern void datum_set_label(DATUM *d, unsigned short index, const char *label);
+
+	Assign the label of one of the components of a data vector.
+
+	Parameters
+	----------
+	d : ``DATUM *``
+		The datum whose label is to be assigned.
+	index : ``unsigned short``
+		The component of the data vector that ``label`` describes.
+	label : ``const char *``
+		The label itself, which is interned by :c:func:`label_intern`.
+		:c:member:`DATUM.labels`, :c:member:`DATUM.ids`, and
+		:c:member:`DATUM.mask` are all updated accordingly.
+*/
+extern void datum_set_label(DATUM *d, unsigned short index,
+	const char *label);
+
 /*
 .. c:function:: extern void datum_free(DATUM *d);
 
@@ -176,6 +232,34 @@ extern void datum_free_everything(DATUM *d);
 extern DATUM *datum_specific_quantities(DATUM d, char **labels,
 	unsigned short n_labels);
 
+/*
+.. c:function:: extern DATUM *datum_specific_ids(DATUM d, const unsigned short *ids, unsigned short n_ids, ARENA *a);
+
+	The integer ID analog of :c:func:`datum_specific_quantities`.
+
+	Parameters
+	----------
+	d : ``DATUM``
+		The input data vector.
+	ids : ``const unsigned short *``
+		The IDs of the labels to pull from the datum object, as assigned by
+		:c:func:`label_intern`.
+	n_ids : ``unsigned short``
+		The number of elements in ``ids``.
+	a : ``ARENA *``
+		The arena to allocate the new datum from, or ``NULL`` to allocate it
+		from the heap as :c:func:`datum_initialize` does.
+
+	Returns
+	-------
+	sub : ``DATUM *``
+		A new :c:type:`DATUM`, containing only the labels, vector components,
+		and covariance matrix entries associated with particular measurements.
+		``NULL`` if ``d`` has no measurements for any of the labels in ``ids``.
+*/
+extern DATUM *datum_specific_ids(DATUM d, const unsigned short *ids,
+	unsigned short n_ids, ARENA *a);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -0,0 +1,350 @@
+/*
+This file is part of the TrackStar package.
+Copyright (C) 2023 James W. Johnson (giganano9@gmail.com)
+License: MIT License. See LICENSE in top-level directory
+at: https://github.com/giganano/TrackStar.git.
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#include "multithread.h"
+#include "device.h"
+#include "likelihood.h"
+#include "profiling.h"
+#include "debug.h"
+#include "matrix.h"
+#include "utils.h"
+
+/* ---------- static function comment headers not duplicated here ---------- */
+DEVICE_FUNCTIONS_BEGIN
+static double log_track_integral(const double *vector, const double *inv,
+	const double *projected, const double *coefficients,
+	const unsigned long stride, const unsigned short dim,
+	const unsigned short n_points, const unsigned short corrections);
+static void quadratic_forms(const double *vector, const double *inv,
+	const double *point, const unsigned long stride, const unsigned short dim,
+	const unsigned short segment, double *forms);
+DEVICE_FUNCTIONS_END
+
+
+/*
+.. c:function:: extern unsigned short device_available(void);
+
+	Returns
+	-------
+	available : ``unsigned short``
+		1 if TrackStar was compiled with OpenMP's target offloading and the
+		OpenMP runtime found at least one accelerator, and 0 otherwise.
+*/
+extern unsigned short device_available(void) {
+
+	#if defined(TRACKSTAR_OFFLOAD)
+		return omp_get_num_devices() > 0;
+	#else
+		return 0u;
+	#endif
+
+}
+
+
+/*
+.. c:function:: extern DEVICE_SAMPLE *device_sample_upload(const PACKED_SAMPLE *p);
+
+	Copy a packed sample into the memory of the default OpenMP device.
+
+	Parameters
+	----------
+	p : ``const PACKED_SAMPLE *``
+		The packed sample to copy. It is not modified, and subsequent changes
+		to it are not reflected on the device.
+
+	Returns
+	-------
+	d : ``DEVICE_SAMPLE *``
+		The copy of the sample, which the caller is responsible for freeing
+		with :c:func:`device_sample_free`.
+
+	Notes
+	-----
+	Without offloading, the copy resides in host memory, and
+	:c:func:`loglikelihood_device` computes the likelihood with a single
+	thread on the host.
+*/
+extern DEVICE_SAMPLE *device_sample_upload(const PACKED_SAMPLE *p) {
+
+	DEVICE_SAMPLE *d = (DEVICE_SAMPLE *) malloc (sizeof(DEVICE_SAMPLE));
+	d -> packed = packed_sample_slice(p, 0ul, (*p).n_vectors);
+	#if defined(TRACKSTAR_OFFLOAD)
+		d -> device = omp_get_default_device();
+	#else
+		d -> device = 0;
+	#endif
+
+	/*
+	The data stay mapped until the sample is freed, so the target regions of
+	each likelihood calculation find them present and do not copy them.
+	*/
+	#if defined(TRACKSTAR_OFFLOAD)
+		for (unsigned long g = 0ul; g < (*(*d).packed).n_groups; g++) {
+			const PACKED_GROUP *group = (*(*d).packed).groups + g;
+			const unsigned long n_vectors = (*group).n_data * (*group).dim;
+			const unsigned long n_inv = n_vectors * ((*group).dim + 1ul) / 2ul;
+			#pragma omp target enter data device((*d).device) \
+				map(to: group -> vectors[0:n_vectors]) \
+				map(to: group -> inv[0:n_inv]) \
+				map(to: group -> logdet[0:group -> n_data])
+		}
+	#endif
+	return d;
+
+}
+
+
+/*
+.. c:function:: extern void device_sample_free(DEVICE_SAMPLE *d);
+
+	Free up the memory stored by a :c:type:`DEVICE_SAMPLE` on both the device
+	and the host.
+
+	Parameters
+	----------
+	d : ``DEVICE_SAMPLE *``
+		The sample to be freed.
+*/
+extern void device_sample_free(DEVICE_SAMPLE *d) {
+
+	if (d != NULL) {
+		#if defined(TRACKSTAR_OFFLOAD)
+			for (unsigned long g = 0ul; g < (*(*d).packed).n_groups; g++) {
+				const PACKED_GROUP *group = (*(*d).packed).groups + g;
+				const unsigned long n_vectors = (*group).n_data * (*group).dim;
+				const unsigned long n_inv = n_vectors * ((*group).dim + 1ul) /
+					2ul;
+				#pragma omp target exit data device((*d).device) \
+					map(delete: group -> vectors[0:n_vectors]) \
+					map(delete: group -> inv[0:n_inv]) \
+					map(delete: group -> logdet[0:group -> n_data])
+			}
+		#endif
+		packed_sample_free(d -> packed);
+		free(d);
+	} else {}
+
+}
+
+
+/*
+.. c:function:: extern double loglikelihood_device(DEVICE_SAMPLE *d, LIKELIHOOD_CONTEXT *c);
+
+	Compute the natural logarithm of the likelihood of observing a sample
+	that resides in the memory of an accelerator.
+
+	Parameters
+	----------
+	d : ``DEVICE_SAMPLE *``
+		The sample, as returned by :c:func:`device_sample_upload`.
+	c : ``LIKELIHOOD_CONTEXT *``
+		The context whose track and settings the likelihood is computed with.
+		:c:member:`LIKELIHOOD_CONTEXT.use_line_segment_corrections` must be
+		either 0 or 1.
+
+	Returns
+	-------
+	logl : ``double``
+		The natural logarithm of the likelihood of observation, as would be
+		computed by :c:func:`loglikelihood_context_sample` without pruning,
+		up to the order of floating point operations.
+
+	Notes
+	-----
+	The track is projected onto the measured quantities of each group of data
+	on the host, and only the projected predictions and their coefficients
+	are transferred to the device, where each datum is assigned to a device
+	thread. Every point along the track contributes to every datum, so
+	:c:member:`LIKELIHOOD_CONTEXT.pruning_threshold` has no effect. Each
+	thread sums the contributions to its datum in logarithmic space in a
+	single pass, and the line segment corrections are evaluated in closed
+	form (see :c:func:`log_line_segment_integral`), so no memory is
+	allocated on the device.
+*/
+extern double loglikelihood_device(DEVICE_SAMPLE *d, LIKELIHOOD_CONTEXT *c) {
+
+	if ((*c).use_line_segment_corrections > 1u) {
+		fatal_print("%s\n",
+			"Quadrature line segment corrections are unavailable on devices.");
+	} else {}
+	PROFILE_START(PROFILE_LIKELIHOOD);
+	const unsigned short n_points = (*(*c).track).n_vectors;
+	const unsigned short corrections = (*c).use_line_segment_corrections;
+	double logl = 0;
+
+	for (unsigned long g = 0ul; g < (*(*d).packed).n_groups; g++) {
+		PACKED_GROUP group = (*(*d).packed).groups[g];
+		const unsigned long stride = likelihood_context_project(c, group.ids,
+			group.dim);
+		const double *projected = (*c).projected;
+		const double *coefficients = (*c).coefficients;
+		const double *vectors = group.vectors, *inv = group.inv;
+		const double *logdet = group.logdet;
+		const unsigned short dim = group.dim;
+		const unsigned long n_data = group.n_data;
+		const unsigned long n_tri = (unsigned long) dim * (dim + 1ul) / 2ul;
+		double total = 0;
+		#if defined(TRACKSTAR_OFFLOAD)
+			#pragma omp target teams distribute parallel for \
+				device((*d).device) map(tofrom: total) reduction(+: total) \
+				map(to: projected[0:dim * stride], coefficients[0:n_points]) \
+				map(to: vectors[0:n_data * dim], inv[0:n_data * n_tri], \
+					logdet[0:n_data]) schedule(static)
+		#endif
+		for (unsigned long i = 0ul; i < n_data; i++) {
+			total += log_track_integral(vectors + i * dim, inv + i * n_tri,
+				projected, coefficients, stride, dim, n_points, corrections) -
+				0.5 * (log(2 * PI) + logdet[i]);
+		}
+		logl += total;
+	}
+
+	if (!(*c).normalize_weights) {
+		logl -= sum((*(*c).track).weights, (*(*c).track).n_vectors);
+	} else {}
+	PROFILE_STOP(PROFILE_LIKELIHOOD);
+	return logl;
+
+}
+
+
+DEVICE_FUNCTIONS_BEGIN
+/*
+.. c:function:: static double log_track_integral(const double *vector, const double *inv, const double *projected, const double *coefficients, const unsigned long stride, const unsigned short dim, const unsigned short n_points, const unsigned short corrections);
+
+	Compute the natural logarithm of the weighted sum of the contributions of
+	every point along a projected track to the likelihood of a datum.
+
+	Parameters
+	----------
+	vector : ``const double *``
+		The packed vector of the datum.
+	inv : ``const double *``
+		The upper triangle of the inverse covariance matrix of the datum,
+		packed row by row.
+	projected : ``const double *``
+		The track projected onto the quantities of the datum (see
+		:c:func:`likelihood_context_project`).
+	coefficients : ``const double *``
+		The weight of each point times the length of the line segment to the
+		next point.
+	stride : ``const unsigned long``
+		The distance in memory between the columns of ``projected``.
+	dim : ``const unsigned short``
+		The number of quantities measured for the datum.
+	n_points : ``const unsigned short``
+		The number of points along the track.
+	corrections : ``const unsigned short``
+		1 to apply the line segment corrections and 0 otherwise.
+
+	Returns
+	-------
+	logl : ``double``
+		The natural logarithm of the sum of each coefficient times
+		:math:`e^{-\chi^2/2}` times the line segment correction, if any.
+
+	Notes
+	-----
+	The sum is accumulated relative to the largest exponent encountered so
+	far, and rescaled whenever a larger one is found, so that it neither
+	underflows nor requires storing every exponent. Points whose coefficient
+	is zero, including the last one, are skipped, so each remaining point
+	has a line segment to the next one.
+*/
+static double log_track_integral(const double *vector, const double *inv,
+	const double *projected, const double *coefficients,
+	const unsigned long stride, const unsigned short dim,
+	const unsigned short n_points, const unsigned short corrections) {
+
+	double largest = -INFINITY, scaled = 0;
+	for (unsigned short j = 0u; j < n_points; j++) {
+		if (coefficients[j]) {
+			double forms[3];
+			quadratic_forms(vector, inv, projected + j, stride, dim,
+				corrections, forms);
+			double exponent = -0.5 * forms[0];
+			if (corrections) {
+				exponent += log_line_segment_integral(forms[1], forms[2]);
+			} else {}
+			if (exponent > largest) {
+				scaled = scaled * exp(largest - exponent) + coefficients[j];
+				largest = exponent;
+			} else if (exponent > -INFINITY) {
+				scaled += coefficients[j] * exp(exponent - largest);
+			} else {}
+		} else {}
+	}
+	return largest + log(scaled);
+
+}
+
+
+/*
+.. c:function:: static void quadratic_forms(const double *vector, const double *inv, const double *point, const unsigned long stride, const unsigned short dim, const unsigned short segment, double *forms);
+
+	Compute the quadratic forms of the inverse covariance matrix of a datum
+	with its displacement from a point along the track and with the line
+	segment to the next point.
+
+	Parameters
+	----------
+	vector : ``const double *``
+		The packed vector of the datum.
+	inv : ``const double *``
+		The upper triangle of the inverse covariance matrix of the datum,
+		packed row by row.
+	point : ``const double *``
+		The first component of the point along the projected track, whose
+		``k``'th component is ``point[k * stride]``.
+	stride : ``const unsigned long``
+		The distance in memory between the components of ``point``.
+	dim : ``const unsigned short``
+		The number of quantities measured for the datum.
+	segment : ``const unsigned short``
+		Nonzero to compute the forms involving the line segment as well.
+	forms : ``double *``
+		Three elements, in which :math:`\chi^2 = d^T C^{-1} d`,
+		:math:`a = s^T C^{-1} s`, and :math:`b = d^T C^{-1} s` are stored,
+		where :math:`d` is the displacement of the datum from the point and
+		:math:`s` the line segment. The last two are zero unless ``segment``
+		is nonzero.
+
+	Notes
+	-----
+	The components of :math:`d` and :math:`s` are recomputed where needed
+	rather than stored, since arrays whose size is only known at run time
+	cannot be allocated on every device.
+*/
+static void quadratic_forms(const double *vector, const double *inv,
+	const double *point, const unsigned long stride, const unsigned short dim,
+	const unsigned short segment, double *forms) {
+
+	forms[0] = forms[1] = forms[2] = 0;
+	const double *element = inv;
+	for (unsigned short j = 0u; j < dim; j++) {
+		double dj = vector[j] - point[j * stride];
+		double sj = segment ? point[j * stride + 1ul] - point[j * stride] : 0;
+		forms[0] += *element * dj * dj;
+		forms[1] += *element * sj * sj;
+		forms[2] += *element * dj * sj;
+		element++;
+		for (unsigned short k = j + 1u; k < dim; k++) {
+			double dk = vector[k] - point[k * stride];
+			double sk = segment ? point[k * stride + 1ul] - point[k * stride] :
+				0;
+			forms[0] += 2 * *element * dj * dk;
+			forms[1] += 2 * *element * sj * sk;
+			forms[2] += *element * (dj * sk + dk * sj);
+			element++;
+		}
+	}
+
+}
+DEVICE_FUNCTIONS_END
@@ -0,0 +1,153 @@
+/*
+This file is part of the TrackStar package.
+Copyright (C) 2023 James W. Johnson (giganano9@gmail.com)
+License: MIT License. See LICENSE in top-level directory
+at: https://github.com/giganano/TrackStar.git.
+
+This header file includes the features for computing the likelihood of a
+sample on an accelerator (e.g., a GPU) with OpenMP's target offloading, which
+keeps the sample in the memory of the device between calculations.
+
+**Source File**: ``trackstar/core/src/device.c``
+*/
+
+#ifndef DEVICE_H
+#define DEVICE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "sample.h"
+#include "likelihood.h"
+
+typedef struct device_sample {
+
+	/*
+	.. c:type:: DEVICE_SAMPLE
+
+		A packed sample whose data reside in the memory of an accelerator, such
+		that each likelihood calculation only transfers the projected track.
+
+		.. c:member:: int device
+
+			The OpenMP device number of the accelerator.
+
+		.. c:member:: PACKED_SAMPLE *packed
+
+			A copy of the packed sample, whose
+			:c:member:`PACKED_GROUP.vectors`, :c:member:`PACKED_GROUP.inv`,
+			and :c:member:`PACKED_GROUP.logdet` are mapped to the device for
+			as long as this object exists.
+	*/
+
+	int device;
+	PACKED_SAMPLE *packed;
+
+} DEVICE_SAMPLE;
+
+/*
+.. c:function:: inline unsigned short offload_enabled();
+
+	Returns 1 if TrackStar was compiled with OpenMP's target offloading and 0
+	otherwise. The setup script defines ``TRACKSTAR_OFFLOAD`` when asked to
+	(see :ref:`offload`), which requires OpenMP to be enabled as well.
+*/
+inline unsigned short offload_enabled(void) {
+	#if defined(TRACKSTAR_OFFLOAD)
+		return 1u;
+	#else
+		return 0u;
+	#endif
+}
+
+/*
+.. c:function:: extern unsigned short device_available(void);
+
+	Returns
+	-------
+	available : ``unsigned short``
+		1 if TrackStar was compiled with OpenMP's target offloading and the
+		OpenMP runtime found at least one accelerator, and 0 otherwise.
+*/
+extern unsigned short device_available(void);
+
+/*
+.. c:function:: extern DEVICE_SAMPLE *device_sample_upload(const PACKED_SAMPLE *p);
+
+	Copy a packed sample into the memory of the default OpenMP device.
+
+	Parameters
+	----------
+	p : ``const PACKED_SAMPLE *``
+		The packed sample to copy. It is not modified, and subsequent changes
+		to it are not reflected on the device.
+
+	Returns
+	-------
+	d : ``DEVICE_SAMPLE *``
+		The copy of the sample, which the caller is responsible for freeing
+		with :c:func:`device_sample_free`.
+
+	Notes
+	-----
+	Without offloading, the copy resides in host memory, and
+	:c:func:`loglikelihood_device` computes the likelihood with a single
+	thread on the host.
+*/
+extern DEVICE_SAMPLE *device_sample_upload(const PACKED_SAMPLE *p);
+
+/*
+.. c:function:: extern void device_sample_free(DEVICE_SAMPLE *d);
+
+	Free up the memory stored by a :c:type:`DEVICE_SAMPLE` on both the device
+	and the host.
+
+	Parameters
+	----------
+	d : ``DEVICE_SAMPLE *``
+		The sample to be freed.
+*/
+extern void device_sample_free(DEVICE_SAMPLE *d);
+
+/*
+.. c:function:: extern double loglikelihood_device(DEVICE_SAMPLE *d, LIKELIHOOD_CONTEXT *c);
+
+	Compute the natural logarithm of the likelihood of observing a sample
+	that resides in the memory of an accelerator.
+
+	Parameters
+	----------
+	d : ``DEVICE_SAMPLE *``
+		The sample, as returned by :c:func:`device_sample_upload`.
+	c : ``LIKELIHOOD_CONTEXT *``
+		The context whose track and settings the likelihood is computed with.
+		:c:member:`LIKELIHOOD_CONTEXT.use_line_segment_corrections` must be
+		either 0 or 1.
+
+	Returns
+	-------
+	logl : ``double``
+		The natural logarithm of the likelihood of observation, as would be
+		computed by :c:func:`loglikelihood_context_sample` without pruning,
+		up to the order of floating point operations.
+
+	Notes
+	-----
+	The track is projected onto the measured quantities of each group of data
+	on the host, and only the projected predictions and their coefficients
+	are transferred to the device, where each datum is assigned to a device
+	thread. Every point along the track contributes to every datum, so
+	:c:member:`LIKELIHOOD_CONTEXT.pruning_threshold` has no effect. Each
+	thread sums the contributions to its datum in logarithmic space in a
+	single pass, and the line segment corrections are evaluated in closed
+	form (see :c:func:`log_line_segment_integral`), so no memory is
+	allocated on the device.
+*/
+extern double loglikelihood_device(DEVICE_SAMPLE *d, LIKELIHOOD_CONTEXT *c);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* DEVICE_H */
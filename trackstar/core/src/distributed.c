@@ -0,0 +1,317 @@
+/*
+This file is part of the TrackStar package.
+Copyright (C) 2023 James W. Johnson (giganano9@gmail.com)
+License: MIT License. See LICENSE in top-level directory
+at: https://github.com/giganano/TrackStar.git.
+*/
+
+#if defined(TRACKSTAR_MPI)
+	#include <mpi.h>
+#endif
+#include "distributed.h"
+#include "likelihood.h"
+#include "matrix.h"
+#include "utils.h"
+
+/* ---------- static function comment headers not duplicated here ---------- */
+#if defined(TRACKSTAR_MPI)
+static unsigned long track_signature(const TRACK *t);
+#endif /* TRACKSTAR_MPI */
+
+
+/*
+.. c:function:: extern unsigned short distributed_initialize(void);
+
+	Initialize MPI if it has not been initialized already (e.g. by
+	``mpi4py``), requesting support for calls from any one thread at a time.
+
+	Returns
+	-------
+	initialized : ``unsigned short``
+		1 if this call initialized MPI, in which case the caller is
+		responsible for calling :c:func:`distributed_finalize` before the
+		process exits, and 0 otherwise.
+*/
+extern unsigned short distributed_initialize(void) {
+
+	#if defined(TRACKSTAR_MPI)
+		int initialized, provided;
+		MPI_Initialized(&initialized);
+		if (!initialized) {
+			MPI_Init_thread(NULL, NULL, MPI_THREAD_SERIALIZED, &provided);
+			return 1u;
+		} else {
+			return 0u;
+		}
+	#else
+		return 0u;
+	#endif
+
+}
+
+
+/*
+.. c:function:: extern void distributed_finalize(void);
+
+	Finalize MPI if it has been initialized and not yet finalized.
+*/
+extern void distributed_finalize(void) {
+
+	#if defined(TRACKSTAR_MPI)
+		int initialized, finalized;
+		MPI_Initialized(&initialized);
+		MPI_Finalized(&finalized);
+		if (initialized && !finalized) MPI_Finalize();
+	#endif
+
+}
+
+
+/*
+.. c:function:: extern unsigned int distributed_rank(void);
+
+	Returns
+	-------
+	rank : ``unsigned int``
+		The rank of the calling process within ``MPI_COMM_WORLD``, or 0
+		without MPI.
+*/
+extern unsigned int distributed_rank(void) {
+
+	#if defined(TRACKSTAR_MPI)
+		int rank;
+		MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+		return (unsigned int) rank;
+	#else
+		return 0u;
+	#endif
+
+}
+
+
+/*
+.. c:function:: extern unsigned int distributed_size(void);
+
+	Returns
+	-------
+	size : ``unsigned int``
+		The number of processes in ``MPI_COMM_WORLD``, or 1 without MPI.
+*/
+extern unsigned int distributed_size(void) {
+
+	#if defined(TRACKSTAR_MPI)
+		int size;
+		MPI_Comm_size(MPI_COMM_WORLD, &size);
+		return (unsigned int) size;
+	#else
+		return 1u;
+	#endif
+
+}
+
+
+/*
+.. c:function:: extern unsigned short distributed_any(const unsigned short flag);
+
+	Determine whether a condition holds on any process. Must be called by
+	every process at once.
+
+	Parameters
+	----------
+	flag : ``const unsigned short``
+		Nonzero if the condition holds on the calling process.
+
+	Returns
+	-------
+	any : ``unsigned short``
+		1 on every process if ``flag`` is nonzero on any of them, and 0
+		otherwise.
+
+	Notes
+	-----
+	This allows every process to skip a collective operation together when
+	some of them cannot take part in it, rather than leaving the others
+	waiting for them indefinitely.
+*/
+extern unsigned short distributed_any(const unsigned short flag) {
+
+	#if defined(TRACKSTAR_MPI)
+		int local = flag != 0u, any;
+		MPI_Allreduce(&local, &any, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+		return (unsigned short) any;
+	#else
+		return flag != 0u;
+	#endif
+
+}
+
+
+/*
+.. c:function:: extern unsigned short distributed_broadcast_track(TRACK *t, const unsigned int root);
+
+	Replace the predictions, weights, and
+	:c:member:`TRACK.weight_norm_factor` of the track of every process with
+	those of the root process. Must be called by every process at once.
+
+	Parameters
+	----------
+	t : ``TRACK *``
+		The track of the calling process.
+	root : ``const unsigned int``
+		The rank of the process whose track is to be copied.
+
+	Returns
+	-------
+	status : ``unsigned short``
+		:c:macro:`DISTRIBUTED_SUCCESS` or
+		:c:macro:`DISTRIBUTED_TRACK_MISMATCH`, the same on every process.
+
+	Notes
+	-----
+	Each process projects the track onto the quantities of its own data with
+	its own labels, so the labels of every track must match those of the
+	root process in the same order. Only a signature of the labels and the
+	number of points is compared, which every process agrees on before any
+	track is modified.
+*/
+extern unsigned short distributed_broadcast_track(TRACK *t,
+	const unsigned int root) {
+
+	#if defined(TRACKSTAR_MPI)
+		unsigned long signature = track_signature(t), expected = signature;
+		MPI_Bcast(&expected, 1, MPI_UNSIGNED_LONG, (int) root,
+			MPI_COMM_WORLD);
+		if (distributed_any(expected != signature)) {
+			return DISTRIBUTED_TRACK_MISMATCH;
+		} else {}
+
+		/* the predictions are laid out like the elements of a MATRIX */
+		MPI_Bcast(matrix_elements(*((MATRIX *) t)),
+			(int) ((*t).n_vectors * (*t).dim), MPI_DOUBLE, (int) root,
+			MPI_COMM_WORLD);
+		MPI_Bcast(t -> weights, (int) (*t).n_vectors, MPI_DOUBLE, (int) root,
+			MPI_COMM_WORLD);
+		MPI_Bcast(&(t -> weight_norm_factor), 1, MPI_DOUBLE, (int) root,
+			MPI_COMM_WORLD);
+	#else
+		/* a single process already holds the only track */
+		(void) t;
+		(void) root;
+	#endif
+	return DISTRIBUTED_SUCCESS;
+
+}
+
+
+/*
+.. c:function:: extern double loglikelihood_distributed(LIKELIHOOD_CONTEXT *c, const PACKED_SAMPLE *shard, const unsigned int root);
+
+	Compute the natural logarithm of the likelihood of observing a sample
+	whose data are split into shards across the processes of an MPI job.
+	Must be called by every process at once.
+
+	Parameters
+	----------
+	c : ``LIKELIHOOD_CONTEXT *``
+		The context of the calling process, whose track should have been
+		broadcast with :c:func:`distributed_broadcast_track` beforehand. Its
+		:c:member:`LIKELIHOOD_CONTEXT.normalize_weights`,
+		:c:member:`LIKELIHOOD_CONTEXT.use_line_segment_corrections`, and
+		:c:member:`LIKELIHOOD_CONTEXT.pruning_threshold` are replaced by
+		those of the root process.
+	shard : ``const PACKED_SAMPLE *``
+		The packed shard of the sample held by the calling process, which may
+		be empty.
+	root : ``const unsigned int``
+		The rank of the process whose settings are to be used.
+
+	Returns
+	-------
+	logl : ``double``
+		The natural logarithm of the likelihood of observing the whole
+		sample, as would be computed by :c:func:`loglikelihood_context_sample`
+		up to the order in which the contributions of the data are summed, on
+		every process.
+
+	Notes
+	-----
+	Each process computes the likelihood of its shard with
+	:c:func:`loglikelihood_context_sample`, using
+	:c:member:`LIKELIHOOD_CONTEXT.n_threads` threads of its own, after which
+	a single ``MPI_Allreduce`` sums the results. The time per calculation
+	therefore scales with the size of the largest shard rather than that of
+	the whole sample.
+*/
+extern double loglikelihood_distributed(LIKELIHOOD_CONTEXT *c,
+	const PACKED_SAMPLE *shard, const unsigned int root) {
+
+	#if defined(TRACKSTAR_MPI)
+		double settings[3] = {
+			(*c).normalize_weights,
+			(*c).use_line_segment_corrections,
+			(*c).pruning_threshold
+		};
+		MPI_Bcast(settings, 3, MPI_DOUBLE, (int) root, MPI_COMM_WORLD);
+		c -> normalize_weights = (unsigned short) settings[0];
+		c -> use_line_segment_corrections = (unsigned short) settings[1];
+		c -> pruning_threshold = settings[2];
+	#else
+		(void) root;
+	#endif
+
+	double logl = loglikelihood_context_sample(c, shard);
+
+	#if defined(TRACKSTAR_MPI)
+		/*
+		Without normalization, the likelihood of each shard includes the
+		negative sum of the weights, which that of the whole sample only
+		includes once.
+		*/
+		if (!(*c).normalize_weights && distributed_rank() != root) {
+			logl += sum((*(*c).track).weights, (*(*c).track).n_vectors);
+		} else {}
+		double total;
+		MPI_Allreduce(&logl, &total, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+		logl = total;
+	#endif
+	return logl;
+
+}
+
+
+#if defined(TRACKSTAR_MPI)
+/*
+.. c:function:: static unsigned long track_signature(const TRACK *t);
+
+	Compute a signature of the shape and labels of a track, by which
+	:c:func:`distributed_broadcast_track` determines whether the tracks of
+	every process are compatible.
+
+	Parameters
+	----------
+	t : ``const TRACK *``
+		The track in question.
+
+	Returns
+	-------
+	signature : ``unsigned long``
+		The 64-bit FNV-1a hash of the number of points, the number of
+		quantities, and each label in order, each followed by its trailing
+		null character.
+*/
+static unsigned long track_signature(const TRACK *t) {
+
+	unsigned long hash = 14695981039346656037ul;
+	const unsigned long prime = 1099511628211ul;
+	hash = (hash ^ (*t).n_vectors) * prime;
+	hash = (hash ^ (*t).dim) * prime;
+	for (unsigned short i = 0u; i < (*t).dim; i++) {
+		const char *label = (*t).labels[i];
+		do {
+			hash = (hash ^ (unsigned char) *label) * prime;
+		} while (*label++);
+	}
+	return hash;
+
+}
+#endif /* TRACKSTAR_MPI */
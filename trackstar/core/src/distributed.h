@@ -0,0 +1,200 @@
+/*
+This file is part of the TrackStar package.
+Copyright (C) 2023 James W. Johnson (giganano9@gmail.com)
+License: MIT License. See LICENSE in top-level directory
+at: https://github.com/giganano/TrackStar.git.
+
+This header file includes the features for computing the likelihood of a
+sample whose data are spread across the processes of an MPI job, each of which
+holds a shard of the sample.
+
+**Source File**: ``trackstar/core/src/distributed.c``
+*/
+
+#ifndef DISTRIBUTED_H
+#define DISTRIBUTED_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "sample.h"
+#include "track.h"
+#include "likelihood.h"
+
+/*
+.. c:macro:: DISTRIBUTED_SUCCESS
+.. c:macro:: DISTRIBUTED_TRACK_MISMATCH
+
+	The status codes of :c:func:`distributed_broadcast_track`:
+
+	- ``0u``: The track was broadcast successfully.
+	- ``1u``: The track of some process has a different number of points or
+	  different labels than that of the root process, in which case no
+	  process modifies its track.
+*/
+#define DISTRIBUTED_SUCCESS 0u
+#define DISTRIBUTED_TRACK_MISMATCH 1u
+
+/*
+.. c:function:: inline unsigned short mpi_enabled();
+
+	Returns 1 if TrackStar was linked with an MPI library at compile time and
+	0 otherwise. The setup script defines ``TRACKSTAR_MPI`` when asked to (see
+	:ref:`mpi`). Without it, every function in this file behaves as if the job
+	consisted of a single process.
+*/
+inline unsigned short mpi_enabled(void) {
+	#if defined(TRACKSTAR_MPI)
+		return 1u;
+	#else
+		return 0u;
+	#endif
+}
+
+/*
+.. c:function:: extern unsigned short distributed_initialize(void);
+
+	Initialize MPI if it has not been initialized already (e.g. by
+	``mpi4py``), requesting support for calls from any one thread at a time.
+
+	Returns
+	-------
+	initialized : ``unsigned short``
+		1 if this call initialized MPI, in which case the caller is
+		responsible for calling :c:func:`distributed_finalize` before the
+		process exits, and 0 otherwise.
+*/
+extern unsigned short distributed_initialize(void);
+
+/*
+.. c:function:: extern void distributed_finalize(void);
+
+	Finalize MPI if it has been initialized and not yet finalized.
+*/
+extern void distributed_finalize(void);
+
+/*
+.. c:function:: extern unsigned int distributed_rank(void);
+
+	Returns
+	-------
+	rank : ``unsigned int``
+		The rank of the calling process within ``MPI_COMM_WORLD``, or 0
+		without MPI.
+*/
+extern unsigned int distributed_rank(void);
+
+/*
+.. c:function:: extern unsigned int distributed_size(void);
+
+	Returns
+	-------
+	size : ``unsigned int``
+		The number of processes in ``MPI_COMM_WORLD``, or 1 without MPI.
+*/
+extern unsigned int distributed_size(void);
+
+/*
+.. c:function:: extern unsigned short distributed_any(const unsigned short flag);
+
+	Determine whether a condition holds on any process. Must be called by
+	every process at once.
+
+	Parameters
+	----------
+	flag : ``const unsigned short``
+		Nonzero if the condition holds on the calling process.
+
+	Returns
+	-------
+	any : ``unsigned short``
+		1 on every process if ``flag`` is nonzero on any of them, and 0
+		otherwise.
+
+	Notes
+	-----
+	This allows every process to skip a collective operation together when
+	some of them cannot take part in it, rather than leaving the others
+	waiting for them indefinitely.
+*/
+extern unsigned short distributed_any(const unsigned short flag);
+
+/*
+.. c:function:: extern unsigned short distributed_broadcast_track(TRACK *t, const unsigned int root);
+
+	Replace the predictions, weights, and
+	:c:member:`TRACK.weight_norm_factor` of the track of every process with
+	those of the root process. Must be called by every process at once.
+
+	Parameters
+	----------
+	t : ``TRACK *``
+		The track of the calling process.
+	root : ``const unsigned int``
+		The rank of the process whose track is to be copied.
+
+	Returns
+	-------
+	status : ``unsigned short``
+		:c:macro:`DISTRIBUTED_SUCCESS` or
+		:c:macro:`DISTRIBUTED_TRACK_MISMATCH`, the same on every process.
+
+	Notes
+	-----
+	Each process projects the track onto the quantities of its own data with
+	its own labels, so the labels of every track must match those of the
+	root process in the same order. Only a signature of the labels and the
+	number of points is compared, which every process agrees on before any
+	track is modified.
+*/
+extern unsigned short distributed_broadcast_track(TRACK *t,
+	const unsigned int root);
+
+/*
+.. c:function:: extern double loglikelihood_distributed(LIKELIHOOD_CONTEXT *c, const PACKED_SAMPLE *shard, const unsigned int root);
+
+	Compute the natural logarithm of the likelihood of observing a sample
+	whose data are split into shards across the processes of an MPI job.
+	Must be called by every process at once.
+
+	Parameters
+	----------
+	c : ``LIKELIHOOD_CONTEXT *``
+		The context of the calling process, whose track should have been
+		broadcast with :c:func:`distributed_broadcast_track` beforehand. Its
+		:c:member:`LIKELIHOOD_CONTEXT.normalize_weights`,
+		:c:member:`LIKELIHOOD_CONTEXT.use_line_segment_corrections`, and
+		:c:member:`LIKELIHOOD_CONTEXT.pruning_threshold` are replaced by
+		those of the root process.
+	shard : ``const PACKED_SAMPLE *``
+		The packed shard of the sample held by the calling process, which may
+		be empty.
+	root : ``const unsigned int``
+		The rank of the process whose settings are to be used.
+
+	Returns
+	-------
+	logl : ``double``
+		The natural logarithm of the likelihood of observing the whole
+		sample, as would be computed by :c:func:`loglikelihood_context_sample`
+		up to the order in which the contributions of the data are summed, on
+		every process.
+
+	Notes
+	-----
+	Each process computes the likelihood of its shard with
+	:c:func:`loglikelihood_context_sample`, using
+	:c:member:`LIKELIHOOD_CONTEXT.n_threads` threads of its own, after which
+	a single ``MPI_Allreduce`` sums the results. The time per calculation
+	therefore scales with the size of the largest shard rather than that of
+	the whole sample.
+*/
+extern double loglikelihood_distributed(LIKELIHOOD_CONTEXT *c,
+	const PACKED_SAMPLE *shard, const unsigned int root);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* DISTRIBUTED_H */
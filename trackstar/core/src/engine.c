@@ -0,0 +1,247 @@
+/*
+This file is part of the TrackStar package.
+Copyright (C) 2023 James W. Johnson (giganano9@gmail.com)
+License: MIT License. See LICENSE in top-level directory
+at: https://github.com/giganano/TrackStar.git.
+*/
+
+#include <stdlib.h>
+#include "multithread.h"
+#include "engine.h"
+#include "likelihood.h"
+#include "sample.h"
+#include "utils.h"
+
+/* ---------- static function comment headers not duplicated here ---------- */
+static LIKELIHOOD_CONTEXT *engine_context(LIKELIHOOD_ENGINE *e,
+	const unsigned short k, const LIKELIHOOD_CONTEXT *c);
+
+/* The spacing of the per-thread results in LIKELIHOOD_ENGINE.by_thread */
+#define ENGINE_STRIDE (CACHE_LINE_SIZE / sizeof(double))
+
+
+/*
+.. c:function:: extern LIKELIHOOD_ENGINE *likelihood_engine_initialize(const PACKED_SAMPLE *p, const unsigned short n_threads);
+
+	Partition a packed sample among a team of threads for repeated likelihood
+	calculations.
+
+	Parameters
+	----------
+	p : ``const PACKED_SAMPLE *``
+		The packed sample, as returned by :c:func:`sample_pack`. It is copied,
+		so it may be freed or invalidated afterwards.
+	n_threads : ``const unsigned short``
+		The number of threads to partition the data among.
+
+	Returns
+	-------
+	e : ``LIKELIHOOD_ENGINE *``
+		The newly constructed engine.
+
+	Notes
+	-----
+	The data are split into :c:member:`LIKELIHOOD_ENGINE.n_threads` partitions
+	of consecutive data of nearly equal size, each of which is copied by the
+	thread that computes its likelihood. Operating systems place memory on the
+	node of a non-uniform memory access (NUMA) machine that first writes to it,
+	so each partition resides in memory local to its thread as long as that
+	thread stays on the same processor. The threads are bound to processors
+	spread as evenly as possible across the machine by OpenMP's
+	``proc_bind(spread)`` policy, which takes effect whenever the OpenMP
+	runtime binds threads at all (e.g. with the environment variable
+	``OMP_PLACES=cores``).
+
+	The OpenMP runtime keeps its threads alive between parallel regions with
+	the same number of threads, so every calculation with the engine reuses
+	the same team, and each thread finds its partition and its scratch memory
+	where it left them.
+*/
+extern LIKELIHOOD_ENGINE *likelihood_engine_initialize(const PACKED_SAMPLE *p,
+	const unsigned short n_threads) {
+
+	LIKELIHOOD_ENGINE *e = (LIKELIHOOD_ENGINE *) malloc (
+		sizeof(LIKELIHOOD_ENGINE));
+	e -> n_threads = n_threads;
+	e -> n_vectors = (*p).n_vectors;
+	e -> partitions = (PACKED_SAMPLE **) malloc (
+		n_threads * sizeof(PACKED_SAMPLE *));
+	e -> contexts = (LIKELIHOOD_CONTEXT **) malloc (
+		n_threads * sizeof(LIKELIHOOD_CONTEXT *));
+	e -> n_points = (unsigned short *) malloc (
+		n_threads * sizeof(unsigned short));
+	e -> dims = (unsigned short *) malloc (n_threads * sizeof(unsigned short));
+	e -> by_thread = (double *) aligned_malloc (
+		n_threads * ENGINE_STRIDE * sizeof(double));
+	for (unsigned short k = 0u; k < n_threads; k++) {
+		e -> contexts[k] = NULL;
+		e -> n_points[k] = 0u;
+		e -> dims[k] = 0u;
+	}
+
+	/*
+	A static schedule with as many iterations as threads assigns the k'th
+	partition to the k'th thread of the team, both here and in
+	loglikelihood_engine, so each partition is copied by the same thread
+	that later reads it.
+	*/
+	#if defined(_OPENMP)
+		#pragma omp parallel for num_threads(n_threads) proc_bind(spread) \
+			schedule(static)
+	#endif
+	for (unsigned short k = 0u; k < n_threads; k++) {
+		e -> partitions[k] = packed_sample_slice(p,
+			k * (*p).n_vectors / n_threads,
+			(k + 1ul) * (*p).n_vectors / n_threads);
+	}
+	return e;
+
+}
+
+
+/*
+.. c:function:: extern void likelihood_engine_free(LIKELIHOOD_ENGINE *e);
+
+	Free up the memory stored by a :c:type:`LIKELIHOOD_ENGINE`.
+
+	Parameters
+	----------
+	e : ``LIKELIHOOD_ENGINE *``
+		The engine to be freed.
+*/
+extern void likelihood_engine_free(LIKELIHOOD_ENGINE *e) {
+
+	if (e != NULL) {
+		for (unsigned short k = 0u; k < (*e).n_threads; k++) {
+			packed_sample_free(e -> partitions[k]);
+			likelihood_context_free(e -> contexts[k]);
+		}
+		free(e -> partitions);
+		free(e -> contexts);
+		free(e -> n_points);
+		free(e -> dims);
+		free(e -> by_thread);
+		free(e);
+	} else {}
+
+}
+
+
+/*
+.. c:function:: extern double loglikelihood_engine(LIKELIHOOD_ENGINE *e, const LIKELIHOOD_CONTEXT *c);
+
+	Compute the natural logarithm of the likelihood of observing the sample
+	that an engine was constructed from, given the track and settings of a
+	context.
+
+	Parameters
+	----------
+	e : ``LIKELIHOOD_ENGINE *``
+		The engine to compute the likelihood with.
+	c : ``const LIKELIHOOD_CONTEXT *``
+		The context whose :c:member:`LIKELIHOOD_CONTEXT.track`,
+		:c:member:`LIKELIHOOD_CONTEXT.normalize_weights`,
+		:c:member:`LIKELIHOOD_CONTEXT.use_line_segment_corrections`, and
+		:c:member:`LIKELIHOOD_CONTEXT.pruning_threshold` are to be used. It is
+		not modified.
+
+	Returns
+	-------
+	logl : ``double``
+		The natural logarithm of the likelihood of observation, as would be
+		computed by :c:func:`loglikelihood_context_sample`, up to the order in
+		which the contributions of the data are summed.
+
+	Notes
+	-----
+	:c:member:`LIKELIHOOD_CONTEXT.n_threads` and
+	:c:member:`LIKELIHOOD_CONTEXT.parallel_policy` do not apply here; the data
+	are always parallelized over, with :c:member:`LIKELIHOOD_ENGINE.n_threads`
+	threads. Each thread computes the likelihood of every data vector in its
+	partition with its own context, which projects the track onto the
+	quantities measured for the data in local memory as well.
+
+	Each engine supports only one calculation at a time, because its threads
+	reuse their contexts.
+*/
+extern double loglikelihood_engine(LIKELIHOOD_ENGINE *e,
+	const LIKELIHOOD_CONTEXT *c) {
+
+	#if defined(_OPENMP)
+		#pragma omp parallel for num_threads((*e).n_threads) \
+			proc_bind(spread) schedule(static)
+	#endif
+	for (unsigned short k = 0u; k < (*e).n_threads; k++) {
+		e -> by_thread[k * ENGINE_STRIDE] = loglikelihood_context_sample(
+			engine_context(e, k, c), (*e).partitions[k]);
+	}
+
+	double logl = 0;
+	for (unsigned short k = 0u; k < (*e).n_threads; k++) {
+		logl += (*e).by_thread[k * ENGINE_STRIDE];
+	}
+
+	/*
+	Without normalization, the likelihood of each partition includes the
+	negative sum of the weights, which that of the whole sample only
+	includes once.
+	*/
+	if (!(*c).normalize_weights) {
+		logl += ((*e).n_threads - 1u) * sum((*(*c).track).weights,
+			(*(*c).track).n_vectors);
+	} else {}
+	return logl;
+
+}
+
+
+/*
+.. c:function:: static LIKELIHOOD_CONTEXT *engine_context(LIKELIHOOD_ENGINE *e, const unsigned short k, const LIKELIHOOD_CONTEXT *c);
+
+	Obtain the context that the thread computing the likelihood of one
+	partition of an engine is to use, allocating it if it does not yet have
+	room for the track.
+
+	Parameters
+	----------
+	e : ``LIKELIHOOD_ENGINE *``
+		The engine in question.
+	k : ``const unsigned short``
+		The index of the partition.
+	c : ``const LIKELIHOOD_CONTEXT *``
+		The context whose track and settings are to be copied.
+
+	Returns
+	-------
+	local : ``LIKELIHOOD_CONTEXT *``
+		The element of :c:member:`LIKELIHOOD_ENGINE.contexts` for the
+		partition, with the track and settings of ``c`` and one thread.
+
+	Notes
+	-----
+	A context allocated for a track may be reused for any other with no more
+	points or quantities, all of its memory being sized by those two numbers.
+	It is only reallocated when a larger track comes along, by the calling
+	thread, such that it resides in memory local to that thread.
+*/
+static LIKELIHOOD_CONTEXT *engine_context(LIKELIHOOD_ENGINE *e,
+	const unsigned short k, const LIKELIHOOD_CONTEXT *c) {
+
+	const TRACK *t = (*c).track;
+	if ((*e).contexts[k] == NULL || (*t).n_vectors > (*e).n_points[k] ||
+		(*t).dim > (*e).dims[k]) {
+		likelihood_context_free(e -> contexts[k]);
+		e -> contexts[k] = likelihood_context_initialize(t);
+		e -> n_points[k] = (*t).n_vectors;
+		e -> dims[k] = (*t).dim;
+	} else {}
+	LIKELIHOOD_CONTEXT *local = (*e).contexts[k];
+	local -> track = t;
+	local -> n_threads = 1u;
+	local -> parallel_policy = PARALLEL_POLICY_DATA;
+	local -> normalize_weights = (*c).normalize_weights;
+	local -> use_line_segment_corrections = (*c).use_line_segment_corrections;
+	local -> pruning_threshold = (*c).pruning_threshold;
+	return local;
+
+}
@@ -0,0 +1,176 @@
+/*
+This file is part of the TrackStar package.
+Copyright (C) 2023 James W. Johnson (giganano9@gmail.com)
+License: MIT License. See LICENSE in top-level directory
+at: https://github.com/giganano/TrackStar.git.
+
+This header file includes the features for computing the likelihood of the
+same sample many times over with a fixed team of threads, each of which keeps
+its share of the data in memory local to it.
+
+**Source File**: ``trackstar/core/src/engine.c``
+*/
+
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "sample.h"
+#include "track.h"
+#include "likelihood.h"
+
+typedef struct likelihood_engine {
+
+	/*
+	.. c:type:: LIKELIHOOD_ENGINE
+
+		A packed sample partitioned among a team of threads, along with the
+		memory that each thread needs to compute the likelihood of its
+		partition, such that repeated likelihood calculations with the same
+		sample reuse both.
+
+		.. c:member:: unsigned short n_threads
+
+			The number of threads in the team, and hence of partitions.
+
+		.. c:member:: unsigned long n_vectors
+
+			The total number of data vectors across all partitions.
+
+		.. c:member:: PACKED_SAMPLE **partitions
+
+			The data assigned to each thread, copied by that thread (see
+			:c:func:`packed_sample_slice`).
+
+		.. c:member:: LIKELIHOOD_CONTEXT **contexts
+
+			The single-threaded context that each thread computes the
+			likelihood of its partition with, allocated by that thread the
+			first time it is needed. ``NULL`` until then.
+
+		.. c:member:: unsigned short *n_points
+
+			The largest number of points along a track that each element of
+			:c:member:`contexts` has room for.
+
+		.. c:member:: unsigned short *dims
+
+			The largest number of quantities predicted by a track that each
+			element of :c:member:`contexts` has room for.
+
+		.. c:member:: double *by_thread
+
+			The log-likelihood of each partition as of the most recent
+			calculation, one cache line apart.
+	*/
+
+	unsigned short n_threads;
+	unsigned long n_vectors;
+	PACKED_SAMPLE **partitions;
+	LIKELIHOOD_CONTEXT **contexts;
+	unsigned short *n_points;
+	unsigned short *dims;
+	double *by_thread;
+
+} LIKELIHOOD_ENGINE;
+
+/*
+.. c:function:: extern LIKELIHOOD_ENGINE *likelihood_engine_initialize(const PACKED_SAMPLE *p, const unsigned short n_threads);
+
+	Partition a packed sample among a team of threads for repeated likelihood
+	calculations.
+
+	Parameters
+	----------
+	p : ``const PACKED_SAMPLE *``
+		The packed sample, as returned by :c:func:`sample_pack`. It is copied,
+		so it may be freed or invalidated afterwards.
+	n_threads : ``const unsigned short``
+		The number of threads to partition the data among.
+
+	Returns
+	-------
+	e : ``LIKELIHOOD_ENGINE *``
+		The newly constructed engine.
+
+	Notes
+	-----
+	The data are split into :c:member:`LIKELIHOOD_ENGINE.n_threads` partitions
+	of consecutive data of nearly equal size, each of which is copied by the
+	thread that computes its likelihood. Operating systems place memory on the
+	node of a non-uniform memory access (NUMA) machine that first writes to it,
+	so each partition resides in memory local to its thread as long as that
+	thread stays on the same processor. The threads are bound to processors
+	spread as evenly as possible across the machine by OpenMP's
+	``proc_bind(spread)`` policy, which takes effect whenever the OpenMP
+	runtime binds threads at all (e.g. with the environment variable
+	``OMP_PLACES=cores``).
+
+	The OpenMP runtime keeps its threads alive between parallel regions with
+	the same number of threads, so every calculation with the engine reuses
+	the same team, and each thread finds its partition and its scratch memory
+	where it left them.
+*/
+extern LIKELIHOOD_ENGINE *likelihood_engine_initialize(const PACKED_SAMPLE *p,
+	const unsigned short n_threads);
+
+/*
+.. c:function:: extern void likelihood_engine_free(LIKELIHOOD_ENGINE *e);
+
+	Free up the memory stored by a :c:type:`LIKELIHOOD_ENGINE`.
+
+	Parameters
+	----------
+	e : ``LIKELIHOOD_ENGINE *``
+		The engine to be freed.
+*/
+extern void likelihood_engine_free(LIKELIHOOD_ENGINE *e);
+
+/*
+.. c:function:: extern double loglikelihood_engine(LIKELIHOOD_ENGINE *e, const LIKELIHOOD_CONTEXT *c);
+
+	Compute the natural logarithm of the likelihood of observing the sample
+	that an engine was constructed from, given the track and settings of a
+	context.
+
+	Parameters
+	----------
+	e : ``LIKELIHOOD_ENGINE *``
+		The engine to compute the likelihood with.
+	c : ``const LIKELIHOOD_CONTEXT *``
+		The context whose :c:member:`LIKELIHOOD_CONTEXT.track`,
+		:c:member:`LIKELIHOOD_CONTEXT.normalize_weights`,
+		:c:member:`LIKELIHOOD_CONTEXT.use_line_segment_corrections`, and
+		:c:member:`LIKELIHOOD_CONTEXT.pruning_threshold` are to be used. It is
+		not modified.
+
+	Returns
+	-------
+	logl : ``double``
+		The natural logarithm of the likelihood of observation, as would be
+		computed by :c:func:`loglikelihood_context_sample`, up to the order in
+		which the contributions of the data are summed.
+
+	Notes
+	-----
+	:c:member:`LIKELIHOOD_CONTEXT.n_threads` and
+	:c:member:`LIKELIHOOD_CONTEXT.parallel_policy` do not apply here; the data
+	are always parallelized over, with :c:member:`LIKELIHOOD_ENGINE.n_threads`
+	threads. Each thread computes the likelihood of every data vector in its
+	partition with its own context, which projects the track onto the
+	quantities measured for the data in local memory as well.
+
+	Each engine supports only one calculation at a time, because its threads
+	reuse their contexts.
+*/
+extern double loglikelihood_engine(LIKELIHOOD_ENGINE *e,
+	const LIKELIHOOD_CONTEXT *c);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* ENGINE_H */
@@ -0,0 +1,539 @@
+/*
+This file is part of the TrackStar package.
+Copyright (C) 2023 James W. Johnson (giganano9@gmail.com)
+License: MIT License. See LICENSE in top-level directory
+at: https://github.com/giganano/TrackStar.git.
+*/
+
+#include <stdlib.h>
+#include "kernels.h"
+#include "blas.h"
+#include "debug.h"
+
+/*
+The SIMD directives need only -fopenmp-simd, which the setup script passes
+whether or not TrackStar is linked with OpenMP.
+*/
+#if defined(_OPENMP) || defined(TRACKSTAR_OPENMP_SIMD)
+	#define SIMD_LOOP _Pragma("omp simd")
+#else
+	#define SIMD_LOOP
+#endif /* _OPENMP || TRACKSTAR_OPENMP_SIMD */
+
+/*
+Whether or not the compiler unrolls small loops on its own depends on the
+optimization level, so the loops over the components of the unrolled kernel
+request it explicitly.
+*/
+#if defined(__GNUC__)
+	#define ALWAYS_INLINE __attribute__((always_inline))
+	#define UNROLL _Pragma("GCC unroll 8")
+#else
+	#define ALWAYS_INLINE
+	#define UNROLL
+#endif /* __GNUC__ */
+
+/* ---------- Static function comment headers not duplicated here ---------- */
+static inline ALWAYS_INLINE void chi_squared_unrolled(
+	const double *restrict vector, const double *restrict inv,
+	const double *restrict projected, const unsigned long stride,
+	const unsigned short dim, const unsigned short n_points,
+	double *restrict chisq);
+static inline ALWAYS_INLINE void chi_squared_unrolled_single(
+	const float *restrict vector, const float *restrict inv,
+	const float *restrict projected, const unsigned long stride,
+	const unsigned short dim, const unsigned short n_points,
+	float *restrict chisq);
+static void chi_squared_generic_single(const float *restrict vector,
+	const float *restrict inv, const float *restrict projected,
+	const unsigned long stride, const unsigned short dim,
+	const unsigned short n_points, float *restrict chisq);
+#if defined(TRACKSTAR_BLAS)
+	static void chi_squared_blas(const double *restrict vector,
+		const double *restrict inv, const double *restrict projected,
+		const unsigned long stride, const unsigned short dim,
+		const unsigned short n_points, double *restrict chisq);
+#else
+	static void chi_squared_generic(const double *restrict vector,
+		const double *restrict inv, const double *restrict projected,
+		const unsigned long stride, const unsigned short dim,
+		const unsigned short n_points, double *restrict chisq);
+#endif /* TRACKSTAR_BLAS */
+
+
+/*
+.. c:function:: extern void chi_squared_points(const double *vector, const double *inv, const double *projected, const unsigned long stride, const unsigned short dim, const unsigned short n_points, double *chisq);
+
+	Compute the value of :math:`\chi^2` for one datum and each of several
+	consecutive points along a model-predicted track.
+
+	Parameters
+	----------
+	vector : ``const double *``
+		The datum vector, with ``dim`` components.
+	inv : ``const double *``
+		The upper triangle of the inverse covariance matrix of the datum,
+		packed row by row (see :c:func:`packed_index`).
+	projected : ``const double *``
+		The track, projected onto the quantities measured for the datum and
+		stored column by column: the ``k``'th component of the ``j``'th point
+		is at ``projected[k * stride + j]``.
+	stride : ``const unsigned long``
+		The distance in memory between consecutive columns of ``projected``.
+	dim : ``const unsigned short``
+		The dimensionality of the datum.
+	n_points : ``const unsigned short``
+		The number of points along the track.
+	chisq : ``double *``
+		The ``n_points`` elements in which to store :math:`\chi^2 =
+		\Delta C^{-1} \Delta^T` for each point, where :math:`\Delta` is the
+		vector difference between the datum and the point.
+
+	Notes
+	-----
+	The loop over points is vectorized: each SIMD lane handles one point
+	along the track, loading its components from consecutive addresses in
+	every column. For 1 through :c:macro:`CHI_SQUARED_MAX_UNROLLED`
+	dimensions, the quadratic form is unrolled at compile time, such that
+	each lane holds the full vector difference in registers. The function is
+	compiled for several instruction sets if :c:macro:`TARGET_CLONES` is
+	available. At higher dimensionality, if TrackStar was linked with a BLAS
+	library, the quadratic forms for all of the points are instead computed
+	as a single matrix product with ``dgemm``.
+*/
+TARGET_CLONES extern void chi_squared_points(const double *vector,
+	const double *inv, const double *projected, const unsigned long stride,
+	const unsigned short dim, const unsigned short n_points, double *chisq) {
+
+	/*
+	Each case passes a compile-time constant dimensionality to the inlined
+	kernel, so the compiler can unroll its inner loops completely.
+	*/
+	switch (dim) {
+
+		case 1u:
+			chi_squared_unrolled(vector, inv, projected, stride, 1u, n_points,
+				chisq);
+			break;
+
+		case 2u:
+			chi_squared_unrolled(vector, inv, projected, stride, 2u, n_points,
+				chisq);
+			break;
+
+		case 3u:
+			chi_squared_unrolled(vector, inv, projected, stride, 3u, n_points,
+				chisq);
+			break;
+
+		case 4u:
+			chi_squared_unrolled(vector, inv, projected, stride, 4u, n_points,
+				chisq);
+			break;
+
+		case 5u:
+			chi_squared_unrolled(vector, inv, projected, stride, 5u, n_points,
+				chisq);
+			break;
+
+		case 6u:
+			chi_squared_unrolled(vector, inv, projected, stride, 6u, n_points,
+				chisq);
+			break;
+
+		case 7u:
+			chi_squared_unrolled(vector, inv, projected, stride, 7u, n_points,
+				chisq);
+			break;
+
+		case 8u:
+			chi_squared_unrolled(vector, inv, projected, stride, 8u, n_points,
+				chisq);
+			break;
+
+		default:
+			#if defined(TRACKSTAR_BLAS)
+				chi_squared_blas(vector, inv, projected, stride, dim, n_points,
+					chisq);
+			#else
+				chi_squared_generic(vector, inv, projected, stride, dim,
+					n_points, chisq);
+			#endif
+			break;
+
+	}
+
+}
+
+
+/*
+.. c:function:: static inline void chi_squared_unrolled(const double *restrict vector, const double *restrict inv, const double *restrict projected, const unsigned long stride, const unsigned short dim, const unsigned short n_points, double *restrict chisq);
+
+	The kernel behind :c:func:`chi_squared_points` for data with at most
+	:c:macro:`CHI_SQUARED_MAX_UNROLLED` dimensions. Always inlined, and only
+	ever called with a constant ``dim``.
+
+	Parameters
+	----------
+	See :c:func:`chi_squared_points`.
+*/
+static inline ALWAYS_INLINE void chi_squared_unrolled(
+	const double *restrict vector, const double *restrict inv,
+	const double *restrict projected, const unsigned long stride,
+	const unsigned short dim, const unsigned short n_points,
+	double *restrict chisq) {
+
+	SIMD_LOOP
+	for (unsigned short j = 0u; j < n_points; j++) {
+		double delta[CHI_SQUARED_MAX_UNROLLED];
+		UNROLL
+		for (unsigned short k = 0u; k < dim; k++) {
+			delta[k] = vector[k] - projected[k * stride + j];
+		}
+
+		/*
+		Each off-diagonal element of the upper triangle stands in for both
+		C_kl and C_lk, hence the factor of 2.
+		*/
+		unsigned short index = 0u;
+		double result = 0;
+		UNROLL
+		for (unsigned short k = 0u; k < dim; k++) {
+			double diagonal = inv[index++] * delta[k];
+			double off_diagonal = 0;
+			UNROLL
+			for (unsigned short l = k + 1u; l < dim; l++) {
+				off_diagonal += inv[index++] * delta[l];
+			}
+			result += delta[k] * (diagonal + 2 * off_diagonal);
+		}
+		chisq[j] = result;
+	}
+
+}
+
+
+/*
+.. c:function:: extern void chi_squared_points_single(const float *vector, const float *inv, const float *projected, const unsigned long stride, const unsigned short dim, const unsigned short n_points, float *chisq);
+
+	The single precision counterpart of :c:func:`chi_squared_points`, with
+	the same parameters.
+
+	Notes
+	-----
+	Each SIMD register holds twice as many points as in double precision, and
+	the projected track occupies half as much cache. For 1 through
+	:c:macro:`CHI_SQUARED_MAX_UNROLLED` dimensions, the quadratic form is
+	unrolled at compile time as in double precision. At higher
+	dimensionality, the generic kernel is used whether or not TrackStar was
+	linked with a BLAS library.
+*/
+TARGET_CLONES extern void chi_squared_points_single(const float *vector,
+	const float *inv, const float *projected, const unsigned long stride,
+	const unsigned short dim, const unsigned short n_points, float *chisq) {
+
+	/* See the comment in chi_squared_points */
+	switch (dim) {
+
+		case 1u:
+			chi_squared_unrolled_single(vector, inv, projected, stride, 1u,
+				n_points, chisq);
+			break;
+
+		case 2u:
+			chi_squared_unrolled_single(vector, inv, projected, stride, 2u,
+				n_points, chisq);
+			break;
+
+		case 3u:
+			chi_squared_unrolled_single(vector, inv, projected, stride, 3u,
+				n_points, chisq);
+			break;
+
+		case 4u:
+			chi_squared_unrolled_single(vector, inv, projected, stride, 4u,
+				n_points, chisq);
+			break;
+
+		case 5u:
+			chi_squared_unrolled_single(vector, inv, projected, stride, 5u,
+				n_points, chisq);
+			break;
+
+		case 6u:
+			chi_squared_unrolled_single(vector, inv, projected, stride, 6u,
+				n_points, chisq);
+			break;
+
+		case 7u:
+			chi_squared_unrolled_single(vector, inv, projected, stride, 7u,
+				n_points, chisq);
+			break;
+
+		case 8u:
+			chi_squared_unrolled_single(vector, inv, projected, stride, 8u,
+				n_points, chisq);
+			break;
+
+		default:
+			chi_squared_generic_single(vector, inv, projected, stride, dim,
+				n_points, chisq);
+			break;
+
+	}
+
+}
+
+
+/*
+.. c:function:: static inline void chi_squared_unrolled_single(const float *restrict vector, const float *restrict inv, const float *restrict projected, const unsigned long stride, const unsigned short dim, const unsigned short n_points, float *restrict chisq);
+
+	The single precision counterpart of :c:func:`chi_squared_unrolled`.
+
+	Parameters
+	----------
+	See :c:func:`chi_squared_points`.
+*/
+static inline ALWAYS_INLINE void chi_squared_unrolled_single(
+	const float *restrict vector, const float *restrict inv,
+	const float *restrict projected, const unsigned long stride,
+	const unsigned short dim, const unsigned short n_points,
+	float *restrict chisq) {
+
+	SIMD_LOOP
+	for (unsigned short j = 0u; j < n_points; j++) {
+		float delta[CHI_SQUARED_MAX_UNROLLED];
+		UNROLL
+		for (unsigned short k = 0u; k < dim; k++) {
+			delta[k] = vector[k] - projected[k * stride + j];
+		}
+		unsigned short index = 0u;
+		float result = 0;
+		UNROLL
+		for (unsigned short k = 0u; k < dim; k++) {
+			float diagonal = inv[index++] * delta[k];
+			float off_diagonal = 0;
+			UNROLL
+			for (unsigned short l = k + 1u; l < dim; l++) {
+				off_diagonal += inv[index++] * delta[l];
+			}
+			result += delta[k] * (diagonal + 2 * off_diagonal);
+		}
+		chisq[j] = result;
+	}
+
+}
+
+
+/*
+.. c:function:: static void chi_squared_generic_single(const float *restrict vector, const float *restrict inv, const float *restrict projected, const unsigned long stride, const unsigned short dim, const unsigned short n_points, float *restrict chisq);
+
+	The single precision counterpart of :c:func:`chi_squared_generic`, which
+	is compiled with or without a BLAS library.
+
+	Parameters
+	----------
+	See :c:func:`chi_squared_points`.
+*/
+static void chi_squared_generic_single(const float *restrict vector,
+	const float *restrict inv, const float *restrict projected,
+	const unsigned long stride, const unsigned short dim,
+	const unsigned short n_points, float *restrict chisq) {
+
+	SIMD_LOOP
+	for (unsigned short j = 0u; j < n_points; j++) chisq[j] = 0;
+
+	unsigned long index = 0ul;
+	for (unsigned short k = 0u; k < dim; k++) {
+		const float *column_k = projected + k * stride;
+		const float x_k = vector[k];
+		const float diagonal = inv[index++];
+		SIMD_LOOP
+		for (unsigned short j = 0u; j < n_points; j++) {
+			float delta = x_k - column_k[j];
+			chisq[j] += diagonal * delta * delta;
+		}
+		for (unsigned short l = k + 1u; l < dim; l++) {
+			const float *column_l = projected + l * stride;
+			const float x_l = vector[l];
+			const float off_diagonal = 2 * inv[index++];
+			SIMD_LOOP
+			for (unsigned short j = 0u; j < n_points; j++) {
+				chisq[j] += off_diagonal * (x_k - column_k[j]) * (
+					x_l - column_l[j]);
+			}
+		}
+	}
+
+}
+
+
+/*
+.. c:function:: extern void squared_distance_points(const double *vector, const double *projected, const unsigned long stride, const unsigned short dim, const unsigned short n_points, double *chisq);
+
+	Compute the squared Euclidean distance between one vector and each of
+	several consecutive points along a model-predicted track, which is
+	:math:`\chi^2` if both are expressed in the whitened frame of the
+	datum's covariance matrix (see :c:member:`PACKED_GROUP.transform`).
+
+	Parameters
+	----------
+	vector : ``const double *``
+		The vector, with ``dim`` components.
+	projected : ``const double *``
+		The track, stored column by column as in
+		:c:func:`chi_squared_points`.
+	stride : ``const unsigned long``
+		The distance in memory between consecutive columns of ``projected``.
+	dim : ``const unsigned short``
+		The dimensionality of the vector.
+	n_points : ``const unsigned short``
+		The number of points along the track.
+	chisq : ``double *``
+		The ``n_points`` elements in which to store the squared distances.
+
+	Notes
+	-----
+	Without an inverse covariance matrix to multiply by, each component
+	costs one subtraction and one fused multiply-add per point, against
+	roughly ``dim / 2`` of them for :c:func:`chi_squared_points`. The
+	columns are visited one at a time, with the loop over points vectorized.
+*/
+TARGET_CLONES extern void squared_distance_points(const double *vector,
+	const double *projected, const unsigned long stride,
+	const unsigned short dim, const unsigned short n_points, double *chisq) {
+
+	SIMD_LOOP
+	for (unsigned short j = 0u; j < n_points; j++) chisq[j] = 0;
+	for (unsigned short k = 0u; k < dim; k++) {
+		const double *column = projected + k * stride;
+		const double x = vector[k];
+		SIMD_LOOP
+		for (unsigned short j = 0u; j < n_points; j++) {
+			double delta = x - column[j];
+			chisq[j] += delta * delta;
+		}
+	}
+
+}
+
+
+#if !defined(TRACKSTAR_BLAS)
+/*
+.. c:function:: static void chi_squared_generic(const double *restrict vector, const double *restrict inv, const double *restrict projected, const unsigned long stride, const unsigned short dim, const unsigned short n_points, double *restrict chisq);
+
+	The kernel behind :c:func:`chi_squared_points` for data of any
+	dimensionality.
+
+	Parameters
+	----------
+	See :c:func:`chi_squared_points`.
+
+	Notes
+	-----
+	Rather than holding the whole vector difference for each point at once,
+	this kernel accumulates the quadratic form one element of the inverse
+	covariance matrix at a time, sweeping over all of the points for each.
+	The vectorized loop is then the same for any dimensionality, at the cost
+	of reading the columns of ``projected`` more than once.
+*/
+static void chi_squared_generic(const double *restrict vector,
+	const double *restrict inv, const double *restrict projected,
+	const unsigned long stride, const unsigned short dim,
+	const unsigned short n_points, double *restrict chisq) {
+
+	SIMD_LOOP
+	for (unsigned short j = 0u; j < n_points; j++) chisq[j] = 0;
+
+	unsigned long index = 0ul;
+	for (unsigned short k = 0u; k < dim; k++) {
+		const double *column_k = projected + k * stride;
+		const double x_k = vector[k];
+		const double diagonal = inv[index++];
+		SIMD_LOOP
+		for (unsigned short j = 0u; j < n_points; j++) {
+			double delta = x_k - column_k[j];
+			chisq[j] += diagonal * delta * delta;
+		}
+		for (unsigned short l = k + 1u; l < dim; l++) {
+			const double *column_l = projected + l * stride;
+			const double x_l = vector[l];
+			const double off_diagonal = 2 * inv[index++];
+			SIMD_LOOP
+			for (unsigned short j = 0u; j < n_points; j++) {
+				chisq[j] += off_diagonal * (x_k - column_k[j]) * (
+					x_l - column_l[j]);
+			}
+		}
+	}
+
+}
+#endif /* TRACKSTAR_BLAS */
+
+
+#if defined(TRACKSTAR_BLAS)
+/*
+.. c:function:: static void chi_squared_blas(const double *restrict vector, const double *restrict inv, const double *restrict projected, const unsigned long stride, const unsigned short dim, const unsigned short n_points, double *restrict chisq);
+
+	The kernel behind :c:func:`chi_squared_points` for data with more than
+	:c:macro:`CHI_SQUARED_MAX_UNROLLED` dimensions when TrackStar is linked
+	with a BLAS library.
+
+	Parameters
+	----------
+	See :c:func:`chi_squared_points`.
+
+	Notes
+	-----
+	With the vector differences for all of the points stored as the columns
+	of an ``n_points`` x ``dim`` matrix :math:`D`, the product :math:`T =
+	DC^{-1}` is a single call to ``dgemm``, and :math:`\chi^2_j = \sum_k
+	D_{jk} T_{jk}`. This does twice the arithmetic of the generic kernel,
+	which exploits the symmetry of :math:`C^{-1}`, but ``dgemm`` keeps the
+	operands in registers and cache far better, which more than makes up for
+	it beyond :c:macro:`CHI_SQUARED_MAX_UNROLLED` dimensions.
+*/
+static void chi_squared_blas(const double *restrict vector,
+	const double *restrict inv, const double *restrict projected,
+	const unsigned long stride, const unsigned short dim,
+	const unsigned short n_points, double *restrict chisq) {
+
+	if (!n_points) return;
+	unsigned long n_elements = (unsigned long) n_points * dim;
+	double *full = (double *) calloc (
+		(unsigned long) dim * dim + 2ul * n_elements, sizeof(double));
+	if (full == NULL) fatal_print("%s\n", "Kernel allocation failed.");
+	double *delta = full + (unsigned long) dim * dim;
+	double *product = delta + n_elements;
+
+	unsigned long index = 0ul;
+	for (unsigned long k = 0ul; k < dim; k++) {
+		full[k * dim + k] = inv[index++];
+		for (unsigned long l = k + 1ul; l < dim; l++) {
+			full[k * dim + l] = inv[index];
+			full[l * dim + k] = inv[index++];
+		}
+		const double *column = projected + k * stride;
+		double *difference = delta + k * n_points;
+		SIMD_LOOP
+		for (unsigned short j = 0u; j < n_points; j++) {
+			difference[j] = vector[k] - column[j];
+		}
+	}
+	cblas_dgemm(CblasColMajor, CblasNoTrans, CblasNoTrans, n_points, dim, dim,
+		1, delta, n_points, full, dim, 0, product, n_points);
+
+	SIMD_LOOP
+	for (unsigned short j = 0u; j < n_points; j++) chisq[j] = 0;
+	for (unsigned long k = 0ul; k < dim; k++) {
+		const double *difference = delta + k * n_points;
+		const double *row = product + k * n_points;
+		SIMD_LOOP
+		for (unsigned short j = 0u; j < n_points; j++) {
+			chisq[j] += difference[j] * row[j];
+		}
+	}
+	free(full);
+
+}
+#endif /* TRACKSTAR_BLAS */
@@ -0,0 +1,159 @@
+/*
+This file is part of the TrackStar package.
+Copyright (C) 2023 James W. Johnson (giganano9@gmail.com)
+License: MIT License. See LICENSE in top-level directory
+at: https://github.com/giganano/TrackStar.git.
+
+**Source File**: ``trackstar/core/src/kernels.c``
+*/
+
+#ifndef KERNELS_H
+#define KERNELS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+.. c:macro:: CHI_SQUARED_BLOCK
+
+	``64u``. The number of points along the track for which
+	:c:func:`chi_squared_points` is called at a time in computing the
+	likelihood. At up to 8 dimensions, a block of the projected track fits
+	comfortably in L1 cache, and there are still enough blocks along a typical
+	track to share out among threads.
+*/
+#ifndef CHI_SQUARED_BLOCK
+#define CHI_SQUARED_BLOCK 64u
+#endif /* CHI_SQUARED_BLOCK */
+
+/*
+.. c:macro:: CHI_SQUARED_MAX_UNROLLED
+
+	``8u``. The largest dimensionality for which :c:func:`chi_squared_points`
+	has a specialized kernel, with the quadratic form unrolled at compile
+	time. Data measuring more quantities than this use a generic kernel.
+*/
+#define CHI_SQUARED_MAX_UNROLLED 8u
+
+/*
+.. c:macro:: TARGET_CLONES
+
+	Expands to an attribute instructing the compiler to build a copy of a
+	function for each of several instruction sets (AVX-512, AVX2 with FMA,
+	and the baseline), the fastest of which the dynamic loader selects for
+	the CPU at hand. Defined only if the setup script determines that the
+	compiler supports it, in which case ``TRACKSTAR_TARGET_CLONES`` is
+	defined; it otherwise expands to nothing. On ARM, NEON is part of the
+	baseline instruction set, so no clones are necessary.
+*/
+#if defined(TRACKSTAR_TARGET_CLONES)
+	#define TARGET_CLONES __attribute__((target_clones("arch=skylake-avx512", \
+		"arch=haswell", "default")))
+#else
+	#define TARGET_CLONES
+#endif /* TRACKSTAR_TARGET_CLONES */
+
+/*
+.. c:function:: extern void chi_squared_points(const double *vector, const double *inv, const double *projected, const unsigned long stride, const unsigned short dim, const unsigned short n_points, double *chisq);
+
+	Compute the value of :math:`\chi^2` for one datum and each of several
+	consecutive points along a model-predicted track.
+
+	Parameters
+	----------
+	vector : ``const double *``
+		The datum vector, with ``dim`` components.
+	inv : ``const double *``
+		The upper triangle of the inverse covariance matrix of the datum,
+		packed row by row (see :c:func:`packed_index`).
+	projected : ``const double *``
+		The track, projected onto the quantities measured for the datum and
+		stored column by column: the ``k``'th component of the ``j``'th point
+		is at ``projected[k * stride + j]``.
+	stride : ``const unsigned long``
+		The distance in memory between consecutive columns of ``projected``.
+	dim : ``const unsigned short``
+		The dimensionality of the datum.
+	n_points : ``const unsigned short``
+		The number of points along the track.
+	chisq : ``double *``
+		The ``n_points`` elements in which to store :math:`\chi^2 =
+		\Delta C^{-1} \Delta^T` for each point, where :math:`\Delta` is the
+		vector difference between the datum and the point.
+
+	Notes
+	-----
+	The loop over points is vectorized: each SIMD lane handles one point
+	along the track, loading its components from consecutive addresses in
+	every column. For 1 through :c:macro:`CHI_SQUARED_MAX_UNROLLED`
+	dimensions, the quadratic form is unrolled at compile time, such that
+	each lane holds the full vector difference in registers. The function is
+	compiled for several instruction sets if :c:macro:`TARGET_CLONES` is
+	available. At higher dimensionality, if TrackStar was linked with a BLAS
+	library, the quadratic forms for all of the points are instead computed
+	as a single matrix product with ``dgemm``.
+*/
+extern void chi_squared_points(const double *vector, const double *inv,
+	const double *projected, const unsigned long stride,
+	const unsigned short dim, const unsigned short n_points, double *chisq);
+
+/*
+.. c:function:: extern void chi_squared_points_single(const float *vector, const float *inv, const float *projected, const unsigned long stride, const unsigned short dim, const unsigned short n_points, float *chisq);
+
+	The single precision counterpart of :c:func:`chi_squared_points`, with
+	the same parameters.
+
+	Notes
+	-----
+	Each SIMD register holds twice as many points as in double precision, and
+	the projected track occupies half as much cache. For 1 through
+	:c:macro:`CHI_SQUARED_MAX_UNROLLED` dimensions, the quadratic form is
+	unrolled at compile time as in double precision. At higher
+	dimensionality, the generic kernel is used whether or not TrackStar was
+	linked with a BLAS library.
+*/
+extern void chi_squared_points_single(const float *vector, const float *inv,
+	const float *projected, const unsigned long stride,
+	const unsigned short dim, const unsigned short n_points, float *chisq);
+
+/*
+.. c:function:: extern void squared_distance_points(const double *vector, const double *projected, const unsigned long stride, const unsigned short dim, const unsigned short n_points, double *chisq);
+
+	Compute the squared Euclidean distance between one vector and each of
+	several consecutive points along a model-predicted track, which is
+	:math:`\chi^2` if both are expressed in the whitened frame of the
+	datum's covariance matrix (see :c:member:`PACKED_GROUP.transform`).
+
+	Parameters
+	----------
+	vector : ``const double *``
+		The vector, with ``dim`` components.
+	projected : ``const double *``
+		The track, stored column by column as in
+		:c:func:`chi_squared_points`.
+	stride : ``const unsigned long``
+		The distance in memory between consecutive columns of ``projected``.
+	dim : ``const unsigned short``
+		The dimensionality of the vector.
+	n_points : ``const unsigned short``
+		The number of points along the track.
+	chisq : ``double *``
+		The ``n_points`` elements in which to store the squared distances.
+
+	Notes
+	-----
+	Without an inverse covariance matrix to multiply by, each component
+	costs one subtraction and one fused multiply-add per point, against
+	roughly ``dim / 2`` of them for :c:func:`chi_squared_points`. The
+	columns are visited one at a time, with the loop over points vectorized.
+*/
+extern void squared_distance_points(const double *vector,
+	const double *projected, const unsigned long stride,
+	const unsigned short dim, const unsigned short n_points, double *chisq);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* KERNELS_H */
@@ -0,0 +1,224 @@
+/*
+This file is part of the TrackStar package.
+Copyright (C) 2023 James W. Johnson (giganano9@gmail.com)
+License: MIT License. See LICENSE in top-level directory
+at: https://github.com/giganano/TrackStar.git.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <stdio.h>
+#include "labels.h"
+#include "debug.h"
+
+/*
+The registry that this copy of the C library operates on. Replaced by the one
+owned by ``trackstar.core.utils`` via ``label_registry_share``.
+*/
+static LABEL_REGISTRY *REGISTRY = NULL;
+
+
+/*
+.. c:function:: extern LABEL_REGISTRY *label_registry(void);
+
+	Obtain the registry that :c:func:`label_intern` and :c:func:`label_lookup`
+	operate on, constructing an empty one if necessary.
+
+	Returns
+	-------
+	r : ``LABEL_REGISTRY *``
+		The active label registry.
+*/
+extern LABEL_REGISTRY *label_registry(void) {
+
+	if (REGISTRY == NULL) {
+		REGISTRY = (LABEL_REGISTRY *) malloc (sizeof(LABEL_REGISTRY));
+		REGISTRY -> labels = NULL;
+		REGISTRY -> n_labels = 0u;
+	} else {}
+	return REGISTRY;
+
+}
+
+
+/*
+.. c:function:: extern void label_registry_share(LABEL_REGISTRY *r);
+
+	Replace the active label registry with another one.
+
+	Parameters
+	----------
+	r : ``LABEL_REGISTRY *``
+		The registry to use from now on.
+
+	Notes
+	-----
+	Each of TrackStar's extension modules links its own copy of the C library,
+	and with it its own registry. Label IDs are only comparable if they were
+	assigned by the same registry, so every module replaces its own with the
+	one owned by ``trackstar.core.utils`` at import time, before any labels
+	have been interned. The registry being replaced is leaked only if it is
+	non-empty, which would indicate a bug.
+*/
+extern void label_registry_share(LABEL_REGISTRY *r) {
+
+	if (REGISTRY != NULL && REGISTRY != r && !(*REGISTRY).n_labels) {
+		free(REGISTRY);
+	} else {}
+	REGISTRY = r;
+
+}
+
+
+/*
+.. c:function:: extern unsigned short label_intern(const char *label);
+
+	Determine the integer ID of a label, adding it to the active registry if
+	it has not been encountered before.
+
+	Parameters
+	----------
+	label : ``const char *``
+		The label to intern.
+
+	Returns
+	-------
+	id : ``unsigned short``
+		The ID of ``label``. ``label_name(id)`` is a character-by-character
+		match to ``label``.
+*/
+extern unsigned short label_intern(const char *label) {
+
+	signed short id = label_lookup(label);
+	if (id >= 0) return (unsigned short) id;
+
+	LABEL_REGISTRY *r = label_registry();
+	if ((*r).n_labels == SHRT_MAX) fatal_print("%s\n",
+		"Label registry is full.");
+	r -> labels = (char **) realloc (r -> labels,
+		((*r).n_labels + 1u) * sizeof(char *));
+	r -> labels[(*r).n_labels] = (char *) malloc (
+		(strlen(label) + 1u) * sizeof(char));
+	strcpy(r -> labels[(*r).n_labels], label);
+	return r -> n_labels++;
+
+}
+
+
+/*
+.. c:function:: extern signed short label_lookup(const char *label);
+
+	Determine the integer ID of a label without modifying the registry.
+
+	Parameters
+	----------
+	label : ``const char *``
+		The label to search for.
+
+	Returns
+	-------
+	id : ``signed short``
+		The ID of ``label``. -1 if it has never been interned, in which case no
+		datum or track carries it.
+*/
+extern signed short label_lookup(const char *label) {
+
+	LABEL_REGISTRY *r = label_registry();
+	for (unsigned short i = 0u; i < (*r).n_labels; i++) {
+		if (!strcmp((*r).labels[i], label)) return (signed short) i;
+	}
+	return -1;
+
+}
+
+
+/*
+.. c:function:: extern char *label_name(unsigned short id);
+
+	Obtain the interned copy of the label with a given ID.
+
+	Parameters
+	----------
+	id : ``unsigned short``
+		The ID of the label, as returned by :c:func:`label_intern`.
+
+	Returns
+	-------
+	label : ``char *``
+		The label itself, owned by the registry. This string must not be
+		modified or freed.
+*/
+extern char *label_name(unsigned short id) {
+
+	LABEL_REGISTRY *r = label_registry();
+	if (id >= (*r).n_labels) fatal_print("Invalid label ID: %u\n", id);
+	return (*r).labels[id];
+
+}
+
+
+/*
+.. c:function:: extern signed short idindex(const unsigned short *ids, unsigned short id, unsigned short n_ids);
+
+	The integer ID analog of :c:func:`strindex`: determine the index of a
+	label ID within an array of them.
+
+	Parameters
+	----------
+	ids : ``const unsigned short *``
+		The array of IDs to search through.
+	id : ``unsigned short``
+		The ID to search for.
+	n_ids : ``unsigned short``
+		The number of elements in ``ids``.
+
+	Returns
+	-------
+	idx : ``signed short``
+		If >= 0, then ``ids[idx] == id``. -1 if there is no such element.
+*/
+extern signed short idindex(const unsigned short *ids, unsigned short id,
+	unsigned short n_ids) {
+
+	for (unsigned short i = 0u; i < n_ids; i++) {
+		if (ids[i] == id) return (signed short) i;
+	}
+	return -1;
+
+}
+
+
+/*
+.. c:function:: extern unsigned long label_mask(const unsigned short *ids, unsigned short n_ids);
+
+	Compute the bitmask of a set of label IDs.
+
+	Parameters
+	----------
+	ids : ``const unsigned short *``
+		The IDs of the labels.
+	n_ids : ``unsigned short``
+		The number of elements in ``ids``.
+
+	Returns
+	-------
+	mask : ``unsigned long``
+		The bitwise OR of :c:macro:`LABEL_BIT` for each element of ``ids``.
+
+	Notes
+	-----
+	While fewer than :c:macro:`LABEL_MASK_BITS` labels have been interned,
+	two sets of labels are identical if and only if they have the same mask.
+	Past that point, equal masks are necessary but not sufficient, so callers
+	confirm a match with :c:func:`idindex`, but unequal masks still rule one
+	out without looking at the IDs themselves.
+*/
+extern unsigned long label_mask(const unsigned short *ids,
+	unsigned short n_ids) {
+
+	unsigned long mask = 0ul;
+	for (unsigned short i = 0u; i < n_ids; i++) mask |= LABEL_BIT(ids[i]);
+	return mask;
+
+}
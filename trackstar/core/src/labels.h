@@ -0,0 +1,202 @@
+/*
+This file is part of the TrackStar package.
+Copyright (C) 2023 James W. Johnson (giganano9@gmail.com)
+License: MIT License. See LICENSE in top-level directory
+at: https://github.com/giganano/TrackStar.git.
+
+**Source File**: ``trackstar/core/src/labels.c``
+*/
+
+#ifndef LABELS_H
+#define LABELS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+.. c:macro:: LABEL_MASK_BITS
+
+	The number of bits in the ``unsigned long`` masks computed by
+	:c:func:`label_mask`.
+*/
+#define LABEL_MASK_BITS (8u * sizeof(unsigned long))
+
+/*
+.. c:macro:: LABEL_BIT(id)
+
+	The bit of a label mask that is set for the label with the integer ID
+	``id``. IDs that differ by a multiple of :c:macro:`LABEL_MASK_BITS` share
+	a bit.
+*/
+#define LABEL_BIT(id) (1ul << ((id) % LABEL_MASK_BITS))
+
+typedef struct label_registry {
+
+	/*
+	.. c:type:: LABEL_REGISTRY
+
+		The set of all the labels that TrackStar has encountered, each of
+		which has been assigned a small integer ID by :c:func:`label_intern`.
+
+		.. c:member:: char **labels
+
+			The labels themselves. The ID of each label is its index in this
+			array. These strings are never freed or modified once added, so
+			pointers to them may be stored freely elsewhere.
+
+		.. c:member:: unsigned short n_labels
+
+			The number of elements in :c:member:`labels`.
+	*/
+
+	char **labels;
+	unsigned short n_labels;
+
+} LABEL_REGISTRY;
+
+/*
+.. c:function:: extern LABEL_REGISTRY *label_registry(void);
+
+	Obtain the registry that :c:func:`label_intern` and :c:func:`label_lookup`
+	operate on, constructing an empty one if necessary.
+
+	Returns
+	-------
+	r : ``LABEL_REGISTRY *``
+		The active label registry.
+*/
+extern LABEL_REGISTRY *label_registry(void);
+
+/*
+.. c:function:: extern void label_registry_share(LABEL_REGISTRY *r);
+
+	Replace the active label registry with another one.
+
+	Parameters
+	----------
+	r : ``LABEL_REGISTRY *``
+		The registry to use from now on.
+
+	Notes
+	-----
+	Each of TrackStar's extension modules links its own copy of the C library,
+	and with it its own registry. Label IDs are only comparable if they were
+	assigned by the same registry, so every module replaces its own with the
+	one owned by ``trackstar.core.utils`` at import time, before any labels
+	have been interned. The registry being replaced is leaked only if it is
+	non-empty, which would indicate a bug.
+*/
+extern void label_registry_share(LABEL_REGISTRY *r);
+
+/*
+.. c:function:: extern unsigned short label_intern(const char *label);
+
+	Determine the integer ID of a label, adding it to the active registry if
+	it has not been encountered before.
+
+	Parameters
+	----------
+	label : ``const char *``
+		The label to intern.
+
+	Returns
+	-------
+	id : ``unsigned short``
+		The ID of ``label``. ``label_name(id)`` is a character-by-character
+		match to ``label``.
+*/
+extern unsigned short label_intern(const char *label);
+
+/*
+.. c:function:: extern signed short label_lookup(const char *label);
+
+	Determine the integer ID of a label without modifying the registry.
+
+	Parameters
+	----------
+	label : ``const char *``
+		The label to search for.
+
+	Returns
+	-------
+	id : ``signed short``
+		The ID of ``label``. -1 if it has never been interned, in which case no
+		datum or track carries it.
+*/
+extern signed short label_lookup(const char *label);
+
+/*
+.. c:function:: extern char *label_name(unsigned short id);
+
+	Obtain the interned copy of the label with a given ID.
+
+	Parameters
+	----------
+	id : ``unsigned short``
+		The ID of the label, as returned by :c:func:`label_intern`.
+
+	Returns
+	-------
+	label : ``char *``
+		The label itself, owned by the registry. This string must not be
+		modified or freed.
+*/
+extern char *label_name(unsigned short id);
+
+/*
+.. c:function:: extern signed short idindex(const unsigned short *ids, unsigned short id, unsigned short n_ids);
+
+	The integer ID analog of :c:func:`strindex`: determine the index of a
+	label ID within an array of them.
+
+	Parameters
+	----------
+	ids : ``const unsigned short *``
+		The array of IDs to search through.
+	id : ``unsigned short``
+		The ID to search for.
+	n_ids : ``unsigned short``
+		The number of elements in ``ids``.
+
+	Returns
+	-------
+	idx : ``signed short``
+		If >= 0, then ``ids[idx] == id``. -1 if there is no such element.
+*/
+extern signed short idindex(const unsigned short *ids, unsigned short id,
+	unsigned short n_ids);
+
+/*
+.. c:function:: extern unsigned long label_mask(const unsigned short *ids, unsigned short n_ids);
+
+	Compute the bitmask of a set of label IDs.
+
+	Parameters
+	----------
+	ids : ``const unsigned short *``
+		The IDs of the labels.
+	n_ids : ``unsigned short``
+		The number of elements in ``ids``.
+
+	Returns
+	-------
+	mask : ``unsigned long``
+		The bitwise OR of :c:macro:`LABEL_BIT` for each element of ``ids``.
+
+	Notes
+	-----
+	While fewer than :c:macro:`LABEL_MASK_BITS` labels have been interned,
+	two sets of labels are identical if and only if they have the same mask.
+	Past that point, equal masks are necessary but not sufficient, so callers
+	confirm a match with :c:func:`idindex`, but unequal masks still rule one
+	out without looking at the IDs themselves.
+*/
+extern unsigned long label_mask(const unsigned short *ids,
+	unsigned short n_ids);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* LABELS_H */
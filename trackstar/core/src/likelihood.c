@@ -11,25 +11,187 @@ at: https://github.com/giganano/TrackStar.git.
 #include "multithread.h"
 #include "likelihood.h"
 #include "quadrature.h"
+#include "kernels.h"
 #include "matrix.h"
+#include "labels.h"
 #include "utils.h"
+#include "profiling.h"
 #include "debug.h"
 #include "utils.h"
 
+struct track_view {
+
+	/*
+	.. c:struct:: track_view
+
+		A projection of a :c:type:`TRACK` onto some of its columns, laid out
+		such that the likelihood of observing a datum can be computed for
+		many points along the track at once with SIMD instructions.
+
+		.. c:member:: LIKELIHOOD_CONTEXT *context
+
+			The context of the likelihood calculation, which owns the memory
+			that :c:member:`columns` and :c:member:`coefficients` point to.
+
+		.. c:member:: const TRACK *track
+
+			The full track.
+
+		.. c:member:: const unsigned short *columns
+
+			The column of :c:member:`track` corresponding to each component of
+			the data vectors in question.
+
+		.. c:member:: unsigned short dim
+
+			The number of elements in :c:member:`columns`.
+
+		.. c:member:: double *coefficients
+
+			The weight of each point along the track multiplied by the length
+			of the line segment connecting it to the next point in the
+			projected space (see ``delta_model``). These are the same for every
+			datum measuring the same quantities, so they are computed once.
+
+		.. c:member:: const double *log_coefficients
+
+			The natural logarithm of each element of :c:member:`coefficients`,
+			or ``NULL`` if the contributions of the points along the track are
+			summed in linear space.
+
+		.. c:member:: const double *projected
+
+			The predictions of :c:member:`track` for :c:member:`columns`,
+			with the ``k``'th component of the ``j``'th point at
+			``projected[k * stride + j]``.
+
+		.. c:member:: const float *projected_single
+
+			A single precision copy of :c:member:`projected` with the same
+			layout, or ``NULL`` if :math:`\chi^2` is computed in double
+			precision (see :c:member:`LIKELIHOOD_CONTEXT.precision`).
+
+		.. c:member:: const double *whitened
+
+			The predictions of :c:member:`track` for :c:member:`columns` in
+			the whitened frame of a covariance matrix shared by every datum
+			in question, laid out like :c:member:`projected`, or ``NULL`` if
+			the data do not share one (see :c:func:`track_view_whiten`).
+
+		.. c:member:: const double *transform
+
+			The transformation into the whitened frame (see
+			:c:member:`PACKED_GROUP.transform`), or ``NULL``.
+
+		.. c:member:: unsigned long stride
+
+			The distance in memory between consecutive columns of
+			:c:member:`projected`.
+
+		.. c:member:: const double *block_lower
+
+			The lower corner of the bounding box of each block of points along
+			the track, or ``NULL`` if the boxes are not in use (see
+			:c:member:`LIKELIHOOD_CONTEXT.block_lower`).
+
+		.. c:member:: const double *block_upper
+
+			The upper corner of the bounding box of each block.
+
+		.. c:member:: const double *block_largest
+
+			The largest element of :c:member:`log_coefficients` within each
+			block.
+	*/
+
+	LIKELIHOOD_CONTEXT *context;
+	const TRACK *track;
+	const unsigned short *columns;
+	unsigned short dim;
+	double *coefficients;
+	const double *log_coefficients;
+	const double *projected;
+	const float *projected_single;
+	const double *whitened;
+	const double *transform;
+	unsigned long stride;
+	const double *block_lower;
+	const double *block_upper;
+	const double *block_largest;
+
+};
+
 /* ---------- Static function comment headers not duplicated here ---------- */
-static double normalize_weights(TRACK *t);
-static void unnormalize_weights(TRACK *t, const double weight_norm);
-static double chi_squared(DATUM d, TRACK t, const unsigned short index);
-static double delta_model(TRACK t, const unsigned short index);
-static double corrective_factor(DATUM d, TRACK t, const unsigned short index);
+static void context_weights(LIKELIHOOD_CONTEXT *c,
+	const unsigned short normalize);
+static void context_map_columns(LIKELIHOOD_CONTEXT *c,
+	const unsigned short *ids, const unsigned short dim);
+static double *context_reserve(double *buffer, unsigned long *capacity,
+	const unsigned long n);
+static double loglikelihood_data(const double *vectors, const double *inv,
+	const float *single, const double *logdet, const double *whitening,
+	const unsigned long n_data, struct track_view v);
+static const float *datum_single(const float *single,
+	const unsigned long index, struct track_view v);
+static double kernel_cache_row(const double *vector, const double *inv,
+	const double *whitening, struct track_view v, double *scratch,
+	double *row);
+static double datum_gradient(const double *vector, const double *inv,
+	const double logdet, const double *whitening, struct track_view v,
+	const double *weights, const double *log_weights, double *scratch,
+	double *row, double *grad_predictions, double *grad_weights);
+static unsigned short parallel_policy(const unsigned long n_data,
+	const unsigned short n_threads, const unsigned short requested);
+static unsigned long padded_length(const unsigned long n);
+static double loglikelihood_packed(const double *vector, const double *inv,
+	const float *single, const double logdet, const double *whitening,
+	struct track_view v, double *scratch);
+static double normalized_loglikelihood(const double *partial,
+	const double logdet);
+static void partial_sum_reset(double *partial, struct track_view v);
+static void partial_sum_merge(double *partial, const double *other);
+static void block_likelihood(const double *vector, const double *inv,
+	const float *single, const double *whitening, struct track_view v,
+	const unsigned short block, double *scratch, double *partial);
+static double block_log_contributions(const double *vector,
+	const double *inv, const float *single, struct track_view v,
+	const unsigned short block, double *scratch);
+static void block_chi_squared(const double *vector, const double *inv,
+	const float *single, struct track_view v, const unsigned short block,
+	double *chisq);
+static double block_bound(const double *vector, const double *whitening,
+	struct track_view v, const unsigned short block);
+static unsigned short most_promising_block(const double *vector,
+	const double *whitening, struct track_view v);
+static unsigned short visiting_order(const unsigned short i,
+	const unsigned short start);
+static unsigned short n_blocks(struct track_view v);
+static unsigned short block_length(struct track_view v,
+	const unsigned short block);
+static double delta_model(struct track_view v, const unsigned short index);
+static double log_corrective_factor(const double *vector, const double *inv,
+	struct track_view v, const unsigned short index, double *scratch);
 static double corrective_factor_marginalization_integrand(double *args);
-static TRACK *track_subset(DATUM d, TRACK t);
-static MATRIX *trackpoint(TRACK t, const unsigned short index);
-static unsigned short CALLING_FUNCTION = 0u;
+DEVICE_FUNCTIONS_BEGIN
+static double scaled_marginalization_integrand(double *args);
+DEVICE_FUNCTIONS_END
+static void line_segment_moments(const double a, const double b,
+	double *moments);
+static double line_segment_moment_integrand(double *args);
+static double quadratic_form(const double *x, const double *A, const double *y,
+	const unsigned short dim);
+static void packed_product(const double *A, const double *x,
+	const unsigned short dim, double *result);
+static struct track_view track_view_project(LIKELIHOOD_CONTEXT *c,
+	const unsigned short dim);
+static void track_view_bound_blocks(LIKELIHOOD_CONTEXT *c,
+	struct track_view *v);
+static void track_view_whiten(struct track_view *v,
+	const double *transform);
 
 
 /*
-.. c:function:: extern double loglikelihood_sample(SAMPLE *s, TRACK *t);
+.. c:function:: extern double loglikelihood_sample(SAMPLE *s, const TRACK *t);
 
 	Compute the natural logarithm of the likelihood that some sample of data
 	vectors would be observed given some model-predicted track through the
@@ -46,7 +208,7 @@ static unsigned short CALLING_FUNCTION = 0u;
 	----------
 	s : ``SAMPLE *``
 		The sample to fit the model to.
-	t : ``TRACK *``
+	t : ``const TRACK *``
 		The model-predicted track through the observed space.
 
 	Returns
@@ -60,50 +222,18 @@ static unsigned short CALLING_FUNCTION = 0u;
 	----------
 	.. [1] Johnson J.W., et al., 2022, MNRAS, 526, 5084
 */
-extern double loglikelihood_sample(SAMPLE s, TRACK *t) {
+extern double loglikelihood_sample(SAMPLE *s, const TRACK *t) {
 
-	CALLING_FUNCTION = 1u;
-	double logl = 0.f, weight_norm = 1.f;
-	if ((*t).normalize_weights) weight_norm = normalize_weights(t);
-	#if defined(_OPENMP)
-		/*
-		Parallelized likelihood calculation is done separately for each
-		individual thread, because an iterative sum is not thread-safe. Total
-		is then added up at the end, after the threads have closed.
-		*/
-		double *by_thread = (double *) malloc ((*t).n_threads * sizeof(double));
-		for (unsigned short i = 0u; i < (*t).n_threads; i++) by_thread[i] = 0;
-		#pragma omp parallel for num_threads((*t).n_threads)
-	#endif
-	for (unsigned long i = 0ul; i < s.n_vectors; i++) {
-		#if defined(_OPENMP)
-			by_thread[omp_get_thread_num()] += loglikelihood_datum(
-				*s.data[i], t);
-		#else
-			logl += loglikelihood_datum(*s.data[i], t);
-		#endif
-	}
-	#if defined(_OPENMP)
-		for (unsigned short i = 0u; i < (*t).n_threads; i++) {
-			logl += by_thread[i];
-		}
-		free(by_thread);
-	#endif
-	if ((*t).normalize_weights) {
-		unnormalize_weights(t, weight_norm);
-	} else {
-		for (unsigned short i = 0u; i < (*t).n_vectors; i++) {
-			logl -= (*t).weights[i];
-		}
-	}
-	CALLING_FUNCTION = 0u;
+	LIKELIHOOD_CONTEXT *c = likelihood_context_initialize(t);
+	double logl = loglikelihood_context_sample(c, sample_pack(s));
+	likelihood_context_free(c);
 	return logl;
 
 }
 
 
 /*
-.. c:function:: extern double loglikelihood_datum(DATUM *d, TRACK *t);
+.. c:function:: extern double loglikelihood_datum(DATUM d, const TRACK *t);
 
 	Compute the natural logarithm of the likelihood that an individual datum
 	will be observed from its vector and the model-predicted track in the
@@ -119,7 +249,7 @@ extern double loglikelihood_sample(SAMPLE s, TRACK *t) {
 	----------
 	d : ``DATUM``
 		The datum to compute the likelihood of observation.
-	t : ``TRACK *``
+	t : ``const TRACK *``
 		The model-predicted track through the observed space.
 
 	Returns
@@ -133,409 +263,2766 @@ extern double loglikelihood_sample(SAMPLE s, TRACK *t) {
 	----------
 	.. [2] Johnson J.W., et al., 2022, MNRAS, 526, 5084
 */
-extern double loglikelihood_datum(DATUM d, TRACK *t) {
+extern double loglikelihood_datum(DATUM d, const TRACK *t) {
 
-	double weight_norm = 1.f;
-	if (CALLING_FUNCTION && (*t).normalize_weights) {
-		weight_norm = normalize_weights(t);
-	} else {}
-	TRACK *sub = track_subset(d, *t);
-	if (sub == NULL) fatal_print("%s\n", "track_subset returned NULL.");
-	double result = 0;
-	#if defined(_OPENMP)
-		double *by_thread = (double *) malloc ((*t).n_threads * sizeof(double));
-		for (unsigned short i = 0u; i < (*t).n_threads; i++) by_thread[i] = 0;
-		#pragma omp parallel for num_threads((*t).n_threads)
-	#endif
-	for (unsigned short i = 0u; i < (*sub).n_vectors; i++) {
-		double s = (*sub).weights[i];
-		s *= exp(-0.5 * chi_squared(d, *sub, i));
-		s *= delta_model(*sub, i);
-		if ((*t).use_line_segment_corrections) {
-			/*
-			Compute the corrective factor using the subsampled track, but use
-			the setting of whether or not to even do the calculation and the
-			comparison against the specified tolerance from the input track to
-			ensure that it will always end up in the right place. Also
-			eliminates the need to copy information over between the input and
-			subsampled track.
-			*/
-			s *= corrective_factor(d, *sub, i);
-		} else {}
-		#if defined(_OPENMP)
-			by_thread[omp_get_thread_num()] += s;
-		#else
-			result += s;
-		#endif
-	}
-	#if defined(_OPENMP)
-		for (unsigned short i = 0u; i < (*t).n_threads; i++) {
-			result += by_thread[i];
-		}
-		free(by_thread);
-	#endif
-	if (CALLING_FUNCTION && (*t).normalize_weights) {
-		unnormalize_weights(t, weight_norm);
-	} else {}
-	track_free(sub);
-	result /= sqrt(2 * PI * matrix_determinant( *((MATRIX *) d.cov) ));
-	return log(result);
+	LIKELIHOOD_CONTEXT *c = likelihood_context_initialize(t);
+	double logl = loglikelihood_context_datum(c, d);
+	likelihood_context_free(c);
+	return logl;
 
 }
 
 
 /*
-.. c:function:: static double normalize_weights(TRACK *t);
+.. c:function:: extern void loglikelihood_batch(SAMPLE *s, TRACK **tracks, const unsigned long n_tracks, double *out);
 
-	Normalize the weights stored by a :c:type:`TRACK` object such that they add
-	up to 1.
+	Compute the natural logarithm of the likelihood that some sample of data
+	vectors would be observed given each of several model-predicted tracks,
+	as when an ensemble sampler proposes many models at once.
 
 	Parameters
 	----------
-	t : ``TRACK *``
-		A pointer to the input track itself
+	s : ``SAMPLE *``
+		The sample to fit the models to.
+	tracks : ``TRACK **``
+		The model-predicted tracks through the observed space. They need not
+		have the same number of points or predict the same quantities, so
+		long as each has predictions for every quantity in the sample.
+	n_tracks : ``const unsigned long``
+		The number of elements in ``tracks``.
+	out : ``double *``
+		The ``n_tracks`` elements in which to store the natural logarithm of
+		the likelihood of observation given each track, as would be computed by
+		:c:func:`loglikelihood_sample`.
 
-	Returns
-	-------
-	weight_norm : ``double``
-		The sum of the weights prior to normalization.
+	Notes
+	-----
+	Rather than walking through the entire sample once per track, each datum
+	is compared against every track in turn, so its vector and inverse
+	covariance matrix are read from memory once and then remain in cache.
+	The (datum, track) combinations are parallelized over with the largest
+	:c:member:`TRACK.n_threads` among the tracks. The reentrant form of this
+	function is :c:func:`loglikelihood_context_batch`.
 */
-static double normalize_weights(TRACK *t) {
+extern void loglikelihood_batch(SAMPLE *s, TRACK **tracks,
+	const unsigned long n_tracks, double *out) {
 
-	double weight_norm = sum((*t).weights, (*t).n_vectors);
-	weight_norm *= 1000.f / (*t).n_vectors;
-	for (unsigned short i = 0u; i < (*t).n_vectors; i++) {
-		t -> weights[i] /= weight_norm;
+	LIKELIHOOD_CONTEXT **contexts = (LIKELIHOOD_CONTEXT **) malloc (
+		n_tracks * sizeof(LIKELIHOOD_CONTEXT *));
+	for (unsigned long i = 0ul; i < n_tracks; i++) {
+		contexts[i] = likelihood_context_initialize(tracks[i]);
 	}
-	return weight_norm;
+	loglikelihood_context_batch(contexts, n_tracks, sample_pack(s), out);
+	for (unsigned long i = 0ul; i < n_tracks; i++) {
+		likelihood_context_free(contexts[i]);
+	}
+	free(contexts);
 
 }
 
 
 /*
-.. c:function:: static void unnormalize_weights(TRACK *t, const double weight_norm);
+.. c:function:: extern LIKELIHOOD_CONTEXT *likelihood_context_initialize(const TRACK *t);
 
-	Undo the action of :c:function:`normalize_weights``, restting the track
-	weights to their original values.
+	Allocate memory for and return a pointer to a :c:type:`LIKELIHOOD_CONTEXT`
+	for computing likelihoods with a given model-predicted track.
 
 	Parameters
 	----------
-	t : ``TRACK *``
-		A pointer to the input track itself.
-	weight_norm : ``double``
-		The value returned by :c:type:`normalize_weights`.
-*/
-static void unnormalize_weights(TRACK *t, const double weight_norm) {
+	t : ``const TRACK *``
+		The model-predicted track through the observed space. It must not be
+		freed before the context.
 
-	for (unsigned short i = 0u; i < (*t).n_vectors; i++) {
-		t -> weights[i] *= weight_norm;
-	}
+	Returns
+	-------
+	c : ``LIKELIHOOD_CONTEXT *``
+		The newly constructed context, with its settings taken from ``t``.
+*/
+extern LIKELIHOOD_CONTEXT *likelihood_context_initialize(const TRACK *t) {
+
+	LIKELIHOOD_CONTEXT *c = (LIKELIHOOD_CONTEXT *) malloc (
+		sizeof(LIKELIHOOD_CONTEXT));
+	c -> track = t;
+	c -> n_threads = (*t).n_threads;
+	c -> parallel_policy = (*t).parallel_policy;
+	c -> normalize_weights = (*t).normalize_weights;
+	c -> use_line_segment_corrections = (*t).use_line_segment_corrections;
+	c -> pruning_threshold = (*t).pruning_threshold;
+	c -> precision = LIKELIHOOD_PRECISION_DOUBLE;
+	c -> weights = (double *) malloc ((*t).n_vectors * sizeof(double));
+	c -> coefficients = (double *) malloc ((*t).n_vectors * sizeof(double));
+	c -> log_coefficients = (double *) malloc (
+		(*t).n_vectors * sizeof(double));
+	c -> columns = (unsigned short *) malloc (
+		(*t).dim * sizeof(unsigned short));
+	c -> projected = (double *) aligned_malloc (
+		(*t).dim * padded_length((*t).n_vectors) * sizeof(double));
+	c -> projected_single = (float *) aligned_malloc (
+		(*t).dim * padded_length((*t).n_vectors) * sizeof(float));
+	c -> projected_whitened = (double *) aligned_malloc (
+		(*t).dim * padded_length((*t).n_vectors) * sizeof(double));
+	unsigned long n_boxes = ((*t).n_vectors + CHI_SQUARED_BLOCK - 1ul) /
+		CHI_SQUARED_BLOCK;
+	c -> block_lower = (double *) malloc (
+		n_boxes * (*t).dim * sizeof(double));
+	c -> block_upper = (double *) malloc (
+		n_boxes * (*t).dim * sizeof(double));
+	c -> block_largest = (double *) malloc (n_boxes * sizeof(double));
+	c -> scratch = NULL;
+	c -> n_scratch = 0ul;
+	c -> by_thread = NULL;
+	c -> n_by_thread = 0ul;
+	return c;
 
 }
 
 
 /*
-.. c:function:: static double chi_squared(DATUM t, TRACK t, const unsigned short index);
+.. c:function:: extern void likelihood_context_free(LIKELIHOOD_CONTEXT *c);
 
-	Compute the value of :math:`\chi^2` for one specific datum and one specific
-	point along a model-predicted track.
+	Free up the memory stored by a :c:type:`LIKELIHOOD_CONTEXT`. The track it
+	was constructed from is not freed.
 
 	Parameters
 	----------
-	d : ``DATUM``
-		The input datum vector.
-	t : ``TRACK``
-		The model-predicted track, containing each predicted vector.
-	index : ``const unsigned short``
-		The index of the point along the track to take in computing a value of
-		:math:`\chi^2`.
-
-	Returns
-	-------
-	chisq : ``double``
-		The computed value of :math:`\chi^2`, defined according to
-		:math:`\chi^2 = \Delta C^{-1} \Delta^T`, where
-		:math:`C^{-1}` is the datum's covariance matrix describing its
-		measurement uncertainties and :math:`\Delta = d - t_{index}` is the
-		vector difference between the datum and the ``index``'th vector along
-		the track.
-*/
-static double chi_squared(DATUM d, TRACK t, const unsigned short index) {
-
-	MATRIX *tpoint = trackpoint(t, index);
-	MATRIX *delta = matrix_subtract(*((MATRIX *) &d), *tpoint, NULL);
-	MATRIX *delta_T = matrix_transpose(*delta, NULL);
-	MATRIX *first = matrix_multiply(*delta, *(*d.cov).inv, NULL);
-	MATRIX *second = matrix_multiply(*first, *delta_T, NULL);
-	if ((*second).n_rows == 1u && (*second).n_cols == 1u) {
-		double result = second -> matrix[0][0];
-		matrix_free(tpoint);
-		matrix_free(delta);
-		matrix_free(delta_T);
-		matrix_free(first);
-		matrix_free(second);
-		return result;
-	} else {
-		fatal_print("%s\n",
-			"Chi-squared calculation resulted in a matrix larger than 1x1.");
-	}
+	c : ``LIKELIHOOD_CONTEXT *``
+		The context to be freed.
+*/
+extern void likelihood_context_free(LIKELIHOOD_CONTEXT *c) {
+
+	if (c != NULL) {
+		free(c -> weights);
+		free(c -> coefficients);
+		free(c -> log_coefficients);
+		free(c -> columns);
+		free(c -> projected);
+		free(c -> projected_single);
+		free(c -> projected_whitened);
+		free(c -> block_lower);
+		free(c -> block_upper);
+		free(c -> block_largest);
+		if ((*c).scratch != NULL) free(c -> scratch);
+		if ((*c).by_thread != NULL) free(c -> by_thread);
+		free(c);
+	} else {}
 
 }
 
 
 /*
-.. c:function:: static delta delta_model(TRACK t, const unsigned short index);
+.. c:function:: extern unsigned long likelihood_context_project(LIKELIHOOD_CONTEXT *c, const unsigned short *ids, const unsigned short dim);
 
-	Computes the magnitude of the vector displacement between neighboring points
-	on the track.
+	Project the track of a context onto some measured quantities, as is done
+	for each group of a packed sample within
+	:c:func:`loglikelihood_context_sample`, for likelihood calculations that
+	are carried out elsewhere (see :c:func:`loglikelihood_device`).
 
 	Parameters
 	----------
-	t : ``TRACK``
-		The track itself, containing all vectors.
-	index : ``unsigned short``
-		The index of the vector along the track to compute the :math:`\Delta M`
-		at.
+	c : ``LIKELIHOOD_CONTEXT *``
+		The context, whose weights are normalized according to its
+		:c:member:`LIKELIHOOD_CONTEXT.normalize_weights`.
+	ids : ``const unsigned short *``
+		The label IDs of the measured quantities.
+	dim : ``const unsigned short``
+		The number of elements in ``ids``.
 
 	Returns
 	-------
-	delta : ``double``
-		The magnitude of the :math:`\Delta M_j = M_{j + 1} - M_j` vector.
+	stride : ``unsigned long``
+		The distance in memory between consecutive columns of
+		:c:member:`LIKELIHOOD_CONTEXT.projected`, which then holds the
+		``k``'th component of the ``j``'th point along the track at
+		``projected[k * stride + j]``, with the corresponding elements of
+		:c:member:`LIKELIHOOD_CONTEXT.coefficients` alongside it.
 */
-static double delta_model(TRACK t, const unsigned short index) {
+extern unsigned long likelihood_context_project(LIKELIHOOD_CONTEXT *c,
+	const unsigned short *ids, const unsigned short dim) {
 
-	if (index < t.n_vectors - 1ul) {
-		MATRIX *current = trackpoint(t, index);
-		MATRIX *next = trackpoint(t, index + 1ul);
-		MATRIX *delta = matrix_subtract(*next, *current, NULL);
-		/* compute magnitude of delta vector in data space */
-		double mag = 0;
-		for (unsigned short i = 0u; i < (*delta).n_cols; i++) {
-			mag += (*delta).matrix[0][i] * (*delta).matrix[0][i];
-		}
-		mag = sqrt(mag);
-		free(current);
-		free(next);
-		free(delta);
-		return mag;
-	} else {
-		return 0.f;
+	context_weights(c, (*c).normalize_weights);
+	context_map_columns(c, ids, dim);
+	return track_view_project(c, dim).stride;
+
+}
+
+
+/*
+.. c:function:: extern double loglikelihood_context_sample(LIKELIHOOD_CONTEXT *c, const PACKED_SAMPLE *p);
+
+	The reentrant form of :c:func:`loglikelihood_sample`, which computes the
+	likelihood of observing a packed sample given the track and settings of a
+	context.
+
+	Parameters
+	----------
+	c : ``LIKELIHOOD_CONTEXT *``
+		The context to compute the likelihood with.
+	p : ``const PACKED_SAMPLE *``
+		The packed sample, as returned by :c:func:`sample_pack`.
+
+	Returns
+	-------
+	logl : ``double``
+		The natural logarithm of the likelihood of observation, as in
+		:c:func:`loglikelihood_sample`.
+
+	Notes
+	-----
+	Neither the track nor the packed sample is modified, so this function
+	may be called concurrently from any number of threads, each with a
+	context of its own. Packing a sample does modify it, so
+	:c:func:`sample_pack` should be called beforehand from only one thread.
+	This is how ``sample.loglikelihood`` is able to release the GIL.
+*/
+extern double loglikelihood_context_sample(LIKELIHOOD_CONTEXT *c,
+	const PACKED_SAMPLE *p) {
+
+	PROFILE_START(PROFILE_LIKELIHOOD);
+	double logl = 0, compensation = 0;
+	context_weights(c, (*c).normalize_weights);
+
+	/*
+	Iterate over the packed copy of the sample, one group of data with the
+	same measured quantities at a time. The track only needs to be projected
+	onto those quantities once per group, and the vectors and inverse
+	covariance matrices of consecutive data are adjacent in memory. The
+	projected predictions are copied into memory owned by the context column
+	by column, which costs far less than the likelihood calculation itself
+	and lets it vectorize over the points along the track. If the data of a
+	group share a covariance matrix, the track is also transformed into its
+	whitened frame, and chi-squared is computed there in double precision
+	even if single precision was requested, since a squared distance costs
+	far less than a quadratic form in either precision.
+	*/
+	for (unsigned long g = 0ul; g < (*p).n_groups; g++) {
+		PACKED_GROUP group = (*p).groups[g];
+		context_map_columns(c, group.ids, group.dim);
+		struct track_view v = track_view_project(c, group.dim);
+		if (group.transform != NULL) {
+			track_view_whiten(&v, group.transform);
+		} else {}
+		compensated_add(&logl, &compensation, loglikelihood_data(
+			group.vectors, group.inv, group.single, group.logdet,
+			group.whitening, group.n_data, v));
 	}
+	logl += compensation;
+
+	if (!(*c).normalize_weights) {
+		for (unsigned short i = 0u; i < (*(*c).track).n_vectors; i++) {
+			logl -= (*(*c).track).weights[i];
+		}
+	} else {}
+	PROFILE_STOP(PROFILE_LIKELIHOOD);
+	return logl;
 
 }
 
 
 /*
-.. c:function:: static double corrective_factor(DATUM d, TRACK t, const unsigned short index);
+.. c:function:: extern double loglikelihood_context_datum(LIKELIHOOD_CONTEXT *c, DATUM d);
 
-	Compute the corrective factor in the likelihood estimate that accounts for
-	the finite length of the line segment connecting two consecutive vectors in
-	the model-predicted track.
+	The reentrant form of :c:func:`loglikelihood_datum`, which computes the
+	likelihood of observing an individual datum given the track and settings
+	of a context.
 
 	Parameters
 	----------
+	c : ``LIKELIHOOD_CONTEXT *``
+		The context to compute the likelihood with.
 	d : ``DATUM``
-		The datum whose likelihood of observation is being computed.
-	t : ``TRACK``
-		The model-predicted track.
-	index : ``const unsigned short``
-		The index of the vector along the track to compute the corrective
-		factor for (i.e. which line segment).
+		The datum to compute the likelihood of observation.
 
 	Returns
 	-------
-	correction : ``double``
-		:math:`\beta_{ij}`, defined according to equation A12 in Johnson et al.
-		(2022) [1]_.
+	logl : ``double``
+		The natural logarithm of the likelihood of observation, as in
+		:c:func:`loglikelihood_datum`.
 
 	Notes
 	-----
-	Although the exact form of :math:`\beta_{ij}` is known, it is a rare case in
-	 which the analytic solution is not numerically stable while the numerical
-	solution is. In this case, the instability arises because :math:`\beta_{ij}`
-	is the product of an extremely large number and an extremely small number,
-	which challenge the limits of double floating point precision. Once the
-	values of :math:`a` and :math:`b` are known, which define the value of
-	:math:`beta` (see science documentation), its value is computed through
-	quadrature.
+	As has always been the case for individual data, the weights of the track
+	are used as they are, regardless of :c:member:`normalize_weights`.
+*/
+extern double loglikelihood_context_datum(LIKELIHOOD_CONTEXT *c, DATUM d) {
+
+	PROFILE_START(PROFILE_LIKELIHOOD);
+	context_weights(c, 0u);
+	context_map_columns(c, d.ids, d.n_cols);
+
+	/*
+	Pack the inverse covariance matrix and the whitening scale factors the
+	same way a sample would.
+	*/
+	double *inv = (double *) malloc ((unsigned long) d.n_cols * (d.n_cols + 1u) /
+		2u * sizeof(double));
+	for (unsigned short j = 0u; j < d.n_cols; j++) {
+		for (unsigned short k = j; k < d.n_cols; k++) {
+			inv[packed_index(j, k, d.n_cols)] = (*(*d.cov).inv).matrix[j][k];
+		}
+	}
+	double *whitening = (double *) malloc (d.n_cols * sizeof(double));
+	covariance_matrix_whitening(*d.cov, NULL, whitening);
+	double result = loglikelihood_data(d.vector[0], inv, NULL,
+		&(*d.cov).logdet, whitening, 1ul, track_view_project(c, d.n_cols));
+	free(inv);
+	free(whitening);
+	PROFILE_STOP(PROFILE_LIKELIHOOD);
+	return result;
 
-	References
+}
+
+
+/*
+.. c:function:: extern void loglikelihood_context_batch(LIKELIHOOD_CONTEXT **contexts, const unsigned long n_contexts, const PACKED_SAMPLE *p, double *out);
+
+	The reentrant form of :c:func:`loglikelihood_batch`, which computes the
+	likelihood of observing a packed sample given the track and settings of
+	each of several contexts.
+
+	Parameters
 	----------
-	.. [1] Johnson J.W., et al., 2022, MNRAS, 526, 5084
+	contexts : ``LIKELIHOOD_CONTEXT **``
+		The contexts to compute the likelihood with, one per track.
+	n_contexts : ``const unsigned long``
+		The number of elements in ``contexts``.
+	p : ``const PACKED_SAMPLE *``
+		The packed sample, as returned by :c:func:`sample_pack`.
+	out : ``double *``
+		The ``n_contexts`` elements in which to store the natural logarithm of
+		the likelihood of observation given each context, as would be computed
+		by :c:func:`loglikelihood_context_sample`.
+
+	Notes
+	-----
+	The same restrictions on concurrency apply as for
+	:c:func:`loglikelihood_context_sample`.
+	:c:member:`LIKELIHOOD_CONTEXT.parallel_policy` does not apply here; the
+	(datum, context) combinations are always parallelized over, with the
+	largest :c:member:`LIKELIHOOD_CONTEXT.n_threads` among the contexts.
 */
-static double corrective_factor(DATUM d, TRACK t, const unsigned short index) {
+extern void loglikelihood_context_batch(LIKELIHOOD_CONTEXT **contexts,
+	const unsigned long n_contexts, const PACKED_SAMPLE *p, double *out) {
+
+	PROFILE_START(PROFILE_LIKELIHOOD);
+	unsigned short n_threads = 1u, max_dim = 1u;
+	for (unsigned long k = 0ul; k < n_contexts; k++) {
+		context_weights(contexts[k], (*contexts[k]).normalize_weights);
+		if ((*contexts[k]).n_threads > n_threads) {
+			n_threads = (*contexts[k]).n_threads;
+		} else {}
+		out[k] = 0;
+	}
+	for (unsigned long g = 0ul; g < (*p).n_groups; g++) {
+		if ((*p).groups[g].dim > max_dim) max_dim = (*p).groups[g].dim;
+	}
+
+	/* See the notes on the padding in loglikelihood_data */
+	const unsigned long scratch_stride = padded_length(
+		CHI_SQUARED_BLOCK + 2ul * max_dim);
+	const unsigned long sum_stride = padded_length(n_contexts);
+	double *scratch = (double *) aligned_malloc(
+		n_threads * scratch_stride * sizeof(double));
+	double *by_thread = (double *) aligned_malloc(
+		n_threads * sum_stride * sizeof(double));
+	struct track_view *views = (struct track_view *) malloc (
+		n_contexts * sizeof(struct track_view));
+	PROFILE_COUNT(PROFILE_BYTES_ALLOCATED, (n_threads * (scratch_stride +
+		sum_stride)) * sizeof(double) + n_contexts * sizeof(struct track_view));
+
+	for (unsigned long g = 0ul; g < (*p).n_groups; g++) {
+		PACKED_GROUP group = (*p).groups[g];
+		const unsigned long n_tri = (unsigned long) group.dim * (
+			group.dim + 1ul) / 2ul;
+		for (unsigned long k = 0ul; k < n_contexts; k++) {
+			context_map_columns(contexts[k], group.ids, group.dim);
+			views[k] = track_view_project(contexts[k], group.dim);
+		}
+		for (unsigned long i = 0ul; i < n_threads * sum_stride; i++) {
+			by_thread[i] = 0;
+		}
 
-	if (index < t.n_vectors - 1u) {
 		/*
-		Determine the values of the a and b coefficients, which define the
-		corrective factor.
+		Datum-major order: consecutive iterations, which a static schedule
+		assigns to the same thread, score the same datum against successive
+		tracks.
 		*/
-		MATRIX *tpoint_index = trackpoint(t, index);
-		MATRIX *tpoint_next = trackpoint(t, index + 1u);
-		MATRIX *delta = matrix_subtract(*((MATRIX *) &d), *tpoint_index, NULL);
-		MATRIX *linesegment = matrix_subtract(*tpoint_next, *tpoint_index, NULL);
-		MATRIX *linesegment_T = matrix_transpose(*linesegment, NULL);
-		MATRIX *first = matrix_multiply(*linesegment, *(*d.cov).inv, NULL);
-		MATRIX *second = matrix_multiply(*first, *linesegment_T, NULL);
-		if ((*second).n_rows != 1u || (*second).n_cols != 1u) {
-			fatal_print("%s\n",
-				"Line segment correction (a): matrix larger than 1x1.");
-		} else {}
-		double a = second -> matrix[0][0];
-		first = matrix_multiply(*delta, *(*d.cov).inv, first);
-		second = matrix_multiply(*first, *linesegment_T, second);
-		if ((*second).n_rows != 1u || (*second).n_cols != 1u) {
-			fatal_print("%s\n",
-				"Line segment correction (b): matrix larger than 1x1.");
+		#if defined(_OPENMP)
+			#pragma omp parallel for num_threads(n_threads) collapse(2) \
+				schedule(static)
+		#endif
+		for (unsigned long i = 0ul; i < group.n_data; i++) {
+			for (unsigned long k = 0ul; k < n_contexts; k++) {
+				PROFILE_START(PROFILE_DATA);
+				unsigned thread = THREAD_NUMBER();
+				by_thread[thread * sum_stride + k] += loglikelihood_packed(
+					group.vectors + i * group.dim, group.inv + i * n_tri,
+					datum_single(group.single, i, views[k]), group.logdet[i],
+					group.whitening + i * group.dim, views[k],
+					scratch + thread * scratch_stride);
+				PROFILE_STOP(PROFILE_DATA);
+			}
+		}
+
+		for (unsigned long k = 0ul; k < n_contexts; k++) {
+			double logl = 0;
+			for (unsigned short j = 0u; j < n_threads; j++) {
+				logl += by_thread[j * sum_stride + k];
+			}
+			out[k] += logl;
+		}
+	}
+
+	for (unsigned long k = 0ul; k < n_contexts; k++) {
+		if (!(*contexts[k]).normalize_weights) {
+			const TRACK *t = (*contexts[k]).track;
+			for (unsigned short i = 0u; i < (*t).n_vectors; i++) {
+				out[k] -= (*t).weights[i];
+			}
 		} else {}
-		double b = second -> matrix[0][0];
-
-		/* Compute corrective factor numerically (see note above) */
-		INTEGRAL intgrl;
-		intgrl.func = &corrective_factor_marginalization_integrand;
-		intgrl.lower = 0;
-		intgrl.upper = 1;
-		intgrl.tolerance = LINE_SEGMENT_CORRECTION_TOLERANCE;
-		intgrl.n_min = LINE_SEGMENT_CORRECTION_MIN_ITERS;
-		intgrl.n_max = LINE_SEGMENT_CORRECTION_MAX_ITERS;
-		intgrl.extra_args = (double *) malloc (2 * sizeof(double));
-		intgrl.extra_args[0] = a;
-		intgrl.extra_args[1] = b;
-		intgrl.n_extra_args = 2u;
-		quad(&intgrl);
-		double correction = intgrl.result;
-
-		/* free up allocated memory */
-		free(intgrl.extra_args);
-		matrix_free(tpoint_index);
-		matrix_free(tpoint_next);
-		matrix_free(delta);
-		matrix_free(linesegment);
-		matrix_free(linesegment_T);
-		matrix_free(first);
-		matrix_free(second);
-		return correction;
-	} else {
-		/*
-		The correction integrates over the full length of the line segment.
-		Therefore, the point at the end of the track can be treated as a line
-		segment of length 0, therefore not contributing to the overall
-		likelihood.
-		*/
-		return 0.f;
 	}
+	free(views);
+	free(scratch);
+	free(by_thread);
+	PROFILE_STOP(PROFILE_LIKELIHOOD);
 
 }
 
 
 /*
-.. c:function:: static double corrective_factor_marginalization_integrand(double *args);
+.. c:function:: extern KERNEL_CACHE *kernel_cache_initialize(LIKELIHOOD_CONTEXT *c, const PACKED_SAMPLE *p);
 
-	The integrand for computing line segment length corrections along the track.
+	Compute the contribution of every point along the track of a context to
+	the likelihood of observing each datum in a packed sample, leaving out
+	the weights of the points.
 
 	Parameters
 	----------
-	args : ``double *``
-		The integration parameters, :math:`q`, :math:`a`, and :math:`b`.
+	c : ``LIKELIHOOD_CONTEXT *``
+		The context, whose track predictions and settings the cache is built
+		from. Its weights are overwritten.
+	p : ``const PACKED_SAMPLE *``
+		The packed sample, as returned by :c:func:`sample_pack`.
 
 	Returns
 	-------
-	value : ``double``
-		The integrand, defined as
-
-		.. math:: \exp(\frac{-1}{2} (aq^2 - 2bq)),
+	k : ``KERNEL_CACHE *``
+		The newly constructed cache, which refers to neither the context nor
+		the sample.
 
-		where ``q = args[0]``, ``a = args[1]``, and ``b = args[2]``.
+	Notes
+	-----
+	If :c:member:`LIKELIHOOD_CONTEXT.pruning_threshold` is non-negative,
+	entries smaller than the largest for the same datum by more than a factor
+	of :math:`e^{-\text{threshold} / 2}` are not stored, and whole blocks of
+	points far from each datum are skipped as in the likelihood calculation
+	itself. Since the weights are left out, this neglects contributions that
+	would be significant only if the weights varied along the track by more
+	than a comparable factor. Otherwise, every nonzero entry is stored,
+	which takes ``10 * n_data * n_points`` bytes.
 */
-static double corrective_factor_marginalization_integrand(double *args) {
+extern KERNEL_CACHE *kernel_cache_initialize(LIKELIHOOD_CONTEXT *c,
+	const PACKED_SAMPLE *p) {
+
+	PROFILE_START(PROFILE_LIKELIHOOD);
+	const TRACK *t = (*c).track;
+	const unsigned short n_threads = (*c).n_threads;
+	KERNEL_CACHE *k = (KERNEL_CACHE *) malloc (sizeof(KERNEL_CACHE));
+	k -> n_data = (*p).n_vectors;
+	k -> n_points = (*t).n_vectors;
+	k -> n_threads = n_threads;
+	k -> offsets = (unsigned long *) malloc (
+		((*p).n_vectors + 1ul) * sizeof(unsigned long));
+	k -> log_scale = (double *) malloc ((*p).n_vectors * sizeof(double));
+
+	/*
+	With unit weights, the coefficients of the projected track are the
+	lengths of the line segments alone. Their logarithms are needed whether
+	or not the likelihood itself is summed in logarithmic space.
+	*/
+	for (unsigned short j = 0u; j < (*t).n_vectors; j++) c -> weights[j] = 1;
+	const double threshold = (*c).pruning_threshold >= 0 ?
+		(*c).pruning_threshold : INFINITY;
+
+	unsigned short max_dim = 1u;
+	for (unsigned long g = 0ul; g < (*p).n_groups; g++) {
+		if ((*p).groups[g].dim > max_dim) max_dim = (*p).groups[g].dim;
+	}
+	const unsigned long scratch_stride = padded_length(
+		CHI_SQUARED_BLOCK + 2ul * max_dim);
+	const unsigned long row_stride = padded_length((*t).n_vectors);
+	double *scratch = (double *) aligned_malloc (
+		n_threads * scratch_stride * sizeof(double));
+	double *rows = (double *) aligned_malloc (
+		n_threads * row_stride * sizeof(double));
+
+	/*
+	Each datum's entries are first stored separately, since the number of
+	them is not known until the whole row has been computed.
+	*/
+	double **kernels = (double **) malloc ((*p).n_vectors * sizeof(double *));
+	unsigned short **points = (unsigned short **) malloc (
+		(*p).n_vectors * sizeof(unsigned short *));
+	unsigned long position = 0ul;
+	for (unsigned long g = 0ul; g < (*p).n_groups; g++) {
+		PACKED_GROUP group = (*p).groups[g];
+		const unsigned long n_tri = (unsigned long) group.dim * (
+			group.dim + 1ul) / 2ul;
+		context_map_columns(c, group.ids, group.dim);
+		struct track_view v = track_view_project(c, group.dim);
+		if (v.log_coefficients == NULL) {
+			for (unsigned short j = 0u; j < (*t).n_vectors; j++) {
+				c -> log_coefficients[j] = log(v.coefficients[j]);
+			}
+			v.log_coefficients = (*c).log_coefficients;
+		} else {}
 
-	double q = args[0], a = args[1], b = args[2];
-	return exp(-0.5 * (a * q * q - 2 * b * q));
+		#if defined(_OPENMP)
+			#pragma omp parallel for num_threads(n_threads) schedule(static)
+		#endif
+		for (unsigned long i = 0ul; i < group.n_data; i++) {
+			PROFILE_START(PROFILE_DATA);
+			unsigned thread = THREAD_NUMBER();
+			double *row = rows + thread * row_stride;
+			const double largest = kernel_cache_row(
+				group.vectors + i * group.dim, group.inv + i * n_tri,
+				group.whitening + i * group.dim, v,
+				scratch + thread * scratch_stride, row);
+			const double floor = largest - 0.5 * threshold;
+			unsigned long n = 0ul;
+			for (unsigned short j = 0u; j < (*t).n_vectors; j++) {
+				if (row[j] > -INFINITY && row[j] >= floor) n++;
+			}
+			double *kernel = (double *) malloc (n * sizeof(double));
+			unsigned short *indices = (unsigned short *) malloc (
+				n * sizeof(unsigned short));
+			n = 0ul;
+			for (unsigned short j = 0u; j < (*t).n_vectors; j++) {
+				if (row[j] > -INFINITY && row[j] >= floor) {
+					kernel[n] = exp(row[j] - largest);
+					indices[n++] = j;
+				} else {}
+			}
+			kernels[position + i] = kernel;
+			points[position + i] = indices;
+			k -> offsets[position + i + 1ul] = n;
+			k -> log_scale[position + i] = largest - 0.5 * (
+				log(2 * PI) + group.logdet[i]);
+			PROFILE_STOP(PROFILE_DATA);
+		}
+		position += group.n_data;
+	}
+
+	k -> offsets[0] = 0ul;
+	for (unsigned long i = 0ul; i < (*p).n_vectors; i++) {
+		k -> offsets[i + 1ul] += (*k).offsets[i];
+	}
+	k -> kernel = (double *) malloc (
+		(*k).offsets[(*p).n_vectors] * sizeof(double));
+	k -> points = (unsigned short *) malloc (
+		(*k).offsets[(*p).n_vectors] * sizeof(unsigned short));
+	PROFILE_COUNT(PROFILE_BYTES_ALLOCATED, (*k).offsets[(*p).n_vectors] * (
+		sizeof(double) + sizeof(unsigned short)));
+	for (unsigned long i = 0ul; i < (*p).n_vectors; i++) {
+		const unsigned long n = (*k).offsets[i + 1ul] - (*k).offsets[i];
+		memcpy((*k).kernel + (*k).offsets[i], kernels[i], n * sizeof(double));
+		memcpy((*k).points + (*k).offsets[i], points[i],
+			n * sizeof(unsigned short));
+		free(kernels[i]);
+		free(points[i]);
+	}
+	free(kernels);
+	free(points);
+	free(scratch);
+	free(rows);
+	PROFILE_STOP(PROFILE_LIKELIHOOD);
+	return k;
 
 }
 
 
 /*
-.. c:function:: static TRACK *track_subset(DATUM d, TRACK t);
+.. c:function:: extern void kernel_cache_free(KERNEL_CACHE *k);
 
-	Obtain a :c:type:`TRACK` object containing only the quantities present in a
-	particular :c:type:`DATUM` by comparing their column labels.
+	Free up the memory stored by a :c:type:`KERNEL_CACHE`.
 
 	Parameters
 	----------
-	d : ``DATUM``
-		The datum vector itself.
-	t : ``TRACK``
-		The model-predicted track through the observed space, which may contain
-		predictions for some number of quantities that are not measured for the
-		present datum ``d``. Those quantities may however be measured for other
-		data vectors in the sample.
+	k : ``KERNEL_CACHE *``
+		The cache to be freed.
+*/
+extern void kernel_cache_free(KERNEL_CACHE *k) {
+
+	if (k != NULL) {
+		free(k -> offsets);
+		free(k -> points);
+		free(k -> kernel);
+		free(k -> log_scale);
+		free(k);
+	} else {}
+
+}
+
+
+/*
+.. c:function:: extern double loglikelihood_kernel_cache(const KERNEL_CACHE *k, const TRACK *t, const unsigned short normalize_weights);
+
+	Compute the natural logarithm of the likelihood of observing the sample
+	that a :c:type:`KERNEL_CACHE` was built from, given new weights for the
+	points along the same track.
+
+	Parameters
+	----------
+	k : ``const KERNEL_CACHE *``
+		The cache.
+	t : ``const TRACK *``
+		The track, whose :c:member:`TRACK.weights` may differ from those
+		the cache was built with, but whose points must be the same.
+	normalize_weights : ``const unsigned short``
+		Whether or not to normalize the weights, as in
+		:c:member:`LIKELIHOOD_CONTEXT.normalize_weights`.
 
 	Returns
 	-------
-	sub : ``TRACK *``
-		A new ``TRACK`` object whose columns occur in the same order as they do
-		for the datum ``d``, expediting the matrix multiplications that compute
-		the likelihood of observing the datum.
+	logl : ``double``
+		The natural logarithm of the likelihood of observation, as would be
+		computed by :c:func:`loglikelihood_context_sample` with these weights,
+		up to the entries left out of the cache.
+
+	Notes
+	-----
+	This costs one sparse matrix-vector product, parallelized over the data
+	with :c:member:`KERNEL_CACHE.n_threads`. The cache is not modified, so
+	this function may be called concurrently from any number of threads.
 */
-static TRACK *track_subset(DATUM d, TRACK t) {
+extern double loglikelihood_kernel_cache(const KERNEL_CACHE *k,
+	const TRACK *t, const unsigned short normalize_weights) {
+
+	/* See context_weights */
+	PROFILE_START(PROFILE_LIKELIHOOD);
+	double weight_norm = normalize_weights ? track_weight_norm(t) : 1;
+	double *normalized = (double *) malloc ((*k).n_points * sizeof(double));
+	for (unsigned short j = 0u; j < (*k).n_points; j++) {
+		normalized[j] = (*t).weights[j] / weight_norm;
+	}
 
-	TRACK *sub = track_initialize(t.n_vectors, d.n_cols);
-	sub -> n_threads = t.n_threads;
-	sub -> use_line_segment_corrections = t.use_line_segment_corrections;
+	/* See the notes on the padding in loglikelihood_data */
+	const unsigned short n_threads = (*k).n_threads;
+	const unsigned long sum_stride = padded_length(1ul);
+	double *by_thread = (double *) aligned_malloc (
+		n_threads * sum_stride * sizeof(double));
+	for (unsigned short i = 0u; i < n_threads; i++) {
+		by_thread[i * sum_stride] = 0;
+	}
+	#if defined(_OPENMP)
+		#pragma omp parallel for num_threads(n_threads) schedule(static)
+	#endif
+	for (unsigned long i = 0ul; i < (*k).n_data; i++) {
+		PROFILE_START(PROFILE_DATA);
+		unsigned thread = THREAD_NUMBER();
+		double result = 0;
+		for (unsigned long e = (*k).offsets[i]; e < (*k).offsets[i + 1ul];
+			e++) {
+			result += (*k).kernel[e] * normalized[(*k).points[e]];
+		}
+		by_thread[thread * sum_stride] += (*k).log_scale[i] + log(result);
+		PROFILE_STOP(PROFILE_DATA);
+	}
+
+	double logl = 0;
+	for (unsigned short i = 0u; i < n_threads; i++) {
+		logl += by_thread[i * sum_stride];
+	}
+	if (!normalize_weights) {
+		for (unsigned short j = 0u; j < (*k).n_points; j++) {
+			logl -= (*t).weights[j];
+		}
+	} else {}
+	free(normalized);
+	free(by_thread);
+	PROFILE_STOP(PROFILE_LIKELIHOOD);
+	return logl;
 
-	for (unsigned short i = 0u; i < d.n_cols; i++) {
-		signed short index = strindex(t.labels, d.labels[i], t.dim);
-		switch(index) {
+}
 
-			case -1:
-				track_free(sub);
-				return NULL;
 
-			default:
-				strcpy(sub -> labels[i], t.labels[index]);
-				for (unsigned short j = 0u; j < t.n_vectors; j++) {
-					sub -> predictions[j][i] = t.predictions[j][index];
-				}
-				break;
+/*
+.. c:function:: extern double loglikelihood_sample_gradient(SAMPLE *s, const TRACK *t, double *grad_predictions, double *grad_weights);
 
-		}
+	Compute the natural logarithm of the likelihood that some sample would be
+	observed given some model-predicted track, as in
+	:c:func:`loglikelihood_sample`, along with its derivatives with respect
+	to the predictions and the weights of the points along the track.
 
-	}
+	Parameters
+	----------
+	s : ``SAMPLE *``
+		The sample to fit the model to.
+	t : ``const TRACK *``
+		The model-predicted track through the observed space.
+	grad_predictions : ``double *``
+		The ``t -> n_vectors * t -> dim`` elements in which to store the
+		derivative with respect to each prediction, with that for
+		``t -> predictions[j][k]`` at ``grad_predictions[j * t -> dim + k]``.
+	grad_weights : ``double *``
+		The ``t -> n_vectors`` elements in which to store the derivative with
+		respect to each element of :c:member:`TRACK.weights`.
 
-	for (unsigned short i = 0u; i < (*sub).n_vectors; i++) {
-		sub -> weights[i] = t.weights[i];
-	}
-	return sub;
+	Returns
+	-------
+	logl : ``double``
+		The natural logarithm of the likelihood of observation.
+
+	Notes
+	-----
+	The reentrant form of this function, which ``sample.loglikelihood``
+	calls when ``return_grad = True``, is
+	:c:func:`loglikelihood_context_sample_gradient`.
+*/
+extern double loglikelihood_sample_gradient(SAMPLE *s, const TRACK *t,
+	double *grad_predictions, double *grad_weights) {
+
+	LIKELIHOOD_CONTEXT *c = likelihood_context_initialize(t);
+	double logl = loglikelihood_context_sample_gradient(c, sample_pack(s),
+		grad_predictions, grad_weights);
+	likelihood_context_free(c);
+	return logl;
 
 }
 
 
 /*
-.. c:function:: static MATRIX *trackpoint(TRACK t, const unsigned short index);
+.. c:function:: extern double loglikelihood_context_sample_gradient(LIKELIHOOD_CONTEXT *c, const PACKED_SAMPLE *p, double *grad_predictions, double *grad_weights);
 
-	Obtain the vector for a specific point along the model predicted track.
+	The reentrant form of :c:func:`loglikelihood_sample_gradient`, which
+	computes the likelihood of observing a packed sample given the track and
+	settings of a context along with its derivatives with respect to the
+	predictions and the weights of the track.
 
 	Parameters
 	----------
-	t : ``TRACK``
-		The input track itself, containing some arbitrary number of vectors.
-	index : ``const unsigned short``
-		The index of the vector along the track to capture as a stand-alone
-		matrix.
+	c : ``LIKELIHOOD_CONTEXT *``
+		The context to compute the likelihood with.
+	p : ``const PACKED_SAMPLE *``
+		The packed sample, as returned by :c:func:`sample_pack`.
+	grad_predictions : ``double *``
+		The ``n_vectors * dim`` elements in which to store the derivative with
+		respect to each prediction of the track, laid out like the
+		predictions themselves (see :c:func:`matrix_elements`). Predictions
+		for quantities that the sample does not measure have derivatives of
+		zero.
+	grad_weights : ``double *``
+		The ``n_vectors`` elements in which to store the derivative with
+		respect to each weight of the track, accounting for their
+		normalization if :c:member:`LIKELIHOOD_CONTEXT.normalize_weights` is
+		nonzero.
 
 	Returns
 	-------
-	mat : ``MATRIX *``
-		A pointer to matrix object containing only one row, whose elements are
-		a component-wise match to ``t.predictions[index]``.
+	logl : ``double``
+		The natural logarithm of the likelihood of observation, as in
+		:c:func:`loglikelihood_context_sample`.
+
+	Notes
+	-----
+	Each datum's contributions from the points along the track are computed
+	once and kept, as for a row of a :c:type:`KERNEL_CACHE`, after which a
+	second pass over them accumulates the derivatives. This costs a few
+	times as much as :c:func:`loglikelihood_context_sample` regardless of the
+	number of points along the track, whereas finite differences would cost
+	two likelihood calculations per prediction and per weight. The data are
+	always parallelized over with :c:member:`LIKELIHOOD_CONTEXT.n_threads`
+	threads, each of which accumulates derivatives of its own.
+
+	With line segment corrections, the derivatives of the corrective factor
+	are those of its closed form (see :c:macro:`LINE_SEGMENT_CORRECTION_SMOOTH`)
+	regardless of how the factor itself is evaluated. If
+	:c:member:`LIKELIHOOD_CONTEXT.pruning_threshold` is non-negative, points
+	are skipped as by :c:func:`kernel_cache_initialize` before the weights
+	are applied, and then again as by :c:func:`loglikelihood_context_sample`
+	afterward. Skipped points contribute to neither the likelihood nor its
+	derivatives. Otherwise, the result agrees with
+	:c:func:`loglikelihood_context_sample` up to rounding.
 */
-static MATRIX *trackpoint(TRACK t, const unsigned short index) {
+extern double loglikelihood_context_sample_gradient(LIKELIHOOD_CONTEXT *c,
+	const PACKED_SAMPLE *p, double *grad_predictions, double *grad_weights) {
+
+	PROFILE_START(PROFILE_LIKELIHOOD);
+	const TRACK *t = (*c).track;
+	const unsigned short n_threads = (*c).n_threads;
+	const unsigned long n_grad = (unsigned long) (*t).n_vectors * (*t).dim;
+
+	/*
+	The contributions are computed with unit weights, like the rows of a
+	kernel cache, so that the derivative with respect to each weight is
+	available even where the weight itself is zero. The weights are then
+	applied in logarithmic space.
+	*/
+	context_weights(c, (*c).normalize_weights);
+	double *weights = (double *) malloc ((*t).n_vectors * sizeof(double));
+	double *log_weights = (double *) malloc ((*t).n_vectors * sizeof(double));
+	for (unsigned short j = 0u; j < (*t).n_vectors; j++) {
+		weights[j] = (*c).weights[j];
+		log_weights[j] = log(weights[j]);
+		c -> weights[j] = 1;
+	}
+
+	/* See the notes on the padding in loglikelihood_data */
+	unsigned short max_dim = 1u;
+	for (unsigned long g = 0ul; g < (*p).n_groups; g++) {
+		if ((*p).groups[g].dim > max_dim) max_dim = (*p).groups[g].dim;
+	}
+	const unsigned long scratch_stride = padded_length(
+		CHI_SQUARED_BLOCK + 4ul * max_dim);
+	const unsigned long row_stride = padded_length((*t).n_vectors);
+	const unsigned long grad_stride = padded_length(n_grad);
+	const unsigned long sum_stride = padded_length(1ul);
+	double *scratch = (double *) aligned_malloc (
+		n_threads * scratch_stride * sizeof(double));
+	double *rows = (double *) aligned_malloc (
+		n_threads * row_stride * sizeof(double));
+	double *by_thread = (double *) aligned_malloc (n_threads * (
+		grad_stride + row_stride + sum_stride) * sizeof(double));
+	for (unsigned long i = 0ul; i < n_threads * (grad_stride + row_stride +
+		sum_stride); i++) {
+		by_thread[i] = 0;
+	}
+	double *grads = by_thread;
+	double *weight_grads = grads + n_threads * grad_stride;
+	double *sums = weight_grads + n_threads * row_stride;
+	PROFILE_COUNT(PROFILE_BYTES_ALLOCATED, n_threads * (scratch_stride +
+		2ul * row_stride + grad_stride + sum_stride) * sizeof(double));
+
+	for (unsigned long g = 0ul; g < (*p).n_groups; g++) {
+		PACKED_GROUP group = (*p).groups[g];
+		const unsigned long n_tri = (unsigned long) group.dim * (
+			group.dim + 1ul) / 2ul;
+		context_map_columns(c, group.ids, group.dim);
+		struct track_view v = track_view_project(c, group.dim);
+		if (v.log_coefficients == NULL) {
+			for (unsigned short j = 0u; j < (*t).n_vectors; j++) {
+				c -> log_coefficients[j] = log(v.coefficients[j]);
+			}
+			v.log_coefficients = (*c).log_coefficients;
+		} else {}
+
+		#if defined(_OPENMP)
+			#pragma omp parallel for num_threads(n_threads) schedule(static)
+		#endif
+		for (unsigned long i = 0ul; i < group.n_data; i++) {
+			PROFILE_START(PROFILE_DATA);
+			unsigned thread = THREAD_NUMBER();
+			sums[thread * sum_stride] += datum_gradient(
+				group.vectors + i * group.dim, group.inv + i * n_tri,
+				group.logdet[i], group.whitening + i * group.dim, v, weights,
+				log_weights, scratch + thread * scratch_stride,
+				rows + thread * row_stride, grads + thread * grad_stride,
+				weight_grads + thread * row_stride);
+			PROFILE_STOP(PROFILE_DATA);
+		}
+	}
+
+	/* Add up the partial sums and derivatives in order of thread number. */
+	double logl = 0;
+	for (unsigned short k = 0u; k < n_threads; k++) {
+		logl += sums[k * sum_stride];
+	}
+	for (unsigned long i = 0ul; i < n_grad; i++) {
+		grad_predictions[i] = 0;
+		for (unsigned short k = 0u; k < n_threads; k++) {
+			grad_predictions[i] += grads[k * grad_stride + i];
+		}
+	}
+	for (unsigned short j = 0u; j < (*t).n_vectors; j++) {
+		grad_weights[j] = 0;
+		for (unsigned short k = 0u; k < n_threads; k++) {
+			grad_weights[j] += weight_grads[k * row_stride + j];
+		}
+	}
 
-	MATRIX *point = matrix_initialize(1u, t.dim);
-	for (unsigned short i = 0u; i < t.dim; i++) {
-		point -> matrix[0][i] = t.predictions[index][i];
+	/*
+	So far, grad_weights holds the derivatives with respect to the weights
+	as used, i.e. normalized by context_weights if applicable. With w_j =
+	W_j / norm and norm proportional to the sum of the W_j, the chain rule
+	gives dlogL / dW_j = dlogL / dw_j / norm - sum_m w_m dlogL / dw_m /
+	sum_m W_m. Otherwise, the sum of the weights is subtracted from the
+	likelihood.
+	*/
+	if ((*c).normalize_weights) {
+		const double total = sum((*t).weights, (*t).n_vectors);
+		const double norm = track_weight_norm(t);
+		double projection = 0;
+		for (unsigned short j = 0u; j < (*t).n_vectors; j++) {
+			projection += weights[j] * grad_weights[j];
+		}
+		for (unsigned short j = 0u; j < (*t).n_vectors; j++) {
+			grad_weights[j] = grad_weights[j] / norm - projection / total;
+		}
+	} else {
+		for (unsigned short j = 0u; j < (*t).n_vectors; j++) {
+			logl -= (*t).weights[j];
+			grad_weights[j] -= 1;
+		}
+	}
+	free(weights);
+	free(log_weights);
+	free(scratch);
+	free(rows);
+	free(by_thread);
+	PROFILE_STOP(PROFILE_LIKELIHOOD);
+	return logl;
+
+}
+
+
+/*
+.. c:function:: static double loglikelihood_data(const double *vectors, const double *inv, const float *single, const double *logdet, const double *whitening, const unsigned long n_data, struct track_view v);
+
+	Compute the sum of the natural logarithms of the likelihoods of observing
+	several data that measure the same quantities, in parallel according to
+	:c:member:`LIKELIHOOD_CONTEXT.parallel_policy`.
+
+	Parameters
+	----------
+	vectors : ``const double *``
+		The data vectors, with the ``k``'th component of the ``i``'th datum at
+		``vectors[i * v.dim + k]``.
+	inv : ``const double *``
+		The packed upper triangles of the inverse covariance matrices, each of
+		which occupies ``v.dim * (v.dim + 1) / 2`` elements.
+	single : ``const float *``
+		Single precision copies of the vectors and inverse covariance
+		matrices, laid out like :c:member:`PACKED_GROUP.single`, or ``NULL``
+		if there are none.
+	logdet : ``const double *``
+		The natural logarithm of the determinant of each datum's covariance
+		matrix.
+	whitening : ``const double *``
+		The whitening scale factors of each datum (see
+		:c:func:`covariance_matrix_whitening`), laid out like ``vectors``.
+	n_data : ``const unsigned long``
+		The number of data.
+	v : ``struct track_view``
+		The model-predicted track, projected onto the quantities measured for
+		the data.
+
+	Returns
+	-------
+	logl : ``double``
+		The sum of the natural log of the likelihood of observation of each
+		datum, as in :c:func:`loglikelihood_datum`.
+
+	Notes
+	-----
+	Each thread accumulates its partial sums and computes its vector
+	differences in memory of its own, which begins on a separate cache line,
+	so threads never write to the same cache line. The partial sums are added
+	up in order of thread number, so the result does not depend on the order
+	in which the threads finish. The log-likelihoods of the data are summed
+	with :c:func:`compensated_add`, each thread carrying the compensation in
+	the element following its partial sum.
+*/
+static double loglikelihood_data(const double *vectors, const double *inv,
+	const float *single, const double *logdet, const double *whitening,
+	const unsigned long n_data, struct track_view v) {
+
+	LIKELIHOOD_CONTEXT *c = v.context;
+	const unsigned short n_threads = (*c).n_threads;
+	const unsigned short policy = parallel_policy(n_data, n_threads,
+		(*c).parallel_policy);
+	const unsigned long n_tri = (unsigned long) v.dim * (v.dim + 1ul) / 2ul;
+
+	/*
+	Under the collapsed policy, a datum's contributions may come from any
+	thread, so each thread needs a partial sum for every datum. Otherwise a
+	single partial sum per thread suffices. Each partial sum over the track
+	takes two elements (see partial_sum_reset).
+	*/
+	const unsigned long scratch_stride = padded_length(
+		CHI_SQUARED_BLOCK + 2ul * v.dim);
+	const unsigned long sum_stride = padded_length(
+		policy == PARALLEL_POLICY_COLLAPSED ? 2ul * n_data : 2ul);
+	c -> scratch = context_reserve(c -> scratch, &(c -> n_scratch),
+		n_threads * scratch_stride);
+	c -> by_thread = context_reserve(c -> by_thread, &(c -> n_by_thread),
+		n_threads * sum_stride);
+	double *scratch = (*c).scratch, *by_thread = (*c).by_thread;
+	for (unsigned long i = 0ul; i < n_threads * sum_stride; i++) {
+		by_thread[i] = 0;
+	}
+	double logl = 0, compensation = 0;
+
+	switch (policy) {
+
+		case PARALLEL_POLICY_TRACK:
+			/*
+			One parallel region for all of the data, with the threads
+			splitting up the track for each datum in turn.
+			*/
+			#if defined(_OPENMP)
+				#pragma omp parallel num_threads(n_threads)
+			#endif
+			{
+				unsigned thread = THREAD_NUMBER();
+				for (unsigned long i = 0ul; i < n_data; i++) {
+					PROFILE_START(PROFILE_DATA);
+					double *partial = by_thread + thread * sum_stride;
+					partial_sum_reset(partial, v);
+					#if defined(_OPENMP)
+						#pragma omp for schedule(static) nowait
+					#endif
+					for (unsigned short b = 0u; b < n_blocks(v); b++) {
+						block_likelihood(vectors + i * v.dim, inv + i * n_tri,
+							datum_single(single, i, v), whitening + i * v.dim,
+							v, b, scratch + thread * scratch_stride, partial);
+					}
+					PROFILE_STOP(PROFILE_DATA);
+					#if defined(_OPENMP)
+						#pragma omp barrier
+						#pragma omp single
+					#endif
+					{
+						double result[2];
+						partial_sum_reset(result, v);
+						for (unsigned short k = 0u; k < n_threads; k++) {
+							partial_sum_merge(result,
+								by_thread + k * sum_stride);
+						}
+						compensated_add(&logl, &compensation,
+							normalized_loglikelihood(result, logdet[i]));
+					}
+				}
+			}
+			break;
+
+		case PARALLEL_POLICY_COLLAPSED:
+			for (unsigned short k = 0u; k < n_threads; k++) {
+				for (unsigned long i = 0ul; i < n_data; i++) {
+					partial_sum_reset(by_thread + k * sum_stride + 2ul * i, v);
+				}
+			}
+			#if defined(_OPENMP)
+				#pragma omp parallel for num_threads(n_threads) collapse(2) \
+					schedule(static)
+			#endif
+			for (unsigned long i = 0ul; i < n_data; i++) {
+				for (unsigned short b = 0u; b < n_blocks(v); b++) {
+					PROFILE_START(PROFILE_DATA);
+					unsigned thread = THREAD_NUMBER();
+					block_likelihood(vectors + i * v.dim, inv + i * n_tri,
+						datum_single(single, i, v), whitening + i * v.dim, v,
+						b, scratch + thread * scratch_stride,
+						by_thread + thread * sum_stride + 2ul * i);
+					PROFILE_STOP(PROFILE_DATA);
+				}
+			}
+			for (unsigned long i = 0ul; i < n_data; i++) {
+				double result[2];
+				partial_sum_reset(result, v);
+				for (unsigned short k = 0u; k < n_threads; k++) {
+					partial_sum_merge(result,
+						by_thread + k * sum_stride + 2ul * i);
+				}
+				compensated_add(&logl, &compensation,
+					normalized_loglikelihood(result, logdet[i]));
+			}
+			break;
+
+		default:
+			#if defined(_OPENMP)
+				#pragma omp parallel for num_threads(n_threads) schedule(static)
+			#endif
+			for (unsigned long i = 0ul; i < n_data; i++) {
+				PROFILE_START(PROFILE_DATA);
+				unsigned thread = THREAD_NUMBER();
+				double *partial = by_thread + thread * sum_stride;
+				compensated_add(partial, partial + 1,
+					loglikelihood_packed(vectors + i * v.dim, inv + i * n_tri,
+						datum_single(single, i, v), logdet[i],
+						whitening + i * v.dim, v,
+						scratch + thread * scratch_stride));
+				PROFILE_STOP(PROFILE_DATA);
+			}
+			for (unsigned short k = 0u; k < n_threads; k++) {
+				compensated_add(&logl, &compensation,
+					by_thread[k * sum_stride]);
+				compensation += by_thread[k * sum_stride + 1ul];
+			}
+			break;
+
+	}
+
+	return logl + compensation;
+
+}
+
+
+/*
+.. c:function:: static const float *datum_single(const float *single, const unsigned long index, struct track_view v);
+
+	Find the single precision copy of a datum within a group, if it is to be
+	used.
+
+	Parameters
+	----------
+	single : ``const float *``
+		The single precision copies of the data within the group (see
+		:c:member:`PACKED_GROUP.single`), or ``NULL`` if there are none.
+	index : ``const unsigned long``
+		The index of the datum within the group.
+	v : ``struct track_view``
+		The model-predicted track, projected onto the quantities measured for
+		the group.
+
+	Returns
+	-------
+	datum : ``const float *``
+		The vector of the datum followed by the upper triangle of its inverse
+		covariance matrix, or ``NULL`` if either the group or ``v`` has no
+		single precision copy, in which case :math:`\chi^2` is computed in
+		double precision.
+*/
+static const float *datum_single(const float *single,
+	const unsigned long index, struct track_view v) {
+
+	if (single != NULL && v.projected_single != NULL) {
+		return single + index * (v.dim + (unsigned long) v.dim * (
+			v.dim + 1ul) / 2ul);
+	} else {
+		return NULL;
+	}
+
+}
+
+
+/*
+.. c:function:: static double kernel_cache_row(const double *vector, const double *inv, const double *whitening, struct track_view v, double *scratch, double *row);
+
+	Compute the natural logarithm of the contribution of each point along the
+	track to the likelihood of observing a datum, as stored by a
+	:c:type:`KERNEL_CACHE`.
+
+	Parameters
+	----------
+	vector : ``const double *``
+		The datum vector, with ``v.dim`` components in the same order as
+		``v.columns``.
+	inv : ``const double *``
+		The packed upper triangle of the inverse covariance matrix of the
+		datum.
+	whitening : ``const double *``
+		The whitening scale factors of the datum (see
+		:c:func:`covariance_matrix_whitening`).
+	v : ``struct track_view``
+		The model-predicted track, projected onto the quantities measured for
+		the datum with unit weights, with :c:member:`log_coefficients`
+		computed.
+	scratch : ``double *``
+		Scratch memory with room for at least
+		``CHI_SQUARED_BLOCK + 2 * v.dim`` elements.
+	row : ``double *``
+		The ``v.track -> n_vectors`` elements in which to store the log
+		contribution of each point, which is negative infinity for points that
+		contribute nothing or that are skipped.
+
+	Returns
+	-------
+	largest : ``double``
+		The largest element of ``row``.
+
+	Notes
+	-----
+	Blocks of points along the track are visited and skipped exactly as they
+	are by :c:func:`loglikelihood_packed`.
+*/
+static double kernel_cache_row(const double *vector, const double *inv,
+	const double *whitening, struct track_view v, double *scratch,
+	double *row) {
+
+	for (unsigned short j = 0u; j < (*v.track).n_vectors; j++) {
+		row[j] = -INFINITY;
+	}
+	const unsigned short start = most_promising_block(vector, whitening, v);
+	double largest = -INFINITY;
+	for (unsigned short i = 0u; i < n_blocks(v); i++) {
+		const unsigned short b = visiting_order(i, start);
+		if (v.block_largest == NULL || block_bound(vector, whitening, v, b) >=
+			largest - 0.5 * (*v.context).pruning_threshold) {
+			const double block_largest = block_log_contributions(vector, inv,
+				NULL, v, b, scratch);
+			if (block_largest > largest) largest = block_largest;
+			memcpy(row + b * CHI_SQUARED_BLOCK, scratch,
+				block_length(v, b) * sizeof(double));
+		} else {
+			PROFILE_COUNT(PROFILE_POINTS_PRUNED, block_length(v, b));
+		}
+	}
+	return largest;
+
+}
+
+
+/*
+.. c:function:: static double datum_gradient(const double *vector, const double *inv, const double logdet, const double *whitening, struct track_view v, const double *weights, const double *log_weights, double *scratch, double *row, double *grad_predictions, double *grad_weights);
+
+	Compute the natural logarithm of the likelihood of observing a single
+	datum stored in a :c:type:`PACKED_GROUP`, adding its derivatives with
+	respect to the predictions and weights of the track to running sums.
+
+	Parameters
+	----------
+	vector : ``const double *``
+		The datum vector, with ``v.dim`` components in the same order as
+		``v.columns``.
+	inv : ``const double *``
+		The packed upper triangle of the inverse covariance matrix of the
+		datum.
+	logdet : ``const double``
+		The natural logarithm of the determinant of the datum's covariance
+		matrix.
+	whitening : ``const double *``
+		The whitening scale factors of the datum (see
+		:c:func:`covariance_matrix_whitening`).
+	v : ``struct track_view``
+		The model-predicted track, projected onto the quantities measured for
+		the datum with unit weights, with :c:member:`log_coefficients`
+		computed.
+	weights : ``const double *``
+		The weight of each point along the track, as used in the likelihood.
+	log_weights : ``const double *``
+		The natural logarithm of each element of ``weights``.
+	scratch : ``double *``
+		Scratch memory with room for at least
+		``CHI_SQUARED_BLOCK + 4 * v.dim`` elements.
+	row : ``double *``
+		Scratch memory with room for ``v.track -> n_vectors`` elements, which
+		will be overwritten as by :c:func:`kernel_cache_row`.
+	grad_predictions : ``double *``
+		The running sums of the derivatives with respect to each prediction,
+		laid out like the predictions of the track.
+	grad_weights : ``double *``
+		The running sums of the derivatives with respect to each weight as
+		used in the likelihood.
+
+	Returns
+	-------
+	logl : ``double``
+		The natural log of the likelihood of observation.
+
+	Notes
+	-----
+	The contribution of the :math:`j`'th point is
+	:math:`w_j |\Delta M_j| \beta_j e^{-\chi_j^2 / 2}`, where
+	:math:`\Delta M_j = M_{j + 1} - M_j` and :math:`\beta_j` is the line
+	segment corrective factor, if applicable. Dividing by the sum of the
+	contributions :math:`S`, the derivative of :math:`\ln S` with respect to
+	:math:`w_j` is the contribution itself without the weight, and that with
+	respect to :math:`M_j` and :math:`M_{j + 1}` is the fraction of the sum
+	:math:`r_j` that the point contributes multiplied by the derivatives of
+	:math:`\ln|\Delta M_j|`, :math:`-\chi_j^2 / 2`, and :math:`\ln\beta_j`.
+	With :math:`y = C^{-1}(x - M_j)` and :math:`z = C^{-1}\Delta M_j`, and
+	the moments :math:`\langle q\rangle` and :math:`\langle q^2\rangle` of
+	the position along the line segment weighted by the integrand of
+	:math:`\beta_j` (see :c:func:`line_segment_moments`), these are
+
+	.. math:: \frac{\partial\ln S}{\partial M_j} = r_j\left[
+		-\frac{\Delta M_j}{|\Delta M_j|^2} + (1 - \langle q\rangle)y +
+		(\langle q^2\rangle - \langle q\rangle)z\right]
+
+	and
+
+	.. math:: \frac{\partial\ln S}{\partial M_{j + 1}} = r_j\left[
+		\frac{\Delta M_j}{|\Delta M_j|^2} + \langle q\rangle y -
+		\langle q^2\rangle z\right],
+
+	where both moments are zero without line segment corrections.
+*/
+static double datum_gradient(const double *vector, const double *inv,
+	const double logdet, const double *whitening, struct track_view v,
+	const double *weights, const double *log_weights, double *scratch,
+	double *row, double *grad_predictions, double *grad_weights) {
+
+	const unsigned short n_vectors = (*v.track).n_vectors;
+	const unsigned short n_cols = (*v.track).dim;
+	kernel_cache_row(vector, inv, whitening, v, scratch, row);
+	double largest = -INFINITY;
+	for (unsigned short j = 0u; j < n_vectors; j++) {
+		if (row[j] + log_weights[j] > largest) {
+			largest = row[j] + log_weights[j];
+		} else {}
+	}
+	if (largest == -INFINITY) return -INFINITY;
+
+	/* Skip points as block_likelihood would in logarithmic space. */
+	const double floor = (*v.context).pruning_threshold >= 0 ?
+		largest - 0.5 * (*v.context).pruning_threshold : -INFINITY;
+	double total = 0;
+	for (unsigned short j = 0u; j < n_vectors; j++) {
+		if (row[j] > -INFINITY && row[j] + log_weights[j] >= floor) {
+			total += exp(row[j] + log_weights[j] - largest);
+		} else {}
+	}
+	const double logs = largest + log(total);
+
+	/*
+	The last point along the track contributes nothing, so the next point
+	always exists for those that do.
+	*/
+	double *delta = scratch, *y = scratch + v.dim;
+	double *segment = scratch + 2u * v.dim, *z = scratch + 3u * v.dim;
+	for (unsigned short j = 0u; j < n_vectors; j++) {
+		if (row[j] > -INFINITY && row[j] + log_weights[j] >= floor) {
+			const double kernel = exp(row[j] - logs);
+			const double r = kernel * weights[j];
+			grad_weights[j] += kernel;
+			double length2 = 0;
+			for (unsigned short k = 0u; k < v.dim; k++) {
+				const double *column = v.projected + k * v.stride;
+				delta[k] = vector[k] - column[j];
+				segment[k] = column[j + 1u] - column[j];
+				length2 += segment[k] * segment[k];
+			}
+			packed_product(inv, delta, v.dim, y);
+			double moments[2] = {0, 0};
+			if ((*v.context).use_line_segment_corrections) {
+				packed_product(inv, segment, v.dim, z);
+				double a = 0, b = 0;
+				for (unsigned short k = 0u; k < v.dim; k++) {
+					a += segment[k] * z[k];
+					b += delta[k] * z[k];
+				}
+				line_segment_moments(a, b, moments);
+			} else {
+				for (unsigned short k = 0u; k < v.dim; k++) z[k] = 0;
+			}
+			double *current = grad_predictions + (unsigned long) j * n_cols;
+			double *next = current + n_cols;
+			for (unsigned short k = 0u; k < v.dim; k++) {
+				const double length = segment[k] / length2;
+				current[v.columns[k]] += r * (-length +
+					(1 - moments[0]) * y[k] + (moments[1] - moments[0]) * z[k]);
+				next[v.columns[k]] += r * (length + moments[0] * y[k] -
+					moments[1] * z[k]);
+			}
+		} else {}
+	}
+	return logs - 0.5 * (log(2 * PI) + logdet);
+
+}
+
+
+/*
+.. c:function:: static unsigned short parallel_policy(const unsigned long n_data, const unsigned short n_threads, const unsigned short requested);
+
+	Determine which loop to parallelize in computing the likelihood of
+	observing a group of data.
+
+	Parameters
+	----------
+	n_data : ``const unsigned long``
+		The number of data in the group.
+	n_threads : ``const unsigned short``
+		The number of threads to use.
+	requested : ``const unsigned short``
+		The value of :c:member:`TRACK.parallel_policy`.
+
+	Returns
+	-------
+	policy : ``unsigned short``
+		``requested``, unless it is :c:macro:`PARALLEL_POLICY_AUTO`, in which
+		case one of :c:macro:`PARALLEL_POLICY_DATA` and
+		:c:macro:`PARALLEL_POLICY_COLLAPSED`.
+*/
+static unsigned short parallel_policy(const unsigned long n_data,
+	const unsigned short n_threads, const unsigned short requested) {
+
+	if (requested != PARALLEL_POLICY_AUTO) {
+		return requested;
+	} else if (n_threads == 1u ||
+		n_data >= PARALLEL_DATA_PER_THREAD * n_threads) {
+		return PARALLEL_POLICY_DATA;
+	} else {
+		/*
+		Too few data to keep every thread busy, so the track points of all
+		of them are shared out instead.
+		*/
+		return PARALLEL_POLICY_COLLAPSED;
+	}
+
+}
+
+
+/*
+.. c:function:: static unsigned long padded_length(const unsigned long n);
+
+	Round a number of ``double`` elements up to fill a whole number of cache
+	lines, so that per-thread blocks of memory do not share cache lines.
+
+	Parameters
+	----------
+	n : ``const unsigned long``
+		The number of elements required.
+
+	Returns
+	-------
+	padded : ``unsigned long``
+		The smallest multiple of ``CACHE_LINE_SIZE / sizeof(double)`` that is
+		greater than or equal to ``n``, and at least one cache line.
+*/
+static unsigned long padded_length(const unsigned long n) {
+
+	const unsigned long per_line = CACHE_LINE_SIZE / sizeof(double);
+	if (n) {
+		return (n + per_line - 1ul) / per_line * per_line;
+	} else {
+		return per_line;
+	}
+
+}
+
+
+/*
+.. c:function:: static double loglikelihood_packed(const double *vector, const double *inv, const float *single, const double logdet, const double *whitening, struct track_view v, double *scratch);
+
+	Compute the natural logarithm of the likelihood of observing a single
+	datum stored in a :c:type:`PACKED_GROUP`, without parallelizing over the
+	points along the track.
+
+	Parameters
+	----------
+	vector : ``const double *``
+		The datum vector, with ``v.dim`` components in the same order as
+		``v.columns``.
+	inv : ``const double *``
+		The upper triangle of the inverse covariance matrix of the datum,
+		packed row by row (see :c:func:`packed_index`).
+	single : ``const float *``
+		Single precision copies of ``vector`` and ``inv``, one after the
+		other, or ``NULL`` to compute :math:`\chi^2` in double precision.
+	logdet : ``const double``
+		The natural logarithm of the determinant of the datum's covariance
+		matrix.
+	whitening : ``const double *``
+		The whitening scale factors of the datum (see
+		:c:func:`covariance_matrix_whitening`).
+	v : ``struct track_view``
+		The model-predicted track, projected onto the quantities measured for
+		the datum.
+	scratch : ``double *``
+		Scratch memory with room for at least
+		``CHI_SQUARED_BLOCK + 2 * v.dim`` elements.
+
+	Returns
+	-------
+	logl : ``double``
+		The natural log of the likelihood of observation, as in
+		:c:func:`loglikelihood_datum`.
+
+	Notes
+	-----
+	The blocks are visited in the order given by :c:func:`visiting_order`,
+	beginning with the :c:func:`most_promising_block`.
+*/
+static double loglikelihood_packed(const double *vector, const double *inv,
+	const float *single, const double logdet, const double *whitening,
+	struct track_view v, double *scratch) {
+
+	const unsigned short start = most_promising_block(vector, whitening, v);
+	double result[2];
+	partial_sum_reset(result, v);
+	for (unsigned short i = 0u; i < n_blocks(v); i++) {
+		block_likelihood(vector, inv, single, whitening, v,
+			visiting_order(i, start), scratch, result);
+	}
+	return normalized_loglikelihood(result, logdet);
+
+}
+
+
+/*
+.. c:function:: static double normalized_loglikelihood(const double *partial, const double logdet);
+
+	Convert the sum of the contributions of each point along the track to the
+	likelihood of observing a datum into the natural log of the likelihood.
+
+	Parameters
+	----------
+	partial : ``const double *``
+		The sum of the contributions over the track, as accumulated by
+		:c:func:`block_likelihood` (see :c:func:`partial_sum_reset`).
+	logdet : ``const double``
+		The natural logarithm of the determinant of the datum's covariance
+		matrix.
+
+	Returns
+	-------
+	logl : ``double``
+		The natural log of the likelihood of observation.
+*/
+static double normalized_loglikelihood(const double *partial,
+	const double logdet) {
+
+	/*
+	Equivalent to log(result / sqrt(2 * PI * det(C))), but uses the
+	log-determinant cached by the covariance matrix, which avoids both
+	recomputing the determinant and the underflow of det(C) in high
+	dimensions.
+	*/
+	return partial[0] + log(partial[1]) - 0.5 * (log(2 * PI) + logdet);
+
+}
+
+
+/*
+.. c:function:: static void partial_sum_reset(double *partial, struct track_view v);
+
+	Reset a partial sum of the contributions of points along the track to the
+	likelihood of observing a datum to zero.
+
+	Parameters
+	----------
+	partial : ``double *``
+		The partial sum, which occupies two elements. The sum itself is
+		``exp(partial[0]) * partial[1]``, so that it may be accumulated in
+		logarithmic space without underflowing.
+	v : ``struct track_view``
+		The projected track, whose context determines whether the sum is
+		accumulated in logarithmic space.
+
+	Notes
+	-----
+	In linear space, ``partial[0]`` is always zero, and the contributions are
+	added to ``partial[1]`` as they are. In logarithmic space, ``partial[0]``
+	is the natural log of the largest contribution seen so far, which begins
+	at negative infinity.
+*/
+static void partial_sum_reset(double *partial, struct track_view v) {
+
+	if (v.log_coefficients != NULL) {
+		partial[0] = -INFINITY;
+	} else {
+		partial[0] = 0;
+	}
+	partial[1] = 0;
+
+}
+
+
+/*
+.. c:function:: static void partial_sum_merge(double *partial, const double *other);
+
+	Add one partial sum of the contributions of points along the track to
+	another.
+
+	Parameters
+	----------
+	partial : ``double *``
+		The partial sum to add to (see :c:func:`partial_sum_reset`).
+	other : ``const double *``
+		The partial sum to be added, which must have been accumulated in the
+		same space.
+*/
+static void partial_sum_merge(double *partial, const double *other) {
+
+	if (other[1]) {
+		if (other[0] > partial[0]) {
+			partial[1] = partial[1] * exp(partial[0] - other[0]) + other[1];
+			partial[0] = other[0];
+		} else {
+			partial[1] += other[1] * exp(other[0] - partial[0]);
+		}
+	} else {}
+
+}
+
+
+/*
+.. c:function:: static void block_likelihood(const double *vector, const double *inv, const float *single, const double *whitening, struct track_view v, const unsigned short block, double *scratch, double *partial);
+
+	Add the contribution of a block of up to :c:macro:`CHI_SQUARED_BLOCK`
+	consecutive points along the track to the likelihood of observing a
+	datum.
+
+	Parameters
+	----------
+	vector : ``const double *``
+		The datum vector, with ``v.dim`` components in the same order as
+		``v.columns``.
+	inv : ``const double *``
+		The packed upper triangle of the inverse covariance matrix of the
+		datum.
+	single : ``const float *``
+		Single precision copies of ``vector`` and ``inv``, or ``NULL`` (see
+		:c:func:`block_chi_squared`).
+	whitening : ``const double *``
+		The whitening scale factors of the datum (see
+		:c:func:`covariance_matrix_whitening`).
+	v : ``struct track_view``
+		The model-predicted track, projected onto the quantities measured for
+		the datum.
+	block : ``const unsigned short``
+		The index of the block, which begins at point number
+		``block * CHI_SQUARED_BLOCK`` along the track.
+	scratch : ``double *``
+		Scratch memory with room for at least
+		``CHI_SQUARED_BLOCK + 2 * v.dim`` elements.
+	partial : ``double *``
+		The partial sum to add to (see :c:func:`partial_sum_reset`). Each
+		point contributes its weight multiplied by :math:`\exp(-\chi^2 / 2)`,
+		the length of the line segment connecting it to the next point, and
+		the line segment corrective factor, if applicable.
+
+	Notes
+	-----
+	The values of :math:`\chi^2` for the whole block are computed first by
+	the vectorized :c:func:`chi_squared_points`, which is why the points are
+	handled in blocks rather than one at a time. In linear space, the
+	contributions within the block are summed on their own before being
+	added to ``partial``, so the rounding error of the sum over the track
+	grows with the number of blocks rather than the number of points.
+
+	In logarithmic space, the largest contribution in the block is found
+	before any are exponentiated, so the scale of the partial sum changes at
+	most once per block. Contributions smaller than the largest seen so far
+	by more than a factor of ``exp(-pruning_threshold / 2)`` are skipped
+	without being exponentiated. Since the largest contribution can only
+	grow, every skipped contribution falls at least this far below the
+	largest one overall. If the track is bounded block by block, the whole
+	block is skipped without computing :math:`\chi^2` when
+	:c:func:`block_bound` falls below this threshold.
+*/
+static void block_likelihood(const double *vector, const double *inv,
+	const float *single, const double *whitening, struct track_view v,
+	const unsigned short block, double *scratch, double *partial) {
+
+	if (v.block_largest != NULL && block_bound(vector, whitening, v, block) <
+		partial[0] - 0.5 * (*v.context).pruning_threshold) {
+		PROFILE_COUNT(PROFILE_POINTS_PRUNED, block_length(v, block));
+		return;
+	} else {}
+
+	const unsigned short first = block * CHI_SQUARED_BLOCK;
+	const unsigned short n_points = block_length(v, block);
+	if (v.log_coefficients == NULL) {
+		double *chisq = scratch, subtotal = 0;
+		block_chi_squared(vector, inv, single, v, block, chisq);
+		for (unsigned short j = 0u; j < n_points; j++) {
+			double s = v.coefficients[first + j];
+			if (s) {
+				/*
+				Zero for the last point along the track and for zero weights.
+				The corrective factor can be extremely large precisely when
+				exp(-chi^2 / 2) is extremely small, so the two are combined in
+				logarithmic space before exponentiating.
+				*/
+				double exponent = -0.5 * chisq[j];
+				if ((*v.context).use_line_segment_corrections) {
+					PROFILE_START(PROFILE_CORRECTIVE_FACTOR);
+					exponent += log_corrective_factor(vector, inv, v,
+						first + j, scratch + CHI_SQUARED_BLOCK);
+					PROFILE_STOP(PROFILE_CORRECTIVE_FACTOR);
+				} else {}
+				subtotal += s * exp(exponent);
+			} else {}
+		}
+		partial[1] += subtotal;
+	} else {
+		double *logc = scratch;
+		const double largest = block_log_contributions(vector, inv, single, v,
+			block, scratch);
+		if (largest > partial[0]) {
+			partial[1] *= exp(partial[0] - largest);
+			partial[0] = largest;
+		} else {}
+		const double floor = partial[0] - 0.5 * (*v.context).pruning_threshold;
+		for (unsigned short j = 0u; j < n_points; j++) {
+			if (logc[j] > -INFINITY && logc[j] >= floor) {
+				partial[1] += exp(logc[j] - partial[0]);
+			} else {
+				PROFILE_COUNT(PROFILE_POINTS_PRUNED, logc[j] > -INFINITY);
+			}
+		}
+	}
+
+}
+
+
+/*
+.. c:function:: static double block_log_contributions(const double *vector, const double *inv, const float *single, struct track_view v, const unsigned short block, double *scratch);
+
+	Compute the natural logarithm of the contribution of each point within a
+	block along the track to the likelihood of observing a datum.
+
+	Parameters
+	----------
+	vector : ``const double *``
+		The datum vector, with ``v.dim`` components in the same order as
+		``v.columns``.
+	inv : ``const double *``
+		The packed upper triangle of the inverse covariance matrix of the
+		datum.
+	single : ``const float *``
+		Single precision copies of ``vector`` and ``inv``, or ``NULL`` (see
+		:c:func:`block_chi_squared`).
+	v : ``struct track_view``
+		The model-predicted track, projected onto the quantities measured for
+		the datum, with :c:member:`log_coefficients` computed.
+	block : ``const unsigned short``
+		The index of the block.
+	scratch : ``double *``
+		Scratch memory with room for at least
+		``CHI_SQUARED_BLOCK + 2 * v.dim`` elements. The log contribution of
+		each point within the block is stored in the first
+		:c:func:`block_length` elements, and is negative infinity for points
+		that contribute nothing (e.g. the last point along the track).
+
+	Returns
+	-------
+	largest : ``double``
+		The largest of the log contributions.
+*/
+static double block_log_contributions(const double *vector,
+	const double *inv, const float *single, struct track_view v,
+	const unsigned short block, double *scratch) {
+
+	const unsigned short first = block * CHI_SQUARED_BLOCK;
+	const unsigned short n_points = block_length(v, block);
+	double *chisq = scratch;
+	block_chi_squared(vector, inv, single, v, block, chisq);
+
+	/* Overwrite chisq with the log of each point's contribution. */
+	double largest = -INFINITY;
+	for (unsigned short j = 0u; j < n_points; j++) {
+		double l = v.log_coefficients[first + j];
+		if (l > -INFINITY) {
+			l -= 0.5 * chisq[j];
+			if ((*v.context).use_line_segment_corrections) {
+				/*
+				The correction can outweigh a large chi-squared at the start
+				of a long line segment, so it must be included before
+				deciding whether or not to skip the point.
+				*/
+				PROFILE_START(PROFILE_CORRECTIVE_FACTOR);
+				l += log_corrective_factor(vector, inv, v, first + j,
+					scratch + CHI_SQUARED_BLOCK);
+				PROFILE_STOP(PROFILE_CORRECTIVE_FACTOR);
+			} else {}
+			if (l > largest) largest = l;
+		} else {}
+		chisq[j] = l;
+	}
+	return largest;
+
+}
+
+
+/*
+.. c:function:: static void block_chi_squared(const double *vector, const double *inv, const float *single, struct track_view v, const unsigned short block, double *chisq);
+
+	Compute :math:`\chi^2` between a datum and each point within a block
+	along the track.
+
+	Parameters
+	----------
+	vector : ``const double *``
+		The datum vector, with ``v.dim`` components in the same order as
+		``v.columns``.
+	inv : ``const double *``
+		The packed upper triangle of the inverse covariance matrix of the
+		datum.
+	single : ``const float *``
+		Single precision copies of ``vector`` and ``inv``, one after the
+		other, or ``NULL``.
+	v : ``struct track_view``
+		The model-predicted track, projected onto the quantities measured for
+		the datum.
+	block : ``const unsigned short``
+		The index of the block.
+	chisq : ``double *``
+		The values of :math:`\chi^2`, one for each of the
+		:c:func:`block_length` points within the block, followed by room for
+		at least ``v.dim`` more elements, which are overwritten.
+
+	Notes
+	-----
+	If the track has been transformed into the whitened frame of the datum's
+	covariance matrix, the datum is transformed as well, and :math:`\chi^2`
+	is computed by :c:func:`squared_distance_points`, ignoring ``single``.
+	Transforming the datum again for each block costs only
+	``v.dim * (v.dim + 1) / 2`` operations, far fewer than the block itself.
+	Otherwise, if ``single`` is not ``NULL``, :math:`\chi^2` is computed by
+	:c:func:`chi_squared_points_single` from
+	:c:member:`track_view.projected_single` and converted to double
+	precision afterwards. Otherwise, :math:`\chi^2` is computed by
+	:c:func:`chi_squared_points`.
+*/
+static void block_chi_squared(const double *vector, const double *inv,
+	const float *single, struct track_view v, const unsigned short block,
+	double *chisq) {
+
+	const unsigned short first = block * CHI_SQUARED_BLOCK;
+	const unsigned short n_points = block_length(v, block);
+	PROFILE_START(PROFILE_CHI_SQUARED);
+	if (v.whitened != NULL) {
+		double *whitened = chisq + CHI_SQUARED_BLOCK;
+		unsigned long index = 0ul;
+		for (unsigned short k = 0u; k < v.dim; k++) {
+			whitened[k] = 0;
+			for (unsigned short l = k; l < v.dim; l++) {
+				whitened[k] += v.transform[index++] * vector[l];
+			}
+		}
+		squared_distance_points(whitened, v.whitened + first, v.stride,
+			v.dim, n_points, chisq);
+	} else if (single != NULL) {
+		float reduced[CHI_SQUARED_BLOCK];
+		chi_squared_points_single(single, single + v.dim,
+			v.projected_single + first, v.stride, v.dim, n_points, reduced);
+		for (unsigned short j = 0u; j < n_points; j++) chisq[j] = reduced[j];
+	} else {
+		chi_squared_points(vector, inv, v.projected + first, v.stride, v.dim,
+			n_points, chisq);
+	}
+	PROFILE_STOP(PROFILE_CHI_SQUARED);
+	PROFILE_COUNT(PROFILE_KERNEL_EVALUATIONS, n_points);
+
+}
+
+
+/*
+.. c:function:: static double block_bound(const double *vector, const double *whitening, struct track_view v, const unsigned short block);
+
+	Bound from above the natural logarithm of the contribution of any point
+	within a block along the track to the likelihood of observing a datum.
+
+	Parameters
+	----------
+	vector : ``const double *``
+		The datum vector.
+	whitening : ``const double *``
+		The whitening scale factors of the datum (see
+		:c:func:`covariance_matrix_whitening`).
+	v : ``struct track_view``
+		The projected track, with bounding boxes for each block.
+	block : ``const unsigned short``
+		The index of the block.
+
+	Returns
+	-------
+	bound : ``double``
+		The largest log coefficient within the block less half of a lower
+		bound on :math:`\chi^2` between the datum and any point within the
+		block's bounding box.
+
+	Notes
+	-----
+	Each bounding box includes the first point of the next block, so it
+	contains every line segment starting within the block as well. The line
+	segment corrective factor multiplied by :math:`\exp(-\chi^2 / 2)` at
+	the start of a segment is the average of :math:`\exp(-\chi^2 / 2)` along
+	the segment, so the bound holds with or without the correction.
+*/
+static double block_bound(const double *vector, const double *whitening,
+	struct track_view v, const unsigned short block) {
+
+	const double *lower = v.block_lower + block * v.dim;
+	const double *upper = v.block_upper + block * v.dim;
+	double chisq = 0;
+	for (unsigned short k = 0u; k < v.dim; k++) {
+		double distance = 0;
+		if (vector[k] < lower[k]) {
+			distance = lower[k] - vector[k];
+		} else if (vector[k] > upper[k]) {
+			distance = vector[k] - upper[k];
+		} else {}
+		distance *= whitening[k];
+		chisq += distance * distance;
+	}
+	return v.block_largest[block] - 0.5 * chisq;
+
+}
+
+
+/*
+.. c:function:: static unsigned short most_promising_block(const double *vector, const double *whitening, struct track_view v);
+
+	Determine which block along the track likely makes the largest
+	contribution to the likelihood of observing a datum.
+
+	Parameters
+	----------
+	vector : ``const double *``
+		The datum vector.
+	whitening : ``const double *``
+		The whitening scale factors of the datum (see
+		:c:func:`covariance_matrix_whitening`).
+	v : ``struct track_view``
+		The projected track.
+
+	Returns
+	-------
+	block : ``unsigned short``
+		The index of the block with the largest :c:func:`block_bound`, or 0 if
+		the track is not bounded block by block.
+
+	Notes
+	-----
+	Visiting this block first raises the largest contribution found so far
+	as early as possible, such that as many of the remaining blocks as
+	possible are skipped entirely.
+*/
+static unsigned short most_promising_block(const double *vector,
+	const double *whitening, struct track_view v) {
+
+	unsigned short start = 0u;
+	if (v.block_largest != NULL) {
+		double best = -INFINITY;
+		for (unsigned short b = 0u; b < n_blocks(v); b++) {
+			double bound = block_bound(vector, whitening, v, b);
+			if (bound > best) {
+				best = bound;
+				start = b;
+			} else {}
+		}
+	} else {}
+	return start;
+
+}
+
+
+/*
+.. c:function:: static unsigned short visiting_order(const unsigned short i, const unsigned short start);
+
+	Determine which block along the track to visit at a given step, starting
+	from a given block and then proceeding through the others in order.
+
+	Parameters
+	----------
+	i : ``const unsigned short``
+		The step number, which begins at 0.
+	start : ``const unsigned short``
+		The block to visit first.
+
+	Returns
+	-------
+	block : ``unsigned short``
+		The index of the block to visit. The blocks are visited in their
+		natural order if ``start`` is 0.
+*/
+static unsigned short visiting_order(const unsigned short i,
+	const unsigned short start) {
+
+	if (i == 0u) {
+		return start;
+	} else if (i <= start) {
+		return i - 1u;
+	} else {
+		return i;
+	}
+
+}
+
+
+/*
+.. c:function:: static unsigned short n_blocks(struct track_view v);
+
+	Determine the number of blocks of :c:macro:`CHI_SQUARED_BLOCK` points that
+	the track is split into by :c:func:`block_likelihood`.
+
+	Parameters
+	----------
+	v : ``struct track_view``
+		The projected track.
+
+	Returns
+	-------
+	n : ``unsigned short``
+		The number of blocks, the last of which may be only partially full.
+*/
+static unsigned short n_blocks(struct track_view v) {
+
+	return ((*v.track).n_vectors + CHI_SQUARED_BLOCK - 1u) / CHI_SQUARED_BLOCK;
+
+}
+
+
+/*
+.. c:function:: static unsigned short block_length(struct track_view v, const unsigned short block);
+
+	Determine the number of points along the track within a block.
+
+	Parameters
+	----------
+	v : ``struct track_view``
+		The projected track.
+	block : ``const unsigned short``
+		The index of the block.
+
+	Returns
+	-------
+	n : ``unsigned short``
+		:c:macro:`CHI_SQUARED_BLOCK`, unless ``block`` is the last block and
+		only partially full.
+*/
+static unsigned short block_length(struct track_view v,
+	const unsigned short block) {
+
+	const unsigned short remaining = (*v.track).n_vectors -
+		block * CHI_SQUARED_BLOCK;
+	return remaining < CHI_SQUARED_BLOCK ? remaining : CHI_SQUARED_BLOCK;
+
+}
+
+
+/*
+.. c:function:: static delta delta_model(struct track_view v, const unsigned short index);
+
+	Computes the magnitude of the vector displacement between neighboring points
+	on the track.
+
+	Parameters
+	----------
+	v : ``struct track_view``
+		The track itself, projected onto the quantities of interest.
+	index : ``unsigned short``
+		The index of the vector along the track to compute the :math:`\Delta M`
+		at.
+
+	Returns
+	-------
+	delta : ``double``
+		The magnitude of the :math:`\Delta M_j = M_{j + 1} - M_j` vector.
+*/
+static double delta_model(struct track_view v, const unsigned short index) {
+
+	if (index < (*v.track).n_vectors - 1ul) {
+		/* compute magnitude of delta vector in data space */
+		const double *current = (*v.track).predictions[index];
+		const double *next = (*v.track).predictions[index + 1u];
+		double mag = 0;
+		for (unsigned short i = 0u; i < v.dim; i++) {
+			double diff = next[v.columns[i]] - current[v.columns[i]];
+			mag += diff * diff;
+		}
+		return sqrt(mag);
+	} else {
+		return 0.f;
+	}
+
+}
+
+
+/*
+.. c:function:: static double log_corrective_factor(const double *vector, const double *inv, struct track_view v, const unsigned short index, double *scratch);
+
+	Compute the natural logarithm of the corrective factor in the likelihood
+	estimate that accounts for the finite length of the line segment
+	connecting two consecutive vectors in the model-predicted track.
+
+	Parameters
+	----------
+	vector : ``const double *``
+		The datum whose likelihood of observation is being computed.
+	inv : ``const double *``
+		The packed upper triangle of the inverse covariance matrix of the
+		datum (see :c:func:`packed_index`).
+	v : ``struct track_view``
+		The model-predicted track, projected onto the quantities measured for
+		the datum.
+	index : ``const unsigned short``
+		The index of the vector along the track to compute the corrective
+		factor for (i.e. which line segment).
+	scratch : ``double *``
+		Scratch memory with room for at least ``2 * v.dim`` elements, which
+		will be overwritten with the vector difference between the datum and
+		the track point and the vector along the line segment.
+
+	Returns
+	-------
+	correction : ``double``
+		:math:`\ln\beta_{ij}`, where :math:`\beta_{ij}` is defined according
+		to equation A12 in Johnson et al. (2022) [1]_.
+
+	Notes
+	-----
+	The method depends on :c:member:`TRACK.use_line_segment_corrections`. If
+	:c:macro:`LINE_SEGMENT_CORRECTIONS_QUADRATURE`, :math:`\beta_{ij}` is
+	integrated numerically with :c:func:`quad`, which is slow but serves to
+	validate the default, closed-form evaluation in
+	:c:func:`log_line_segment_integral`.
+
+	References
+	----------
+	.. [1] Johnson J.W., et al., 2022, MNRAS, 526, 5084
+*/
+static double log_corrective_factor(const double *vector, const double *inv,
+	struct track_view v, const unsigned short index, double *scratch) {
+
+	if (index < (*v.track).n_vectors - 1u) {
+		/*
+		Determine the values of the a and b coefficients, which define the
+		corrective factor.
+		*/
+		const double *current = (*v.track).predictions[index];
+		const double *next = (*v.track).predictions[index + 1u];
+		double *delta = scratch, *linesegment = scratch + v.dim;
+		for (unsigned short i = 0u; i < v.dim; i++) {
+			delta[i] = vector[i] - current[v.columns[i]];
+			linesegment[i] = next[v.columns[i]] - current[v.columns[i]];
+		}
+		double a = quadratic_form(linesegment, inv, linesegment, v.dim);
+		double b = quadratic_form(delta, inv, linesegment, v.dim);
+
+		if ((*v.context).use_line_segment_corrections ==
+			LINE_SEGMENT_CORRECTIONS_QUADRATURE) {
+			double extra_args[2] = {a, b};
+			double workspace[QUAD_WORKSPACE_SIZE(1ul, 2u)];
+			INTEGRAL intgrl;
+			intgrl.func = &corrective_factor_marginalization_integrand;
+			intgrl.lower = 0;
+			intgrl.upper = 1;
+			intgrl.tolerance = LINE_SEGMENT_CORRECTION_TOLERANCE;
+			intgrl.n_min = LINE_SEGMENT_CORRECTION_MIN_ITERS;
+			intgrl.n_max = LINE_SEGMENT_CORRECTION_MAX_ITERS;
+			intgrl.extra_args = extra_args;
+			intgrl.n_extra_args = 2u;
+			quad_batch(&intgrl, 1ul, workspace);
+			return log(intgrl.result);
+		} else {
+			return log_line_segment_integral(a, b);
+		}
+	} else {
+		/*
+		The correction integrates over the full length of the line segment.
+		Therefore, the point at the end of the track can be treated as a line
+		segment of length 0, therefore not contributing to the overall
+		likelihood.
+		*/
+		return -INFINITY;
+	}
+
+}
+
+
+/*
+.. c:function:: extern double log_line_segment_integral(const double a, const double b);
+
+	Evaluate the natural logarithm of the integral
+
+	.. math:: \beta = \int_0^1 \exp\left(\frac{-1}{2}(aq^2 - 2bq)\right) dq
+
+	in closed form without overflow or catastrophic cancellation.
+
+	Parameters
+	----------
+	a : ``const double``
+		The squared length of the line segment, weighted by the inverse
+		covariance matrix of the datum. Non-negative.
+	b : ``const double``
+		The projection of the vector difference between the datum and the
+		start of the line segment onto the line segment, weighted by the
+		inverse covariance matrix of the datum.
+
+	Returns
+	-------
+	logbeta : ``double``
+		:math:`\ln\beta`.
+
+	Notes
+	-----
+	Completing the square with :math:`u_0 = -b / \sqrt{2a}` and
+	:math:`u_1 = (a - b) / \sqrt{2a}` gives
+
+	.. math:: \beta = \sqrt{\frac{\pi}{2a}} e^{u_0^2}
+		\left[\text{erf}(u_1) - \text{erf}(u_0)\right].
+
+	The naive evaluation of this expression multiplies the potentially
+	enormous :math:`e^{u_0^2}` by a potentially tiny difference of error
+	functions. When :math:`u_0` and :math:`u_1` share a sign, the difference
+	is instead rewritten in terms of :func:`erfcx`, such that the only
+	exponential left over is bounded by 1 (for :math:`u_0 \geq 0`) or is
+	added in logarithmic space (for :math:`u_1 \leq 0`). When they have
+	opposite signs, the difference of error functions is at least
+	:math:`\text{erf}(|u_0|)` and there is no cancellation to avoid.
+
+	For :math:`a <` :c:macro:`LINE_SEGMENT_CORRECTION_SMALL_A`,
+	:math:`u_1 - u_0 = \sqrt{a / 2}` is small enough that the difference
+	loses precision regardless. The integrand is then nearly exponential in
+	:math:`q`, and the integral is evaluated with :c:func:`gauss_legendre`
+	after factoring out the maximum of the integrand over the line segment.
+	This is accurate to double precision for :math:`|b| \lesssim 10`, which
+	covers every line segment whose contribution to the likelihood does not
+	underflow, since :math:`b^2 \leq a\chi^2` by the Cauchy-Schwarz
+	inequality.
+*/
+extern double log_line_segment_integral(const double a, const double b) {
+
+	if (a < LINE_SEGMENT_CORRECTION_SMALL_A) {
+		double qmax;
+		if (b <= 0) {
+			qmax = 0;
+		} else if (b >= a) {
+			qmax = 1;
+		} else {
+			qmax = b / a;
+		}
+		double args[4] = {0, a, b, b * qmax - 0.5 * a * qmax * qmax};
+		return args[3] + log(gauss_legendre(&scaled_marginalization_integrand,
+			0, 1, args));
+	} else {
+		double root2a = sqrt(2 * a);
+		double u0 = -b / root2a, u1 = (a - b) / root2a;
+		double prefactor = 0.5 * log(PI / (2 * a));
+		if (u0 >= 0) {
+			return prefactor + log(erfcx(u0) - exp(b - 0.5 * a) * erfcx(u1));
+		} else if (u1 <= 0) {
+			return prefactor + b - 0.5 * a + log(erfcx(-u1) -
+				exp(0.5 * a - b) * erfcx(-u0));
+		} else {
+			return prefactor + u0 * u0 + log(erf(u1) - erf(u0));
+		}
+	}
+
+}
+
+
+/*
+.. c:function:: static double corrective_factor_marginalization_integrand(double *args);
+
+	The integrand for computing line segment length corrections along the track.
+
+	Parameters
+	----------
+	args : ``double *``
+		The integration parameters, :math:`q`, :math:`a`, and :math:`b`.
+
+	Returns
+	-------
+	value : ``double``
+		The integrand, defined as
+
+		.. math:: \exp(\frac{-1}{2} (aq^2 - 2bq)),
+
+		where ``q = args[0]``, ``a = args[1]``, and ``b = args[2]``.
+*/
+static double corrective_factor_marginalization_integrand(double *args) {
+
+	double q = args[0], a = args[1], b = args[2];
+	return exp(-0.5 * (a * q * q - 2 * b * q));
+
+}
+
+
+/*
+.. c:function:: static double scaled_marginalization_integrand(double *args);
+static void line_segment_moments(const double a, const double b,
+	double *moments);
+static double line_segment_moment_integrand(double *args);
+
+	The integrand of :c:func:`corrective_factor_marginalization_integrand`,
+	divided by a constant factor to prevent overflow.
+
+	Parameters
+	----------
+	args : ``double *``
+		The integration parameters, :math:`q`, :math:`a`, :math:`b`, and
+		:math:`m`.
+
+	Returns
+	-------
+	value : ``double``
+		The integrand, defined as
+
+		.. math:: \exp(\frac{-1}{2} (aq^2 - 2bq) - m),
+
+		where ``q = args[0]``, ``a = args[1]``, ``b = args[2]``, and
+		``m = args[3]``.
+*/
+static double scaled_marginalization_integrand(double *args) {
+
+	double q = args[0], a = args[1], b = args[2], m = args[3];
+	return exp(-0.5 * (a * q * q - 2 * b * q) - m);
+
+}
+
+
+/*
+.. c:function:: static void line_segment_moments(const double a, const double b, double *moments);
+
+	Compute the first two moments of the position along a line segment
+	weighted by the integrand of the corrective factor, which give its
+	derivatives.
+
+	Parameters
+	----------
+	a : ``const double``
+		The squared length of the line segment, weighted by the inverse
+		covariance matrix of the datum (see
+		:c:func:`log_line_segment_integral`).
+	b : ``const double``
+		The projection of the vector difference between the datum and the
+		start of the line segment onto the line segment, weighted likewise.
+	moments : ``double *``
+		The two elements in which to store :math:`\langle q\rangle` and
+		:math:`\langle q^2\rangle`, where
+
+		.. math:: \langle q^n\rangle = \frac{1}{\beta}\int_0^1 q^n
+			\exp\left(\frac{-1}{2}(aq^2 - 2bq)\right) dq.
+
+	Notes
+	-----
+	These are the derivatives :math:`\partial\ln\beta / \partial b` and
+	:math:`-2\partial\ln\beta / \partial a`. Integrating
+	:math:`(b - aq)` and :math:`q(b - aq)` times the integrand by parts gives
+
+	.. math:: a\langle q\rangle = b - \frac{e^{b - a / 2} - 1}{\beta}
+
+	and
+
+	.. math:: a\langle q^2\rangle = b\langle q\rangle -
+		\frac{e^{b - a / 2}}{\beta} + 1.
+
+	The subtractions cancel catastrophically at small :math:`a`, so if both
+	:math:`a` and :math:`|b|` are at most
+	:c:macro:`LINE_SEGMENT_CORRECTION_SMOOTH`, where the integrand is smooth
+	enough for :c:func:`gauss_legendre` to be accurate to nearly double
+	precision, the moments are integrated numerically instead. Outside of
+	this range, :math:`b^2 \leq a\chi^2` bounds :math:`a` from below for any
+	contribution that does not underflow.
+*/
+static void line_segment_moments(const double a, const double b,
+	double *moments) {
+
+	if (a <= LINE_SEGMENT_CORRECTION_SMOOTH &&
+		fabs(b) <= LINE_SEGMENT_CORRECTION_SMOOTH) {
+		double integrals[3];
+		for (unsigned short n = 0u; n < 3u; n++) {
+			double args[4] = {0, a, b, n};
+			integrals[n] = gauss_legendre(&line_segment_moment_integrand, 0, 1,
+				args);
+		}
+		moments[0] = integrals[1] / integrals[0];
+		moments[1] = integrals[2] / integrals[0];
+	} else {
+		const double logbeta = log_line_segment_integral(a, b);
+		const double start = exp(-logbeta), end = exp(b - 0.5 * a - logbeta);
+		moments[0] = (b - end + start) / a;
+		if (moments[0] < 0) moments[0] = 0;
+		if (moments[0] > 1) moments[0] = 1;
+		moments[1] = (b * moments[0] - end + 1) / a;
+		if (moments[1] < 0) moments[1] = 0;
+		if (moments[1] > moments[0]) moments[1] = moments[0];
+	}
+
+}
+
+
+/*
+.. c:function:: static double line_segment_moment_integrand(double *args);
+
+	The integrand of :c:func:`corrective_factor_marginalization_integrand`
+	multiplied by a power of the position along the line segment.
+
+	Parameters
+	----------
+	args : ``double *``
+		The integration parameters, :math:`q`, :math:`a`, :math:`b`, and
+		:math:`n`.
+
+	Returns
+	-------
+	value : ``double``
+		The integrand, defined as
+
+		.. math:: q^n\exp(\frac{-1}{2} (aq^2 - 2bq)),
+
+		where ``q = args[0]``, ``a = args[1]``, ``b = args[2]``, and
+		``n = args[3]`` is a non-negative integer.
+*/
+static double line_segment_moment_integrand(double *args) {
+
+	double q = args[0], a = args[1], b = args[2];
+	double value = exp(-0.5 * (a * q * q - 2 * b * q));
+	for (unsigned short n = 0u; n < args[3]; n++) value *= q;
+	return value;
+
+}
+
+
+/*
+.. c:function:: static struct track_view track_view_project(LIKELIHOOD_CONTEXT *c, const unsigned short dim);
+
+	Project the track of a :c:type:`LIKELIHOOD_CONTEXT` onto the columns most
+	recently determined by ``context_map_columns``, copying the predictions
+	for those columns into :c:member:`LIKELIHOOD_CONTEXT.projected`.
+
+	Parameters
+	----------
+	c : ``LIKELIHOOD_CONTEXT *``
+		The context, whose :c:member:`LIKELIHOOD_CONTEXT.columns` and
+		:c:member:`LIKELIHOOD_CONTEXT.weights` are up to date.
+	dim : ``const unsigned short``
+		The number of elements of :c:member:`LIKELIHOOD_CONTEXT.columns` to
+		project onto.
+
+	Returns
+	-------
+	v : ``struct track_view``
+		The projection of the track, with the coefficients at each point
+		computed from the weights stored by the context, and their natural
+		logarithms if :c:member:`LIKELIHOOD_CONTEXT.pruning_threshold` is
+		non-negative. The coefficients and projected predictions are stored
+		by the context, so the view is only valid until ``c`` is projected
+		again.
+*/
+static struct track_view track_view_project(LIKELIHOOD_CONTEXT *c,
+	const unsigned short dim) {
+
+	PROFILE_START(PROFILE_TRACK_PROJECTION);
+	struct track_view v;
+	v.context = c;
+	v.track = (*c).track;
+	v.columns = (*c).columns;
+	v.dim = dim;
+	v.coefficients = (*c).coefficients;
+	v.projected = (*c).projected;
+	v.projected_single = NULL;
+	v.whitened = NULL;
+	v.transform = NULL;
+	v.stride = padded_length((*v.track).n_vectors);
+
+	/* the predictions are row-major, so each column is read with a stride */
+	const double *predictions = matrix_elements(*((MATRIX *) v.track));
+	const unsigned short n_cols = (*v.track).dim;
+	for (unsigned short k = 0u; k < dim; k++) {
+		double *column = (*c).projected + k * v.stride;
+		const double *source = predictions + v.columns[k];
+		for (unsigned short i = 0u; i < (*v.track).n_vectors; i++) {
+			column[i] = source[(unsigned long) i * n_cols];
+		}
+	}
+	if ((*c).precision == LIKELIHOOD_PRECISION_SINGLE) {
+		for (unsigned long i = 0ul; i < dim * v.stride; i++) {
+			c -> projected_single[i] = (float) (*c).projected[i];
+		}
+		v.projected_single = (*c).projected_single;
+	} else {}
+	for (unsigned short i = 0u; i < (*v.track).n_vectors; i++) {
+		v.coefficients[i] = (*c).weights[i] * delta_model(v, i);
+	}
+	if ((*c).pruning_threshold >= 0) {
+		for (unsigned short i = 0u; i < (*v.track).n_vectors; i++) {
+			(*c).log_coefficients[i] = log(v.coefficients[i]);
+		}
+		v.log_coefficients = (*c).log_coefficients;
+	} else {
+		v.log_coefficients = NULL;
+	}
+	track_view_bound_blocks(c, &v);
+	PROFILE_STOP(PROFILE_TRACK_PROJECTION);
+	return v;
+
+}
+
+
+/*
+.. c:function:: static void track_view_bound_blocks(LIKELIHOOD_CONTEXT *c, struct track_view *v);
+
+	Compute the bounding box of each block of :c:macro:`CHI_SQUARED_BLOCK`
+	points along a projected track and the largest log coefficient within
+	it, which allow :c:func:`block_likelihood` to skip blocks that cannot
+	contribute appreciably to the likelihood of observing a datum.
+
+	Parameters
+	----------
+	c : ``LIKELIHOOD_CONTEXT *``
+		The context, which stores the bounding boxes.
+	v : ``struct track_view *``
+		The projected track, with :c:member:`log_coefficients` already
+		computed if appropriate.
+
+	Notes
+	-----
+	The boxes are only needed when points are pruned, so they are computed
+	only if :c:member:`LIKELIHOOD_CONTEXT.pruning_threshold` is non-negative
+	and finite. Otherwise, the members of ``v`` pointing to them are set to
+	``NULL``. Because the track is an ordered curve, consecutive points are
+	close together in the observed space, so the boxes of consecutive blocks
+	are compact, and a flat list of them serves as the index. Building it
+	takes one pass over the projected predictions, which is no more than
+	the projection itself costs, so it is rebuilt whenever the track is
+	projected and never goes stale when the predictions are modified.
+*/
+static void track_view_bound_blocks(LIKELIHOOD_CONTEXT *c,
+	struct track_view *v) {
+
+	if ((*v).log_coefficients == NULL ||
+		(*c).pruning_threshold == INFINITY) {
+		v -> block_lower = NULL;
+		v -> block_upper = NULL;
+		v -> block_largest = NULL;
+		return;
+	} else {}
+
+	const unsigned short n_vectors = (*(*v).track).n_vectors;
+	for (unsigned short b = 0u; b < n_blocks(*v); b++) {
+		const unsigned short first = b * CHI_SQUARED_BLOCK;
+		unsigned short last = first + CHI_SQUARED_BLOCK;
+		if (last > n_vectors - 1u) last = n_vectors - 1u;
+		for (unsigned short k = 0u; k < (*v).dim; k++) {
+			const double *column = (*v).projected + k * (*v).stride;
+			double lower = column[first], upper = column[first];
+			for (unsigned short j = first + 1u; j <= last; j++) {
+				if (column[j] < lower) lower = column[j];
+				if (column[j] > upper) upper = column[j];
+			}
+			c -> block_lower[b * (*v).dim + k] = lower;
+			c -> block_upper[b * (*v).dim + k] = upper;
+		}
+		double largest = -INFINITY;
+		for (unsigned short j = first; j < first + CHI_SQUARED_BLOCK &&
+			j < n_vectors; j++) {
+			if ((*v).log_coefficients[j] > largest) {
+				largest = (*v).log_coefficients[j];
+			} else {}
+		}
+		c -> block_largest[b] = largest;
+	}
+	v -> block_lower = (*c).block_lower;
+	v -> block_upper = (*c).block_upper;
+	v -> block_largest = (*c).block_largest;
+
+}
+
+
+/*
+.. c:function:: static void context_weights(LIKELIHOOD_CONTEXT *c, const unsigned short normalize);
+
+	Copy the weights of the track into a :c:type:`LIKELIHOOD_CONTEXT`,
+	normalizing them if necessary. The weights of the track itself are left
+	untouched.
+
+	Parameters
+	----------
+	c : ``LIKELIHOOD_CONTEXT *``
+		The context.
+	normalize : ``const unsigned short``
+		Whether or not to normalize the weights. If nonzero, they are divided
+		by :c:func:`track_weight_norm`.
+*/
+static void context_weights(LIKELIHOOD_CONTEXT *c,
+	const unsigned short normalize) {
+
+	const TRACK *t = (*c).track;
+	double weight_norm = normalize ? track_weight_norm(t) : 1;
+	for (unsigned short i = 0u; i < (*t).n_vectors; i++) {
+		c -> weights[i] = (*t).weights[i] / weight_norm;
+	}
+
+}
+
+
+/*
+.. c:function:: static void context_map_columns(LIKELIHOOD_CONTEXT *c, const unsigned short *ids, const unsigned short dim);
+
+	Determine which column of the track predicts each of a set of measured
+	quantities, storing the result in
+	:c:member:`LIKELIHOOD_CONTEXT.columns`.
+
+	Parameters
+	----------
+	c : ``LIKELIHOOD_CONTEXT *``
+		The context.
+	ids : ``const unsigned short *``
+		The label IDs of the measured quantities.
+	dim : ``const unsigned short``
+		The number of elements in ``ids``.
+
+	Notes
+	-----
+	This costs ``dim`` comparisons of integer IDs against each column of the
+	track, which is negligible compared to evaluating the likelihood along
+	the whole track for even a single datum. The mapping is stored by the
+	context and not by the sample, so that calculations with different
+	tracks may share a sample.
+*/
+static void context_map_columns(LIKELIHOOD_CONTEXT *c,
+	const unsigned short *ids, const unsigned short dim) {
+
+	const TRACK *t = (*c).track;
+	for (unsigned short k = 0u; k < dim; k++) {
+		signed short index = idindex((*t).ids, ids[k], (*t).dim);
+		if (index == -1 || k >= (*t).dim) fatal_print("%s: %s\n",
+			"Track does not have predictions for quantity",
+			label_name(ids[k]));
+		c -> columns[k] = (unsigned short) index;
+	}
+
+}
+
+
+/*
+.. c:function:: static double *context_reserve(double *buffer, unsigned long *capacity, const unsigned long n);
+
+	Ensure that a block of memory owned by a :c:type:`LIKELIHOOD_CONTEXT` has
+	room for some number of elements.
+
+	Parameters
+	----------
+	buffer : ``double *``
+		The block of memory. May be ``NULL`` if ``*capacity`` is 0.
+	capacity : ``unsigned long *``
+		The number of elements allocated for ``buffer``, updated if it is
+		reallocated.
+	n : ``const unsigned long``
+		The number of elements required.
+
+	Returns
+	-------
+	buffer : ``double *``
+		``buffer`` itself if it was already large enough, and otherwise a new
+		block of memory aligned to ``CACHE_LINE_SIZE``, in which case the
+		original is freed. The contents are not preserved.
+*/
+static double *context_reserve(double *buffer, unsigned long *capacity,
+	const unsigned long n) {
+
+	if (n > *capacity) {
+		if (buffer != NULL) free(buffer);
+		buffer = (double *) aligned_malloc(n * sizeof(double));
+		*capacity = n;
+		PROFILE_COUNT(PROFILE_BYTES_ALLOCATED, n * sizeof(double));
+	} else {}
+	return buffer;
+
+}
+
+
+/*
+.. c:function:: static double quadratic_form(const double *x, const double *A, const double *y, const unsigned short dim);
+
+	Compute the scalar :math:`x A y^T` for two row vectors :math:`x` and
+	:math:`y` and a symmetric matrix :math:`A` without allocating any memory.
+
+	Parameters
+	----------
+	x : ``const double *``
+		The row vector on the left-hand side. Must have ``dim`` elements.
+	A : ``const double *``
+		The upper triangle of the ``dim`` x ``dim`` symmetric matrix in the
+		middle (in practice, the inverse of a covariance matrix), packed row by
+		row (see :c:func:`packed_index`).
+	y : ``const double *``
+		The row vector on the right-hand side. Must have ``dim`` elements.
+	dim : ``const unsigned short``
+		The dimensionality of the vectors.
+
+	Returns
+	-------
+	result : ``double``
+		:math:`\sum_{jk} x_j A_{jk} y_k`.
+*/
+static double quadratic_form(const double *x, const double *A, const double *y,
+	const unsigned short dim) {
+
+	/*
+	Each off-diagonal element of the upper triangle stands in for both A_jk
+	and A_kj, so it multiplies both x_j y_k and x_k y_j.
+	*/
+	double result = 0;
+	for (unsigned short j = 0u; j < dim; j++) {
+		double row = *A++ * y[j];
+		for (unsigned short k = j + 1u; k < dim; k++) {
+			row += *A * y[k];
+			result += *A++ * x[k] * y[j];
+		}
+		result += x[j] * row;
+	}
+	return result;
+
+}
+
+
+/*
+.. c:function:: static void packed_product(const double *A, const double *x, const unsigned short dim, double *result);
+
+	Compute the product :math:`A x` of a symmetric matrix :math:`A` and a
+	column vector :math:`x` without allocating any memory.
+
+	Parameters
+	----------
+	A : ``const double *``
+		The upper triangle of the ``dim`` x ``dim`` symmetric matrix, packed
+		row by row (see :c:func:`packed_index`).
+	x : ``const double *``
+		The vector. Must have ``dim`` elements.
+	dim : ``const unsigned short``
+		The dimensionality of the vector.
+	result : ``double *``
+		The ``dim`` elements in which to store the product, which must not
+		overlap with ``x``.
+*/
+static void packed_product(const double *A, const double *x,
+	const unsigned short dim, double *result) {
+
+	/* As in quadratic_form, each off-diagonal element stands in for two. */
+	for (unsigned short j = 0u; j < dim; j++) result[j] = 0;
+	for (unsigned short j = 0u; j < dim; j++) {
+		result[j] += *A++ * x[j];
+		for (unsigned short k = j + 1u; k < dim; k++) {
+			result[j] += *A * x[k];
+			result[k] += *A++ * x[j];
+		}
+	}
+
+}
+
+
+/*
+.. c:function:: static void track_view_whiten(struct track_view *v, const double *transform);
+
+	Transform a projected track into the whitened frame of a covariance
+	matrix shared by every datum in a group, copying the result into
+	:c:member:`LIKELIHOOD_CONTEXT.projected_whitened`.
+
+	Parameters
+	----------
+	v : ``struct track_view *``
+		The projected track, whose :c:member:`track_view.whitened` and
+		:c:member:`track_view.transform` are set.
+	transform : ``const double *``
+		The upper triangular transformation into the whitened frame (see
+		:c:member:`PACKED_GROUP.transform`).
+
+	Notes
+	-----
+	This costs ``dim * (dim + 1) / 2`` multiply-adds per point along the
+	track, once per group, against which :math:`\chi^2` then costs one per
+	component for each datum instead (see :c:func:`squared_distance_points`).
+	Each row of the transformation is applied a column at a time, so the
+	loop over points vectorizes. The bounding boxes of the blocks of the
+	track remain those of the original frame, since they are only compared
+	against the data in that frame.
+*/
+static void track_view_whiten(struct track_view *v,
+	const double *transform) {
+
+	PROFILE_START(PROFILE_TRACK_PROJECTION);
+	LIKELIHOOD_CONTEXT *c = (*v).context;
+	const unsigned short n_vectors = (*(*v).track).n_vectors;
+	unsigned long index = 0ul;
+	for (unsigned short k = 0u; k < (*v).dim; k++) {
+		double *column = (*c).projected_whitened + k * (*v).stride;
+		for (unsigned short j = 0u; j < n_vectors; j++) column[j] = 0;
+		for (unsigned short l = k; l < (*v).dim; l++) {
+			const double *source = (*v).projected + l * (*v).stride;
+			const double w = transform[index++];
+			for (unsigned short j = 0u; j < n_vectors; j++) {
+				column[j] += w * source[j];
+			}
+		}
 	}
-	return point;
+	v -> whitened = (*c).projected_whitened;
+	v -> transform = transform;
+	PROFILE_STOP(PROFILE_TRACK_PROJECTION);
 
 }
@@ -21,14 +21,15 @@ extern "C" {
 #include "sample.h"
 #include "datum.h"
 #include "track.h"
+#include "multithread.h"
 
 /*
 The following macros are relevant for computing multiplicative factor
 corrections for the finite lengths of individual line segments along the track
 and the continuous change in the likelihood of observation along the line
-segment. They are only relevant when the user specifies the keyword argument
-``use_line_segment_corrections = True`` in their call to either
-``sample.loglikelihood`` or ``datum.loglikelihood``.
+segment by numerical quadrature. They are only relevant when the user
+specifies the keyword argument ``use_line_segment_corrections = "quad"`` in
+their call to either ``sample.loglikelihood`` or ``datum.loglikelihood``.
 
 .. c:macro:: LINE_SEGMENT_CORRECTION_TOLERANCE
 
@@ -50,9 +51,325 @@ segment. They are only relevant when the user specifies the keyword argument
 #define LINE_SEGMENT_CORRECTION_MAX_ITERS 1e6
 
 /*
-.. c:function:: extern double loglikelihood_sample(SAMPLE *s, TRACK *t);
+The following macros are the allowed values of
+:c:member:`TRACK.use_line_segment_corrections`.
 
-	This function is called when the user calls ``sample.loglikelihood``.
+.. c:macro:: LINE_SEGMENT_CORRECTIONS_OFF
+
+	``0u``. Line segment corrections are not applied.
+
+.. c:macro:: LINE_SEGMENT_CORRECTIONS_ANALYTIC
+
+	``1u``. Line segment corrections are evaluated in closed form. This is
+	what ``use_line_segment_corrections = True`` selects.
+
+.. c:macro:: LINE_SEGMENT_CORRECTIONS_QUADRATURE
+
+	``2u``. Line segment corrections are integrated numerically according to
+	the macros above. This is slower by orders of magnitude, and is intended
+	only for validating the closed-form evaluation. It is selected with
+	``use_line_segment_corrections = "quad"``.
+
+.. c:macro:: LINE_SEGMENT_CORRECTION_SMALL_A
+
+	``1e-8``. Below this value of the weighted squared length of a line
+	segment, the closed-form evaluation falls back to Gauss-Legendre
+	quadrature (see ``log_line_segment_integral`` in likelihood.c).
+
+.. c:macro:: LINE_SEGMENT_CORRECTION_SMOOTH
+
+	``5``. In computing the gradient of the likelihood, the derivatives of the
+	corrective factor are evaluated with Gauss-Legendre quadrature if both
+	coefficients of the integrand are no larger than this in magnitude, and
+	in closed form otherwise (see ``line_segment_moments`` in
+	likelihood.c).
+*/
+#define LINE_SEGMENT_CORRECTIONS_OFF 0u
+#define LINE_SEGMENT_CORRECTIONS_ANALYTIC 1u
+#define LINE_SEGMENT_CORRECTIONS_QUADRATURE 2u
+#define LINE_SEGMENT_CORRECTION_SMALL_A 1e-8
+#define LINE_SEGMENT_CORRECTION_SMOOTH 5
+
+/*
+The following macros are the allowed values of
+:c:member:`TRACK.parallel_policy`, which determines the loop that the
+likelihood calculation distributes across :c:member:`TRACK.n_threads`
+threads. Only one loop is ever parallelized, so no parallel region is opened
+from within another one.
+
+.. c:macro:: PARALLEL_POLICY_AUTO
+
+	``0u``. Decide separately for each group of data with the same measured
+	quantities: :c:macro:`PARALLEL_POLICY_DATA` if there are at least
+	:c:macro:`PARALLEL_DATA_PER_THREAD` data per thread, and
+	:c:macro:`PARALLEL_POLICY_COLLAPSED` otherwise. This is the default.
+
+.. c:macro:: PARALLEL_POLICY_DATA
+
+	``1u``. Distribute the data across threads, each of which computes the
+	likelihood of its own data over the entire track.
+
+.. c:macro:: PARALLEL_POLICY_TRACK
+
+	``2u``. Distribute the points along the track across threads, one datum
+	at a time, within a single parallel region.
+
+.. c:macro:: PARALLEL_POLICY_COLLAPSED
+
+	``3u``. Distribute every combination of a datum and a point along the
+	track across threads.
+
+.. c:macro:: PARALLEL_DATA_PER_THREAD
+
+	``4ul``. The number of data per thread above which
+	:c:macro:`PARALLEL_POLICY_AUTO` parallelizes over data, which is then
+	coarse-grained enough to balance the load across threads.
+*/
+#define PARALLEL_POLICY_AUTO 0u
+#define PARALLEL_POLICY_DATA 1u
+#define PARALLEL_POLICY_TRACK 2u
+#define PARALLEL_POLICY_COLLAPSED 3u
+#define PARALLEL_DATA_PER_THREAD 4ul
+
+/*
+The following macros are the allowed values of
+:c:member:`LIKELIHOOD_CONTEXT.precision`.
+
+.. c:macro:: LIKELIHOOD_PRECISION_DOUBLE
+
+	``0u``. Compute :math:`\chi^2` in double precision. This is the default.
+
+.. c:macro:: LIKELIHOOD_PRECISION_SINGLE
+
+	``1u``. Compute :math:`\chi^2` in single precision from the copies of
+	the data made by :c:func:`packed_sample_single`, with every sum over the
+	track and over the data still accumulated in double precision. The error
+	in the log-likelihood of each datum is then of the order of the rounding
+	error of a single precision :math:`\chi^2`, roughly ``1e-7`` times
+	:math:`\chi^2` itself. Data without single precision copies fall back
+	to double precision.
+*/
+#define LIKELIHOOD_PRECISION_DOUBLE 0u
+#define LIKELIHOOD_PRECISION_SINGLE 1u
+
+typedef struct likelihood_context {
+
+	/*
+	.. c:type:: LIKELIHOOD_CONTEXT
+
+		Everything that a likelihood calculation for a given model-predicted
+		track writes to. The track itself is never modified, so any number of
+		calculations may proceed at once as long as each has a context of its
+		own, even if they share the same track or sample.
+
+		.. c:member:: const TRACK *track
+
+			The model-predicted track through the observed space.
+
+		.. c:member:: unsigned short n_threads
+
+			The number of parallel processing threads to use. Initialized to
+			:c:member:`TRACK.n_threads`.
+
+		.. c:member:: unsigned short parallel_policy
+
+			Which loop to parallelize. Initialized to
+			:c:member:`TRACK.parallel_policy`.
+
+		.. c:member:: unsigned short normalize_weights
+
+			Whether or not to normalize the weights of the points along the
+			track in computing the likelihood of a sample. Initialized to
+			:c:member:`TRACK.normalize_weights`.
+
+		.. c:member:: unsigned short use_line_segment_corrections
+
+			How to correct for the finite lengths of line segments along the
+			track. Initialized to
+			:c:member:`TRACK.use_line_segment_corrections`.
+
+		.. c:member:: double pruning_threshold
+
+			Whether to sum the contributions of the points along the track in
+			logarithmic space, and if so, how far below the largest one they
+			may be before being skipped. Initialized to
+			:c:member:`TRACK.pruning_threshold`.
+
+		.. c:member:: unsigned short precision
+
+			The floating point precision with which to compute
+			:math:`\chi^2` (see :c:macro:`LIKELIHOOD_PRECISION_SINGLE`).
+			Initialized to :c:macro:`LIKELIHOOD_PRECISION_DOUBLE`.
+
+		.. c:member:: double *weights
+
+			The weights of each point along the track, normalized if
+			appropriate, as of the most recent calculation.
+
+		.. c:member:: double *coefficients
+
+			The weight of each point along the track multiplied by the length
+			of the line segment connecting it to the next point, projected onto
+			the quantities measured for the data currently being considered.
+
+		.. c:member:: double *log_coefficients
+
+			The natural logarithm of each element of :c:member:`coefficients`,
+			which are only computed if :c:member:`pruning_threshold` is
+			non-negative.
+
+		.. c:member:: unsigned short *columns
+
+			The column of the track predicting each quantity measured for the
+			data currently being considered.
+
+		.. c:member:: double *block_lower
+
+			The lower corner of the bounding box of each block of
+			``CHI_SQUARED_BLOCK`` points along the track projected onto
+			:c:member:`columns`, with the ``k``'th component for the ``b``'th
+			block at ``block_lower[b * dim + k]``. Only computed if
+			:c:member:`pruning_threshold` is non-negative and finite.
+
+		.. c:member:: double *block_upper
+
+			The upper corner of each bounding box, laid out like
+			:c:member:`block_lower`.
+
+		.. c:member:: double *block_largest
+
+			The largest element of :c:member:`log_coefficients` within each
+			block.
+
+		.. c:member:: double *projected
+
+			The track projected onto :c:member:`columns`, stored column by
+			column for :c:func:`chi_squared_points`. Each column begins on a
+			new cache line.
+
+		.. c:member:: float *projected_single
+
+			A single precision copy of :c:member:`projected` with the same
+			layout, which is only filled in if :c:member:`precision` is
+			:c:macro:`LIKELIHOOD_PRECISION_SINGLE`.
+
+		.. c:member:: double *projected_whitened
+
+			The projected track transformed into the whitened frame of the
+			group of data currently being considered, laid out like
+			:c:member:`projected`, if every datum in the group has the same
+			covariance matrix (see :c:member:`PACKED_GROUP.transform`).
+
+		.. c:member:: double *scratch
+
+			Per-thread scratch memory for the values of chi-squared along a
+			block of the track and the vector differences that go into the line
+			segment calculations.
+
+		.. c:member:: unsigned long n_scratch
+
+			The number of elements allocated for :c:member:`scratch`.
+
+		.. c:member:: double *by_thread
+
+			Per-thread partial sums of the likelihood.
+
+		.. c:member:: unsigned long n_by_thread
+
+			The number of elements allocated for :c:member:`by_thread`.
+
+		The settings may be modified between calculations. The remaining
+		members are managed internally, with :c:member:`scratch` and
+		:c:member:`by_thread` grown as needed and reused thereafter.
+	*/
+
+	const TRACK *track;
+	unsigned short n_threads;
+	unsigned short parallel_policy;
+	unsigned short normalize_weights;
+	unsigned short use_line_segment_corrections;
+	double pruning_threshold;
+	unsigned short precision;
+	double *weights;
+	double *coefficients;
+	double *log_coefficients;
+	unsigned short *columns;
+	double *block_lower;
+	double *block_upper;
+	double *block_largest;
+	double *projected;
+	float *projected_single;
+	double *projected_whitened;
+	double *scratch;
+	unsigned long n_scratch;
+	double *by_thread;
+	unsigned long n_by_thread;
+
+} LIKELIHOOD_CONTEXT;
+
+typedef struct kernel_cache {
+
+	/*
+	.. c:type:: KERNEL_CACHE
+
+		The contribution of each point along a model-predicted track to the
+		likelihood of observing each datum in a sample, without the weights
+		of the points, such that the likelihood may be recomputed for new
+		weights without recomputing any :math:`\chi^2`. Entries are stored in
+		compressed sparse row (CSR) format, with one row per datum.
+
+		.. c:member:: unsigned long n_data
+
+			The number of data, i.e. rows.
+
+		.. c:member:: unsigned short n_points
+
+			The number of points along the track, i.e. columns.
+
+		.. c:member:: unsigned short n_threads
+
+			The number of parallel processing threads to use in evaluating the
+			likelihood. Initialized to :c:member:`LIKELIHOOD_CONTEXT.n_threads`.
+
+		.. c:member:: unsigned long *offsets
+
+			The ``n_data + 1`` offsets at which each row begins in
+			:c:member:`points` and :c:member:`kernel`, the last of which is the
+			total number of entries.
+
+		.. c:member:: unsigned short *points
+
+			The index of the point along the track for each entry.
+
+		.. c:member:: double *kernel
+
+			The value of each entry: :math:`\exp(-\chi^2 / 2)` multiplied by
+			the length of the line segment connecting the point to the next
+			one and the line segment corrective factor, if applicable, divided
+			by the largest such value for the same datum.
+
+		.. c:member:: double *log_scale
+
+			The natural logarithm of the largest value divided out of each
+			row of :c:member:`kernel`, less half the log-determinant of the
+			datum's covariance matrix and :math:`\ln(2\pi) / 2`.
+	*/
+
+	unsigned long n_data;
+	unsigned short n_points;
+	unsigned short n_threads;
+	unsigned long *offsets;
+	unsigned short *points;
+	double *kernel;
+	double *log_scale;
+
+} KERNEL_CACHE;
+
+/*
+.. c:function:: extern double loglikelihood_sample(SAMPLE *s, const TRACK *t);
+
+	``sample.loglikelihood`` calls the reentrant form of this function,
+	:c:func:`loglikelihood_context_sample`.
 
 	Compute the natural logarithm of the likelihood that some sample of data
 	vectors would be observed given some model-predicted track through the
@@ -69,7 +386,7 @@ segment. They are only relevant when the user specifies the keyword argument
 	----------
 	s : ``SAMPLE *``
 		The sample to fit the model to.
-	t : ``TRACK *``
+	t : ``const TRACK *``
 		The model-predicted track through the observed space.
 
 	Returns
@@ -83,12 +400,13 @@ segment. They are only relevant when the user specifies the keyword argument
 	----------
 	.. [1] Johnson J.W., et al., 2022, MNRAS, 526, 5084
 */
-extern double loglikelihood_sample(SAMPLE s, TRACK *t);
+extern double loglikelihood_sample(SAMPLE *s, const TRACK *t);
 
 /*
-.. c:function:: extern double loglikelihood_datum(DATUM *d, TRACK *t);
+.. c:function:: extern double loglikelihood_datum(DATUM d, const TRACK *t);
 
-	This function is called when the user calls ``datum.loglikelihood``.
+	``datum.loglikelihood`` calls the reentrant form of this function,
+	:c:func:`loglikelihood_context_datum`.
 
 	Compute the natural logarithm of the likelihood that an individual datum
 	will be observed from its vector and the model-predicted track in the
@@ -104,7 +422,7 @@ extern double loglikelihood_sample(SAMPLE s, TRACK *t);
 	----------
 	d : ``DATUM``
 		The datum to compute the likelihood of observation.
-	t : ``TRACK *``
+	t : ``const TRACK *``
 		The model-predicted track through the observed space.
 
 	Returns
@@ -118,7 +436,420 @@ extern double loglikelihood_sample(SAMPLE s, TRACK *t);
 	----------
 	.. [2] Johnson J.W., et al., 2022, MNRAS, 526, 5084
 */
-extern double loglikelihood_datum(DATUM d, TRACK *t);
+extern double loglikelihood_datum(DATUM d, const TRACK *t);
+
+/*
+.. c:function:: extern void loglikelihood_batch(SAMPLE *s, TRACK **tracks, const unsigned long n_tracks, double *out);
+
+	Compute the natural logarithm of the likelihood that some sample of data
+	vectors would be observed given each of several model-predicted tracks,
+	as when an ensemble sampler proposes many models at once.
+
+	Parameters
+	----------
+	s : ``SAMPLE *``
+		The sample to fit the models to.
+	tracks : ``TRACK **``
+		The model-predicted tracks through the observed space. They need not
+		have the same number of points or predict the same quantities, so
+		long as each has predictions for every quantity in the sample.
+	n_tracks : ``const unsigned long``
+		The number of elements in ``tracks``.
+	out : ``double *``
+		The ``n_tracks`` elements in which to store the natural logarithm of
+		the likelihood of observation given each track, as would be computed by
+		:c:func:`loglikelihood_sample`.
+
+	Notes
+	-----
+	Rather than walking through the entire sample once per track, each datum
+	is compared against every track in turn, so its vector and inverse
+	covariance matrix are read from memory once and then remain in cache.
+	The (datum, track) combinations are parallelized over with the largest
+	:c:member:`TRACK.n_threads` among the tracks. The reentrant form of this
+	function is :c:func:`loglikelihood_context_batch`.
+*/
+extern void loglikelihood_batch(SAMPLE *s, TRACK **tracks,
+	const unsigned long n_tracks, double *out);
+
+/*
+.. c:function:: extern LIKELIHOOD_CONTEXT *likelihood_context_initialize(const TRACK *t);
+
+	Allocate memory for and return a pointer to a :c:type:`LIKELIHOOD_CONTEXT`
+	for computing likelihoods with a given model-predicted track.
+
+	Parameters
+	----------
+	t : ``const TRACK *``
+		The model-predicted track through the observed space. It must not be
+		freed before the context.
+
+	Returns
+	-------
+	c : ``LIKELIHOOD_CONTEXT *``
+		The newly constructed context, with its settings taken from ``t``.
+*/
+extern LIKELIHOOD_CONTEXT *likelihood_context_initialize(const TRACK *t);
+
+/*
+.. c:function:: extern void likelihood_context_free(LIKELIHOOD_CONTEXT *c);
+
+	Free up the memory stored by a :c:type:`LIKELIHOOD_CONTEXT`. The track it
+	was constructed from is not freed.
+
+	Parameters
+	----------
+	c : ``LIKELIHOOD_CONTEXT *``
+		The context to be freed.
+*/
+extern void likelihood_context_free(LIKELIHOOD_CONTEXT *c);
+
+/*
+.. c:function:: extern unsigned long likelihood_context_project(LIKELIHOOD_CONTEXT *c, const unsigned short *ids, const unsigned short dim);
+
+	Project the track of a context onto some measured quantities, as is done
+	for each group of a packed sample within
+	:c:func:`loglikelihood_context_sample`, for likelihood calculations that
+	are carried out elsewhere (see :c:func:`loglikelihood_device`).
+
+	Parameters
+	----------
+	c : ``LIKELIHOOD_CONTEXT *``
+		The context, whose weights are normalized according to its
+		:c:member:`LIKELIHOOD_CONTEXT.normalize_weights`.
+	ids : ``const unsigned short *``
+		The label IDs of the measured quantities.
+	dim : ``const unsigned short``
+		The number of elements in ``ids``.
+
+	Returns
+	-------
+	stride : ``unsigned long``
+		The distance in memory between consecutive columns of
+		:c:member:`LIKELIHOOD_CONTEXT.projected`, which then holds the
+		``k``'th component of the ``j``'th point along the track at
+		``projected[k * stride + j]``, with the corresponding elements of
+		:c:member:`LIKELIHOOD_CONTEXT.coefficients` alongside it.
+*/
+extern unsigned long likelihood_context_project(LIKELIHOOD_CONTEXT *c,
+	const unsigned short *ids, const unsigned short dim);
+
+/*
+.. c:function:: extern double loglikelihood_context_sample(LIKELIHOOD_CONTEXT *c, const PACKED_SAMPLE *p);
+
+	The reentrant form of :c:func:`loglikelihood_sample`, which computes the
+	likelihood of observing a packed sample given the track and settings of a
+	context.
+
+	Parameters
+	----------
+	c : ``LIKELIHOOD_CONTEXT *``
+		The context to compute the likelihood with.
+	p : ``const PACKED_SAMPLE *``
+		The packed sample, as returned by :c:func:`sample_pack`.
+
+	Returns
+	-------
+	logl : ``double``
+		The natural logarithm of the likelihood of observation, as in
+		:c:func:`loglikelihood_sample`.
+
+	Notes
+	-----
+	Neither the track nor the packed sample is modified, so this function
+	may be called concurrently from any number of threads, each with a
+	context of its own. Packing a sample does modify it, so
+	:c:func:`sample_pack` should be called beforehand from only one thread.
+	This is how ``sample.loglikelihood`` is able to release the GIL.
+*/
+extern double loglikelihood_context_sample(LIKELIHOOD_CONTEXT *c,
+	const PACKED_SAMPLE *p);
+
+/*
+.. c:function:: extern double loglikelihood_context_datum(LIKELIHOOD_CONTEXT *c, DATUM d);
+
+	The reentrant form of :c:func:`loglikelihood_datum`, which computes the
+	likelihood of observing an individual datum given the track and settings
+	of a context.
+
+	Parameters
+	----------
+	c : ``LIKELIHOOD_CONTEXT *``
+		The context to compute the likelihood with.
+	d : ``DATUM``
+		The datum to compute the likelihood of observation.
+
+	Returns
+	-------
+	logl : ``double``
+		The natural logarithm of the likelihood of observation, as in
+		:c:func:`loglikelihood_datum`.
+
+	Notes
+	-----
+	As has always been the case for individual data, the weights of the track
+	are used as they are, regardless of :c:member:`normalize_weights`.
+*/
+extern double loglikelihood_context_datum(LIKELIHOOD_CONTEXT *c, DATUM d);
+
+/*
+.. c:function:: extern void loglikelihood_context_batch(LIKELIHOOD_CONTEXT **contexts, const unsigned long n_contexts, const PACKED_SAMPLE *p, double *out);
+
+	The reentrant form of :c:func:`loglikelihood_batch`, which computes the
+	likelihood of observing a packed sample given the track and settings of
+	each of several contexts.
+
+	Parameters
+	----------
+	contexts : ``LIKELIHOOD_CONTEXT **``
+		The contexts to compute the likelihood with, one per track.
+	n_contexts : ``const unsigned long``
+		The number of elements in ``contexts``.
+	p : ``const PACKED_SAMPLE *``
+		The packed sample, as returned by :c:func:`sample_pack`.
+	out : ``double *``
+		The ``n_contexts`` elements in which to store the natural logarithm of
+		the likelihood of observation given each context, as would be computed
+		by :c:func:`loglikelihood_context_sample`.
+
+	Notes
+	-----
+	The same restrictions on concurrency apply as for
+	:c:func:`loglikelihood_context_sample`.
+	:c:member:`LIKELIHOOD_CONTEXT.parallel_policy` does not apply here; the
+	(datum, context) combinations are always parallelized over, with the
+	largest :c:member:`LIKELIHOOD_CONTEXT.n_threads` among the contexts.
+*/
+extern void loglikelihood_context_batch(LIKELIHOOD_CONTEXT **contexts,
+	const unsigned long n_contexts, const PACKED_SAMPLE *p, double *out);
+
+/*
+.. c:function:: extern KERNEL_CACHE *kernel_cache_initialize(LIKELIHOOD_CONTEXT *c, const PACKED_SAMPLE *p);
+
+	Compute the contribution of every point along the track of a context to
+	the likelihood of observing each datum in a packed sample, leaving out
+	the weights of the points.
+
+	Parameters
+	----------
+	c : ``LIKELIHOOD_CONTEXT *``
+		The context, whose track predictions and settings the cache is built
+		from. Its weights are overwritten.
+	p : ``const PACKED_SAMPLE *``
+		The packed sample, as returned by :c:func:`sample_pack`.
+
+	Returns
+	-------
+	k : ``KERNEL_CACHE *``
+		The newly constructed cache, which refers to neither the context nor
+		the sample.
+
+	Notes
+	-----
+	If :c:member:`LIKELIHOOD_CONTEXT.pruning_threshold` is non-negative,
+	entries smaller than the largest for the same datum by more than a factor
+	of :math:`e^{-\text{threshold} / 2}` are not stored, and whole blocks of
+	points far from each datum are skipped as in the likelihood calculation
+	itself. Since the weights are left out, this neglects contributions that
+	would be significant only if the weights varied along the track by more
+	than a comparable factor. Otherwise, every nonzero entry is stored,
+	which takes ``10 * n_data * n_points`` bytes.
+*/
+extern KERNEL_CACHE *kernel_cache_initialize(LIKELIHOOD_CONTEXT *c,
+	const PACKED_SAMPLE *p);
+
+/*
+.. c:function:: extern void kernel_cache_free(KERNEL_CACHE *k);
+
+	Free up the memory stored by a :c:type:`KERNEL_CACHE`.
+
+	Parameters
+	----------
+	k : ``KERNEL_CACHE *``
+		The cache to be freed.
+*/
+extern void kernel_cache_free(KERNEL_CACHE *k);
+
+/*
+.. c:function:: extern double loglikelihood_kernel_cache(const KERNEL_CACHE *k, const TRACK *t, const unsigned short normalize_weights);
+
+	Compute the natural logarithm of the likelihood of observing the sample
+	that a :c:type:`KERNEL_CACHE` was built from, given new weights for the
+	points along the same track.
+
+	Parameters
+	----------
+	k : ``const KERNEL_CACHE *``
+		The cache.
+	t : ``const TRACK *``
+		The track, whose :c:member:`TRACK.weights` may differ from those
+		the cache was built with, but whose points must be the same.
+	normalize_weights : ``const unsigned short``
+		Whether or not to normalize the weights, as in
+		:c:member:`LIKELIHOOD_CONTEXT.normalize_weights`.
+
+	Returns
+	-------
+	logl : ``double``
+		The natural logarithm of the likelihood of observation, as would be
+		computed by :c:func:`loglikelihood_context_sample` with these weights,
+		up to the entries left out of the cache.
+
+	Notes
+	-----
+	This costs one sparse matrix-vector product, parallelized over the data
+	with :c:member:`KERNEL_CACHE.n_threads`. The cache is not modified, so
+	this function may be called concurrently from any number of threads.
+*/
+extern double loglikelihood_kernel_cache(const KERNEL_CACHE *k,
+	const TRACK *t, const unsigned short normalize_weights);
+
+/*
+.. c:function:: extern double loglikelihood_sample_gradient(SAMPLE *s, const TRACK *t, double *grad_predictions, double *grad_weights);
+
+	Compute the natural logarithm of the likelihood that some sample would be
+	observed given some model-predicted track, as in
+	:c:func:`loglikelihood_sample`, along with its derivatives with respect
+	to the predictions and the weights of the points along the track.
+
+	Parameters
+	----------
+	s : ``SAMPLE *``
+		The sample to fit the model to.
+	t : ``const TRACK *``
+		The model-predicted track through the observed space.
+	grad_predictions : ``double *``
+		The ``t -> n_vectors * t -> dim`` elements in which to store the
+		derivative with respect to each prediction, with that for
+		``t -> predictions[j][k]`` at ``grad_predictions[j * t -> dim + k]``.
+	grad_weights : ``double *``
+		The ``t -> n_vectors`` elements in which to store the derivative with
+		respect to each element of :c:member:`TRACK.weights`.
+
+	Returns
+	-------
+	logl : ``double``
+		The natural logarithm of the likelihood of observation.
+
+	Notes
+	-----
+	The reentrant form of this function, which ``sample.loglikelihood``
+	calls when ``return_grad = True``, is
+	:c:func:`loglikelihood_context_sample_gradient`.
+*/
+extern double loglikelihood_sample_gradient(SAMPLE *s, const TRACK *t,
+	double *grad_predictions, double *grad_weights);
+
+/*
+.. c:function:: extern double loglikelihood_context_sample_gradient(LIKELIHOOD_CONTEXT *c, const PACKED_SAMPLE *p, double *grad_predictions, double *grad_weights);
+
+	The reentrant form of :c:func:`loglikelihood_sample_gradient`, which
+	computes the likelihood of observing a packed sample given the track and
+	settings of a context along with its derivatives with respect to the
+	predictions and the weights of the track.
+
+	Parameters
+	----------
+	c : ``LIKELIHOOD_CONTEXT *``
+		The context to compute the likelihood with.
+	p : ``const PACKED_SAMPLE *``
+		The packed sample, as returned by :c:func:`sample_pack`.
+	grad_predictions : ``double *``
+		The ``n_vectors * dim`` elements in which to store the derivative with
+		respect to each prediction of the track, laid out like the
+		predictions themselves (see :c:func:`matrix_elements`). Predictions
+		for quantities that the sample does not measure have derivatives of
+		zero.
+	grad_weights : ``double *``
+		The ``n_vectors`` elements in which to store the derivative with
+		respect to each weight of the track, accounting for their
+		normalization if :c:member:`LIKELIHOOD_CONTEXT.normalize_weights` is
+		nonzero.
+
+	Returns
+	-------
+	logl : ``double``
+		The natural logarithm of the likelihood of observation, as in
+		:c:func:`loglikelihood_context_sample`.
+
+	Notes
+	-----
+	Each datum's contributions from the points along the track are computed
+	once and kept, as for a row of a :c:type:`KERNEL_CACHE`, after which a
+	second pass over them accumulates the derivatives. This costs a few
+	times as much as :c:func:`loglikelihood_context_sample` regardless of the
+	number of points along the track, whereas finite differences would cost
+	two likelihood calculations per prediction and per weight. The data are
+	always parallelized over with :c:member:`LIKELIHOOD_CONTEXT.n_threads`
+	threads, each of which accumulates derivatives of its own.
+
+	With line segment corrections, the derivatives of the corrective factor
+	are those of its closed form (see :c:macro:`LINE_SEGMENT_CORRECTION_SMOOTH`)
+	regardless of how the factor itself is evaluated. If
+	:c:member:`LIKELIHOOD_CONTEXT.pruning_threshold` is non-negative, points
+	are skipped as by :c:func:`kernel_cache_initialize` before the weights
+	are applied, and then again as by :c:func:`loglikelihood_context_sample`
+	afterward. Skipped points contribute to neither the likelihood nor its
+	derivatives. Otherwise, the result agrees with
+	:c:func:`loglikelihood_context_sample` up to rounding.
+*/
+extern double loglikelihood_context_sample_gradient(LIKELIHOOD_CONTEXT *c,
+	const PACKED_SAMPLE *p, double *grad_predictions, double *grad_weights);
+
+/*
+.. c:function:: extern double log_line_segment_integral(const double a, const double b);
+
+	Evaluate the natural logarithm of the integral
+
+	.. math:: \beta = \int_0^1 \exp\left(\frac{-1}{2}(aq^2 - 2bq)\right) dq
+
+	in closed form without overflow or catastrophic cancellation.
+
+	Parameters
+	----------
+	a : ``const double``
+		The squared length of the line segment, weighted by the inverse
+		covariance matrix of the datum. Non-negative.
+	b : ``const double``
+		The projection of the vector difference between the datum and the
+		start of the line segment onto the line segment, weighted by the
+		inverse covariance matrix of the datum.
+
+	Returns
+	-------
+	logbeta : ``double``
+		:math:`\ln\beta`.
+
+	Notes
+	-----
+	Completing the square with :math:`u_0 = -b / \sqrt{2a}` and
+	:math:`u_1 = (a - b) / \sqrt{2a}` gives
+
+	.. math:: \beta = \sqrt{\frac{\pi}{2a}} e^{u_0^2}
+		\left[\text{erf}(u_1) - \text{erf}(u_0)\right].
+
+	The naive evaluation of this expression multiplies the potentially
+	enormous :math:`e^{u_0^2}` by a potentially tiny difference of error
+	functions. When :math:`u_0` and :math:`u_1` share a sign, the difference
+	is instead rewritten in terms of :func:`erfcx`, such that the only
+	exponential left over is bounded by 1 (for :math:`u_0 \geq 0`) or is
+	added in logarithmic space (for :math:`u_1 \leq 0`). When they have
+	opposite signs, the difference of error functions is at least
+	:math:`\text{erf}(|u_0|)` and there is no cancellation to avoid.
+
+	For :math:`a <` :c:macro:`LINE_SEGMENT_CORRECTION_SMALL_A`,
+	:math:`u_1 - u_0 = \sqrt{a / 2}` is small enough that the difference
+	loses precision regardless. The integrand is then nearly exponential in
+	:math:`q`, and the integral is evaluated with :c:func:`gauss_legendre`
+	after factoring out the maximum of the integrand over the line segment.
+	This is accurate to double precision for :math:`|b| \lesssim 10`, which
+	covers every line segment whose contribution to the likelihood does not
+	underflow, since :math:`b^2 \leq a\chi^2` by the Cauchy-Schwarz
+	inequality.
+*/
+DEVICE_FUNCTIONS_BEGIN
+extern double log_line_segment_integral(const double a, const double b);
+DEVICE_FUNCTIONS_END
 
 #ifdef __cplusplus
 }
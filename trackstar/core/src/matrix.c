@@ -6,24 +6,32 @@ at: https://github.com/giganano/TrackStar.git.
 */
 
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 #include "matrix.h"
+#include "arena.h"
+#include "blas.h"
+#include "profiling.h"
 #include "debug.h"
 
 
 /* ---------- Static function comment headers not duplicated here ---------- */
 static MATRIX *matrix_unary_minus(MATRIX m, MATRIX *result);
-static MATRIX *LUdecomp(MATRIX m);
-static double determinant_expansion_minors(MATRIX m);
-struct row_column_index;
-static struct row_column_index expansion_ideal_axis(MATRIX m);
-static unsigned short zeros_along_axis(MATRIX m,
-	const unsigned short index, const unsigned short along_row);
-static MATRIX *matrix_adjoint(MATRIX m, MATRIX *result);
-static MATRIX *matrix_cofactors(MATRIX m, MATRIX *result);
-static MATRIX *matrix_minor(MATRIX m, unsigned short axis[2], MATRIX *result);
+static MATRIX *LUdecomp(MATRIX m, unsigned short *perm, short *parity);
+static void LUsolve(MATRIX LU, double *x);
 static void matrix_resize(MATRIX *m, const unsigned short n_rows,
 	const unsigned short n_cols);
+static unsigned long matrix_block_size(const unsigned short n_rows,
+	const unsigned short n_cols);
+static double **matrix_rows(void *block, const unsigned short n_rows,
+	const unsigned short n_cols);
+#if defined(TRACKSTAR_BLAS)
+	static MATRIX *lapack_invert(MATRIX m, MATRIX *result);
+	static double lapack_determinant(MATRIX m);
+	static MATRIX *lapack_cholesky(MATRIX m, MATRIX *result);
+	static unsigned short lapack_covariance_matrix_update(
+		COVARIANCE_MATRIX *cov);
+#endif /* TRACKSTAR_BLAS */
 
 
 /*
@@ -49,16 +57,13 @@ static void matrix_resize(MATRIX *m, const unsigned short n_rows,
 */
 extern MATRIX *matrix_initialize(unsigned short n_rows, unsigned short n_cols) {
 
-	unsigned short i, j;
 	MATRIX *m = (MATRIX *) malloc (sizeof(MATRIX));
-	m -> matrix = (double **) malloc (n_rows * sizeof(double *));
-	for (i = 0u; i < n_rows; i++) {
-		m -> matrix[i] = (double *) malloc (n_cols * sizeof(double));
-		for (j = 0u; j < n_cols; j++) m -> matrix[i][j] = 0.0;
-	}
-
+	m -> matrix = matrix_rows(calloc (matrix_block_size(n_rows, n_cols), 1u),
+		n_rows, n_cols);
 	m -> n_rows = n_rows;
 	m -> n_cols = n_cols;
+	PROFILE_COUNT(PROFILE_BYTES_ALLOCATED, sizeof(MATRIX) +
+		matrix_block_size(n_rows, n_cols));
 	return m;
 
 }
@@ -78,13 +83,8 @@ extern void matrix_free(MATRIX *m) {
 
 	if (m != NULL) {
 
-		if ((*m).matrix != NULL) {
-			unsigned short i;
-			for (i = 0u; i < (*m).n_rows; i++) {
-				if ((*m).matrix[i] != NULL) free(m -> matrix[i]);
-			}
-			free(m -> matrix);
-		} else {}
+		/* the rows are part of the same block as the row pointers */
+		if ((*m).matrix != NULL) free(m -> matrix);
 		free(m);
 
 	} else {}
@@ -92,6 +92,80 @@ extern void matrix_free(MATRIX *m) {
 }
 
 
+/*
+.. c:function:: extern double *matrix_elements(const MATRIX m);
+
+	Obtain the elements of a matrix as a single row-major array.
+
+	Parameters
+	----------
+	m : ``const MATRIX``
+		The matrix of interest.
+
+	Returns
+	-------
+	elements : ``double *``
+		The ``n_rows * n_cols`` elements of ``m``, with :math:`m_{ij}` at
+		``elements[i * n_cols + j]``. This is the same memory that the row
+		pointers of :c:member:`MATRIX.matrix` point into, so it can be handed
+		to routines that expect a dense matrix, or exposed to python, without
+		copying it.
+
+	Notes
+	-----
+	Routines that permute the row pointers of a matrix in place (e.g.
+	pivoting during an LU decomposition) break the correspondence between the
+	two, so they only ever do so for temporary copies.
+*/
+extern double *matrix_elements(const MATRIX m) {
+
+	/* see matrix_rows: the elements follow the row pointers */
+	return (double *) (m.matrix + m.n_rows);
+
+}
+
+
+/*
+.. c:function:: extern MATRIX *matrix_arena_initialize(ARENA *a, const unsigned long struct_size, const unsigned short n_rows, const unsigned short n_cols);
+
+	Allocate a :c:type:`MATRIX`, or a structure that begins with the members
+	of one, from an arena.
+
+	Parameters
+	----------
+	a : ``ARENA *``
+		The arena to allocate from.
+	struct_size : ``const unsigned long``
+		The size of the structure to allocate: ``sizeof(MATRIX)``, or e.g.
+		``sizeof(DATUM)`` for a :c:type:`DATUM`. Members beyond those of a
+		:c:type:`MATRIX` are set to zero.
+	n_rows : ``const unsigned short``
+		The desired number of rows in the matrix.
+	n_cols : ``const unsigned short``
+		The desired number of columns in the matrix.
+
+	Returns
+	-------
+	m : ``MATRIX *``
+		The newly constructed matrix, laid out like one constructed by
+		:c:func:`matrix_initialize` and with each element set to zero. It
+		belongs to the arena: it must not be passed to :c:func:`matrix_free`,
+		and it must not be resized to other dimensions.
+*/
+extern MATRIX *matrix_arena_initialize(ARENA *a,
+	const unsigned long struct_size, const unsigned short n_rows,
+	const unsigned short n_cols) {
+
+	MATRIX *m = (MATRIX *) arena_allocate(a, struct_size);
+	m -> matrix = matrix_rows(arena_allocate(a,
+		matrix_block_size(n_rows, n_cols)), n_rows, n_cols);
+	m -> n_rows = n_rows;
+	m -> n_cols = n_cols;
+	return m;
+
+}
+
+
 /*
 .. c:function:: extern COVARIANCE_MATRIX *covariance_matrix_initialize(unsigned short size);
 
@@ -110,7 +184,7 @@ extern void matrix_free(MATRIX *m) {
 		A pointer to the newly constructed ``size`` x ``size`` covariance
 		matrix, with each matrix element assigned an initial value of zero.
 		The struct members ``inv`` and ``labels`` are given initial values
-		of ``NULL``.
+		of ``NULL``, and ``logdet`` is given an initial value of ``NAN``.
  */
 extern COVARIANCE_MATRIX *covariance_matrix_initialize(unsigned short size) {
 
@@ -118,11 +192,193 @@ extern COVARIANCE_MATRIX *covariance_matrix_initialize(unsigned short size) {
 	cov = (COVARIANCE_MATRIX *) realloc (cov, sizeof(COVARIANCE_MATRIX));
 	cov -> inv = NULL;
 	cov -> labels = NULL;
+	cov -> logdet = NAN;
+	return cov;
+
+}
+
+
+/*
+.. c:function:: extern COVARIANCE_MATRIX *covariance_matrix_arena_initialize(ARENA *a, const unsigned short size);
+
+	Allocate a :c:type:`COVARIANCE_MATRIX` from an arena.
+
+	Parameters
+	----------
+	a : ``ARENA *``
+		The arena to allocate from.
+	size : ``const unsigned short``
+		The desired number of rows and columns in the matrix.
+
+	Returns
+	-------
+	cov : ``COVARIANCE_MATRIX *``
+		The newly constructed matrix, initialized like one constructed by
+		:c:func:`covariance_matrix_initialize` except that its inverse
+		:c:member:`inv` is also allocated from the arena, because
+		:c:func:`covariance_matrix_update` would otherwise allocate it from
+		the heap. Neither must be passed to :c:func:`matrix_free` or
+		:c:func:`covariance_matrix_free`.
+*/
+extern COVARIANCE_MATRIX *covariance_matrix_arena_initialize(ARENA *a,
+	const unsigned short size) {
+
+	COVARIANCE_MATRIX *cov = (COVARIANCE_MATRIX *) matrix_arena_initialize(a,
+		sizeof(COVARIANCE_MATRIX), size, size);
+	cov -> inv = matrix_arena_initialize(a, sizeof(MATRIX), size, size);
+	cov -> labels = NULL;
+	cov -> logdet = NAN;
 	return cov;
 
 }
 
 
+/*
+.. c:function:: extern unsigned short covariance_matrix_update(COVARIANCE_MATRIX *cov);
+
+	Recompute the quantities that a :c:type:`COVARIANCE_MATRIX` caches about
+	itself: its inverse :c:member:`inv` and the logarithm of its determinant
+	:c:member:`logdet`. This should be called any time the elements of the
+	covariance matrix are modified.
+
+	Parameters
+	----------
+	cov : ``COVARIANCE_MATRIX *``
+		The covariance matrix to update. If :c:member:`inv` is ``NULL``, the
+		memory for it will be allocated automatically.
+
+	Returns
+	-------
+	status : ``unsigned short``
+		0u on success. 1u if the matrix is not positive-definite, in which case
+		it is not a valid covariance matrix. :c:member:`logdet` will be ``NAN``
+		in this case, and :c:member:`inv` will be left unchanged if the matrix
+		is singular.
+
+	Notes
+	-----
+	Both quantities are computed from a single Cholesky decomposition
+	:math:`C = LL^T` (see :c:func:`matrix_cholesky`), with
+
+	.. math:: \ln|C| = 2\sum_i \ln L_{ii}
+
+	and :math:`C^{-1} = L^{-T}L^{-1}`, which is exactly symmetric by
+	construction. If the decomposition fails, the inverse is computed with
+	:c:func:`matrix_invert` instead. If TrackStar was linked with a BLAS
+	library, matrices of at least :c:macro:`BLAS_MIN_DIMENSION` rows are
+	decomposed and inverted by LAPACK's ``dpotrf`` and ``dpotri``.
+*/
+extern unsigned short covariance_matrix_update(COVARIANCE_MATRIX *cov) {
+
+	PROFILE_START(PROFILE_COVARIANCE_UPDATE);
+	#if defined(TRACKSTAR_BLAS)
+		if ((*cov).n_rows >= BLAS_MIN_DIMENSION) {
+			unsigned short status = lapack_covariance_matrix_update(cov);
+			PROFILE_STOP(PROFILE_COVARIANCE_UPDATE);
+			return status;
+		} else {}
+	#endif
+
+	MATRIX *L = matrix_cholesky( *((MATRIX *) cov), NULL);
+	if (L != NULL) {
+		unsigned short n = (*cov).n_rows;
+		double logdet = 0;
+		for (unsigned short i = 0u; i < n; i++) logdet += log((*L).matrix[i][i]);
+		cov -> logdet = 2 * logdet;
+
+		/* Overwrite L with its inverse by forward substitution ... */
+		for (unsigned short j = 0u; j < n; j++) {
+			L -> matrix[j][j] = 1 / (*L).matrix[j][j];
+			for (unsigned short i = j + 1u; i < n; i++) {
+				double sum = 0;
+				for (unsigned short k = j; k < i; k++) {
+					sum -= (*L).matrix[i][k] * (*L).matrix[k][j];
+				}
+				L -> matrix[i][j] = sum / (*L).matrix[i][i];
+			}
+		}
+		/* ... and take the product L^-T L^-1 over the lower triangle. */
+		if ((*cov).inv == NULL) {
+			cov -> inv = matrix_initialize(n, n);
+		} else {
+			matrix_resize(cov -> inv, n, n);
+		}
+		for (unsigned short i = 0u; i < n; i++) {
+			for (unsigned short j = 0u; j <= i; j++) {
+				double sum = 0;
+				for (unsigned short k = i; k < n; k++) {
+					sum += (*L).matrix[k][i] * (*L).matrix[k][j];
+				}
+				cov -> inv -> matrix[i][j] = sum;
+				cov -> inv -> matrix[j][i] = sum;
+			}
+		}
+		matrix_free(L);
+		PROFILE_STOP(PROFILE_COVARIANCE_UPDATE);
+		return 0u;
+
+	} else {
+		/* matrix_invert leaves inv untouched if the matrix is singular */
+		MATRIX *inv = matrix_invert( *((MATRIX *) cov), cov -> inv);
+		if ((*cov).inv == NULL) cov -> inv = inv;
+		cov -> logdet = NAN;
+		PROFILE_STOP(PROFILE_COVARIANCE_UPDATE);
+		return 1u;
+	}
+
+}
+
+
+/*
+.. c:function:: extern void covariance_matrix_whitening(COVARIANCE_MATRIX cov, const unsigned short *order, double *scales);
+
+	Compute the factors by which to scale each component of a vector
+	difference :math:`\Delta` such that the sum of the squares of the scaled
+	components is a lower bound on :math:`\chi^2 = \Delta C^{-1} \Delta^T`.
+
+	Parameters
+	----------
+	cov : ``COVARIANCE_MATRIX``
+		The covariance matrix :math:`C`.
+	order : ``const unsigned short *``
+		The row of ``cov`` corresponding to each element of ``scales``. If
+		``NULL``, the rows are taken in order.
+	scales : ``double *``
+		The ``cov.n_rows`` elements in which to store the scale factors.
+
+	Notes
+	-----
+	Writing :math:`C = DRD`, where :math:`D` is the diagonal matrix of
+	standard deviations and :math:`R` the correlation matrix,
+
+	.. math:: \chi^2 = w R^{-1} w^T \geq \frac{|w|^2}{\lambda_\text{max}(R)}
+
+	with :math:`w_k = \Delta_k / \sigma_k`. The largest eigenvalue of
+	:math:`R` is bounded from above by :math:`\rho = \max_i \sum_j |R_{ij}|`
+	(the Gershgorin circle theorem), so each scale factor is
+	:math:`1 / (\sigma_k \sqrt{\rho})`. For uncorrelated measurements,
+	:math:`\rho = 1` and the bound is exact.
+*/
+extern void covariance_matrix_whitening(COVARIANCE_MATRIX cov,
+	const unsigned short *order, double *scales) {
+
+	double rho = 1;
+	for (unsigned short i = 0u; i < cov.n_rows; i++) {
+		double row = 0;
+		for (unsigned short j = 0u; j < cov.n_rows; j++) {
+			row += fabs(cov.matrix[i][j]) / sqrt(
+				cov.matrix[i][i] * cov.matrix[j][j]);
+		}
+		if (row > rho) rho = row;
+	}
+	for (unsigned short k = 0u; k < cov.n_rows; k++) {
+		unsigned short row = (order == NULL) ? k : order[k];
+		scales[k] = 1 / sqrt(cov.matrix[row][row] * rho);
+	}
+
+}
+
+
 /*
 .. c:function:: extern void covariance_matrix_free(COVARIANCE_MATRIX *cov);
 
@@ -183,7 +439,7 @@ extern void covariance_matrix_free(COVARIANCE_MATRIX *cov) {
 extern void covariance_matrix_free_everything(COVARIANCE_MATRIX *cov) {
 
 	covariance_matrix_free(cov);
-	if (cov != NULL) free(cov);
+	matrix_free((MATRIX *) cov);
 
 }
 
@@ -332,6 +588,11 @@ static MATRIX *matrix_unary_minus(MATRIX m, MATRIX *result) {
 		that
 
 		.. math:: M_{ij} = \sum_k m_{1i,k} m_{2k,j}
+
+	Notes
+	-----
+	If TrackStar was linked with a BLAS library, the product is computed by
+	``dgemm`` when every dimension is at least :c:macro:`BLAS_MIN_DIMENSION`.
 */
 extern MATRIX *matrix_multiply(MATRIX m1, MATRIX m2, MATRIX *result) {
 
@@ -342,6 +603,17 @@ extern MATRIX *matrix_multiply(MATRIX m1, MATRIX m2, MATRIX *result) {
 		} else {
 			matrix_resize(result, m1.n_rows, m2.n_cols);
 		}
+		#if defined(TRACKSTAR_BLAS)
+			if (m1.n_rows >= BLAS_MIN_DIMENSION &&
+				m1.n_cols >= BLAS_MIN_DIMENSION &&
+				m2.n_cols >= BLAS_MIN_DIMENSION) {
+				cblas_dgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans,
+					m1.n_rows, m2.n_cols, m1.n_cols, 1, matrix_elements(m1),
+					m1.n_cols, matrix_elements(m2), m2.n_cols, 0,
+					matrix_elements(*result), m2.n_cols);
+				return result;
+			} else {}
+		#endif
 		for (unsigned short i = 0u; i < (*result).n_rows; i++) {
 			for (unsigned short j = 0u; j < (*result).n_cols; j++) {
 				for (unsigned short k = 0u; k < m1.n_cols; k++) {
@@ -385,26 +657,69 @@ extern MATRIX *matrix_multiply(MATRIX m1, MATRIX m2, MATRIX *result) {
 
 		where :math:`I` is the identity matrix of the same size as :math:`m`.
 		``NULL`` is returned when :math:`det(m) = 0`, because such matrices
-		are not invertible.
+		are not invertible. In this case, ``result`` is left unmodified.
+
+	Notes
+	-----
+	The inverse is computed by solving :math:`mx = e_j` for each column
+	:math:`e_j` of the identity matrix using a single LU decomposition with
+	partial pivoting (see section 2.3 of Press et al. 2007 [1]_), which
+	requires :math:`O(n^3)` operations in total. If TrackStar was linked with
+	a BLAS library, matrices of at least :c:macro:`BLAS_MIN_DIMENSION` rows
+	are instead inverted by LAPACK's ``dgetrf`` and ``dgetri``.
+
+	.. seealso::
+
+		- ``static MATRIX *LUdecomp(MATRIX m, unsigned short *perm, short *parity);``
+		- ``static void LUsolve(MATRIX LU, double *x);``
 
 	.. note::
 
 		While some non-square matrices have left- and right-inverses, TrackStar
 		only supports inversion of square matrices.
+
+	.. [1] Press, Teukolsky, Vetterling & Flannery (2007), Numerical Recipes,
+		Cambridge University Press
 */
 extern MATRIX *matrix_invert(MATRIX m, MATRIX *result) {
 
-	double det = matrix_determinant(m);
-	if (det) {
-		result = matrix_adjoint(m, result);
-		for (unsigned short i = 0u; i < m.n_rows; i++) {
+	if (m.n_rows == m.n_cols) {
+
+		#if defined(TRACKSTAR_BLAS)
+			if (m.n_rows >= BLAS_MIN_DIMENSION) {
+				return lapack_invert(m, result);
+			} else {}
+		#endif
+		unsigned short *perm = (unsigned short *) malloc (
+			m.n_rows * sizeof(unsigned short));
+		short parity;
+		MATRIX *LU = LUdecomp(m, perm, &parity);
+		if (LU != NULL) {
+			if (result == NULL) {
+				result = matrix_initialize(m.n_rows, m.n_cols);
+			} else {
+				matrix_resize(result, m.n_rows, m.n_cols);
+			}
+			double *column = (double *) malloc (m.n_rows * sizeof(double));
 			for (unsigned short j = 0u; j < m.n_cols; j++) {
-				result -> matrix[i][j] /= det;
+				for (unsigned short i = 0u; i < m.n_rows; i++) {
+					column[i] = (double) (perm[i] == j);
+				}
+				LUsolve(*LU, column);
+				for (unsigned short i = 0u; i < m.n_rows; i++) {
+					result -> matrix[i][j] = column[i];
+				}
 			}
+			free(column);
+			matrix_free(LU);
+		} else {
+			result = NULL;
 		}
+		free(perm);
 		return result;
+
 	} else {
-		return NULL;
+		fatal_print("%s\n", "Cannot invert a non-square matrix.");
 	}
 
 }
@@ -467,23 +782,19 @@ extern MATRIX *matrix_transpose(MATRIX m, MATRIX *result) {
 
 	Notes
 	-----
-	The determinant is computed through LU decomposition with Crout's
-	algorithm (see section 2.3.1 of Press et al. 2007 [1]_). If it finds that
-	a row exchange would be required to compute the decomposition, then this
-	function falls back on expansion by minors along an ideal row or column,
-	implemented recursively within an iterative sum. The solution for a 2x2
-	matrix is implemented as the base case, with an additional base case for a
-	1x1 matrix included as a failsafe.
-
-	Since the primary use case of this function is symmetric covariance
-	matrices, the vast majority of applications in practice will proceed just
-	fine with an LU decomposition, which will more than make up for any
-	slow-downs encurred by the cases where expansion by minors was necessary.
+	The determinant is computed through LU decomposition with partial
+	pivoting (see section 2.3.1 of Press et al. 2007 [1]_). It is given by the
+	product of the diagonal elements of the upper triangular matrix, with the
+	sign flipped for each row exchange performed during the decomposition.
+	This requires :math:`O(n^3)` operations, and a return value of exactly zero
+	indicates that the matrix is singular. If TrackStar was linked with a BLAS
+	library, matrices of at least :c:macro:`BLAS_MIN_DIMENSION` rows are
+	instead decomposed by LAPACK's ``dgetrf``.
 
 	.. seealso::
 
-		- ``static MATRIX *LUdecomp(MATRIX *m);``
-		- ``static double determinant_expansion_minors(MATRIX m);``
+		- ``static MATRIX *LUdecomp(MATRIX m, unsigned short *perm, short *parity);``
+		- :c:func:`matrix_cholesky` for symmetric positive-definite matrices.
 
 	.. [1] Press, Teukolsky, Vetterling & Flannery (2007), Numerical Recipes,
 		Cambridge University Press
@@ -492,16 +803,25 @@ extern double matrix_determinant(MATRIX m) {
 
 	if (m.n_rows == m.n_cols) {
 
-		MATRIX *LU = LUdecomp(m);
+		#if defined(TRACKSTAR_BLAS)
+			if (m.n_rows >= BLAS_MIN_DIMENSION) {
+				return lapack_determinant(m);
+			} else {}
+		#endif
+		unsigned short *perm = (unsigned short *) malloc (
+			m.n_rows * sizeof(unsigned short));
+		short parity;
+		MATRIX *LU = LUdecomp(m, perm, &parity);
+		free(perm);
 		if (LU != NULL) {
-			double prod = 1.f;
+			double prod = (double) parity;
 			for (unsigned short i = 0u; i < m.n_rows; i++) {
 				prod *= (*LU).matrix[i][i];
 			}
 			matrix_free(LU);
 			return prod;
 		} else {
-			return determinant_expansion_minors(m);
+			return 0;
 		}
 
 	} else {
@@ -513,436 +833,501 @@ extern double matrix_determinant(MATRIX m) {
 
 
 /*
-.. c:function:: static MATRIX *LUdecomp(MATRIX m);
+.. c:function:: extern MATRIX *matrix_cholesky(MATRIX m, MATRIX *result);
 
-	Compute the LU decomposition of a square matrix.
+	Compute the Cholesky decomposition of a symmetric positive-definite
+	matrix.
 
 	Parameters
 	----------
 	m : ``MATRIX``
-		The input square matrix to decompose.
+		The input matrix. Only the elements along and below the diagonal are
+		accessed; the matrix is assumed to be symmetric.
+	result : ``MATRIX *``
+		A pointer to an already-initialized :c:type:`MATRIX` object to store
+		the decomposition, if applicable. If ``NULL``, memory will be
+		allocated automatically. If a pointer is provided, the same pointer
+		will be returned.
 
 	Returns
 	-------
-	decomp : ``MATRIX *``
-		A pointer to the decomposed matrix. The decomposition is returned
-		"in place" in that the elements of the upper triangular (U) matrix are
-		along and above the diagonal, and the elements of the lower triangular
-		(L) matrix) are below the diagonal.
+	result : ``MATRIX *``
+		The lower triangular matrix :math:`L`, defined such that
 
-		``NULL`` if a row exchange would be required to compute the
-		decomposition, in which case the LU decomposition does not exist.
+		.. math:: LL^T = m
+
+		with all elements above the diagonal equal to zero. ``NULL`` is
+		returned if ``m`` is not positive-definite, in which case the
+		decomposition does not exist. If ``result`` was provided, its contents
+		are undefined in this case.
 
 	Notes
 	-----
-	This function follows Crout's algorithm for determining an LU decomposition
-	(see section 2.3.1 of Press et al. 2007 [1]_).
+	This function follows the Cholesky-Banachiewicz algorithm (see section
+	2.9 of Press et al. 2007 [1]_), which requires roughly half as many
+	operations as an LU decomposition. It is the primary route by which
+	TrackStar inverts covariance matrices (see
+	:c:func:`covariance_matrix_update`). If TrackStar was linked with a BLAS
+	library, matrices of at least :c:macro:`BLAS_MIN_DIMENSION` rows are
+	instead decomposed by LAPACK's ``dpotrf``.
 
 	.. [1] Press, Teukolsky, Vetterling & Flannery (2007), Numerical Recipes,
 		Cambridge University Press
 */
-static MATRIX *LUdecomp(MATRIX m) {
+extern MATRIX *matrix_cholesky(MATRIX m, MATRIX *result) {
 
 	if (m.n_rows == m.n_cols) {
 
-		MATRIX *decomp = matrix_initialize(m.n_rows, m.n_cols);
-
-		/* start with the identity matrix */
-		for (unsigned short i = 0u; i < m.n_rows; i++) {
-			decomp -> matrix[i][i] = 1.f;
+		#if defined(TRACKSTAR_BLAS)
+			if (m.n_rows >= BLAS_MIN_DIMENSION) {
+				return lapack_cholesky(m, result);
+			} else {}
+		#endif
+		unsigned short allocated = result == NULL;
+		if (allocated) {
+			result = matrix_initialize(m.n_rows, m.n_cols);
+		} else {
+			matrix_resize(result, m.n_rows, m.n_cols);
 		}
 
-		for (unsigned short j = 0u; j < m.n_cols; j++) {
-			for (unsigned short i = 0u; i <= j; i++) {
-				decomp -> matrix[i][j] = m.matrix[i][j];
-				for (unsigned short k = 0u; k < i; k++) {
-					decomp -> matrix[i][j] -= (
-						(*decomp).matrix[i][k] * (*decomp).matrix[k][j]
-					);
-				}
-			}
-			for (unsigned short i = j + 1u; i < m.n_rows; i++) {
-				decomp -> matrix[i][j] = m.matrix[i][j];
+		for (unsigned short i = 0u; i < m.n_rows; i++) {
+			for (unsigned short j = 0u; j <= i; j++) {
+				double sum = m.matrix[i][j];
 				for (unsigned short k = 0u; k < j; k++) {
-					decomp -> matrix[i][j] -= (
-						(*decomp).matrix[i][k] * (*decomp).matrix[k][j]
-					);
+					sum -= (*result).matrix[i][k] * (*result).matrix[j][k];
 				}
-				if ((*decomp).matrix[j][j]) {
-					decomp -> matrix[i][j] /= (*decomp).matrix[j][j];
+				if (i == j) {
+					if (sum > 0) {
+						result -> matrix[i][i] = sqrt(sum);
+					} else {
+						if (allocated) matrix_free(result);
+						return NULL;
+					}
 				} else {
-					matrix_free(decomp);
-					return NULL;
+					result -> matrix[i][j] = sum / (*result).matrix[j][j];
 				}
 			}
 		}
 
-		return decomp;
-
+		return result;
 
 	} else {
 		fatal_print("%s\n",
-			"Cannot compute the LU decomposition of a non-square matrix.");
+			"Cannot compute the Cholesky decomposition of a non-square matrix.");
 	}
 
 }
 
 
-struct row_column_index {
-
-	/*
-	.. c:struct:: row_column_index;
-
-		A ``struct`` used to determine which row or column along which it would
-		be ideal to run expansion by minors. The ideal row or column is
-		determined by figuring out which one has the most zeros.
-
-		.. c:member:: unsigned short index;
-
-			A row or column number.
-
-		.. c:member:: along_row;
-
-			1u if ``index`` refers to a row. 0u if it refers to a column.
-	*/
-
-	unsigned short index;
-	unsigned short along_row;
-
-};
-
-
 /*
-.. c:function:: static double determinant_expansion_minors(MATRIX m);
+.. c:function:: static MATRIX *LUdecomp(MATRIX m, unsigned short *perm, short *parity);
 
-	Compute the determinant of a square matrix through expansion by minors.
+	Compute the LU decomposition of a square matrix with partial pivoting.
 
 	Parameters
 	----------
 	m : ``MATRIX``
-		The matrix itself.
+		The input square matrix to decompose.
+	perm : ``unsigned short *``
+		An array of length ``m.n_rows`` to store the row permutation. On
+		output, ``perm[i]`` is the row of ``m`` that was moved to row ``i`` of
+		the decomposition.
+	parity : ``short *``
+		On output, +1 if an even number of row exchanges were performed, and
+		-1 if an odd number were.
 
 	Returns
 	-------
-	det : ``double``
-		:math:`det(m)`, computed via expansion by minors along an optimal
-		axis.
+	decomp : ``MATRIX *``
+		A pointer to the decomposed matrix. The decomposition is returned
+		"in place" in that the elements of the upper triangular (U) matrix are
+		along and above the diagonal, and the elements of the unit lower
+		triangular (L) matrix are below the diagonal, such that :math:`LU = Pm`
+		for the permutation matrix :math:`P` described by ``perm``.
+
+		``NULL`` if the matrix is singular, in which case ``perm`` and
+		``parity`` are undefined.
 
 	Notes
 	-----
-	The expansion by minors is implemented recursively within an iterative sum,
-	with the solution for a 2x2 matrix implemented as the base case. As a
-	failsafe, the obvious solution for a 1x1 matrix is implemented as an
-	additional base case.
-
-	This method for calculating a matrix determinant will only be called in the
-	event that an LU decomposition does not exist. In practice, this should
-	rarely if ever happen for symmetric covariance matrices, which are the
-	primary use case of TrackStar's ``matrix_determinant`` function. This
-	method, originally implemented in TrackStar's initial development, remains
-	included as a failsafe. Though expansion by minors does not scale well, it
-	is fast enough for most <10x10 matrices anyway.
-
-	.. seealso:: ``static MATRIX *LUdecomp(MATRIX m);
+	At each step, the row with the largest absolute value in the current
+	column is exchanged into the pivot position (see section 2.3 of Press et
+	al. 2007 [1]_), which keeps the decomposition numerically stable for
+	arbitrary non-singular matrices.
+
+	.. [1] Press, Teukolsky, Vetterling & Flannery (2007), Numerical Recipes,
+		Cambridge University Press
 */
-static double determinant_expansion_minors(MATRIX m) {
+static MATRIX *LUdecomp(MATRIX m, unsigned short *perm, short *parity) {
 
 	if (m.n_rows == m.n_cols) {
 
-		if (m.n_rows == 1u) {
-			/* failsafe base case: a 1x1 matrix */
-			return m.matrix[0][0];
-		} else if (m.n_rows == 2u) {
-			/* primary base case: a 2x2 matrix */
-			return (
-				m.matrix[0][0] * m.matrix[1][1] -
-				m.matrix[0][1] * m.matrix[1][0]
-			);
-		} else {
-			/* The recursive case: an NxN matrix where N > 2 */
-			double result = 0.f;
-			struct row_column_index ideal_axis = expansion_ideal_axis(m);
-			if (ideal_axis.along_row) {
-				for (unsigned short j = 0u; j < m.n_cols; j++) {
-					if (m.matrix[ideal_axis.index][j] != 0) {
-						unsigned short axis[2] = {ideal_axis.index, j};
-						MATRIX *minor = matrix_minor(m, axis, NULL);
-						result += m.matrix[ideal_axis.index][j] * pow(
-							-1, ideal_axis.index + j) * matrix_determinant(
-							*minor);
-						matrix_free(minor);
-					}
-				}
-			} else {
-				for (unsigned short i = 0u; i < m.n_rows; i++) {
-					if (m.matrix[i][ideal_axis.index] != 0) {
-						unsigned short axis[2] = {i, ideal_axis.index};
-						MATRIX *minor = matrix_minor(m, axis, NULL);
-						result += m.matrix[i][ideal_axis.index] * pow(
-							-1, i + ideal_axis.index) * matrix_determinant(
-							*minor);
-						matrix_free(minor);
-					} else {}
+		MATRIX *decomp = matrix_initialize(m.n_rows, m.n_cols);
+		for (unsigned short i = 0u; i < m.n_rows; i++) {
+			for (unsigned short j = 0u; j < m.n_cols; j++) {
+				decomp -> matrix[i][j] = m.matrix[i][j];
+			}
+			perm[i] = i;
+		}
+		*parity = 1;
+
+		for (unsigned short k = 0u; k < m.n_rows; k++) {
+			unsigned short pivot = k;
+			for (unsigned short i = k + 1u; i < m.n_rows; i++) {
+				if (fabs((*decomp).matrix[i][k]) >
+					fabs((*decomp).matrix[pivot][k])) pivot = i;
+			}
+			if ((*decomp).matrix[pivot][k] == 0) {
+				matrix_free(decomp);
+				return NULL;
+			} else if (pivot != k) {
+				/* swapping row pointers is sufficient */
+				double *row = (*decomp).matrix[k];
+				decomp -> matrix[k] = (*decomp).matrix[pivot];
+				decomp -> matrix[pivot] = row;
+				unsigned short index = perm[k];
+				perm[k] = perm[pivot];
+				perm[pivot] = index;
+				*parity = -*parity;
+			} else {}
+			for (unsigned short i = k + 1u; i < m.n_rows; i++) {
+				double factor = (*decomp).matrix[i][k] / (*decomp).matrix[k][k];
+				decomp -> matrix[i][k] = factor;
+				for (unsigned short j = k + 1u; j < m.n_cols; j++) {
+					decomp -> matrix[i][j] -= factor * (*decomp).matrix[k][j];
 				}
 			}
-			return result;
 		}
 
+		return decomp;
+
 	} else {
 		fatal_print("%s\n",
-			"Cannot compute the determinant of a non-square matrix.");
+			"Cannot compute the LU decomposition of a non-square matrix.");
 	}
 
 }
 
 
 /*
-.. c:function:: static struct row_column_index matrix_determinant_ideal_axis(MATRIX m);
+.. c:function:: static void LUsolve(MATRIX LU, double *x);
 
-	Determine the ideal axis along which expansion by minors will be most
-	efficient by determining which row or column has the most zeros.
+	Solve the linear system :math:`mx = b` given the LU decomposition of
+	:math:`m` computed by ``LUdecomp``.
 
 	Parameters
 	----------
-	m : ``MATRIX``
-		The matrix whose determinant is to be computed.
+	LU : ``MATRIX``
+		The decomposition of :math:`m` as returned by ``LUdecomp``.
+	x : ``double *``
+		On input, the right-hand side :math:`b` permuted according to the
+		row exchanges performed by ``LUdecomp`` (i.e. ``x[i] = b[perm[i]]``).
+		Overwritten with the solution on output.
 
-	Returns
-	-------
-	axis : ``struct row_column_index``
-		The ``struct`` containing the index of the row or column and a boolean
-		flag describing whether it is a row or a column.
+	Notes
+	-----
+	This is implemented as a forward substitution with the unit lower
+	triangular matrix followed by a back substitution with the upper
+	triangular matrix (see section 2.3 of Press et al. 2007 [1]_).
+
+	.. [1] Press, Teukolsky, Vetterling & Flannery (2007), Numerical Recipes,
+		Cambridge University Press
 */
-static struct row_column_index expansion_ideal_axis(MATRIX m) {
-
-	struct row_column_index axis;
-	axis.index = 0u;
-	axis.along_row = 1u;
-	unsigned short current_max = zeros_along_axis(m,axis.index, axis.along_row);
-	for (unsigned short i = 1u; i < m.n_rows; i++) {
-		if (zeros_along_axis(m, i, 1u) > current_max) {
-			axis.index = i;
-		} else {}
+static void LUsolve(MATRIX LU, double *x) {
+
+	for (unsigned short i = 1u; i < LU.n_rows; i++) {
+		for (unsigned short k = 0u; k < i; k++) x[i] -= LU.matrix[i][k] * x[k];
 	}
-	for (unsigned short j = 0u; j < m.n_cols; j++) {
-		if (zeros_along_axis(m, j, 0u) > current_max) {
-			axis.index = j;
-			axis.along_row = 0u;
-		} else {}
+	for (unsigned short i = LU.n_rows; i > 0u; i--) {
+		unsigned short row = i - 1u;
+		for (unsigned short k = i; k < LU.n_cols; k++) {
+			x[row] -= LU.matrix[row][k] * x[k];
+		}
+		x[row] /= LU.matrix[row][row];
 	}
-	return axis;
 
 }
 
 
 /*
-.. c:function:: static unsigned short matrix_zeros_along_axis(MATRIX m, const unsigned short index, const unsigned short along_row);
+.. cpp:function:: static void matrix_resize(MATRIX *M, const unsigned short n_rows, const unsigned short n_cols);
 
-	Determine the number of zeros along a given row or column of a matrix.
+	Update the amount of memory reserved for the matrix based on new dimensions,
+	and set all entries to zero (i.e. :math:`M_{ij} = 0` for all :math:`i` and
+	:math:`j` after calling this function).
+	If the dimensions are unchanged, the matrix keeps its block of memory.
 
 	Parameters
 	----------
-	m : ``MATRIX``
-		The matrix in question.
-	index : ``const unsigned short``
-		The row or column number.
-	along_row : ``const unsigned short``
-		1u if ``index`` refers to a row number, 0u if it refers to a column.
-
-	Returns
-	-------
-	n : ``unsigned short``
-		The number of zeros along the given row or column.
+	m : ``MATRIX *``
+		The matrix to reszie.
+	n_rows : ``const unsigned short``
+		The new number of rows in the matrix.
+	n_cols : ``const unsigned short``
+		The new number of columns in the matrix.
 */
-static unsigned short zeros_along_axis(MATRIX m,
-	const unsigned short index, const unsigned short along_row) {
+static void matrix_resize(MATRIX *m, const unsigned short n_rows,
+	const unsigned short n_cols) {
 
-	unsigned short n = 0;
-	if (along_row) {
-		for (unsigned short j = 0u; j < m.n_cols; j++) {
-			n += m.matrix[index][j] == 0;
+	/*
+	A matrix that keeps its dimensions keeps its block, which is what allows
+	matrices allocated from an arena to be updated in place.
+	*/
+	if (n_rows == (*m).n_rows && n_cols == (*m).n_cols) {
+		for (unsigned short i = 0u; i < n_rows; i++) {
+			for (unsigned short j = 0u; j < n_cols; j++) m -> matrix[i][j] = 0;
 		}
 	} else {
-		for (unsigned short i = 0u; i < m.n_rows; i++) {
-			n += m.matrix[i][index] == 0;
-		}
+		free(m -> matrix);
+		m -> matrix = matrix_rows(calloc (matrix_block_size(n_rows, n_cols),
+			1u), n_rows, n_cols);
+		m -> n_rows = n_rows;
+		m -> n_cols = n_cols;
+		PROFILE_COUNT(PROFILE_BYTES_ALLOCATED,
+			matrix_block_size(n_rows, n_cols));
 	}
-	return n;
 
 }
 
 
 /*
-.. cpp:function:: static MATRIX *matrix_adjoint(MATRIX m, MATRIX *result);
+.. c:function:: static unsigned long matrix_block_size(const unsigned short n_rows, const unsigned short n_cols);
 
-	Compute the adjoint of a square matrix.
+	Determine the size of the block of memory that stores the row pointers
+	and elements of a matrix.
 
 	Parameters
 	----------
-	m : ``MATRIX``
-		The input matrix itself.
-	result : ``MATRIX *``
-		A pointer to an already-initialized :c:type:`MATRIX` object to store
-		the adjoint matrix, if applicable. If ``NULL``, memory will be
-		allocated automatically. If a pointer is provided, the same pointer
-		will be returned.
+	n_rows : ``const unsigned short``
+		The number of rows in the matrix.
+	n_cols : ``const unsigned short``
+		The number of columns in the matrix.
 
 	Returns
 	-------
-	result : ``MATRIX *``
-		The adjoint, defined as the transpose of the matrix of cofactors
-		(i.e. :math:`\text{adj}(M) \equiv \text{cof}(M)^T`).
-
-	.. note::
-
-		Some textbooks and authors use the term adjugate or adjunt instead of
-		adjoint. Though we use the term adjoint here, they refer to the same
-		thing.
+	size : ``unsigned long``
+		The size of the block in bytes, which is never zero.
 */
-static MATRIX *matrix_adjoint(MATRIX m, MATRIX *result) {
+static unsigned long matrix_block_size(const unsigned short n_rows,
+	const unsigned short n_cols) {
 
-	MATRIX *cofactors = matrix_cofactors(m, NULL);
-	result = matrix_transpose(*cofactors, result);
-	matrix_free(cofactors);
-	return result;
+	unsigned long size = n_rows * (sizeof(double *) + n_cols * sizeof(double));
+	return size ? size : sizeof(double *);
 
 }
 
 
 /*
-.. cpp:function:: static MATRIX *matrix_cofactors(MATRIX m, MATRIX *result);
+.. c:function:: static double **matrix_rows(void *block, const unsigned short n_rows, const unsigned short n_cols);
 
-	Compute the matrix of cofactors for a square matrix.
+	Lay out the row pointers of a matrix within its block of memory.
 
 	Parameters
 	----------
-	m : ``MATRIX``
-		The input matrix itself.
-	result : ``MATRIX *``
-		A pointer to an already-initialized :c:type:`MATRIX` object to store
-		the cofactor matrix, if applicable. If ``NULL``, memory will be
-		allocated automatically. If a pointer is provided, the same pointer
-		will be returned.
+	block : ``void *``
+		The block, of at least :c:func:`matrix_block_size` bytes, all of which
+		are zero.
+	n_rows : ``const unsigned short``
+		The number of rows in the matrix.
+	n_cols : ``const unsigned short``
+		The number of columns in the matrix.
 
 	Returns
 	-------
-	result : ``MATRIX *``
-		The matrix of cofactors, defined according to
+	rows : ``double **``
+		The start of the block, which holds ``n_rows`` pointers, each to the
+		first element of one row. The rows follow the pointers contiguously.
+*/
+static double **matrix_rows(void *block, const unsigned short n_rows,
+	const unsigned short n_cols) {
 
-		.. math:: A_{ij} = (-1)^{i + j} det(m_{ij}),
+	if (block == NULL) fatal_print("%s\n", "Matrix allocation failed.");
+	double **rows = (double **) block;
+	double *elements = (double *) (rows + n_rows);
+	for (unsigned short i = 0u; i < n_rows; i++) {
+		rows[i] = elements + i * n_cols;
+	}
+	return rows;
 
-		where :math:`m_{ij}` is the :math:`ij`'th minor of ``m``.
-*/
-static MATRIX *matrix_cofactors(MATRIX m, MATRIX *result) {
+}
 
-	if (m.n_rows == m.n_cols) {
+
+#if defined(TRACKSTAR_BLAS)
+/*
+.. c:function:: static MATRIX *lapack_invert(MATRIX m, MATRIX *result);
+
+	Invert a square matrix with LAPACK's ``dgetrf`` and ``dgetri``. Called by
+	:c:func:`matrix_invert`, with the same parameters and return value.
+
+	Notes
+	-----
+	LAPACK expects column-major matrices, so it sees the transpose of ``m``.
+	Since :math:`(m^T)^{-1} = (m^{-1})^T`, the inverse it computes in
+	column-major order is :math:`m^{-1}` in row-major order.
+*/
+static MATRIX *lapack_invert(MATRIX m, MATRIX *result) {
+
+	int n = (int) m.n_rows, lwork = -1, info;
+	unsigned long size = (unsigned long) m.n_rows * m.n_cols * sizeof(double);
+	double *lu = (double *) malloc (size);
+	int *pivots = (int *) malloc (m.n_rows * sizeof(int));
+	memcpy(lu, matrix_elements(m), size);
+	dgetrf_(&n, &n, lu, &n, pivots, &info);
+	if (info == 0) {
+		double optimal;
+		dgetri_(&n, lu, &n, pivots, &optimal, &lwork, &info);
+		lwork = (int) optimal;
+		double *work = (double *) malloc ((unsigned long) lwork *
+			sizeof(double));
+		dgetri_(&n, lu, &n, pivots, work, &lwork, &info);
+		free(work);
 		if (result == NULL) {
 			result = matrix_initialize(m.n_rows, m.n_cols);
 		} else {
 			matrix_resize(result, m.n_rows, m.n_cols);
 		}
-		for (unsigned short i = 0u; i < m.n_rows; i++) {
-			for (unsigned short j = 0u; j < m.n_cols; j++) {
-				unsigned short axis[2] = {i, j};
-				MATRIX *minor = matrix_minor(m, axis, NULL);
-				result -> matrix[i][j] = pow(-1,
-					i + j) * matrix_determinant(*minor);
-				matrix_free(minor);
-			}
-		}
-		return result;
+		memcpy(matrix_elements(*result), lu, size);
 	} else {
-		fatal_print("%s\n", "Matrix is not square.");
+		/* info > 0 flags an exactly zero pivot, as LUdecomp does */
+		result = NULL;
 	}
+	free(pivots);
+	free(lu);
+	return result;
 
 }
 
 
 /*
-.. cpp:function:: static MATRIX *matrix_minor(MATRIX m, unsigned short axis[2], MATRIX *result);
+.. c:function:: static double lapack_determinant(MATRIX m);
 
-	Obtain one of a matrix's minors.
+	Compute the determinant of a square matrix with LAPACK's ``dgetrf``.
+	Called by :c:func:`matrix_determinant`, with the same parameters and
+	return value.
 
-	Parameters
-	----------
-	m : ``MATRIX``
-		The input matrix itself.
-	axis : ``unsigned short [2]``
-		Which minor to obtain. axis[0] refers to the row to omit from ``m``,
-		and axes[1] to the column.
-	result : ``MATRIX *``
-		A pointer to an already-initialized :c:type:`MATRIX` object to store
-		the minor, if applicable. If ``NULL``, memory will be allocated
-		automatically. If a pointer is provided, the same pointer will be
-		returned.
+	Notes
+	-----
+	LAPACK sees the transpose of ``m`` (see ``lapack_invert``), which has the
+	same determinant. ``dgetrf`` records the row exchanged with row ``i`` as
+	``pivots[i]``, counting from one.
+*/
+static double lapack_determinant(MATRIX m) {
+
+	int n = (int) m.n_rows, info;
+	unsigned long size = (unsigned long) m.n_rows * m.n_cols * sizeof(double);
+	double *lu = (double *) malloc (size);
+	int *pivots = (int *) malloc (m.n_rows * sizeof(int));
+	memcpy(lu, matrix_elements(m), size);
+	dgetrf_(&n, &n, lu, &n, pivots, &info);
+	double prod = 1;
+	for (int i = 0; i < n; i++) {
+		prod *= lu[(unsigned long) i * m.n_cols + (unsigned long) i];
+		if (pivots[i] != i + 1) prod = -prod;
+	}
+	free(pivots);
+	free(lu);
+	return prod;
 
-	Returns
-	-------
-	result : ``matrix``
-		If ``m`` is an :math:`MxN` matrix, the returned matrix will be
-		:math:`(M-1)x(N-1)`, with the ``axis[0]``'th row and the
-		``axes[1]``'st column omitted from the original.
+}
+
+
+/*
+.. c:function:: static MATRIX *lapack_cholesky(MATRIX m, MATRIX *result);
+
+	Compute the Cholesky decomposition of a symmetric positive-definite
+	matrix with LAPACK's ``dpotrf``. Called by :c:func:`matrix_cholesky`,
+	with the same parameters and return value.
+
+	Notes
+	-----
+	The lower triangle of ``m`` in row-major order is the upper triangle of
+	the column-major matrix that LAPACK sees, so ``dpotrf`` is asked for the
+	factor :math:`U` with :math:`U^TU = m`, which in row-major order is
+	:math:`L`. It does not access the other triangle, which is zeroed
+	afterwards.
 */
-static MATRIX *matrix_minor(MATRIX m, unsigned short axis[2], MATRIX *result) {
+static MATRIX *lapack_cholesky(MATRIX m, MATRIX *result) {
 
-	if (result == NULL) {
-		result = matrix_initialize(m.n_rows - 1u, m.n_cols - 1u);
+	unsigned short allocated = result == NULL;
+	if (allocated) {
+		result = matrix_initialize(m.n_rows, m.n_cols);
 	} else {
-		matrix_resize(result, m.n_rows - 1u, m.n_cols - 1u);
+		matrix_resize(result, m.n_rows, m.n_cols);
 	}
-
-	/*
-	Don't use multi-threading here. Thread safety would be a nightmare as one
-	would have to access the current thread number as opposed to simply
-	incrementing n1 and n2. Since we're simply copying values over, opening
-	and closing threads would likely slow things down anyway.
-	*/
-	unsigned short n1 = 0u;
-	for (unsigned short i = 0u; i < m.n_rows; i++) {
-		if (i != axis[0]) {
-			unsigned short n2 = 0u;
-			for (unsigned short j = 0u; j < m.n_cols; j++) {
-				if (j != axis[1]) {
-					result -> matrix[n1][n2] = m.matrix[i][j];
-					n2++;
-				}
+	int n = (int) m.n_rows, info;
+	double *factor = matrix_elements(*result);
+	memcpy(factor, matrix_elements(m),
+		(unsigned long) m.n_rows * m.n_cols * sizeof(double));
+	dpotrf_("U", &n, factor, &n, &info);
+	if (info == 0) {
+		for (unsigned short i = 0u; i < m.n_rows; i++) {
+			for (unsigned short j = i + 1u; j < m.n_cols; j++) {
+				result -> matrix[i][j] = 0;
 			}
-			n1++;
-		} else {}
+		}
+		return result;
+	} else {
+		if (allocated) matrix_free(result);
+		return NULL;
 	}
 
-	return result;
-
 }
 
 
 /*
-.. cpp:function:: static void matrix_resize(MATRIX *M, const unsigned short n_rows, const unsigned short n_cols);
+.. c:function:: static unsigned short lapack_covariance_matrix_update(COVARIANCE_MATRIX *cov);
 
-	Update the amount of memory reserved for the matrix based on new dimensions,
-	and set all entries to zero (i.e. :math:`M_{ij} = 0` for all :math:`i` and
-	:math:`j` after calling this function).
+	Update the inverse and log-determinant of a covariance matrix with
+	LAPACK's ``dpotrf`` and ``dpotri``. Called by
+	:c:func:`covariance_matrix_update`, with the same parameters and return
+	value.
 
-	Parameters
-	----------
-	m : ``MATRIX *``
-		The matrix to reszie.
-	n_rows : ``const unsigned short``
-		The new number of rows in the matrix.
-	n_cols : ``const unsigned short``
-		The new number of columns in the matrix.
+	Notes
+	-----
+	As in ``lapack_cholesky``, LAPACK factors the lower triangle of the
+	matrix in row-major order. ``dpotri`` then overwrites the factor with the
+	same triangle of the inverse, which is mirrored into the other. The
+	factorization is done in a copy of the matrix so that :c:member:`inv` is
+	left unchanged if it fails, in which case the inverse is computed by
+	:c:func:`matrix_invert` as usual.
 */
-static void matrix_resize(MATRIX *m, const unsigned short n_rows,
-	const unsigned short n_cols) {
-
-	m -> n_rows = n_rows;
-	m -> n_cols = n_cols;
-	m -> matrix = (double **) realloc (m -> matrix,
-		(*m).n_rows * sizeof(double *));
-	for (unsigned short i = 0u; i < n_rows; i++) {
-		m -> matrix[i] = (double *) realloc (m -> matrix[i],
-			n_cols * sizeof(double));
-		for (unsigned short j = 0u; j < n_cols; j++) m -> matrix[i][j] = 0.f;
+static unsigned short lapack_covariance_matrix_update(
+	COVARIANCE_MATRIX *cov) {
+
+	unsigned short n = (*cov).n_rows;
+	int size = (int) n, info;
+	double *factor = (double *) malloc ((unsigned long) n * n *
+		sizeof(double));
+	memcpy(factor, matrix_elements(*((MATRIX *) cov)),
+		(unsigned long) n * n * sizeof(double));
+	dpotrf_("U", &size, factor, &size, &info);
+	if (info == 0) {
+		double logdet = 0;
+		for (unsigned long i = 0ul; i < n; i++) {
+			logdet += log(factor[i * n + i]);
+		}
+		cov -> logdet = 2 * logdet;
+		dpotri_("U", &size, factor, &size, &info);
+		if ((*cov).inv == NULL) {
+			cov -> inv = matrix_initialize(n, n);
+		} else {
+			matrix_resize(cov -> inv, n, n);
+		}
+		for (unsigned long i = 0ul; i < n; i++) {
+			for (unsigned long j = 0ul; j <= i; j++) {
+				cov -> inv -> matrix[i][j] = factor[i * n + j];
+				cov -> inv -> matrix[j][i] = factor[i * n + j];
+			}
+		}
+		free(factor);
+		return 0u;
+	} else {
+		free(factor);
+		MATRIX *inv = matrix_invert( *((MATRIX *) cov), cov -> inv);
+		if ((*cov).inv == NULL) cov -> inv = inv;
+		cov -> logdet = NAN;
+		return 1u;
 	}
 
 }
+#endif /* TRACKSTAR_BLAS */
@@ -17,6 +17,8 @@ that are central to TrackStar's backend.
 extern "C" {
 #endif /* __cplusplus */
 
+#include "arena.h"
+
 #ifndef PI /* the mathematical constant */
 #define PI 3.14159265358979
 #endif /* PI */
@@ -30,7 +32,12 @@ typedef struct matrix {
 
 		.. c:member:: double **matrix
 
-			The matrix itself, stored as a pointer to each row.
+			The matrix itself, stored as a pointer to each row. The row
+			pointers and the elements occupy a single block of memory, with
+			the elements following the pointers row by row, so that allocating
+			or freeing a matrix is a single call to ``calloc`` or ``free``.
+			Functions may permute the row pointers (e.g. when pivoting), but
+			``matrix`` itself always points to the start of the block.
 
 		.. c:member:: unsigned short n_rows
 
@@ -80,6 +87,13 @@ typedef struct covariance_matrix {
 
 			The inverse of a particular covariance matrix.
 
+		.. c:member:: double logdet
+
+			The natural logarithm of the determinant of the covariance matrix,
+			:math:`\ln|C|`. This is cached alongside :c:member:`inv` by
+			:c:func:`covariance_matrix_update` so that the likelihood
+			calculation never needs to recompute it.
+
 		.. c:member:: char **labels
 
 			An array of string labels describing the measured quantities.
@@ -115,6 +129,7 @@ typedef struct covariance_matrix {
 	unsigned short n_cols;
 	MATRIX *inv;
 	char **labels;
+	double logdet;
 
 } COVARIANCE_MATRIX;
 
@@ -154,6 +169,64 @@ extern MATRIX *matrix_initialize(unsigned short n_rows, unsigned short n_cols);
 */
 extern void matrix_free(MATRIX *m);
 
+/*
+.. c:function:: extern double *matrix_elements(const MATRIX m);
+
+	Obtain the elements of a matrix as a single row-major array.
+
+	Parameters
+	----------
+	m : ``const MATRIX``
+		The matrix of interest.
+
+	Returns
+	-------
+	elements : ``double *``
+		The ``n_rows * n_cols`` elements of ``m``, with :math:`m_{ij}` at
+		``elements[i * n_cols + j]``. This is the same memory that the row
+		pointers of :c:member:`MATRIX.matrix` point into, so it can be handed
+		to routines that expect a dense matrix, or exposed to python, without
+		copying it.
+
+	Notes
+	-----
+	Routines that permute the row pointers of a matrix in place (e.g.
+	pivoting during an LU decomposition) break the correspondence between the
+	two, so they only ever do so for temporary copies.
+*/
+extern double *matrix_elements(const MATRIX m);
+
+/*
+.. c:function:: extern MATRIX *matrix_arena_initialize(ARENA *a, const unsigned long struct_size, const unsigned short n_rows, const unsigned short n_cols);
+
+	Allocate a :c:type:`MATRIX`, or a structure that begins with the members
+	of one, from an arena.
+
+	Parameters
+	----------
+	a : ``ARENA *``
+		The arena to allocate from.
+	struct_size : ``const unsigned long``
+		The size of the structure to allocate: ``sizeof(MATRIX)``, or e.g.
+		``sizeof(DATUM)`` for a :c:type:`DATUM`. Members beyond those of a
+		:c:type:`MATRIX` are set to zero.
+	n_rows : ``const unsigned short``
+		The desired number of rows in the matrix.
+	n_cols : ``const unsigned short``
+		The desired number of columns in the matrix.
+
+	Returns
+	-------
+	m : ``MATRIX *``
+		The newly constructed matrix, laid out like one constructed by
+		:c:func:`matrix_initialize` and with each element set to zero. It
+		belongs to the arena: it must not be passed to :c:func:`matrix_free`,
+		and it must not be resized to other dimensions.
+*/
+extern MATRIX *matrix_arena_initialize(ARENA *a,
+	const unsigned long struct_size, const unsigned short n_rows,
+	const unsigned short n_cols);
+
 /*
 .. c:function:: extern COVARIANCE_MATRIX *covariance_matrix_initialize(unsigned short size);
 
@@ -171,10 +244,105 @@ extern void matrix_free(MATRIX *m);
 		A pointer to the newly constructed ``size`` x ``size`` covariance
 		matrix, with each matrix element assigned an initial value of zero.
 		The struct members ``inv`` and ``labels`` are given initial values
-		of ``NULL``.
+		of ``NULL``, and ``logdet`` is given an initial value of ``NAN``.
  */
 extern COVARIANCE_MATRIX *covariance_matrix_initialize(unsigned short size);
 
+/*
+.. c:function:: extern COVARIANCE_MATRIX *covariance_matrix_arena_initialize(ARENA *a, const unsigned short size);
+
+	Allocate a :c:type:`COVARIANCE_MATRIX` from an arena.
+
+	Parameters
+	----------
+	a : ``ARENA *``
+		The arena to allocate from.
+	size : ``const unsigned short``
+		The desired number of rows and columns in the matrix.
+
+	Returns
+	-------
+	cov : ``COVARIANCE_MATRIX *``
+		The newly constructed matrix, initialized like one constructed by
+		:c:func:`covariance_matrix_initialize` except that its inverse
+		:c:member:`inv` is also allocated from the arena, because
+		:c:func:`covariance_matrix_update` would otherwise allocate it from
+		the heap. Neither must be passed to :c:func:`matrix_free` or
+		:c:func:`covariance_matrix_free`.
+*/
+extern COVARIANCE_MATRIX *covariance_matrix_arena_initialize(ARENA *a,
+	const unsigned short size);
+
+/*
+.. c:function:: extern unsigned short covariance_matrix_update(COVARIANCE_MATRIX *cov);
+
+	Recompute the quantities that a :c:type:`COVARIANCE_MATRIX` caches about
+	itself: its inverse :c:member:`inv` and the logarithm of its determinant
+	:c:member:`logdet`. This should be called any time the elements of the
+	covariance matrix are modified.
+
+	Parameters
+	----------
+	cov : ``COVARIANCE_MATRIX *``
+		The covariance matrix to update. If :c:member:`inv` is ``NULL``, the
+		memory for it will be allocated automatically.
+
+	Returns
+	-------
+	status : ``unsigned short``
+		0u on success. 1u if the matrix is not positive-definite, in which case
+		it is not a valid covariance matrix. :c:member:`logdet` will be ``NAN``
+		in this case, and :c:member:`inv` will be left unchanged if the matrix
+		is singular.
+
+	Notes
+	-----
+	Both quantities are computed from a single Cholesky decomposition
+	:math:`C = LL^T` (see :c:func:`matrix_cholesky`), with
+
+	.. math:: \ln|C| = 2\sum_i \ln L_{ii}
+
+	and :math:`C^{-1} = L^{-T}L^{-1}`, which is exactly symmetric by
+	construction. If the decomposition fails, the inverse is computed with
+	:c:func:`matrix_invert` instead. If TrackStar was linked with a BLAS
+	library, matrices of at least :c:macro:`BLAS_MIN_DIMENSION` rows are
+	decomposed and inverted by LAPACK's ``dpotrf`` and ``dpotri``.
+*/
+extern unsigned short covariance_matrix_update(COVARIANCE_MATRIX *cov);
+
+/*
+.. c:function:: extern void covariance_matrix_whitening(COVARIANCE_MATRIX cov, const unsigned short *order, double *scales);
+
+	Compute the factors by which to scale each component of a vector
+	difference :math:`\Delta` such that the sum of the squares of the scaled
+	components is a lower bound on :math:`\chi^2 = \Delta C^{-1} \Delta^T`.
+
+	Parameters
+	----------
+	cov : ``COVARIANCE_MATRIX``
+		The covariance matrix :math:`C`.
+	order : ``const unsigned short *``
+		The row of ``cov`` corresponding to each element of ``scales``. If
+		``NULL``, the rows are taken in order.
+	scales : ``double *``
+		The ``cov.n_rows`` elements in which to store the scale factors.
+
+	Notes
+	-----
+	Writing :math:`C = DRD`, where :math:`D` is the diagonal matrix of
+	standard deviations and :math:`R` the correlation matrix,
+
+	.. math:: \chi^2 = w R^{-1} w^T \geq \frac{|w|^2}{\lambda_\text{max}(R)}
+
+	with :math:`w_k = \Delta_k / \sigma_k`. The largest eigenvalue of
+	:math:`R` is bounded from above by :math:`\rho = \max_i \sum_j |R_{ij}|`
+	(the Gershgorin circle theorem), so each scale factor is
+	:math:`1 / (\sigma_k \sqrt{\rho})`. For uncorrelated measurements,
+	:math:`\rho = 1` and the bound is exact.
+*/
+extern void covariance_matrix_whitening(COVARIANCE_MATRIX cov,
+	const unsigned short *order, double *scales);
+
 /*
 .. c:function:: extern void covariance_matrix_free(COVARIANCE_MATRIX *cov);
 
@@ -303,6 +471,11 @@ extern MATRIX *matrix_subtract(MATRIX m1, MATRIX m2, MATRIX *result);
 		that
 
 		.. math:: M_{ij} = \sum_k m_{1i,k} m_{2k,j}
+
+	Notes
+	-----
+	If TrackStar was linked with a BLAS library, the product is computed by
+	``dgemm`` when every dimension is at least :c:macro:`BLAS_MIN_DIMENSION`.
 */
 extern MATRIX *matrix_multiply(MATRIX m1, MATRIX m2, MATRIX *result);
 
@@ -330,12 +503,29 @@ extern MATRIX *matrix_multiply(MATRIX m1, MATRIX m2, MATRIX *result);
 
 		where :math:`I` is the identity matrix of the same size as :math:`m`.
 		``NULL`` is returned when :math:`det(m) = 0`, because such matrices
-		are not invertible.
+		are not invertible. In this case, ``result`` is left unmodified.
+
+	Notes
+	-----
+	The inverse is computed by solving :math:`mx = e_j` for each column
+	:math:`e_j` of the identity matrix using a single LU decomposition with
+	partial pivoting (see section 2.3 of Press et al. 2007 [1]_), which
+	requires :math:`O(n^3)` operations in total. If TrackStar was linked with
+	a BLAS library, matrices of at least :c:macro:`BLAS_MIN_DIMENSION` rows
+	are instead inverted by LAPACK's ``dgetrf`` and ``dgetri``.
+
+	.. seealso::
+
+		- ``static MATRIX *LUdecomp(MATRIX m, unsigned short *perm, short *parity);``
+		- ``static void LUsolve(MATRIX LU, double *x);``
 
 	.. note::
 
 		While some non-square matrices have left- and right-inverses, TrackStar
 		only supports inversion of square matrices.
+
+	.. [1] Press, Teukolsky, Vetterling & Flannery (2007), Numerical Recipes,
+		Cambridge University Press
 */
 extern MATRIX *matrix_invert(MATRIX m, MATRIX *result);
 
@@ -380,29 +570,69 @@ extern MATRIX *matrix_transpose(MATRIX m, MATRIX *result);
 
 	Notes
 	-----
-	The determinant is computed through LU decomposition with Crout's
-	algorithm (see section 2.3.1 of Press et al. 2007 [1]_). If it finds that
-	a row exchange would be required to compute the decomposition, then this
-	function falls back on expansion by minors along an ideal row or column,
-	implemented recursively within an iterative sum. The solution for a 2x2
-	matrix is implemented as the base case, with an additional base case for a
-	1x1 matrix included as a failsafe.
-
-	Since the primary use case of this function is symmetric covariance
-	matrices, the vast majority of applications in practice will proceed just
-	fine with an LU decomposition, which will more than make up for any
-	slow-downs encurred by the cases where expansion by minors was necessary.
+	The determinant is computed through LU decomposition with partial
+	pivoting (see section 2.3.1 of Press et al. 2007 [1]_). It is given by the
+	product of the diagonal elements of the upper triangular matrix, with the
+	sign flipped for each row exchange performed during the decomposition.
+	This requires :math:`O(n^3)` operations, and a return value of exactly zero
+	indicates that the matrix is singular. If TrackStar was linked with a BLAS
+	library, matrices of at least :c:macro:`BLAS_MIN_DIMENSION` rows are
+	instead decomposed by LAPACK's ``dgetrf``.
 
 	.. seealso::
 
-		- ``static MATRIX *LUdecomp(MATRIX *m);``
-		- ``static double determinant_expansion_minors(MATRIX m);``
+		- ``static MATRIX *LUdecomp(MATRIX m, unsigned short *perm, short *parity);``
+		- :c:func:`matrix_cholesky` for symmetric positive-definite matrices.
 
 	.. [1] Press, Teukolsky, Vetterling & Flannery (2007), Numerical Recipes,
 		Cambridge University Press
 */
 extern double matrix_determinant(MATRIX m);
 
+/*
+.. c:function:: extern MATRIX *matrix_cholesky(MATRIX m, MATRIX *result);
+
+	Compute the Cholesky decomposition of a symmetric positive-definite
+	matrix.
+
+	Parameters
+	----------
+	m : ``MATRIX``
+		The input matrix. Only the elements along and below the diagonal are
+		accessed; the matrix is assumed to be symmetric.
+	result : ``MATRIX *``
+		A pointer to an already-initialized :c:type:`MATRIX` object to store
+		the decomposition, if applicable. If ``NULL``, memory will be
+		allocated automatically. If a pointer is provided, the same pointer
+		will be returned.
+
+	Returns
+	-------
+	result : ``MATRIX *``
+		The lower triangular matrix :math:`L`, defined such that
+
+		.. math:: LL^T = m
+
+		with all elements above the diagonal equal to zero. ``NULL`` is
+		returned if ``m`` is not positive-definite, in which case the
+		decomposition does not exist. If ``result`` was provided, its contents
+		are undefined in this case.
+
+	Notes
+	-----
+	This function follows the Cholesky-Banachiewicz algorithm (see section
+	2.9 of Press et al. 2007 [1]_), which requires roughly half as many
+	operations as an LU decomposition. It is the primary route by which
+	TrackStar inverts covariance matrices (see
+	:c:func:`covariance_matrix_update`). If TrackStar was linked with a BLAS
+	library, matrices of at least :c:macro:`BLAS_MIN_DIMENSION` rows are
+	instead decomposed by LAPACK's ``dpotrf``.
+
+	.. [1] Press, Teukolsky, Vetterling & Flannery (2007), Numerical Recipes,
+		Cambridge University Press
+*/
+extern MATRIX *matrix_cholesky(MATRIX m, MATRIX *result);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
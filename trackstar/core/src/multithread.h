@@ -32,6 +32,36 @@ inline unsigned short multithreading_enabled(void) {
 	#endif
 }
 
+/*
+.. c:macro:: THREAD_NUMBER()
+
+	The index of the calling thread within the current team of threads, or 0
+	if TrackStar was not linked with the OpenMP library at compile time.
+*/
+#if defined(_OPENMP)
+	#define THREAD_NUMBER() ((unsigned) omp_get_thread_num())
+#else
+	#define THREAD_NUMBER() 0u
+#endif
+
+/*
+.. c:macro:: DEVICE_FUNCTIONS_BEGIN
+.. c:macro:: DEVICE_FUNCTIONS_END
+
+	Enclose the declarations of functions that are called from within
+	OpenMP ``target`` regions, such that they are compiled for the
+	accelerator as well (see :c:func:`loglikelihood_device`). Both expand to
+	nothing unless TrackStar was compiled with ``TRACKSTAR_OFFLOAD`` (see
+	:ref:`offload`).
+*/
+#if defined(TRACKSTAR_OFFLOAD)
+	#define DEVICE_FUNCTIONS_BEGIN _Pragma("omp declare target")
+	#define DEVICE_FUNCTIONS_END _Pragma("omp end declare target")
+#else
+	#define DEVICE_FUNCTIONS_BEGIN
+	#define DEVICE_FUNCTIONS_END
+#endif
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -0,0 +1,151 @@
+/*
+This file is part of the TrackStar package.
+Copyright (C) 2023 James W. Johnson (giganano9@gmail.com)
+License: MIT License. See LICENSE in top-level directory
+at: https://github.com/giganano/TrackStar.git.
+*/
+
+#include <string.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+	#include <x86intrin.h>
+#endif
+#include "profiling.h"
+#include "utils.h"
+
+/* ---------- static function comment headers not duplicated here ---------- */
+static unsigned long long monotonic_nanoseconds(void);
+
+/*
+The counters that this copy of the C library records to, aligned such that
+those of each thread occupy whole cache lines. Replaced by the ones owned by
+``trackstar.core.profiling`` via ``profile_share``.
+*/
+static PROFILE_COUNTERS DEFAULT_COUNTERS[PROFILE_MAX_THREADS]
+	__attribute__((aligned(CACHE_LINE_SIZE)));
+static PROFILE_COUNTERS *COUNTERS = DEFAULT_COUNTERS;
+
+
+/*
+.. c:function:: extern PROFILE_COUNTERS *profile_counters(void);
+
+	Obtain the counters that the ``PROFILE_*`` macros record to.
+
+	Returns
+	-------
+	counters : ``PROFILE_COUNTERS *``
+		The :c:macro:`PROFILE_MAX_THREADS` elements holding the counters of
+		each thread.
+*/
+extern PROFILE_COUNTERS *profile_counters(void) {
+
+	return COUNTERS;
+
+}
+
+
+/*
+.. c:function:: extern void profile_share(PROFILE_COUNTERS *counters);
+
+	Replace the active counters with others.
+
+	Parameters
+	----------
+	counters : ``PROFILE_COUNTERS *``
+		The :c:macro:`PROFILE_MAX_THREADS` elements to record to from now on.
+
+	Notes
+	-----
+	As with the label registry (see :c:func:`label_registry_share`), each of
+	TrackStar's extension modules links its own copy of the C library, so
+	every module records to the counters owned by
+	``trackstar.core.profiling`` from the time it is imported.
+*/
+extern void profile_share(PROFILE_COUNTERS *counters) {
+
+	COUNTERS = counters;
+
+}
+
+
+/*
+.. c:function:: extern void profile_reset(void);
+
+	Set every timer and event count of the active counters to zero.
+*/
+extern void profile_reset(void) {
+
+	memset(COUNTERS, 0, PROFILE_MAX_THREADS * sizeof(PROFILE_COUNTERS));
+
+}
+
+
+/*
+.. c:function:: extern unsigned long long profile_ticks(void);
+
+	Read the fastest available clock.
+
+	Returns
+	-------
+	ticks : ``unsigned long long``
+		The CPU's time-stamp counter on x86 processors, which counts at a
+		constant rate on those made in the last decade, and the time in
+		nanoseconds according to the monotonic clock otherwise.
+*/
+extern unsigned long long profile_ticks(void) {
+
+	#if defined(__x86_64__) || defined(__i386__)
+		return (unsigned long long) __rdtsc();
+	#else
+		return monotonic_nanoseconds();
+	#endif
+
+}
+
+
+/*
+.. c:function:: extern double profile_ticks_per_second(void);
+
+	Measure the rate at which :c:func:`profile_ticks` counts.
+
+	Returns
+	-------
+	rate : ``double``
+		The number of ticks per second, measured against the monotonic clock
+		over 10 milliseconds the first time this function is called.
+*/
+extern double profile_ticks_per_second(void) {
+
+	static double rate = 0;
+	if (!rate) {
+		const unsigned long long start = monotonic_nanoseconds();
+		const unsigned long long first = profile_ticks();
+		unsigned long long now;
+		do {
+			now = monotonic_nanoseconds();
+		} while (now - start < 10000000ull);
+		rate = 1e9 * (profile_ticks() - first) / (now - start);
+	} else {}
+	return rate;
+
+}
+
+
+/*
+.. c:function:: static unsigned long long monotonic_nanoseconds(void);
+
+	Read the monotonic clock.
+
+	Returns
+	-------
+	ns : ``unsigned long long``
+		The time in nanoseconds since some arbitrary starting point.
+*/
+static unsigned long long monotonic_nanoseconds(void) {
+
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return 1000000000ull * (unsigned long long) t.tv_sec + (
+		unsigned long long) t.tv_nsec;
+
+}
@@ -0,0 +1,240 @@
+/*
+This file is part of the TrackStar package.
+Copyright (C) 2023 James W. Johnson (giganano9@gmail.com)
+License: MIT License. See LICENSE in top-level directory
+at: https://github.com/giganano/TrackStar.git.
+
+**Source File**: ``trackstar/core/src/profiling.c``
+
+Instrumentation of the likelihood calculation, which is compiled in only if
+``TRACKSTAR_PROFILE`` is defined (see :ref:`profiling`). Otherwise, the
+``PROFILE_*`` macros expand to nothing, and neither the counters below nor
+the arguments to the macros are ever touched.
+*/
+
+#ifndef PROFILING_H
+#define PROFILING_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "multithread.h"
+
+/*
+.. c:macro:: PROFILE_MAX_THREADS
+
+	``64u``. The number of threads whose counters are kept separately.
+	Threads with larger numbers share counters with a smaller one, in which
+	case their counts may be lost to the race between them.
+*/
+#define PROFILE_MAX_THREADS 64u
+
+/*
+.. c:macro:: PROFILE_LIKELIHOOD
+.. c:macro:: PROFILE_TRACK_PROJECTION
+.. c:macro:: PROFILE_DATA
+.. c:macro:: PROFILE_CHI_SQUARED
+.. c:macro:: PROFILE_CORRECTIVE_FACTOR
+.. c:macro:: PROFILE_QUADRATURE
+.. c:macro:: PROFILE_COVARIANCE_UPDATE
+.. c:macro:: PROFILE_N_TIMERS
+
+	The indices of the timers within :c:member:`PROFILE_COUNTERS.ticks`:
+
+	- ``0u``: Whole likelihood calculations, on the calling thread.
+	- ``1u``: Projecting the track onto the quantities measured for a group
+	  of data (see ``track_view_project`` in ``likelihood.c``).
+	- ``2u``: The work on individual data within each parallel region, on
+	  the thread that does it. Differences between threads indicate an
+	  imbalance in the work assigned to them.
+	- ``3u``: The :math:`\chi^2` kernels (see :c:func:`chi_squared_points`).
+	- ``4u``: The line segment corrective factors.
+	- ``5u``: Numerical integration with :c:func:`quad_batch`.
+	- ``6u``: :c:func:`covariance_matrix_update`, which runs whenever the
+	  covariance matrix of a datum is set.
+
+	Timers 1 through 5 run within timer 0 and timers 3 through 5 within
+	timer 2, so each is a part of the one it runs within.
+	:c:macro:`PROFILE_N_TIMERS` is the number of timers.
+*/
+#define PROFILE_LIKELIHOOD 0u
+#define PROFILE_TRACK_PROJECTION 1u
+#define PROFILE_DATA 2u
+#define PROFILE_CHI_SQUARED 3u
+#define PROFILE_CORRECTIVE_FACTOR 4u
+#define PROFILE_QUADRATURE 5u
+#define PROFILE_COVARIANCE_UPDATE 6u
+#define PROFILE_N_TIMERS 7u
+
+/*
+.. c:macro:: PROFILE_KERNEL_EVALUATIONS
+.. c:macro:: PROFILE_QUAD_REFINEMENTS
+.. c:macro:: PROFILE_POINTS_PRUNED
+.. c:macro:: PROFILE_BYTES_ALLOCATED
+.. c:macro:: PROFILE_N_EVENTS
+
+	The indices of the event counts within
+	:c:member:`PROFILE_COUNTERS.events`:
+
+	- ``0u``: The number of values of :math:`\chi^2` computed, one per
+	  datum and point along the track.
+	- ``1u``: The number of times an integral was refined by doubling the
+	  number of quadrature bins.
+	- ``2u``: The number of points along the track skipped by pruning,
+	  whether individually or as part of a whole block.
+	- ``3u``: The number of bytes allocated for matrices and for the scratch
+	  memory of the likelihood calculation.
+
+	:c:macro:`PROFILE_N_EVENTS` is the number of event counts.
+*/
+#define PROFILE_KERNEL_EVALUATIONS 0u
+#define PROFILE_QUAD_REFINEMENTS 1u
+#define PROFILE_POINTS_PRUNED 2u
+#define PROFILE_BYTES_ALLOCATED 3u
+#define PROFILE_N_EVENTS 4u
+
+/*
+.. c:macro:: PROFILE_START(timer)
+.. c:macro:: PROFILE_STOP(timer)
+
+	Start and stop one of the timers (e.g. :c:macro:`PROFILE_DATA`) of the
+	calling thread. Both must appear in the same scope, and a timer may be
+	started only once within it.
+*/
+
+/*
+.. c:macro:: PROFILE_COUNT(event, n)
+
+	Add ``n`` to one of the event counts (e.g.
+	:c:macro:`PROFILE_KERNEL_EVALUATIONS`) of the calling thread. ``n`` is
+	not evaluated unless ``TRACKSTAR_PROFILE`` is defined.
+*/
+#if defined(TRACKSTAR_PROFILE)
+	#define PROFILE_START(timer) \
+		const unsigned long long profile_start_##timer = profile_ticks()
+	#define PROFILE_STOP(timer) \
+		profile_counters()[THREAD_NUMBER() % PROFILE_MAX_THREADS].ticks[ \
+			timer] += profile_ticks() - profile_start_##timer
+	#define PROFILE_COUNT(event, n) \
+		profile_counters()[THREAD_NUMBER() % PROFILE_MAX_THREADS].events[ \
+			event] += (unsigned long long) (n)
+#else
+	#define PROFILE_START(timer)
+	#define PROFILE_STOP(timer)
+	#define PROFILE_COUNT(event, n)
+#endif /* TRACKSTAR_PROFILE */
+
+typedef struct profile_counters {
+
+	/*
+	.. c:type:: PROFILE_COUNTERS
+
+		The timers and event counts of one thread.
+
+		.. c:member:: unsigned long long ticks[PROFILE_N_TIMERS]
+
+			The time spent within each timer, in units of
+			:c:func:`profile_ticks`.
+
+		.. c:member:: unsigned long long events[PROFILE_N_EVENTS]
+
+			The event counts.
+
+		.. c:member:: unsigned long long padding[]
+
+			Unused. Rounds the size of the struct up to two cache lines, such
+			that threads never write to the same cache line.
+	*/
+
+	unsigned long long ticks[PROFILE_N_TIMERS];
+	unsigned long long events[PROFILE_N_EVENTS];
+	unsigned long long padding[16u - PROFILE_N_TIMERS - PROFILE_N_EVENTS];
+
+} PROFILE_COUNTERS;
+
+/*
+.. c:function:: extern PROFILE_COUNTERS *profile_counters(void);
+
+	Obtain the counters that the ``PROFILE_*`` macros record to.
+
+	Returns
+	-------
+	counters : ``PROFILE_COUNTERS *``
+		The :c:macro:`PROFILE_MAX_THREADS` elements holding the counters of
+		each thread.
+*/
+extern PROFILE_COUNTERS *profile_counters(void);
+
+/*
+.. c:function:: extern void profile_share(PROFILE_COUNTERS *counters);
+
+	Replace the active counters with others.
+
+	Parameters
+	----------
+	counters : ``PROFILE_COUNTERS *``
+		The :c:macro:`PROFILE_MAX_THREADS` elements to record to from now on.
+
+	Notes
+	-----
+	As with the label registry (see :c:func:`label_registry_share`), each of
+	TrackStar's extension modules links its own copy of the C library, so
+	every module records to the counters owned by
+	``trackstar.core.profiling`` from the time it is imported.
+*/
+extern void profile_share(PROFILE_COUNTERS *counters);
+
+/*
+.. c:function:: extern void profile_reset(void);
+
+	Set every timer and event count of the active counters to zero.
+*/
+extern void profile_reset(void);
+
+/*
+.. c:function:: extern unsigned long long profile_ticks(void);
+
+	Read the fastest available clock.
+
+	Returns
+	-------
+	ticks : ``unsigned long long``
+		The CPU's time-stamp counter on x86 processors, which counts at a
+		constant rate on those made in the last decade, and the time in
+		nanoseconds according to the monotonic clock otherwise.
+*/
+extern unsigned long long profile_ticks(void);
+
+/*
+.. c:function:: extern double profile_ticks_per_second(void);
+
+	Measure the rate at which :c:func:`profile_ticks` counts.
+
+	Returns
+	-------
+	rate : ``double``
+		The number of ticks per second, measured against the monotonic clock
+		over 10 milliseconds the first time this function is called.
+*/
+extern double profile_ticks_per_second(void);
+
+/*
+.. c:function:: inline unsigned short profiling_enabled();
+
+	Returns 1 if ``TRACKSTAR_PROFILE`` was defined at compile time, such that
+	the ``PROFILE_*`` macros record to the counters, and 0 otherwise.
+*/
+inline unsigned short profiling_enabled(void) {
+	#if defined(TRACKSTAR_PROFILE)
+		return 1u;
+	#else
+		return 0u;
+	#endif
+}
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* PROFILING_H */
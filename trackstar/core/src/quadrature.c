@@ -7,17 +7,15 @@ at: https://github.com/giganano/TrackStar.git.
 
 #include <stdlib.h>
 #include "quadrature.h"
+#include "profiling.h"
 #include "utils.h"
 
 /* ---------- static function comment headers not duplicated here ---------- */
-static double simpsons_rule(double (*func)(double *), const double lower,
-	const double upper, const unsigned long n_bins, const double *extra_args,
-	const unsigned short n_extra_args);
 static double trapezoid_rule(double (*func)(double *), const double lower,
-	const double upper, const unsigned long n_bins, const double *extra_args,
-	const unsigned short n_extra_args);
-static double *bin_edges(const double start, const double stop, 
-	const unsigned long n_bins);
+	const double upper, const unsigned long n_bins, double *args);
+static double refine_trapezoid_rule(double (*func)(double *),
+	const double lower, const double upper, const unsigned long n_bins,
+	const double coarse, double *args);
 static double absval(double x);
 static signed short sign(double x);
 
@@ -42,50 +40,153 @@ static signed short sign(double x);
 
 	Notes
 	-----
+	This is equivalent to calling :c:func:`quad_batch` with a single integral
+	and no workspace.
+
 	In the current version of TrackStar, this function is called for only one
-	purpose: evaluating corrective factors for the lengths of each individual
-	line segment that make up a track (see science documentation for further
-	details). Therefore, in practice, the functional form of the integrand is
-	known, and it is smooth. Although it does have an analytic solution, it is
-	an example of the rare case where the analytic form is not numerically
-	stable while the numerical integral is. In this instance, the issue arises
-	because the solution involves the product of an extremely large number and
-	an extremely small number, both of which challenge the limits of double
-	floating point precision.
+	purpose: validating the closed-form evaluation of the corrective factors
+	for the lengths of each individual line segment that make up a track (see
+	science documentation for further details), when the user passes
+	``use_line_segment_corrections = "quad"``. The closed form is rewritten
+	in terms of the scaled complementary error function (see :c:func:`erfcx`)
+	to avoid the product of an extremely large number and an extremely small
+	number that the naive analytic solution involves.
 */
 extern unsigned short quad(INTEGRAL *intgrl) {
 
-	unsigned long n = (*intgrl).n_min;
-	if (n % 2ul) n++;
-	double old_int = 0, new_int;
+	return quad_batch(intgrl, 1ul, NULL);
 
-	do {
+}
+
+
+/*
+.. c:function:: extern unsigned short quad_batch(INTEGRAL *intgrls, const unsigned long n_integrals, double *workspace);
 
-		new_int = simpsons_rule((*intgrl).func, (*intgrl).lower,
-			(*intgrl).upper, n, (*intgrl).extra_args, (*intgrl).n_extra_args);
-		if (new_int) {
-			intgrl -> error = absval(old_int / new_int - 1);
-		} else{
-			/* avoid numerical errors from division by zero. */
-			intgrl -> error = 1;
+	Evaluate several integrals numerically in a single sweep over the
+	refinement levels.
+
+	Parameters
+	----------
+	intgrls : ``INTEGRAL *``
+		The integrals to evaluate. Each may have its own integrand, bounds,
+		tolerance, and extra arguments.
+	n_integrals : ``const unsigned long``
+		The number of elements in ``intgrls``.
+	workspace : ``double *``
+		Scratch memory with room for at least
+		``QUAD_WORKSPACE_SIZE(n_integrals, n_extra_args)`` elements, where
+		``n_extra_args`` is the largest :c:member:`INTEGRAL.n_extra_args` of
+		``intgrls``. If ``NULL``, it will be allocated and freed internally.
+
+	Returns
+	-------
+	0u if every integral has converged. 1u if the maximum number of iterations
+	was reached for at least one integral before its error converged within the
+	specified tolerance. The result, numerical error, and number of iterations
+	will be stored within each element of ``intgrls``.
+
+	Notes
+	-----
+	Each integral is approximated by Simpson's Rule, computed from the
+	Trapezoid Rule at :math:`N` and :math:`N/2` bins as
+	:math:`S_N = (4T_N - T_{N/2}) / 3` (see Chapter 4 of Press et al. 2007
+	[1]_), with :math:`N` doubling from :c:member:`INTEGRAL.n_min` until
+	consecutive values of :math:`S_N` agree to within
+	:c:member:`INTEGRAL.tolerance`. Because the bin edges at :math:`N`
+	bins include those at :math:`N/2`, each refinement evaluates the integrand
+	only at the :math:`N/2` new midpoints and reuses the previous level's sum.
+	With a caller-provided workspace, this function does not allocate memory.
+
+	.. [1] Press, Teukolsky, Vetterling, Flannery, 2007, Numerical Recipes,
+		Cambridge University Press
+*/
+extern unsigned short quad_batch(INTEGRAL *intgrls,
+	const unsigned long n_integrals, double *workspace) {
+
+	PROFILE_START(PROFILE_QUADRATURE);
+	unsigned long i;
+	unsigned short max_extra_args = 0u, status = 0u;
+	for (i = 0ul; i < n_integrals; i++) {
+		if (intgrls[i].n_extra_args > max_extra_args) {
+			max_extra_args = intgrls[i].n_extra_args;
+		} else {}
+	}
+	double *ws = workspace;
+	if (ws == NULL) ws = (double *) malloc (
+		QUAD_WORKSPACE_SIZE(n_integrals, max_extra_args) * sizeof(double));
+
+	/*
+	The trapezoid rule at the current number of bins of each integral and the
+	previous Simpson's rule estimate, followed by the arguments to pass to the
+	integrand. While an integral is being refined, its iters member holds the
+	number of bins to refine it to next.
+	*/
+	double *trapezoid = ws, *simpson = ws + n_integrals;
+	double *args = ws + 2ul * n_integrals;
+
+	for (i = 0ul; i < n_integrals; i++) {
+		INTEGRAL *intgrl = &intgrls[i];
+		unsigned long n = (*intgrl).n_min;
+		if (n % 2ul) n++;
+		for (unsigned short j = 0u; j < (*intgrl).n_extra_args; j++) {
+			args[j + 1u] = (*intgrl).extra_args[j];
 		}
-		old_int = new_int;
-		n *= 2ul;
+		trapezoid[i] = trapezoid_rule((*intgrl).func, (*intgrl).lower,
+			(*intgrl).upper, n / 2ul, args);
+		simpson[i] = 0;
+		intgrl -> iters = n;
+		intgrl -> error = 1;
+	}
 
-	} while ((*intgrl).error > (*intgrl).tolerance && n < (*intgrl).n_max);
+	unsigned long n_active;
+	do {
+		n_active = 0ul;
+		for (i = 0ul; i < n_integrals; i++) {
+			INTEGRAL *intgrl = &intgrls[i];
+			unsigned long n_first = (*intgrl).n_min + (*intgrl).n_min % 2ul;
+
+			/* Always refine at least once, as a do-while would */
+			if ((*intgrl).iters != n_first && !(
+				(*intgrl).error > (*intgrl).tolerance &&
+				(*intgrl).iters < (*intgrl).n_max)) continue;
+
+			for (unsigned short j = 0u; j < (*intgrl).n_extra_args; j++) {
+				args[j + 1u] = (*intgrl).extra_args[j];
+			}
+			double coarse = trapezoid[i];
+			trapezoid[i] = refine_trapezoid_rule((*intgrl).func,
+				(*intgrl).lower, (*intgrl).upper, (*intgrl).iters, coarse,
+				args);
+			double new_int = (4 * trapezoid[i] - coarse) / 3;
+			if (new_int) {
+				intgrl -> error = absval(simpson[i] / new_int - 1);
+			} else {
+				/* avoid numerical errors from division by zero. */
+				intgrl -> error = 1;
+			}
+			simpson[i] = new_int;
+			intgrl -> iters *= 2ul;
+			n_active++;
+		}
+		PROFILE_COUNT(PROFILE_QUAD_REFINEMENTS, n_active);
+	} while (n_active);
 
-	intgrl -> result = new_int;
-	intgrl -> iters = n;
-	return (*intgrl).error > (*intgrl).tolerance;
+	for (i = 0ul; i < n_integrals; i++) {
+		intgrls[i].result = simpson[i];
+		status |= intgrls[i].error > intgrls[i].tolerance;
+	}
+	if (workspace == NULL) free(ws);
+	PROFILE_STOP(PROFILE_QUADRATURE);
+	return status;
 
 }
 
 
 /*
-.. c:function:: static double simpsons_rule(double (*func)(double *), const double lower, const double upper, const unsigned long n_bins, const double *extra_args, const unsigned long n_extra_args);
+.. c:function:: extern double gauss_legendre(double (*func)(double *), const double lower, const double upper, double *args);
 
-	Evaluate a Reimann sum according to Simpson's Rule (see Chapter 4 of Press
-	et al. 2007 [1]_).
+	Evaluate an integral with the fixed, 12-point Gauss-Legendre rule (see
+	Chapter 4 of Press et al. 2007 [1]_).
 
 	Parameters
 	----------
@@ -93,42 +194,56 @@ extern unsigned short quad(INTEGRAL *intgrl) {
 		A pointer to a function that accepts a double pointer as its only
 		argument. The first argument should be the one over which the integral
 		is being evaluated.
-	lower : ``double``
+	lower : ``const double``
 		The lower bound of the integral.
-	upper : ``double``
+	upper : ``const double``
 		The upper bound of the integral.
-	n_bins : ``unsigned long``
-		The number of quadrature bins in the Reimann sum.
-	extra_args : ``double *``
-		Any extra values to be passed to the integrand function.
-	n_extra_args : ``unsigned short``
-		The number of elements in ``extra_args``.
+	args : ``double *``
+		The arguments to pass to ``func``. The first element is overwritten
+		with each abscissa in turn, and any extra arguments should follow it.
 
 	Returns
 	-------
 	s : ``double``
-		The value of the Reimann sum according to Simpson's Rule, which can be
-		understood as an extension of Trapezoid Rule.
+		The approximated value of the integral.
+
+	Notes
+	-----
+	Unlike :c:func:`quad`, this routine neither allocates memory nor
+	estimates its own error. It is exact for polynomials up to degree 23, and
+	is intended for smooth integrands that are known to be well approximated
+	by one.
 
 	.. [1] Press, Teukolsky, Vetterling, Flannery, 2007, Numerical Recipes,
 		Cambridge University Press
 */
-static double simpsons_rule(double (*func)(double *), const double lower,
-	const double upper, const unsigned long n_bins, const double *extra_args,
-	const unsigned short n_extra_args) {
-
-	return (
-		4 * trapezoid_rule(
-			func, lower, upper, n_bins, extra_args, n_extra_args) -
-		trapezoid_rule(
-			func, lower, upper, n_bins / 2ul, extra_args, n_extra_args)
-	) / 3;
+extern double gauss_legendre(double (*func)(double *),
+	const double lower, const double upper, double *args) {
+
+	/* The positive abscissas on [-1, 1] and their weights */
+	static const double x[6] = {
+		0.1252334085114689, 0.3678314989981802, 0.5873179542866175,
+		0.7699026741943047, 0.9041172563704749, 0.9815606342467192
+	};
+	static const double w[6] = {
+		0.2491470458134028, 0.2334925365383548, 0.2031674267230659,
+		0.1600783285433462, 0.1069393259953184, 0.0471753363865118
+	};
+	double midpoint = (upper + lower) / 2, halfwidth = (upper - lower) / 2;
+	double total = 0;
+	for (unsigned short i = 0u; i < 6u; i++) {
+		args[0] = midpoint - halfwidth * x[i];
+		total += w[i] * func(args);
+		args[0] = midpoint + halfwidth * x[i];
+		total += w[i] * func(args);
+	}
+	return halfwidth * total;
 
 }
 
 
 /*
-.. c:function:: static double trapezoid_rule(double (*func)(double *), const double lower, const double upper, const unsigned long n_bins, const double *extra_args, const unsigned long n_extra_args);
+.. c:function:: static double trapezoid_rule(double (*func)(double *), const double lower, const double upper, const unsigned long n_bins, double *args);
 
 	Evaluate a Reimann sum according to Trapezoid Rule (see Chapter 4 of Press
 	et al. 2007 [1]_).
@@ -145,10 +260,9 @@ static double simpsons_rule(double (*func)(double *), const double lower,
 		The upper bound of the integral.
 	n_bins : ``unsigned long``
 		The number of quadrature bins in the Reimann sum.
-	extra_args : ``double *``
-		Any extra values to be passed to the integrand function.
-	n_extra_args : ``unsigned short``
-		The number of elements in ``extra_args``.
+	args : ``double *``
+		The arguments to pass to ``func``. The first element is overwritten
+		with each bin edge in turn, and any extra arguments should follow it.
 
 	Returns
 	-------
@@ -161,59 +275,62 @@ static double simpsons_rule(double (*func)(double *), const double lower,
 		Cambridge University Press
 */
 static double trapezoid_rule(double (*func)(double *), const double lower,
-	const double upper, const unsigned long n_bins, const double *extra_args,
-	const unsigned short n_extra_args) {
+	const double upper, const unsigned long n_bins, double *args) {
 
 	double bin_width = (upper - lower) / n_bins;
-	double *x = bin_edges(lower, upper, n_bins);
-	double *funcofx = (double *) malloc ((n_bins + 1ul) * sizeof(double));
-	double *args = (double *) malloc ((n_extra_args + 1u) * sizeof(double));
-	for (unsigned short i = 0ul; i < n_extra_args; i++) {
-		args[i + 1u] = extra_args[i];
-	}
-	for (unsigned long i = 0ul; i <= n_bins; i++) {
-		args[0] = x[i];
-		funcofx[i] = func(args);
+	args[0] = lower;
+	double total = func(args) / 2;
+	for (unsigned long i = 1ul; i < n_bins; i++) {
+		args[0] = lower + i * bin_width;
+		total += func(args);
 	}
-	double total = sum(funcofx, n_bins + 1ul);
-	total -= (funcofx[0] + funcofx[n_bins]) / 2;
-	free(x);
-	free(args);
-	free(funcofx);
+	args[0] = upper;
+	total += func(args) / 2;
 	return bin_width * total;
 
 }
 
 
 /*
-.. c:function:: static double bin_edges(const double start, const double stop, const unsigned long n_bins);
+.. c:function:: static double refine_trapezoid_rule(double (*func)(double *), const double lower, const double upper, const unsigned long n_bins, const double coarse, double *args);
 
-	Compute the desired bin edges for some known range of values and known
-	number of bins.
+	Evaluate a Reimann sum according to Trapezoid Rule from the same sum with
+	half as many bins.
 
 	Parameters
 	----------
-	start : ``double``
-		The bottom-most edge of the bins.
-	stop : ``double``
-		The upper-most edge of the bins.
+	func : ``double (*)(double *)``
+		A pointer to a function that accepts a double pointer as its only
+		argument. The first argument should be the one over which the integral
+		is being evaluated.
+	lower : ``double``
+		The lower bound of the integral.
+	upper : ``double``
+		The upper bound of the integral.
 	n_bins : ``unsigned long``
-		The number of bins to separate the range between ``start`` and ``stop``
-		into.
+		The number of quadrature bins in the refined sum. Must be even.
+	coarse : ``double``
+		The value of the Trapezoid Rule with ``n_bins / 2`` bins.
+	args : ``double *``
+		The arguments to pass to ``func``, as in :c:func:`trapezoid_rule`.
 
 	Returns
 	-------
-	arr : ``double *``
-		A pointer to the array of bin edges, in ascending order.
-		Has length ``n_bins + 1``.
+	s : ``double``
+		The value of the Reimann sum according to Trapezoid rule with
+		``n_bins`` bins. Only the ``n_bins / 2`` new midpoints are evaluated.
 */
-static double *bin_edges(const double start, const double stop, 
-	const unsigned long n_bins) {
+static double refine_trapezoid_rule(double (*func)(double *),
+	const double lower, const double upper, const unsigned long n_bins,
+	const double coarse, double *args) {
 
-	double *arr = (double *) malloc ((n_bins + 1l) * sizeof(double));
-	double dx = (stop - start) / n_bins;
-	for (unsigned long i = 0ul; i <= n_bins; i++) arr[i] = start + i * dx;
-	return arr;
+	double bin_width = (upper - lower) / n_bins;
+	double total = 0;
+	for (unsigned long i = 1ul; i < n_bins; i += 2ul) {
+		args[0] = lower + i * bin_width;
+		total += func(args);
+	}
+	return coarse / 2 + bin_width * total;
 
 }
 
@@ -14,6 +14,18 @@ at: https://github.com/giganano/TrackStar.git.
 extern "C" {
 #endif /* __cplusplus */
 
+#include "multithread.h"
+
+/*
+.. c:macro:: QUAD_WORKSPACE_SIZE(n_integrals, n_extra_args)
+
+	The number of elements of scratch memory that :c:func:`quad_batch`
+	requires to evaluate ``n_integrals`` integrals whose integrands each take
+	at most ``n_extra_args`` extra arguments.
+*/
+#define QUAD_WORKSPACE_SIZE(n_integrals, n_extra_args) \
+	(2ul * (n_integrals) + (n_extra_args) + 1ul)
+
 typedef struct integral {
 
 	/*
@@ -25,7 +37,8 @@ typedef struct integral {
 
 			In the current version of trackstar, quadrature is required for
 			only purpose: correction for the finite lengths of line segments
-			along the track (see notes for function ``quad``).
+			along the track (see notes for functions ``quad`` and
+			``gauss_legendre``).
 
 		.. c:member:: double (*func)(double *)
 
@@ -111,19 +124,104 @@ typedef struct integral {
 
 	Notes
 	-----
+	This is equivalent to calling :c:func:`quad_batch` with a single integral
+	and no workspace.
+
 	In the current version of TrackStar, this function is called for only one
-	purpose: evaluating corrective factors for the lengths of each individual
-	line segment that make up a track (see science documentation for further
-	details). Therefore, in practice, the functional form of the integrand is
-	known, and it is smooth. Although it does have an analytic solution, it is
-	an example of the rare case where the analytic form is not numerically
-	stable while the numerical integral is. In this instance, the issue arises
-	because the solution involves the product of an extremely large number and
-	an extremely small number, both of which challenge the limits of double
-	floating point precision.
+	purpose: validating the closed-form evaluation of the corrective factors
+	for the lengths of each individual line segment that make up a track (see
+	science documentation for further details), when the user passes
+	``use_line_segment_corrections = "quad"``. The closed form is rewritten
+	in terms of the scaled complementary error function (see :c:func:`erfcx`)
+	to avoid the product of an extremely large number and an extremely small
+	number that the naive analytic solution involves.
 */
 extern unsigned short quad(INTEGRAL *intgrl);
 
+/*
+.. c:function:: extern unsigned short quad_batch(INTEGRAL *intgrls, const unsigned long n_integrals, double *workspace);
+
+	Evaluate several integrals numerically in a single sweep over the
+	refinement levels.
+
+	Parameters
+	----------
+	intgrls : ``INTEGRAL *``
+		The integrals to evaluate. Each may have its own integrand, bounds,
+		tolerance, and extra arguments.
+	n_integrals : ``const unsigned long``
+		The number of elements in ``intgrls``.
+	workspace : ``double *``
+		Scratch memory with room for at least
+		``QUAD_WORKSPACE_SIZE(n_integrals, n_extra_args)`` elements, where
+		``n_extra_args`` is the largest :c:member:`INTEGRAL.n_extra_args` of
+		``intgrls``. If ``NULL``, it will be allocated and freed internally.
+
+	Returns
+	-------
+	0u if every integral has converged. 1u if the maximum number of iterations
+	was reached for at least one integral before its error converged within the
+	specified tolerance. The result, numerical error, and number of iterations
+	will be stored within each element of ``intgrls``.
+
+	Notes
+	-----
+	Each integral is approximated by Simpson's Rule, computed from the
+	Trapezoid Rule at :math:`N` and :math:`N/2` bins as
+	:math:`S_N = (4T_N - T_{N/2}) / 3` (see Chapter 4 of Press et al. 2007
+	[1]_), with :math:`N` doubling from :c:member:`INTEGRAL.n_min` until
+	consecutive values of :math:`S_N` agree to within
+	:c:member:`INTEGRAL.tolerance`. Because the bin edges at :math:`N`
+	bins include those at :math:`N/2`, each refinement evaluates the integrand
+	only at the :math:`N/2` new midpoints and reuses the previous level's sum.
+	With a caller-provided workspace, this function does not allocate memory.
+
+	.. [1] Press, Teukolsky, Vetterling, Flannery, 2007, Numerical Recipes,
+		Cambridge University Press
+*/
+extern unsigned short quad_batch(INTEGRAL *intgrls,
+	const unsigned long n_integrals, double *workspace);
+
+/*
+.. c:function:: extern double gauss_legendre(double (*func)(double *), const double lower, const double upper, double *args);
+
+	Evaluate an integral with the fixed, 12-point Gauss-Legendre rule (see
+	Chapter 4 of Press et al. 2007 [1]_).
+
+	Parameters
+	----------
+	func : ``double (*)(double *)``
+		A pointer to a function that accepts a double pointer as its only
+		argument. The first argument should be the one over which the integral
+		is being evaluated.
+	lower : ``const double``
+		The lower bound of the integral.
+	upper : ``const double``
+		The upper bound of the integral.
+	args : ``double *``
+		The arguments to pass to ``func``. The first element is overwritten
+		with each abscissa in turn, and any extra arguments should follow it.
+
+	Returns
+	-------
+	s : ``double``
+		The approximated value of the integral.
+
+	Notes
+	-----
+	Unlike :c:func:`quad`, this routine neither allocates memory nor
+	estimates its own error. It is exact for polynomials up to degree 23, and
+	is intended for smooth integrands that are known to be well approximated
+	by one.
+
+	.. [1] Press, Teukolsky, Vetterling, Flannery, 2007, Numerical Recipes,
+		Cambridge University Press
+*/
+DEVICE_FUNCTIONS_BEGIN
+extern double gauss_legendre(double (*func)(double *),
+	const double lower, const double upper, double *args);
+DEVICE_FUNCTIONS_END
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -6,9 +6,34 @@ at: https://github.com/giganano/TrackStar.git.
 */
 
 #include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <sys/mman.h>
 #include "sample.h"
 #include "datum.h"
+#include "matrix.h"
+#include "arena.h"
+#include "labels.h"
 #include "utils.h"
+#include "debug.h"
+
+/* ---------- Static function comment headers not duplicated here ---------- */
+static signed long packed_group_index(PACKED_SAMPLE p, DATUM d);
+static void packed_group_fill(PACKED_GROUP *g, DATUM d,
+	const unsigned long position);
+static void packed_group_copy(PACKED_GROUP *copy, PACKED_GROUP g,
+	const unsigned long first, const unsigned long last);
+static DATUM *unpack_datum(ARENA *a, PACKED_GROUP g,
+	const unsigned long position);
+static unsigned short condition_satisfied(const double x,
+	const unsigned short condition_indicator, const double value);
+static void packed_group_split(PACKED_SAMPLE *p, const unsigned long index);
+static int shared_covariance_compare(const void *a, const void *b);
+static void packed_group_gather(PACKED_GROUP *sub, PACKED_GROUP g,
+	const unsigned long *assignment, const unsigned long which,
+	const unsigned long n_data);
+static void covariance_matrix_reuse(COVARIANCE_MATRIX *cov,
+	const COVARIANCE_MATRIX *previous);
 
 
 /*
@@ -28,7 +53,10 @@ extern SAMPLE *sample_initialize(void) {
 
 	SAMPLE *s = (SAMPLE *) malloc (sizeof(SAMPLE));
 	s -> n_vectors = 0ul;
+	s -> capacity = 0ul;
 	s -> data = NULL;
+	s -> arena = NULL;
+	s -> packed = NULL;
 	return s;
 
 }
@@ -57,7 +85,9 @@ extern SAMPLE *sample_initialize(void) {
 	``__dealloc__`` functions that do free up the required blocks of memory.
 	Namely, this function does not call :c:func:`datum_free` for each
 	individual :c:type:`DATUM` stored by ``s``, because Cython calls
-	``datum.__dealloc__`` with the same addresses as ``sample.data``.
+	``datum.__dealloc__`` with the same addresses as ``sample.data``. Data
+	allocated from the sample's :c:member:`SAMPLE.arena` are not wrapped by
+	python objects that own them, so they are released along with it.
 */
 extern void sample_free(SAMPLE *s) {
 
@@ -70,6 +100,8 @@ extern void sample_free(SAMPLE *s) {
 		*/
 
 		if ((*s).data != NULL) free(s -> data);
+		if ((*s).packed != NULL) packed_sample_free(s -> packed);
+		arena_free(s -> arena);
 		free(s);
 
 	} else {}
@@ -89,6 +121,10 @@ extern void sample_free(SAMPLE *s) {
 	objects created in TrackStar's C library or ``cdef``'ed instances created
 	in Cython that are not returned to the user.
 
+	If the sample has an arena (see :c:member:`SAMPLE.arena`), its data are
+	assumed to have been allocated from it, and they are released with a
+	handful of calls to ``free`` rather than several per datum.
+
 	.. seealso::
 
 		See "Notes" under function :c:func:`sample_free` for details on the
@@ -98,10 +134,15 @@ extern void sample_free_everything(SAMPLE *s) {
 
 	if (s != NULL) {
 
-		for (unsigned long i = 0ul; i < (*s).n_vectors; i++) {
-			datum_free_everything(s -> data[i]);
+		if ((*s).arena != NULL) {
+			arena_free(s -> arena);
+		} else {
+			for (unsigned long i = 0ul; i < (*s).n_vectors; i++) {
+				datum_free_everything(s -> data[i]);
+			}
 		}
 		free(s -> data);
+		if ((*s).packed != NULL) packed_sample_free(s -> packed);
 		free(s);
 
 	} else {}
@@ -121,16 +162,117 @@ extern void sample_free_everything(SAMPLE *s) {
 		data vectors already added to the sample.
 	d : ``DATUM *``
 		The vector to be included in this sample.
+
+	Notes
+	-----
+	The capacity of :c:member:`SAMPLE.data` doubles whenever it runs out,
+	so building a sample of :math:`N` data copies :math:`\mathcal{O}(N)`
+	pointers in total rather than :math:`\mathcal{O}(N^2)`.
 */
 extern void sample_add_datum(SAMPLE *s, DATUM *d) {
 
-	if ((*s).data == NULL) {
-		s -> data = (DATUM **) malloc (sizeof(DATUM *));
-	} else {
+	if ((*s).n_vectors == (*s).capacity) {
+		s -> capacity = (*s).capacity ? 2ul * (*s).capacity : 16ul;
 		s -> data = (DATUM **) realloc (s -> data,
-			((*s).n_vectors + 1ul) * sizeof(DATUM *));
-	}
+			(*s).capacity * sizeof(DATUM *));
+	} else {}
 	s -> data[s -> n_vectors++] = d;
+	sample_invalidate(s);
+
+}
+
+
+/*
+.. c:function:: extern SAMPLE *sample_from_arrays(const double *values, const double *errors, const unsigned char *mask, char **labels, const unsigned long n_data, const unsigned short n_labels);
+
+	Construct a :c:type:`SAMPLE` from contiguous arrays of measurements and
+	their uncertainties in a single pass.
+
+	Parameters
+	----------
+	values : ``const double *``
+		The measurements, with the ``k``'th quantity measured for the ``i``'th
+		datum at ``values[i * n_labels + k]``. ``NAN`` marks a quantity that
+		was not measured for a given datum.
+	errors : ``const double *``
+		The uncertainties, laid out like ``values``. Each datum's covariance
+		matrix is diagonal, with the squares of these values along the
+		diagonal. May be ``NULL``, in which case, and wherever an uncertainty
+		is ``NAN``, the variance is 1, as for a datum constructed without
+		an uncertainty in python.
+	mask : ``const unsigned char *``
+		Laid out like ``values``. If not ``NULL``, only the measurements at
+		which it is nonzero are used.
+	labels : ``char **``
+		The label of each quantity.
+	n_data : ``const unsigned long``
+		The number of data.
+	n_labels : ``const unsigned short``
+		The number of quantities.
+
+	Returns
+	-------
+	s : ``SAMPLE *``
+		The newly constructed sample, whose data are owned by the C library
+		and are freed by :c:func:`sample_free_everything`. ``NULL`` if any
+		datum would have no measurements at all.
+
+	Notes
+	-----
+	Each label is interned once rather than once per datum, and the labels,
+	IDs, and masks of the data are assigned directly.
+*/
+extern SAMPLE *sample_from_arrays(const double *values, const double *errors,
+	const unsigned char *mask, char **labels, const unsigned long n_data,
+	const unsigned short n_labels) {
+
+	unsigned short *ids = (unsigned short *) malloc (
+		n_labels * sizeof(unsigned short));
+	for (unsigned short k = 0u; k < n_labels; k++) {
+		ids[k] = label_intern(labels[k]);
+	}
+
+	SAMPLE *s = sample_initialize();
+	s -> data = (DATUM **) malloc (n_data * sizeof(DATUM *));
+	s -> capacity = n_data;
+	s -> arena = arena_initialize();
+	const DATUM *previous = NULL;
+	for (unsigned long i = 0ul; i < n_data; i++) {
+		const double *row = values + i * n_labels;
+		unsigned short dim = 0u;
+		for (unsigned short k = 0u; k < n_labels; k++) {
+			if (!isnan(row[k]) && (mask == NULL || mask[i * n_labels + k])) {
+				dim++;
+			} else {}
+		}
+		if (!dim) {
+			free(ids);
+			sample_free_everything(s);
+			return NULL;
+		} else {}
+
+		DATUM *d = datum_arena_initialize(s -> arena, dim);
+		d -> cov = covariance_matrix_arena_initialize(s -> arena, dim);
+		unsigned short j = 0u;
+		for (unsigned short k = 0u; k < n_labels; k++) {
+			if (!isnan(row[k]) && (mask == NULL || mask[i * n_labels + k])) {
+				d -> vector[0][j] = row[k];
+				d -> ids[j] = ids[k];
+				d -> labels[j] = label_name(ids[k]);
+				double error = errors != NULL ? errors[i * n_labels + k] : NAN;
+				d -> cov -> matrix[j][j] = isnan(error) ? 1 : error * error;
+				j++;
+			} else {}
+		}
+		d -> mask = label_mask((*d).ids, dim);
+		d -> cov -> labels = (*d).labels;
+		covariance_matrix_reuse(d -> cov, previous != NULL &&
+			(*previous).mask == (*d).mask ? (*previous).cov : NULL);
+		s -> data[s -> n_vectors++] = d;
+		previous = d;
+	}
+	free(ids);
+	return s;
 
 }
 
@@ -161,11 +303,23 @@ extern void sample_add_datum(SAMPLE *s, DATUM *d) {
 extern SAMPLE *sample_specific_quantities(SAMPLE s, char **labels,
 	const unsigned short n_labels) {
 
+	/* Look up each label once rather than once per datum. */
+	unsigned short n_ids = 0u;
+	unsigned short *ids = (unsigned short *) malloc (n_labels *
+		sizeof(unsigned short));
+	for (unsigned short i = 0u; i < n_labels; i++) {
+		signed short id = label_lookup(labels[i]);
+		if (id >= 0) ids[n_ids++] = (unsigned short) id;
+	}
+
 	SAMPLE *sub = sample_initialize();
+	sub -> arena = arena_initialize();
 	for (unsigned long i = 0ul; i < s.n_vectors; i++) {
-		DATUM *d = datum_specific_quantities(*s.data[i], labels, n_labels);
+		DATUM *d = datum_specific_ids(*sample_datum(&s, i), ids, n_ids,
+			sub -> arena);
 		if (d != NULL) sample_add_datum(sub, d);
 	}
+	free(ids);
 	return sub;
 
 }
@@ -240,11 +394,21 @@ extern unsigned long *sample_filter_indices(SAMPLE s, char *label,
 	unsigned long *indices = (unsigned long *) malloc (sizeof(unsigned long));
 	indices[0] = 0ul;
 
+	/*
+	A label that has never been interned is measured for none of the data.
+	Otherwise, the mask rules out most data that don't measure it without
+	searching their labels.
+	*/
+	signed short id = label_lookup(label);
+
 	for (unsigned long i = 0ul; i < s.n_vectors; i++) {
 
 		unsigned short pass;
-		signed short colidx = strindex((*s.data[i]).labels, label,
-			(*s.data[i]).n_cols);
+		signed short colidx = -1;
+		DATUM *d = sample_datum(&s, i);
+		if (id >= 0 && ((*d).mask & LABEL_BIT((unsigned short) id))) {
+			colidx = idindex((*d).ids, (unsigned short) id, (*d).n_cols);
+		} else {}
 
 		if (colidx == -1) {
 			pass = keep_missing_measurements;
@@ -253,27 +417,27 @@ extern unsigned long *sample_filter_indices(SAMPLE s, char *label,
 
 				case 1:
 					/* == */
-					pass = (*s.data[i]).vector[0][colidx] == value;
+					pass = (*d).vector[0][colidx] == value;
 					break;
 
 				case 2:
 					/* < */
-					pass = (*s.data[i]).vector[0][colidx] < value;
+					pass = (*d).vector[0][colidx] < value;
 					break;
 
 				case 3:
 					/* <= */
-					pass = (*s.data[i]).vector[0][colidx] <= value;
+					pass = (*d).vector[0][colidx] <= value;
 					break;
 
 				case 4:
 					/* > */
-					pass = (*s.data[i]).vector[0][colidx] > value;
+					pass = (*d).vector[0][colidx] > value;
 					break;
 
 				case 5:
 					/* >= */
-					pass = (*s.data[i]).vector[0][colidx] >= value;
+					pass = (*d).vector[0][colidx] >= value;
 					break;
 
 				default:
@@ -293,3 +457,1221 @@ extern unsigned long *sample_filter_indices(SAMPLE s, char *label,
 	return indices;
 
 }
+
+
+/*
+.. c:function:: extern unsigned long *sample_filter_compound(SAMPLE *s, const SAMPLE_CONDITION *conditions, const unsigned short n_conditions, const unsigned short combine);
+
+	Determine the indices of data vectors that pass several filter conditions
+	at once.
+
+	Parameters
+	----------
+	s : ``SAMPLE *``
+		The sample to filter data from. It is packed by :c:func:`sample_pack`
+		if it has not been already.
+	conditions : ``const SAMPLE_CONDITION *``
+		The conditions to apply.
+	n_conditions : ``const unsigned short``
+		The number of elements in ``conditions``.
+	combine : ``const unsigned short``
+		:c:macro:`SAMPLE_FILTER_ALL` or :c:macro:`SAMPLE_FILTER_ANY`.
+
+	Returns
+	-------
+	idx : ``unsigned long *``
+		The number of data vectors that pass the filter followed by their
+		indices in ascending order, as returned by
+		:c:func:`sample_filter_indices`. ``NULL`` if any condition has an
+		unrecognized :c:member:`SAMPLE_CONDITION.condition_indicator`.
+
+	Notes
+	-----
+	The conditions are evaluated over the columns of the packed sample (see
+	:c:type:`PACKED_GROUP`), a group at a time. Each condition looks up its
+	label once per group rather than once per datum, and every condition is
+	evaluated for a datum while its vector is in cache. The data of a sample
+	read by :c:func:`sample_load` are not reconstructed.
+*/
+extern unsigned long *sample_filter_compound(SAMPLE *s,
+	const SAMPLE_CONDITION *conditions, const unsigned short n_conditions,
+	const unsigned short combine) {
+
+	for (unsigned short c = 0u; c < n_conditions; c++) {
+		if (conditions[c].condition_indicator < 1u ||
+			conditions[c].condition_indicator > 5u) return NULL;
+	}
+	PACKED_SAMPLE *p = sample_pack(s);
+	unsigned char *pass = (unsigned char *) calloc ((*s).n_vectors + 1ul,
+		sizeof(unsigned char));
+	signed short *columns = (signed short *) malloc (
+		(n_conditions + 1u) * sizeof(signed short));
+	signed short *ids = (signed short *) malloc (
+		(n_conditions + 1u) * sizeof(signed short));
+	for (unsigned short c = 0u; c < n_conditions; c++) {
+		ids[c] = label_lookup(conditions[c].label);
+	}
+
+	unsigned long n_pass = 0ul;
+	for (unsigned long g = 0ul; g < (*p).n_groups; g++) {
+		PACKED_GROUP group = (*p).groups[g];
+		for (unsigned short c = 0u; c < n_conditions; c++) {
+			if (ids[c] >= 0 &&
+				(group.mask & LABEL_BIT((unsigned short) ids[c]))) {
+				columns[c] = idindex(group.ids, (unsigned short) ids[c],
+					group.dim);
+			} else {
+				columns[c] = -1;
+			}
+		}
+		for (unsigned long i = 0ul; i < group.n_data; i++) {
+			const double *vector = group.vectors + i * group.dim;
+			unsigned short result = combine == SAMPLE_FILTER_ALL;
+			for (unsigned short c = 0u; c < n_conditions; c++) {
+				unsigned short satisfied;
+				if (columns[c] == -1) {
+					satisfied = conditions[c].keep_missing_measurements != 0u;
+				} else {
+					satisfied = condition_satisfied(vector[columns[c]],
+						conditions[c].condition_indicator,
+						conditions[c].value);
+				}
+				if (combine == SAMPLE_FILTER_ALL) {
+					result &= satisfied;
+				} else {
+					result |= satisfied;
+				}
+			}
+			pass[group.indices[i]] = (unsigned char) result;
+			n_pass += result;
+		}
+	}
+	free(columns);
+	free(ids);
+
+	unsigned long *indices = (unsigned long *) malloc (
+		(n_pass + 1ul) * sizeof(unsigned long));
+	indices[0] = 0ul;
+	for (unsigned long i = 0ul; i < (*s).n_vectors; i++) {
+		if (pass[i]) indices[++indices[0]] = i;
+	}
+	free(pass);
+	return indices;
+
+}
+
+
+/*
+.. c:function:: extern SAMPLE *sample_view(SAMPLE *s, const unsigned long *indices);
+
+	Obtain a sample containing some of the data of another without copying
+	them.
+
+	Parameters
+	----------
+	s : ``SAMPLE *``
+		The parent sample.
+	indices : ``const unsigned long *``
+		The number of data to include followed by their indices in ``s``, as
+		returned by :c:func:`sample_filter_compound`.
+
+	Returns
+	-------
+	view : ``SAMPLE *``
+		A new sample whose :c:member:`SAMPLE.data` point to the same
+		:c:type:`DATUM` objects as those of ``s``. Its
+		:c:member:`SAMPLE.arena` is ``NULL``, so it must be freed with
+		:c:func:`sample_free` rather than :c:func:`sample_free_everything`,
+		and before ``s`` is.
+*/
+extern SAMPLE *sample_view(SAMPLE *s, const unsigned long *indices) {
+
+	SAMPLE *view = sample_initialize();
+	view -> n_vectors = indices[0];
+	view -> capacity = indices[0];
+	view -> data = (DATUM **) malloc ((indices[0] + 1ul) * sizeof(DATUM *));
+	for (unsigned long i = 0ul; i < indices[0]; i++) {
+		view -> data[i] = sample_datum(s, indices[i + 1ul]);
+	}
+	return view;
+
+}
+
+
+/*
+.. c:function:: extern void sample_column(SAMPLE *s, const char *label, double *values);
+
+	Extract the measurements of one quantity for every datum in a sample.
+
+	Parameters
+	----------
+	s : ``SAMPLE *``
+		The sample. It is packed by :c:func:`sample_pack` if it has not been
+		already.
+	label : ``const char *``
+		The label of the quantity.
+	values : ``double *``
+		The ``s -> n_vectors`` elements in which to store the measurements,
+		in the order of the data in the sample. Data without a measurement of
+		``label`` get ``NAN``.
+
+	Notes
+	-----
+	Like :c:func:`sample_filter_compound`, this reads the columns of the
+	packed sample a group at a time.
+*/
+extern void sample_column(SAMPLE *s, const char *label, double *values) {
+
+	for (unsigned long i = 0ul; i < (*s).n_vectors; i++) values[i] = NAN;
+	signed short id = label_lookup(label);
+	if (id >= 0) {
+		PACKED_SAMPLE *p = sample_pack(s);
+		for (unsigned long g = 0ul; g < (*p).n_groups; g++) {
+			PACKED_GROUP group = (*p).groups[g];
+			if (group.mask & LABEL_BIT((unsigned short) id)) {
+				signed short column = idindex(group.ids, (unsigned short) id,
+					group.dim);
+				if (column != -1) {
+					const double *source = group.vectors + column;
+					for (unsigned long i = 0ul; i < group.n_data; i++) {
+						values[group.indices[i]] = source[i * group.dim];
+					}
+				} else {}
+			} else {}
+		}
+	} else {}
+
+}
+
+
+/*
+.. c:function:: extern double **sample_column_pointers(SAMPLE *s, const char *label);
+
+	Obtain the address of the measurement of one quantity within each datum
+	of a sample.
+
+	Parameters
+	----------
+	s : ``SAMPLE *``
+		The sample.
+	label : ``const char *``
+		The label of the quantity.
+
+	Returns
+	-------
+	pointers : ``double **``
+		The ``s -> n_vectors`` addresses, in the order of the data in the
+		sample, which the python class ``linked_list`` takes ownership of.
+		Each datum without a measurement of ``label`` instead gets the
+		address of its own newly allocated ``NAN``, as ``linked_list``
+		expects.
+*/
+extern double **sample_column_pointers(SAMPLE *s, const char *label) {
+
+	double **pointers = (double **) malloc (
+		((*s).n_vectors + 1ul) * sizeof(double *));
+	signed short id = label_lookup(label);
+	for (unsigned long i = 0ul; i < (*s).n_vectors; i++) {
+		DATUM *d = sample_datum(s, i);
+		signed short column = -1;
+		if (id >= 0 && ((*d).mask & LABEL_BIT((unsigned short) id))) {
+			column = idindex((*d).ids, (unsigned short) id, (*d).n_cols);
+		} else {}
+		if (column != -1) {
+			pointers[i] = &(d -> vector[0][column]);
+		} else {
+			pointers[i] = (double *) malloc (sizeof(double));
+			pointers[i][0] = NAN;
+		}
+	}
+	return pointers;
+
+}
+
+
+/*
+.. c:function:: extern double sample_uncertainty_scale(SAMPLE *s, const char *label);
+
+	Determine the smallest uncertainty with which any datum in a sample
+	measures some quantity.
+
+	Parameters
+	----------
+	s : ``SAMPLE *``
+		The sample. It is packed by :c:func:`sample_pack` if it has not been
+		already.
+	label : ``const char *``
+		The label of the quantity.
+
+	Returns
+	-------
+	scale : ``double``
+		The smallest value of :math:`1 / \sqrt{C^{-1}_{kk}}` among the data
+		that measure ``label``, where :math:`C^{-1}_{kk}` is the diagonal
+		element of the inverse covariance matrix of the datum corresponding
+		to ``label``. This is the uncertainty in ``label`` with every other
+		measured quantity held fixed, which is no larger than the square root
+		of the variance. ``INFINITY`` if no datum measures ``label``.
+*/
+extern double sample_uncertainty_scale(SAMPLE *s, const char *label) {
+
+	double scale = INFINITY;
+	signed short id = label_lookup(label);
+	if (id >= 0) {
+		PACKED_SAMPLE *p = sample_pack(s);
+		for (unsigned long g = 0ul; g < (*p).n_groups; g++) {
+			PACKED_GROUP group = (*p).groups[g];
+			if (group.mask & LABEL_BIT((unsigned short) id)) {
+				signed short column = idindex(group.ids, (unsigned short) id,
+					group.dim);
+				if (column != -1) {
+					unsigned long n_tri = (unsigned long) group.dim * (
+						group.dim + 1ul) / 2ul;
+					const double *source = group.inv + packed_index(
+						(unsigned short) column, (unsigned short) column,
+						group.dim);
+					for (unsigned long i = 0ul; i < group.n_data; i++) {
+						double x = 1 / sqrt(source[i * n_tri]);
+						if (x < scale) scale = x;
+					}
+				} else {}
+			} else {}
+		}
+	} else {}
+	return scale;
+
+}
+
+
+/*
+.. c:function:: extern PACKED_SAMPLE *sample_pack(SAMPLE *s);
+
+	Obtain the packed representation of a sample, constructing it if it does
+	not already exist.
+
+	Parameters
+	----------
+	s : ``SAMPLE *``
+		The sample to pack.
+
+	Returns
+	-------
+	packed : ``PACKED_SAMPLE *``
+		The packed copy of the sample, which is also stored as
+		:c:member:`SAMPLE.packed`. The same pointer is returned on subsequent
+		calls until :c:func:`sample_invalidate` is called.
+
+	Notes
+	-----
+	Data vectors are assigned to a :c:type:`PACKED_GROUP` according to the
+	*set* of labels they carry, so two data with the same quantities listed
+	in a different order share a group. The first datum encountered with a
+	given set of labels determines the order of the components within the
+	group. If a datum's covariance matrix has not yet been inverted,
+	:c:func:`covariance_matrix_update` is called first.
+
+	Within each set of labels, every set of at least
+	:c:macro:`PACKED_GROUP_MIN_SHARED` data with identical inverse covariance
+	matrices (e.g., those of a survey with the same uncertainties for every
+	measurement) is then moved into a group of its own, which
+	:c:func:`packed_group_whiten` gives a transformation into its whitened
+	frame. The remaining data keep the group of their set of labels. Each
+	group lists its data in the order of the sample.
+
+	The packed copy is not updated automatically when the data are modified.
+	Any code that modifies the vectors or covariance matrices of data within
+	a sample must call :c:func:`sample_invalidate` before the next likelihood
+	calculation. TrackStar's python API handles this automatically.
+*/
+extern PACKED_SAMPLE *sample_pack(SAMPLE *s) {
+
+	if ((*s).packed != NULL) return s -> packed;
+
+	PACKED_SAMPLE *p = (PACKED_SAMPLE *) malloc (sizeof(PACKED_SAMPLE));
+	p -> groups = NULL;
+	p -> n_groups = 0ul;
+	p -> n_vectors = (*s).n_vectors;
+	p -> storage = NULL;
+	p -> storage_size = 0ul;
+	p -> locations = NULL;
+
+	/*
+	First pass: determine which group each datum belongs to and how many
+	data are in each group, so that each group's arrays can be allocated
+	exactly once.
+	*/
+	unsigned long *membership = (unsigned long *) malloc (
+		(*s).n_vectors * sizeof(unsigned long));
+	for (unsigned long i = 0ul; i < (*s).n_vectors; i++) {
+		DATUM *d = (*s).data[i];
+		signed long index = packed_group_index(*p, *d);
+		if (index == -1l) {
+			p -> groups = (PACKED_GROUP *) realloc (p -> groups,
+				((*p).n_groups + 1ul) * sizeof(PACKED_GROUP));
+			PACKED_GROUP *g = &(p -> groups[p -> n_groups]);
+			g -> dim = (*d).n_cols;
+			g -> n_data = 0ul;
+			g -> labels = (char **) malloc ((*g).dim * sizeof(char *));
+			g -> ids = (unsigned short *) malloc (
+				(*g).dim * sizeof(unsigned short));
+			for (unsigned short k = 0u; k < (*g).dim; k++) {
+				g -> labels[k] = (*d).labels[k];
+				g -> ids[k] = (*d).ids[k];
+			}
+			g -> mask = (*d).mask;
+			g -> cov = NULL;
+			g -> single = NULL;
+			g -> transform = NULL;
+			index = (signed long) p -> n_groups++;
+		} else {}
+		membership[i] = (unsigned long) index;
+		p -> groups[index].n_data++;
+	}
+
+	for (unsigned long i = 0ul; i < (*p).n_groups; i++) {
+		PACKED_GROUP *g = &(p -> groups[i]);
+		unsigned long dim = (*g).dim;
+		g -> indices = (unsigned long *) malloc (
+			(*g).n_data * sizeof(unsigned long));
+		g -> vectors = (double *) aligned_malloc (
+			(*g).n_data * dim * sizeof(double));
+		g -> inv = (double *) aligned_malloc (
+			(*g).n_data * dim * (dim + 1ul) / 2ul * sizeof(double));
+		g -> logdet = (double *) aligned_malloc (
+			(*g).n_data * sizeof(double));
+		g -> whitening = (double *) aligned_malloc (
+			(*g).n_data * dim * sizeof(double));
+		g -> n_data = 0ul;
+	}
+
+	/* Second pass: copy each datum into its group */
+	for (unsigned long i = 0ul; i < (*s).n_vectors; i++) {
+		PACKED_GROUP *g = &(p -> groups[membership[i]]);
+		g -> indices[g -> n_data] = i;
+		packed_group_fill(g, *(*s).data[i], (*g).n_data);
+		g -> n_data++;
+	}
+	free(membership);
+	const unsigned long n_groups = (*p).n_groups;
+	for (unsigned long i = 0ul; i < n_groups; i++) packed_group_split(p, i);
+	for (unsigned long i = 0ul; i < (*p).n_groups; i++) {
+		packed_group_whiten(&(p -> groups[i]));
+	}
+
+	s -> packed = p;
+	return p;
+
+}
+
+
+/*
+.. c:function:: extern PACKED_SAMPLE *packed_sample_slice(const PACKED_SAMPLE *p, const unsigned long start, const unsigned long stop);
+
+	Copy a contiguous range of the data in a packed sample into a packed
+	sample of their own.
+
+	Parameters
+	----------
+	p : ``const PACKED_SAMPLE *``
+		The packed sample to copy the data from.
+	start : ``const unsigned long``
+		The position of the first datum to copy, counting through the data of
+		each group of ``p`` in turn.
+	stop : ``const unsigned long``
+		One past the position of the last datum to copy.
+
+	Returns
+	-------
+	slice : ``PACKED_SAMPLE *``
+		The copy, with one group for each group of ``p`` that has data in the
+		range, in the same order. Its :c:member:`PACKED_GROUP.indices` still
+		refer to the data of the whole sample. The caller is responsible for
+		freeing it with :c:func:`packed_sample_free`.
+
+	Notes
+	-----
+	Every array of the copy is written by the calling thread immediately after
+	it is allocated. Operating systems that place memory on the node of a
+	non-uniform memory access (NUMA) machine that first writes to it therefore
+	keep the copy local to that thread (see
+	:c:func:`likelihood_engine_initialize`).
+*/
+extern PACKED_SAMPLE *packed_sample_slice(const PACKED_SAMPLE *p,
+	const unsigned long start, const unsigned long stop) {
+
+	PACKED_SAMPLE *slice = (PACKED_SAMPLE *) malloc (sizeof(PACKED_SAMPLE));
+	slice -> groups = NULL;
+	slice -> n_groups = 0ul;
+	slice -> n_vectors = 0ul;
+	slice -> storage = NULL;
+	slice -> storage_size = 0ul;
+	slice -> locations = NULL;
+
+	unsigned long offset = 0ul;
+	for (unsigned long i = 0ul; i < (*p).n_groups; i++) {
+		PACKED_GROUP g = (*p).groups[i];
+		/* the positions within this group that fall within the range */
+		unsigned long first = start > offset ? start - offset : 0ul;
+		unsigned long last = stop > offset ? stop - offset : 0ul;
+		if (last > g.n_data) last = g.n_data;
+		if (first < last) {
+			slice -> groups = (PACKED_GROUP *) realloc (slice -> groups,
+				((*slice).n_groups + 1ul) * sizeof(PACKED_GROUP));
+			packed_group_copy(&(slice -> groups[slice -> n_groups]), g,
+				first, last);
+			slice -> n_groups++;
+			slice -> n_vectors += last - first;
+		} else {}
+		offset += g.n_data;
+	}
+	return slice;
+
+}
+
+
+/*
+.. c:function:: extern void sample_invalidate(SAMPLE *s);
+
+	Discard the packed representation of a sample, if it exists, such that
+	the next call to :c:func:`sample_pack` reconstructs it from the current
+	values stored by each datum.
+
+	Parameters
+	----------
+	s : ``SAMPLE *``
+		The sample whose packed representation is to be discarded.
+*/
+extern void sample_invalidate(SAMPLE *s) {
+
+	if ((*s).packed != NULL) {
+		/* data not yet reconstructed from a file would be lost with it */
+		if ((*s).packed -> storage != NULL) {
+			for (unsigned long i = 0ul; i < (*s).n_vectors; i++) {
+				(void) sample_datum(s, i);
+			}
+		} else {}
+		packed_sample_free(s -> packed);
+		s -> packed = NULL;
+	} else {}
+
+}
+
+
+/*
+.. c:function:: extern DATUM *sample_datum(SAMPLE *s, const unsigned long index);
+
+	Obtain a datum from a sample, reconstructing it from the packed
+	representation if the sample was read by :c:func:`sample_load` and the
+	datum has not yet been needed.
+
+	Parameters
+	----------
+	s : ``SAMPLE *``
+		The sample of interest.
+	index : ``const unsigned long``
+		The index of the datum within the sample.
+
+	Returns
+	-------
+	d : ``DATUM *``
+		The datum, which is also stored at ``s -> data[index]``.
+*/
+extern DATUM *sample_datum(SAMPLE *s, const unsigned long index) {
+
+	if ((*s).data[index] == NULL) {
+		if ((*s).packed == NULL || (*s).packed -> locations == NULL) {
+			fatal_print("%s\n", "Datum missing from sample.");
+		} else {}
+		PACKED_SAMPLE p = *(*s).packed;
+		s -> data[index] = unpack_datum(s -> arena,
+			p.groups[p.locations[2ul * index]], p.locations[2ul * index + 1ul]);
+	} else {}
+	return s -> data[index];
+
+}
+
+
+/*
+.. c:function:: extern unsigned long packed_index(const unsigned short i, const unsigned short j, const unsigned short dim);
+
+	Determine where the :math:`i,j`'th element of a symmetric matrix is
+	stored within its upper triangle packed row by row, as in
+	:c:member:`PACKED_GROUP.inv`.
+
+	Parameters
+	----------
+	i : ``const unsigned short``
+		The row number.
+	j : ``const unsigned short``
+		The column number. Must be >= ``i``.
+	dim : ``const unsigned short``
+		The number of rows and columns in the matrix.
+
+	Returns
+	-------
+	idx : ``unsigned long``
+		The index of the element within the packed upper triangle.
+*/
+extern unsigned long packed_index(const unsigned short i,
+	const unsigned short j, const unsigned short dim) {
+
+	/* rows 0 through i - 1 occupy dim + (dim - 1) + ... + (dim - i + 1) */
+	unsigned long row = i;
+	return row * dim - row * (row - 1ul) / 2ul + (j - row);
+
+}
+
+
+/*
+.. c:function:: static signed long packed_group_index(PACKED_SAMPLE p, DATUM d);
+
+	Determine which group of a packed sample a datum belongs to.
+
+	Parameters
+	----------
+	p : ``PACKED_SAMPLE``
+		The packed sample, which may be only partially constructed.
+	d : ``DATUM``
+		The datum in question.
+
+	Returns
+	-------
+	index : ``signed long``
+		The index of the group within :c:member:`PACKED_SAMPLE.groups` whose
+		labels are the same set as those of ``d``. -1 if there is no such
+		group.
+*/
+static signed long packed_group_index(PACKED_SAMPLE p, DATUM d) {
+
+	for (unsigned long i = 0ul; i < p.n_groups; i++) {
+		if (p.groups[i].dim == d.n_cols && p.groups[i].mask == d.mask) {
+			unsigned short match = 1u;
+			for (unsigned short k = 0u; k < d.n_cols && match; k++) {
+				match = idindex(p.groups[i].ids, d.ids[k], d.n_cols) != -1;
+			}
+			if (match) return (signed long) i;
+		} else {}
+	}
+	return -1l;
+
+}
+
+
+/*
+.. c:function:: static void packed_group_fill(PACKED_GROUP *g, DATUM d, const unsigned long position);
+
+	Copy the vector, inverse covariance matrix, log-determinant, and whitening
+	scale factors of a datum into a group of a packed sample.
+
+	Parameters
+	----------
+	g : ``PACKED_GROUP *``
+		The group to copy the datum into. Its arrays must already be
+		allocated.
+	d : ``DATUM``
+		The datum to copy. Must carry the same set of labels as ``g``.
+	position : ``const unsigned long``
+		Where within the group to store the datum.
+*/
+static void packed_group_fill(PACKED_GROUP *g, DATUM d,
+	const unsigned long position) {
+
+	if ((*d.cov).inv == NULL) covariance_matrix_update(d.cov);
+	unsigned short *perm = (unsigned short *) malloc (
+		(*g).dim * sizeof(unsigned short));
+	for (unsigned short k = 0u; k < (*g).dim; k++) {
+		signed short idx = idindex(d.ids, (*g).ids[k], d.n_cols);
+		if (idx == -1) fatal_print("%s\n",
+			"Datum does not match the labels of its packed group.");
+		perm[k] = (unsigned short) idx;
+	}
+
+	unsigned long n_tri = (unsigned long) (*g).dim * ((*g).dim + 1ul) / 2ul;
+	double *vector = (*g).vectors + position * (*g).dim;
+	double *inv = (*g).inv + position * n_tri;
+	for (unsigned short k = 0u; k < (*g).dim; k++) {
+		vector[k] = d.vector[0][perm[k]];
+		for (unsigned short l = k; l < (*g).dim; l++) {
+			*inv++ = (*(*d.cov).inv).matrix[perm[k]][perm[l]];
+		}
+	}
+	g -> logdet[position] = (*d.cov).logdet;
+	covariance_matrix_whitening(*d.cov, perm,
+		(*g).whitening + position * (*g).dim);
+	free(perm);
+
+}
+
+
+/*
+.. c:function:: static void packed_group_copy(PACKED_GROUP *copy, PACKED_GROUP g, const unsigned long first, const unsigned long last);
+
+	Copy a contiguous range of the data in a group of a packed sample into a
+	new group.
+
+	Parameters
+	----------
+	copy : ``PACKED_GROUP *``
+		The group to copy the data into, whose arrays are allocated here.
+	g : ``PACKED_GROUP``
+		The group to copy the data from.
+	first : ``const unsigned long``
+		The position of the first datum to copy within ``g``.
+	last : ``const unsigned long``
+		One past the position of the last datum to copy within ``g``.
+*/
+static void packed_group_copy(PACKED_GROUP *copy, PACKED_GROUP g,
+	const unsigned long first, const unsigned long last) {
+
+	unsigned long dim = g.dim, n_tri = dim * (dim + 1ul) / 2ul;
+	copy -> dim = g.dim;
+	copy -> mask = g.mask;
+	copy -> n_data = last - first;
+	copy -> labels = (char **) malloc (dim * sizeof(char *));
+	copy -> ids = (unsigned short *) malloc (dim * sizeof(unsigned short));
+	memcpy(copy -> labels, g.labels, dim * sizeof(char *));
+	memcpy(copy -> ids, g.ids, dim * sizeof(unsigned short));
+	copy -> indices = (unsigned long *) malloc (
+		(*copy).n_data * sizeof(unsigned long));
+	copy -> vectors = (double *) aligned_malloc (
+		(*copy).n_data * dim * sizeof(double));
+	copy -> inv = (double *) aligned_malloc (
+		(*copy).n_data * n_tri * sizeof(double));
+	copy -> logdet = (double *) aligned_malloc (
+		(*copy).n_data * sizeof(double));
+	copy -> whitening = (double *) aligned_malloc (
+		(*copy).n_data * dim * sizeof(double));
+	copy -> cov = NULL;
+	copy -> single = NULL;
+	if (g.transform != NULL) {
+		copy -> transform = (double *) aligned_malloc (
+			n_tri * sizeof(double));
+		memcpy(copy -> transform, g.transform, n_tri * sizeof(double));
+	} else {
+		copy -> transform = NULL;
+	}
+	memcpy(copy -> indices, g.indices + first,
+		(*copy).n_data * sizeof(unsigned long));
+	memcpy(copy -> vectors, g.vectors + first * dim,
+		(*copy).n_data * dim * sizeof(double));
+	memcpy(copy -> inv, g.inv + first * n_tri,
+		(*copy).n_data * n_tri * sizeof(double));
+	memcpy(copy -> logdet, g.logdet + first,
+		(*copy).n_data * sizeof(double));
+	memcpy(copy -> whitening, g.whitening + first * dim,
+		(*copy).n_data * dim * sizeof(double));
+
+}
+
+
+/*
+.. c:function:: extern void packed_sample_free(PACKED_SAMPLE *p);
+
+	Free up the memory stored by a :c:type:`PACKED_SAMPLE` object.
+
+	Parameters
+	----------
+	p : ``PACKED_SAMPLE *``
+		The packed sample to be freed.
+
+	Notes
+	-----
+	The packed copy of a sample returned by :c:func:`sample_pack` is freed
+	along with the sample, so this need only be called for those returned
+	by :c:func:`packed_sample_slice`.
+*/
+extern void packed_sample_free(PACKED_SAMPLE *p) {
+
+	for (unsigned long i = 0ul; i < (*p).n_groups; i++) {
+		PACKED_GROUP *g = &(p -> groups[i]);
+		free(g -> labels);
+		free(g -> ids);
+		free(g -> single);
+		free(g -> transform);
+		if ((*p).storage == NULL) {
+			free(g -> indices);
+			free(g -> vectors);
+			free(g -> inv);
+			free(g -> logdet);
+			free(g -> whitening);
+		} else {}
+	}
+	if ((*p).storage_size) {
+		munmap(p -> storage, (*p).storage_size);
+	} else {
+		free(p -> storage);
+	}
+	free(p -> locations);
+	free(p -> groups);
+	free(p);
+
+}
+
+
+/*
+.. c:function:: extern void packed_sample_single(PACKED_SAMPLE *p);
+
+	Store a single precision copy of the vectors and inverse covariance
+	matrices of the data in a packed sample, for likelihood calculations with
+	:c:macro:`LIKELIHOOD_PRECISION_SINGLE`, if it is not already stored.
+
+	Parameters
+	----------
+	p : ``PACKED_SAMPLE *``
+		The packed sample, whose :c:member:`PACKED_GROUP.single` is filled in
+		for each group.
+
+	Notes
+	-----
+	The double precision arrays are kept, since the line segment corrections
+	and the pruning bounds are still evaluated in double precision. Like the
+	packed sample itself, the copy is discarded along with it when the data
+	are modified.
+*/
+extern void packed_sample_single(PACKED_SAMPLE *p) {
+
+	for (unsigned long i = 0ul; i < (*p).n_groups; i++) {
+		PACKED_GROUP *g = &(p -> groups[i]);
+		if ((*g).single == NULL) {
+			const unsigned long dim = (*g).dim;
+			const unsigned long n_tri = dim * (dim + 1ul) / 2ul;
+			g -> single = (float *) aligned_malloc (
+				(*g).n_data * (dim + n_tri) * sizeof(float));
+			for (unsigned long j = 0ul; j < (*g).n_data; j++) {
+				float *datum = (*g).single + j * (dim + n_tri);
+				for (unsigned long k = 0ul; k < dim; k++) {
+					datum[k] = (float) (*g).vectors[j * dim + k];
+				}
+				for (unsigned long k = 0ul; k < n_tri; k++) {
+					datum[dim + k] = (float) (*g).inv[j * n_tri + k];
+				}
+			}
+		} else {}
+	}
+
+}
+
+
+/*
+.. c:function:: extern void packed_group_whiten(PACKED_GROUP *g);
+
+	Determine whether or not every datum in a group of a packed sample has
+	the same covariance matrix, and if so, compute the transformation into
+	its whitened frame.
+
+	Parameters
+	----------
+	g : ``PACKED_GROUP *``
+		The group, whose :c:member:`PACKED_GROUP.transform` is set.
+
+	Notes
+	-----
+	Catalogs with the same uncertainties for every measurement of a given
+	survey often carry thousands of identical covariance matrices. For such a
+	group, the Cholesky decomposition of the shared inverse covariance matrix
+	:math:`C^{-1} = RR^T` gives :math:`\chi^2 = |R^T\Delta|^2`, so the
+	likelihood calculation transforms the track into the whitened frame once
+	for the whole group, after which :math:`\chi^2` is the squared Euclidean
+	distance computed by :c:func:`squared_distance_points`. Groups of a
+	single datum are left alone, since transforming the track costs about as
+	much as the one datum would save. The inverse covariance matrices are
+	compared bit for bit, so data whose uncertainties differ at all are
+	never treated as sharing one.
+*/
+extern void packed_group_whiten(PACKED_GROUP *g) {
+
+	const unsigned short dim = (*g).dim;
+	const unsigned long n_tri = (unsigned long) dim * (dim + 1ul) / 2ul;
+	unsigned short shared = (*g).n_data > 1ul;
+	for (unsigned long i = 1ul; shared && i < (*g).n_data; i++) {
+		shared = !memcmp((*g).inv, (*g).inv + i * n_tri,
+			n_tri * sizeof(double));
+	}
+	g -> transform = NULL;
+	if (shared) {
+		MATRIX *inv = matrix_initialize(dim, dim);
+		for (unsigned short j = 0u; j < dim; j++) {
+			for (unsigned short k = j; k < dim; k++) {
+				inv -> matrix[j][k] = (*g).inv[packed_index(j, k, dim)];
+				inv -> matrix[k][j] = (*inv).matrix[j][k];
+			}
+		}
+		MATRIX *R = matrix_cholesky(*inv, NULL);
+		if (R != NULL) {
+			g -> transform = (double *) aligned_malloc (
+				n_tri * sizeof(double));
+			for (unsigned short j = 0u; j < dim; j++) {
+				for (unsigned short k = j; k < dim; k++) {
+					g -> transform[packed_index(j, k, dim)] = (*R).matrix[k][j];
+				}
+			}
+			matrix_free(R);
+		} else {}
+		matrix_free(inv);
+	} else {}
+
+}
+
+
+/*
+.. c:function:: static DATUM *unpack_datum(ARENA *a, PACKED_GROUP g, const unsigned long position);
+
+	Reconstruct a datum from a group of a packed sample read from a binary
+	sample file.
+
+	Parameters
+	----------
+	a : ``ARENA *``
+		The arena of the sample, which the datum is allocated from.
+	g : ``PACKED_GROUP``
+		The group that the datum belongs to, whose :c:member:`PACKED_GROUP.cov`
+		is not ``NULL``.
+	position : ``const unsigned long``
+		The position of the datum within the group.
+
+	Returns
+	-------
+	d : ``DATUM *``
+		The datum, whose components are in the order of the group and whose
+		inverse covariance matrix and log-determinant are copied from the
+		group rather than recomputed.
+*/
+static DATUM *unpack_datum(ARENA *a, PACKED_GROUP g,
+	const unsigned long position) {
+
+	unsigned long n_tri = (unsigned long) g.dim * (g.dim + 1ul) / 2ul;
+	const double *vector = g.vectors + position * g.dim;
+	const double *cov = g.cov + position * n_tri;
+	const double *inv = g.inv + position * n_tri;
+	DATUM *d = datum_arena_initialize(a, g.dim);
+	d -> cov = covariance_matrix_arena_initialize(a, g.dim);
+	for (unsigned short k = 0u; k < g.dim; k++) {
+		d -> vector[0][k] = vector[k];
+		d -> ids[k] = g.ids[k];
+		d -> labels[k] = g.labels[k];
+		for (unsigned short l = k; l < g.dim; l++) {
+			d -> cov -> matrix[k][l] = d -> cov -> matrix[l][k] = *cov++;
+			d -> cov -> inv -> matrix[k][l] = *inv;
+			d -> cov -> inv -> matrix[l][k] = *inv++;
+		}
+	}
+	d -> mask = g.mask;
+	d -> cov -> labels = (*d).labels;
+	d -> cov -> logdet = g.logdet[position];
+	return d;
+
+}
+
+
+/*
+.. c:function:: static unsigned short condition_satisfied(const double x, const unsigned short condition_indicator, const double value);
+
+	Determine whether or not a measurement satisfies a filter condition.
+
+	Parameters
+	----------
+	x : ``const double``
+		The measurement.
+	condition_indicator : ``const unsigned short``
+		The condition, encoded as in :c:func:`sample_filter_indices`.
+	value : ``const double``
+		The value to condition based on.
+
+	Returns
+	-------
+	satisfied : ``unsigned short``
+		1 if ``x`` satisfies the condition and 0 otherwise, including for a
+		condition that is not recognized.
+*/
+static unsigned short condition_satisfied(const double x,
+	const unsigned short condition_indicator, const double value) {
+
+	switch (condition_indicator) {
+
+		case 1:
+			/* == */
+			return x == value;
+
+		case 2:
+			/* < */
+			return x < value;
+
+		case 3:
+			/* <= */
+			return x <= value;
+
+		case 4:
+			/* > */
+			return x > value;
+
+		case 5:
+			/* >= */
+			return x >= value;
+
+		default:
+			return 0u;
+
+	}
+
+}
+
+
+/*
+.. c:function:: static void covariance_matrix_reuse(COVARIANCE_MATRIX *cov, const COVARIANCE_MATRIX *previous);
+
+	Compute the inverse and log-determinant of a covariance matrix
+	constructed by :c:func:`sample_from_arrays`, copying them from that of
+	the previous datum if the two matrices are identical rather than
+	decomposing the matrix again.
+
+	Parameters
+	----------
+	cov : ``COVARIANCE_MATRIX *``
+		The covariance matrix, whose :c:member:`COVARIANCE_MATRIX.inv` has
+		been allocated.
+	previous : ``const COVARIANCE_MATRIX *``
+		The covariance matrix of the previous datum, if it measures the same
+		quantities in the same order, and ``NULL`` otherwise.
+
+	Notes
+	-----
+	Catalogs with a single error model per survey are usually stored one
+	survey after another, so consecutive rows often have identical
+	uncertainties. Each datum still owns its covariance matrix, which may
+	be modified independently of the others afterward.
+*/
+static void covariance_matrix_reuse(COVARIANCE_MATRIX *cov,
+	const COVARIANCE_MATRIX *previous) {
+
+	const unsigned short n = (*cov).n_rows;
+	unsigned short same = previous != NULL && (*previous).n_rows == n;
+	for (unsigned short j = 0u; same && j < n; j++) {
+		same = !memcmp((*cov).matrix[j], (*previous).matrix[j],
+			n * sizeof(double));
+	}
+	if (same) {
+		for (unsigned short j = 0u; j < n; j++) {
+			memcpy(cov -> inv -> matrix[j], (*(*previous).inv).matrix[j],
+				n * sizeof(double));
+		}
+		cov -> logdet = (*previous).logdet;
+	} else {
+		covariance_matrix_update(cov);
+	}
+
+}
+
+
+struct shared_covariance {
+
+	/*
+	.. c:struct:: shared_covariance
+
+		The inverse covariance matrix of a datum within a group of a packed
+		sample, by which :c:func:`packed_group_split` sorts the group.
+
+		.. c:member:: const double *inv
+
+			The packed upper triangle of the inverse covariance matrix.
+
+		.. c:member:: unsigned long n_tri
+
+			The number of elements of :c:member:`inv`.
+
+		.. c:member:: unsigned long position
+
+			The position of the datum within the group.
+	*/
+
+	const double *inv;
+	unsigned long n_tri;
+	unsigned long position;
+
+};
+
+
+/*
+.. c:function:: static void packed_group_split(PACKED_SAMPLE *p, const unsigned long index);
+
+	Move every set of at least :c:macro:`PACKED_GROUP_MIN_SHARED` data within
+	a group of a packed sample that have identical inverse covariance
+	matrices into a group of its own.
+
+	Parameters
+	----------
+	p : ``PACKED_SAMPLE *``
+		The packed sample, whose :c:member:`PACKED_SAMPLE.groups` may be
+		reallocated. New groups are appended to the end.
+	index : ``const unsigned long``
+		The index of the group to split. It is replaced by the data that do
+		not belong to any such set, or by one of the sets if there are none.
+
+	Notes
+	-----
+	The data are sorted by the bytes of their inverse covariance matrices,
+	such that identical matrices are adjacent, which takes
+	:math:`O(N\log N)` comparisons for a group of :math:`N` data. The data
+	of each new group remain in the order of the old one.
+*/
+static void packed_group_split(PACKED_SAMPLE *p, const unsigned long index) {
+
+	const PACKED_GROUP g = (*p).groups[index];
+	if (g.n_data < 2ul * PACKED_GROUP_MIN_SHARED) return;
+	const unsigned long n_tri = (unsigned long) g.dim * (g.dim + 1ul) / 2ul;
+	struct shared_covariance *order = (struct shared_covariance *) malloc (
+		g.n_data * sizeof(struct shared_covariance));
+	for (unsigned long i = 0ul; i < g.n_data; i++) {
+		order[i].inv = g.inv + i * n_tri;
+		order[i].n_tri = n_tri;
+		order[i].position = i;
+	}
+	qsort(order, g.n_data, sizeof(struct shared_covariance),
+		&shared_covariance_compare);
+
+	/*
+	assignment[i] is the new group of the i'th datum: 0 for the data that
+	share their covariance matrix with too few others, and 1, 2, 3, ... for
+	each set that is large enough, in the order in which they are sorted.
+	*/
+	unsigned long *assignment = (unsigned long *) malloc (
+		g.n_data * sizeof(unsigned long));
+	unsigned long *counts = (unsigned long *) malloc (
+		(g.n_data + 1ul) * sizeof(unsigned long));
+	unsigned long n_sets = 0ul;
+	counts[0] = 0ul;
+	for (unsigned long start = 0ul, stop; start < g.n_data; start = stop) {
+		stop = start + 1ul;
+		while (stop < g.n_data && !memcmp(order[start].inv, order[stop].inv,
+			n_tri * sizeof(double))) stop++;
+		unsigned long set = 0ul;
+		if (stop - start >= PACKED_GROUP_MIN_SHARED) {
+			set = ++n_sets;
+			counts[set] = 0ul;
+		} else {}
+		for (unsigned long i = start; i < stop; i++) {
+			assignment[order[i].position] = set;
+			counts[set]++;
+		}
+	}
+	free(order);
+
+	if (n_sets > 1ul || (n_sets && counts[0])) {
+		p -> groups = (PACKED_GROUP *) realloc (p -> groups,
+			((*p).n_groups + n_sets + 1ul - (counts[0] ? 0ul : 1ul)) *
+			sizeof(PACKED_GROUP));
+		for (unsigned long set = 0ul; set <= n_sets; set++) {
+			if (counts[set]) {
+				/* the first non-empty set takes the place of the old group */
+				PACKED_GROUP *sub = set == 0ul || (set == 1ul && !counts[0]) ?
+					&(p -> groups[index]) : &(p -> groups[p -> n_groups++]);
+				packed_group_gather(sub, g, assignment, set, counts[set]);
+			} else {}
+		}
+		free(g.labels);
+		free(g.ids);
+		free(g.indices);
+		free(g.vectors);
+		free(g.inv);
+		free(g.logdet);
+		free(g.whitening);
+	} else {}
+	free(assignment);
+	free(counts);
+
+}
+
+
+/*
+.. c:function:: static int shared_covariance_compare(const void *a, const void *b);
+
+	Order two elements of an array of ``struct shared_covariance`` for
+	``qsort``.
+
+	Parameters
+	----------
+	a : ``const void *``
+		The first element.
+	b : ``const void *``
+		The second element.
+
+	Returns
+	-------
+	order : ``int``
+		Negative, zero, or positive if ``a`` is to be placed before, at the
+		same position as, or after ``b``. Elements are ordered by the bytes of
+		their inverse covariance matrices, and those with identical matrices
+		by their positions within the group, such that the order does not
+		depend on the implementation of ``qsort``.
+*/
+static int shared_covariance_compare(const void *a, const void *b) {
+
+	const struct shared_covariance *x = (const struct shared_covariance *) a;
+	const struct shared_covariance *y = (const struct shared_covariance *) b;
+	int order = memcmp((*x).inv, (*y).inv, (*x).n_tri * sizeof(double));
+	if (!order) {
+		order = ((*x).position > (*y).position) -
+			((*x).position < (*y).position);
+	} else {}
+	return order;
+
+}
+
+
+/*
+.. c:function:: static void packed_group_gather(PACKED_GROUP *sub, PACKED_GROUP g, const unsigned long *assignment, const unsigned long which, const unsigned long n_data);
+
+	Copy some of the data in a group of a packed sample into a new group.
+
+	Parameters
+	----------
+	sub : ``PACKED_GROUP *``
+		The group to copy the data into, whose arrays are allocated here.
+	g : ``PACKED_GROUP``
+		The group to copy the data from, whose
+		:c:member:`PACKED_GROUP.cov` and :c:member:`PACKED_GROUP.single` must
+		be ``NULL``.
+	assignment : ``const unsigned long *``
+		A label for each datum in ``g``.
+	which : ``const unsigned long``
+		The label of the data to copy, which are copied in the order of ``g``.
+	n_data : ``const unsigned long``
+		The number of elements of ``assignment`` equal to ``which``.
+*/
+static void packed_group_gather(PACKED_GROUP *sub, PACKED_GROUP g,
+	const unsigned long *assignment, const unsigned long which,
+	const unsigned long n_data) {
+
+	unsigned long dim = g.dim, n_tri = dim * (dim + 1ul) / 2ul;
+	sub -> dim = g.dim;
+	sub -> mask = g.mask;
+	sub -> n_data = n_data;
+	sub -> labels = (char **) malloc (dim * sizeof(char *));
+	sub -> ids = (unsigned short *) malloc (dim * sizeof(unsigned short));
+	memcpy(sub -> labels, g.labels, dim * sizeof(char *));
+	memcpy(sub -> ids, g.ids, dim * sizeof(unsigned short));
+	sub -> indices = (unsigned long *) malloc (n_data * sizeof(unsigned long));
+	sub -> vectors = (double *) aligned_malloc (n_data * dim * sizeof(double));
+	sub -> inv = (double *) aligned_malloc (n_data * n_tri * sizeof(double));
+	sub -> logdet = (double *) aligned_malloc (n_data * sizeof(double));
+	sub -> whitening = (double *) aligned_malloc (
+		n_data * dim * sizeof(double));
+	sub -> cov = NULL;
+	sub -> single = NULL;
+	sub -> transform = NULL;
+
+	unsigned long j = 0ul;
+	for (unsigned long i = 0ul; i < g.n_data; i++) {
+		if (assignment[i] == which) {
+			sub -> indices[j] = g.indices[i];
+			memcpy(sub -> vectors + j * dim, g.vectors + i * dim,
+				dim * sizeof(double));
+			memcpy(sub -> inv + j * n_tri, g.inv + i * n_tri,
+				n_tri * sizeof(double));
+			sub -> logdet[j] = g.logdet[i];
+			memcpy(sub -> whitening + j * dim, g.whitening + i * dim,
+				dim * sizeof(double));
+			j++;
+		} else {}
+	}
+
+}
@@ -16,6 +16,179 @@ extern "C" {
 
 #include "matrix.h"
 #include "datum.h"
+#include "arena.h"
+
+/*
+.. c:macro:: PACKED_GROUP_MIN_SHARED
+
+	``8ul``. The fewest data with the same measured quantities that must share
+	a covariance matrix for :c:func:`sample_pack` to place them in a
+	:c:type:`PACKED_GROUP` of their own, separate from the other data with
+	those quantities. Smaller sets stay with the others, since projecting the
+	track and transforming it into the whitened frame of a group (see
+	:c:func:`packed_group_whiten`) costs about as much as a few data.
+*/
+#define PACKED_GROUP_MIN_SHARED 8ul
+
+typedef struct packed_group {
+
+	/*
+	.. c:type:: PACKED_GROUP
+
+		A contiguous block of data vectors that all have measurements for the
+		same set of quantities, stored in a structure-of-arrays layout for the
+		likelihood calculation.
+
+		.. c:member:: char **labels
+
+			The labels of the quantities measured for each datum in this group.
+			Each datum's vector and covariance matrix are stored with their
+			components in this order, regardless of the order in which they
+			appear in the datum itself. The strings are owned by the
+			:c:type:`LABEL_REGISTRY`.
+
+		.. c:member:: unsigned short *ids
+
+			The integer ID of each element of :c:member:`labels`.
+
+		.. c:member:: unsigned long mask
+
+			The bitmask of :c:member:`ids`, shared by every datum in the group
+			(see :c:func:`label_mask`).
+
+		.. c:member:: unsigned short dim
+
+			The number of quantities measured for each datum in the group.
+
+		.. c:member:: unsigned long n_data
+
+			The number of data vectors in the group.
+
+		.. c:member:: unsigned long *indices
+
+			The index of each datum in the group within :c:member:`SAMPLE.data`.
+
+		.. c:member:: double *vectors
+
+			The data vectors themselves, with the ``k``'th component of the
+			``i``'th datum in the group at ``vectors[i * dim + k]``.
+
+		.. c:member:: double *inv
+
+			The upper triangles of the inverse covariance matrices, stored
+			row by row. Each datum occupies ``dim * (dim + 1) / 2`` elements
+			(see :c:func:`packed_index`).
+
+		.. c:member:: double *logdet
+
+			The natural logarithm of the determinant of each datum's covariance
+			matrix (see :c:member:`COVARIANCE_MATRIX.logdet`).
+
+		.. c:member:: double *whitening
+
+			The scale factors that bound each datum's :math:`\chi^2` from below
+			(see :c:func:`covariance_matrix_whitening`), laid out like
+			:c:member:`vectors`.
+
+		.. c:member:: double *cov
+
+			The upper triangles of the covariance matrices, laid out like
+			:c:member:`inv`, if the packed sample was read by
+			:c:func:`sample_load`. The data themselves are reconstructed from
+			these arrays by :c:func:`sample_datum` as they are needed. ``NULL``
+			otherwise.
+
+		.. c:member:: float *single
+
+			The vector of each datum followed by the upper triangle of its
+			inverse covariance matrix, in single precision, each datum
+			occupying ``dim + dim * (dim + 1) / 2`` elements. ``NULL`` until
+			:c:func:`packed_sample_single` is called.
+
+		.. c:member:: double *transform
+
+			If every datum in the group has the same covariance matrix, as
+			:c:func:`sample_pack` arranges for sets of at least
+			:c:macro:`PACKED_GROUP_MIN_SHARED` data, the upper triangular
+			matrix :math:`W` with :math:`W^TW = C^{-1}`,
+			packed like a single element of :c:member:`inv`, which maps both
+			the data and the track into a frame in which :math:`\chi^2` is a
+			squared Euclidean distance. ``NULL`` otherwise (see
+			:c:func:`packed_group_whiten`).
+
+		All of :c:member:`vectors`, :c:member:`inv`, :c:member:`logdet`, and
+		:c:member:`whitening` are aligned to :c:macro:`CACHE_LINE_SIZE`.
+	*/
+
+	char **labels;
+	unsigned short *ids;
+	unsigned long mask;
+	unsigned short dim;
+	unsigned long n_data;
+	unsigned long *indices;
+	double *vectors;
+	double *inv;
+	double *logdet;
+	double *whitening;
+	double *cov;
+	float *single;
+	double *transform;
+
+} PACKED_GROUP;
+
+typedef struct packed_sample {
+
+	/*
+	.. c:type:: PACKED_SAMPLE
+
+		A contiguous copy of the information in a :c:type:`SAMPLE` that is
+		relevant to the likelihood calculation, with data vectors grouped by
+		the set of quantities that are measured for them.
+
+		.. c:member:: PACKED_GROUP *groups
+
+			The groups of data vectors that share the same set of measured
+			quantities.
+
+		.. c:member:: unsigned long n_groups
+
+			The number of elements in :c:member:`groups`.
+
+		.. c:member:: unsigned long n_vectors
+
+			The total number of data vectors across all groups.
+
+		.. c:member:: void *storage
+
+			The contents of the binary sample file that the arrays of each
+			group point into, if the packed sample was read by
+			:c:func:`sample_load`, in which case those arrays are not freed
+			individually. ``NULL`` otherwise.
+
+		.. c:member:: unsigned long storage_size
+
+			The number of bytes in :c:member:`storage` if it is a memory
+			mapping of the file, which is released with ``munmap``. 0 if the
+			file was instead read into memory allocated with
+			:c:func:`aligned_malloc`.
+
+		.. c:member:: unsigned long *locations
+
+			If the packed sample was read by :c:func:`sample_load`, the group
+			of the ``i``'th datum of the sample and its position within that
+			group, at ``locations[2 * i]`` and ``locations[2 * i + 1]``.
+			``NULL`` otherwise.
+
+	*/
+
+	PACKED_GROUP *groups;
+	unsigned long n_groups;
+	unsigned long n_vectors;
+	void *storage;
+	unsigned long storage_size;
+	unsigned long *locations;
+
+} PACKED_SAMPLE;
 
 typedef struct sample {
 
@@ -28,15 +201,41 @@ typedef struct sample {
 		.. c:member:: DATUM **d
 
 			The collection of data vectors themselves, each stored as a pointer
-			to a :c:type:`DATUM`.
+			to a :c:type:`DATUM`. For a sample read by :c:func:`sample_load`,
+			an element is ``NULL`` until :c:func:`sample_datum` reconstructs
+			it, so code outside of this file should access the data through
+			that function.
 
 		.. c:member:: unsigned long n_vectors
 
 			The number of vectors in :c:member:`data` (i.e. the sample size).
+
+		.. c:member:: unsigned long capacity
+
+			The number of elements that :c:member:`data` has room for, which
+			:c:func:`sample_add_datum` doubles whenever it runs out.
+
+		.. c:member:: ARENA *arena
+
+			The arena that the data constructed for this sample by the C
+			library are allocated from (e.g., by :c:func:`sample_from_arrays`
+			or :c:func:`sample_specific_quantities`), which releases them all
+			at once when the sample is freed. ``NULL`` for a sample built by
+			adding data one at a time with :c:func:`sample_add_datum`.
+
+		.. c:member:: PACKED_SAMPLE *packed
+
+			A packed copy of the sample for the likelihood calculation,
+			constructed on demand by :c:func:`sample_pack`. ``NULL`` if it has
+			not been constructed or has been invalidated by
+			:c:func:`sample_invalidate`.
 	*/
 
 	DATUM **data;
 	unsigned long n_vectors;
+	unsigned long capacity;
+	ARENA *arena;
+	PACKED_SAMPLE *packed;
 
 } SAMPLE;
 
@@ -78,7 +277,9 @@ extern SAMPLE *sample_initialize(void);
 	``__dealloc__`` functions that do free up the required blocks of memory.
 	Namely, this function does not call :c:func:`datum_free` for each
 	individual :c:type:`DATUM` stored by ``s``, because Cython calls
-	``datum.__dealloc__`` with the same addresses as ``sample.data``.
+	``datum.__dealloc__`` with the same addresses as ``sample.data``. Data
+	allocated from the sample's :c:member:`SAMPLE.arena` are not wrapped by
+	python objects that own them, so they are released along with it.
 */
 extern void sample_free(SAMPLE *s);
 
@@ -94,6 +295,10 @@ extern void sample_free(SAMPLE *s);
 	objects created in TrackStar's C library or ``cdef``'ed instances created
 	in Cython that are not returned to the user.
 
+	If the sample has an arena (see :c:member:`SAMPLE.arena`), its data are
+	assumed to have been allocated from it, and they are released with a
+	handful of calls to ``free`` rather than several per datum.
+
 	.. seealso::
 
 		See "Notes" under function :c:func:`sample_free` for details on the
@@ -113,9 +318,59 @@ extern void sample_free_everything(SAMPLE *s);
 		data vectors already added to the sample.
 	d : ``DATUM *``
 		The vector to be included in this sample.
+
+	Notes
+	-----
+	The capacity of :c:member:`SAMPLE.data` doubles whenever it runs out,
+	so building a sample of :math:`N` data copies :math:`\mathcal{O}(N)`
+	pointers in total rather than :math:`\mathcal{O}(N^2)`.
 */
 extern void sample_add_datum(SAMPLE *s, DATUM *d);
 
+/*
+.. c:function:: extern SAMPLE *sample_from_arrays(const double *values, const double *errors, const unsigned char *mask, char **labels, const unsigned long n_data, const unsigned short n_labels);
+
+	Construct a :c:type:`SAMPLE` from contiguous arrays of measurements and
+	their uncertainties in a single pass.
+
+	Parameters
+	----------
+	values : ``const double *``
+		The measurements, with the ``k``'th quantity measured for the ``i``'th
+		datum at ``values[i * n_labels + k]``. ``NAN`` marks a quantity that
+		was not measured for a given datum.
+	errors : ``const double *``
+		The uncertainties, laid out like ``values``. Each datum's covariance
+		matrix is diagonal, with the squares of these values along the
+		diagonal. May be ``NULL``, in which case, and wherever an uncertainty
+		is ``NAN``, the variance is 1, as for a datum constructed without
+		an uncertainty in python.
+	mask : ``const unsigned char *``
+		Laid out like ``values``. If not ``NULL``, only the measurements at
+		which it is nonzero are used.
+	labels : ``char **``
+		The label of each quantity.
+	n_data : ``const unsigned long``
+		The number of data.
+	n_labels : ``const unsigned short``
+		The number of quantities.
+
+	Returns
+	-------
+	s : ``SAMPLE *``
+		The newly constructed sample, whose data are owned by the C library
+		and are freed by :c:func:`sample_free_everything`. ``NULL`` if any
+		datum would have no measurements at all.
+
+	Notes
+	-----
+	Each label is interned once rather than once per datum, and the labels,
+	IDs, and masks of the data are assigned directly.
+*/
+extern SAMPLE *sample_from_arrays(const double *values, const double *errors,
+	const unsigned char *mask, char **labels, const unsigned long n_data,
+	const unsigned short n_labels);
+
 /*
 .. c:function:: extern SAMPLE *sample_specific_quantities(SAMPLE s, char **labels, unsigned short n_labels);
 
@@ -209,6 +464,392 @@ extern unsigned long *sample_filter_indices(SAMPLE s, char *label,
 	unsigned short condition_indicator, double value,
 	unsigned short keep_missing_measurements);
 
+/*
+.. c:macro:: SAMPLE_FILTER_ALL
+.. c:macro:: SAMPLE_FILTER_ANY
+
+	How :c:func:`sample_filter_compound` combines its conditions:
+
+	- ``0u``: A datum passes if it satisfies every condition (AND).
+	- ``1u``: A datum passes if it satisfies at least one condition (OR).
+*/
+#define SAMPLE_FILTER_ALL 0u
+#define SAMPLE_FILTER_ANY 1u
+
+typedef struct sample_condition {
+
+	/*
+	.. c:type:: SAMPLE_CONDITION
+
+		One condition of a filter applied by :c:func:`sample_filter_compound`.
+
+		.. c:member:: char *label
+
+			The label of the quantity to filter based on.
+
+		.. c:member:: unsigned short condition_indicator
+
+			The condition to apply, encoded as in
+			:c:func:`sample_filter_indices`.
+
+		.. c:member:: double value
+
+			The value to condition based on.
+
+		.. c:member:: unsigned short keep_missing_measurements
+
+			Nonzero if data without a measurement of :c:member:`label`
+			satisfy the condition, zero if they do not.
+	*/
+
+	char *label;
+	unsigned short condition_indicator;
+	double value;
+	unsigned short keep_missing_measurements;
+
+} SAMPLE_CONDITION;
+
+/*
+.. c:function:: extern unsigned long *sample_filter_compound(SAMPLE *s, const SAMPLE_CONDITION *conditions, const unsigned short n_conditions, const unsigned short combine);
+
+	Determine the indices of data vectors that pass several filter conditions
+	at once.
+
+	Parameters
+	----------
+	s : ``SAMPLE *``
+		The sample to filter data from. It is packed by :c:func:`sample_pack`
+		if it has not been already.
+	conditions : ``const SAMPLE_CONDITION *``
+		The conditions to apply.
+	n_conditions : ``const unsigned short``
+		The number of elements in ``conditions``.
+	combine : ``const unsigned short``
+		:c:macro:`SAMPLE_FILTER_ALL` or :c:macro:`SAMPLE_FILTER_ANY`.
+
+	Returns
+	-------
+	idx : ``unsigned long *``
+		The number of data vectors that pass the filter followed by their
+		indices in ascending order, as returned by
+		:c:func:`sample_filter_indices`. ``NULL`` if any condition has an
+		unrecognized :c:member:`SAMPLE_CONDITION.condition_indicator`.
+
+	Notes
+	-----
+	The conditions are evaluated over the columns of the packed sample (see
+	:c:type:`PACKED_GROUP`), a group at a time. Each condition looks up its
+	label once per group rather than once per datum, and every condition is
+	evaluated for a datum while its vector is in cache. The data of a sample
+	read by :c:func:`sample_load` are not reconstructed.
+*/
+extern unsigned long *sample_filter_compound(SAMPLE *s,
+	const SAMPLE_CONDITION *conditions, const unsigned short n_conditions,
+	const unsigned short combine);
+
+/*
+.. c:function:: extern SAMPLE *sample_view(SAMPLE *s, const unsigned long *indices);
+
+	Obtain a sample containing some of the data of another without copying
+	them.
+
+	Parameters
+	----------
+	s : ``SAMPLE *``
+		The parent sample.
+	indices : ``const unsigned long *``
+		The number of data to include followed by their indices in ``s``, as
+		returned by :c:func:`sample_filter_compound`.
+
+	Returns
+	-------
+	view : ``SAMPLE *``
+		A new sample whose :c:member:`SAMPLE.data` point to the same
+		:c:type:`DATUM` objects as those of ``s``. Its
+		:c:member:`SAMPLE.arena` is ``NULL``, so it must be freed with
+		:c:func:`sample_free` rather than :c:func:`sample_free_everything`,
+		and before ``s`` is.
+*/
+extern SAMPLE *sample_view(SAMPLE *s, const unsigned long *indices);
+
+/*
+.. c:function:: extern void sample_column(SAMPLE *s, const char *label, double *values);
+
+	Extract the measurements of one quantity for every datum in a sample.
+
+	Parameters
+	----------
+	s : ``SAMPLE *``
+		The sample. It is packed by :c:func:`sample_pack` if it has not been
+		already.
+	label : ``const char *``
+		The label of the quantity.
+	values : ``double *``
+		The ``s -> n_vectors`` elements in which to store the measurements,
+		in the order of the data in the sample. Data without a measurement of
+		``label`` get ``NAN``.
+
+	Notes
+	-----
+	Like :c:func:`sample_filter_compound`, this reads the columns of the
+	packed sample a group at a time.
+*/
+extern void sample_column(SAMPLE *s, const char *label, double *values);
+
+/*
+.. c:function:: extern double **sample_column_pointers(SAMPLE *s, const char *label);
+
+	Obtain the address of the measurement of one quantity within each datum
+	of a sample.
+
+	Parameters
+	----------
+	s : ``SAMPLE *``
+		The sample.
+	label : ``const char *``
+		The label of the quantity.
+
+	Returns
+	-------
+	pointers : ``double **``
+		The ``s -> n_vectors`` addresses, in the order of the data in the
+		sample, which the python class ``linked_list`` takes ownership of.
+		Each datum without a measurement of ``label`` instead gets the
+		address of its own newly allocated ``NAN``, as ``linked_list``
+		expects.
+*/
+extern double **sample_column_pointers(SAMPLE *s, const char *label);
+
+/*
+.. c:function:: extern double sample_uncertainty_scale(SAMPLE *s, const char *label);
+
+	Determine the smallest uncertainty with which any datum in a sample
+	measures some quantity.
+
+	Parameters
+	----------
+	s : ``SAMPLE *``
+		The sample. It is packed by :c:func:`sample_pack` if it has not been
+		already.
+	label : ``const char *``
+		The label of the quantity.
+
+	Returns
+	-------
+	scale : ``double``
+		The smallest value of :math:`1 / \sqrt{C^{-1}_{kk}}` among the data
+		that measure ``label``, where :math:`C^{-1}_{kk}` is the diagonal
+		element of the inverse covariance matrix of the datum corresponding
+		to ``label``. This is the uncertainty in ``label`` with every other
+		measured quantity held fixed, which is no larger than the square root
+		of the variance. ``INFINITY`` if no datum measures ``label``.
+*/
+extern double sample_uncertainty_scale(SAMPLE *s, const char *label);
+
+/*
+.. c:function:: extern PACKED_SAMPLE *sample_pack(SAMPLE *s);
+
+	Obtain the packed representation of a sample, constructing it if it does
+	not already exist.
+
+	Parameters
+	----------
+	s : ``SAMPLE *``
+		The sample to pack.
+
+	Returns
+	-------
+	packed : ``PACKED_SAMPLE *``
+		The packed copy of the sample, which is also stored as
+		:c:member:`SAMPLE.packed`. The same pointer is returned on subsequent
+		calls until :c:func:`sample_invalidate` is called.
+
+	Notes
+	-----
+	Data vectors are assigned to a :c:type:`PACKED_GROUP` according to the
+	*set* of labels they carry, so two data with the same quantities listed
+	in a different order share a group. The first datum encountered with a
+	given set of labels determines the order of the components within the
+	group. If a datum's covariance matrix has not yet been inverted,
+	:c:func:`covariance_matrix_update` is called first.
+
+	Within each set of labels, every set of at least
+	:c:macro:`PACKED_GROUP_MIN_SHARED` data with identical inverse covariance
+	matrices (e.g., those of a survey with the same uncertainties for every
+	measurement) is then moved into a group of its own, which
+	:c:func:`packed_group_whiten` gives a transformation into its whitened
+	frame. The remaining data keep the group of their set of labels. Each
+	group lists its data in the order of the sample.
+
+	The packed copy is not updated automatically when the data are modified.
+	Any code that modifies the vectors or covariance matrices of data within
+	a sample must call :c:func:`sample_invalidate` before the next likelihood
+	calculation. TrackStar's python API handles this automatically.
+*/
+extern PACKED_SAMPLE *sample_pack(SAMPLE *s);
+
+/*
+.. c:function:: extern PACKED_SAMPLE *packed_sample_slice(const PACKED_SAMPLE *p, const unsigned long start, const unsigned long stop);
+
+	Copy a contiguous range of the data in a packed sample into a packed
+	sample of their own.
+
+	Parameters
+	----------
+	p : ``const PACKED_SAMPLE *``
+		The packed sample to copy the data from.
+	start : ``const unsigned long``
+		The position of the first datum to copy, counting through the data of
+		each group of ``p`` in turn.
+	stop : ``const unsigned long``
+		One past the position of the last datum to copy.
+
+	Returns
+	-------
+	slice : ``PACKED_SAMPLE *``
+		The copy, with one group for each group of ``p`` that has data in the
+		range, in the same order. Its :c:member:`PACKED_GROUP.indices` still
+		refer to the data of the whole sample. The caller is responsible for
+		freeing it with :c:func:`packed_sample_free`.
+
+	Notes
+	-----
+	Every array of the copy is written by the calling thread immediately after
+	it is allocated. Operating systems that place memory on the node of a
+	non-uniform memory access (NUMA) machine that first writes to it therefore
+	keep the copy local to that thread (see
+	:c:func:`likelihood_engine_initialize`).
+*/
+extern PACKED_SAMPLE *packed_sample_slice(const PACKED_SAMPLE *p,
+	const unsigned long start, const unsigned long stop);
+
+/*
+.. c:function:: extern void packed_sample_free(PACKED_SAMPLE *p);
+
+	Free up the memory stored by a :c:type:`PACKED_SAMPLE` object.
+
+	Parameters
+	----------
+	p : ``PACKED_SAMPLE *``
+		The packed sample to be freed.
+
+	Notes
+	-----
+	The packed copy of a sample returned by :c:func:`sample_pack` is freed
+	along with the sample, so this need only be called for those returned
+	by :c:func:`packed_sample_slice`.
+*/
+extern void packed_sample_free(PACKED_SAMPLE *p);
+
+/*
+.. c:function:: extern void packed_sample_single(PACKED_SAMPLE *p);
+
+	Store a single precision copy of the vectors and inverse covariance
+	matrices of the data in a packed sample, for likelihood calculations with
+	:c:macro:`LIKELIHOOD_PRECISION_SINGLE`, if it is not already stored.
+
+	Parameters
+	----------
+	p : ``PACKED_SAMPLE *``
+		The packed sample, whose :c:member:`PACKED_GROUP.single` is filled in
+		for each group.
+
+	Notes
+	-----
+	The double precision arrays are kept, since the line segment corrections
+	and the pruning bounds are still evaluated in double precision. Like the
+	packed sample itself, the copy is discarded along with it when the data
+	are modified.
+*/
+extern void packed_sample_single(PACKED_SAMPLE *p);
+
+/*
+.. c:function:: extern void packed_group_whiten(PACKED_GROUP *g);
+
+	Determine whether or not every datum in a group of a packed sample has
+	the same covariance matrix, and if so, compute the transformation into
+	its whitened frame.
+
+	Parameters
+	----------
+	g : ``PACKED_GROUP *``
+		The group, whose :c:member:`PACKED_GROUP.transform` is set.
+
+	Notes
+	-----
+	Catalogs with the same uncertainties for every measurement of a given
+	survey often carry thousands of identical covariance matrices. For such a
+	group, the Cholesky decomposition of the shared inverse covariance matrix
+	:math:`C^{-1} = RR^T` gives :math:`\chi^2 = |R^T\Delta|^2`, so the
+	likelihood calculation transforms the track into the whitened frame once
+	for the whole group, after which :math:`\chi^2` is the squared Euclidean
+	distance computed by :c:func:`squared_distance_points`. Groups of a
+	single datum are left alone, since transforming the track costs about as
+	much as the one datum would save. The inverse covariance matrices are
+	compared bit for bit, so data whose uncertainties differ at all are
+	never treated as sharing one.
+*/
+extern void packed_group_whiten(PACKED_GROUP *g);
+
+/*
+.. c:function:: extern void sample_invalidate(SAMPLE *s);
+
+	Discard the packed representation of a sample, if it exists, such that
+	the next call to :c:func:`sample_pack` reconstructs it from the current
+	values stored by each datum.
+
+	Parameters
+	----------
+	s : ``SAMPLE *``
+		The sample whose packed representation is to be discarded.
+*/
+extern void sample_invalidate(SAMPLE *s);
+
+/*
+.. c:function:: extern DATUM *sample_datum(SAMPLE *s, const unsigned long index);
+
+	Obtain a datum from a sample, reconstructing it from the packed
+	representation if the sample was read by :c:func:`sample_load` and the
+	datum has not yet been needed.
+
+	Parameters
+	----------
+	s : ``SAMPLE *``
+		The sample of interest.
+	index : ``const unsigned long``
+		The index of the datum within the sample.
+
+	Returns
+	-------
+	d : ``DATUM *``
+		The datum, which is also stored at ``s -> data[index]``.
+*/
+extern DATUM *sample_datum(SAMPLE *s, const unsigned long index);
+
+/*
+.. c:function:: extern unsigned long packed_index(const unsigned short i, const unsigned short j, const unsigned short dim);
+
+	Determine where the :math:`i,j`'th element of a symmetric matrix is
+	stored within its upper triangle packed row by row, as in
+	:c:member:`PACKED_GROUP.inv`.
+
+	Parameters
+	----------
+	i : ``const unsigned short``
+		The row number.
+	j : ``const unsigned short``
+		The column number. Must be >= ``i``.
+	dim : ``const unsigned short``
+		The number of rows and columns in the matrix.
+
+	Returns
+	-------
+	idx : ``unsigned long``
+		The index of the element within the packed upper triangle.
+*/
+extern unsigned long packed_index(const unsigned short i,
+	const unsigned short j, const unsigned short dim);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
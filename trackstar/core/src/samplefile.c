@@ -0,0 +1,679 @@
+/*
+This file is part of the TrackStar package.
+Copyright (C) 2023 James W. Johnson (giganano9@gmail.com)
+License: MIT License. See LICENSE in top-level directory
+at: https://github.com/giganano/TrackStar.git.
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "samplefile.h"
+#include "sample.h"
+#include "datum.h"
+#include "matrix.h"
+#include "arena.h"
+#include "labels.h"
+#include "utils.h"
+
+/* The first eight bytes of every binary sample file */
+static const char SAMPLE_FILE_MAGIC[8] = "TRKSTAR";
+
+/* ---------- Static function comment headers not duplicated here ---------- */
+static uint64_t reserve_block(uint64_t *offset, const uint64_t n_bytes);
+static unsigned short write_block(FILE *f, const void *block,
+	const uint64_t offset, const uint64_t n_bytes, uint64_t *position);
+static double *covariance_triangles(SAMPLE s, PACKED_GROUP g);
+static unsigned short read_file(int fd, void *storage, uint64_t size);
+static unsigned short block_fits(const uint64_t size, const uint64_t offset,
+	const uint64_t n, const uint64_t m, const uint64_t width);
+static unsigned short check_file(const void *storage, const uint64_t size);
+static SAMPLE *unpack_file(void *storage, const uint64_t storage_size);
+
+
+/*
+.. c:function:: extern unsigned short sample_save(SAMPLE *s, const char *path);
+
+	Write a sample to a binary sample file.
+
+	Parameters
+	----------
+	s : ``SAMPLE *``
+		The sample to write. It is packed by :c:func:`sample_pack` if it has
+		not been already.
+	path : ``const char *``
+		The path to the file, which is overwritten if it exists.
+
+	Returns
+	-------
+	status : ``unsigned short``
+		:c:macro:`SAMPLE_FILE_SUCCESS` or :c:macro:`SAMPLE_FILE_IO_ERROR`.
+
+	Notes
+	-----
+	The file stores the packed representation of the sample (see
+	:c:type:`PACKED_SAMPLE`) along with the covariance matrices of the data,
+	such that :c:func:`sample_load` can reconstruct each datum without
+	inverting its covariance matrix. The file is first written to ``path``
+	with ".tmp" appended and then renamed, so any process that has mapped a
+	previous version of the file into memory is unaffected.
+*/
+extern unsigned short sample_save(SAMPLE *s, const char *path) {
+
+	PACKED_SAMPLE *p = sample_pack(s);
+
+	/*
+	The label table holds each label carried by any group once, and the
+	groups refer to their labels by their index within it.
+	*/
+	unsigned short n_labels = 0u;
+	unsigned short *table = NULL;
+	uint16_t **group_labels = (uint16_t **) malloc (
+		(*p).n_groups * sizeof(uint16_t *));
+	for (unsigned long i = 0ul; i < (*p).n_groups; i++) {
+		PACKED_GROUP g = (*p).groups[i];
+		group_labels[i] = (uint16_t *) malloc (g.dim * sizeof(uint16_t));
+		for (unsigned short k = 0u; k < g.dim; k++) {
+			signed short idx = idindex(table, g.ids[k], n_labels);
+			if (idx == -1) {
+				table = (unsigned short *) realloc (table,
+					(n_labels + 1u) * sizeof(unsigned short));
+				table[n_labels] = g.ids[k];
+				idx = (signed short) n_labels++;
+			} else {}
+			group_labels[i][k] = (uint16_t) idx;
+		}
+	}
+
+	SAMPLE_FILE_HEADER header;
+	memset(&header, 0, sizeof(SAMPLE_FILE_HEADER));
+	memcpy(header.magic, SAMPLE_FILE_MAGIC, sizeof(header.magic));
+	header.version = SAMPLE_FILE_VERSION;
+	header.byte_order = 0x01020304u;
+	header.n_vectors = (*p).n_vectors;
+	header.n_groups = (*p).n_groups;
+	header.n_labels = n_labels;
+	header.label_size = MAX_LABEL_SIZE;
+
+	uint64_t offset = sizeof(SAMPLE_FILE_HEADER);
+	offset += (*p).n_groups * sizeof(SAMPLE_FILE_GROUP);
+	offset += (uint64_t) n_labels * MAX_LABEL_SIZE;
+	SAMPLE_FILE_GROUP *records = (SAMPLE_FILE_GROUP *) malloc (
+		(*p).n_groups * sizeof(SAMPLE_FILE_GROUP));
+	for (unsigned long i = 0ul; i < (*p).n_groups; i++) {
+		uint64_t dim = (*p).groups[i].dim;
+		uint64_t n = (*p).groups[i].n_data;
+		uint64_t n_tri = dim * (dim + 1ul) / 2ul;
+		records[i].dim = dim;
+		records[i].n_data = n;
+		records[i].labels = reserve_block(&offset, dim * sizeof(uint16_t));
+		records[i].indices = reserve_block(&offset, n * sizeof(uint64_t));
+		records[i].vectors = reserve_block(&offset, n * dim * sizeof(double));
+		records[i].cov = reserve_block(&offset, n * n_tri * sizeof(double));
+		records[i].inv = reserve_block(&offset, n * n_tri * sizeof(double));
+		records[i].logdet = reserve_block(&offset, n * sizeof(double));
+		records[i].whitening = reserve_block(&offset,
+			n * dim * sizeof(double));
+	}
+	header.file_size = offset;
+
+	/*
+	The file is written under a temporary name and then renamed, so that
+	processes which have mapped a previous version of it into memory keep
+	reading the old contents rather than a partially written file.
+	*/
+	unsigned short status = SAMPLE_FILE_IO_ERROR;
+	uint64_t position = 0ul;
+	char *temporary = (char *) malloc ((strlen(path) + 5u) * sizeof(char));
+	sprintf(temporary, "%s.tmp", path);
+	FILE *f = fopen(temporary, "wb");
+	if (f != NULL) {
+		unsigned short ok = write_block(f, &header, 0ul,
+			sizeof(SAMPLE_FILE_HEADER), &position);
+		ok &= write_block(f, records, position,
+			(*p).n_groups * sizeof(SAMPLE_FILE_GROUP), &position);
+		for (unsigned short k = 0u; k < n_labels && ok; k++) {
+			char label[MAX_LABEL_SIZE];
+			memset(label, '\0', MAX_LABEL_SIZE);
+			strncpy(label, label_name(table[k]), MAX_LABEL_SIZE - 1u);
+			ok &= write_block(f, label, position, MAX_LABEL_SIZE, &position);
+		}
+		for (unsigned long i = 0ul; i < (*p).n_groups && ok; i++) {
+			PACKED_GROUP g = (*p).groups[i];
+			SAMPLE_FILE_GROUP r = records[i];
+			uint64_t n_tri = r.dim * (r.dim + 1ul) / 2ul;
+			/* a sample that was itself loaded already has the triangles */
+			double *cov = g.cov != NULL ? g.cov : covariance_triangles(*s, g);
+			ok &= write_block(f, group_labels[i], r.labels,
+				r.dim * sizeof(uint16_t), &position);
+			ok &= write_block(f, g.indices, r.indices,
+				r.n_data * sizeof(uint64_t), &position);
+			ok &= write_block(f, g.vectors, r.vectors,
+				r.n_data * r.dim * sizeof(double), &position);
+			ok &= write_block(f, cov, r.cov,
+				r.n_data * n_tri * sizeof(double), &position);
+			ok &= write_block(f, g.inv, r.inv,
+				r.n_data * n_tri * sizeof(double), &position);
+			ok &= write_block(f, g.logdet, r.logdet,
+				r.n_data * sizeof(double), &position);
+			ok &= write_block(f, g.whitening, r.whitening,
+				r.n_data * r.dim * sizeof(double), &position);
+			if (g.cov == NULL) free(cov);
+		}
+		if (fclose(f)) ok = 0u;
+		if (ok && !rename(temporary, path)) {
+			status = SAMPLE_FILE_SUCCESS;
+		} else {
+			int error = errno;
+			remove(temporary);
+			errno = error;
+		}
+	} else {}
+	free(temporary);
+
+	for (unsigned long i = 0ul; i < (*p).n_groups; i++) free(group_labels[i]);
+	free(group_labels);
+	free(records);
+	free(table);
+	return status;
+
+}
+
+
+/*
+.. c:function:: static uint64_t reserve_block(uint64_t *offset, const uint64_t n_bytes);
+
+	Reserve space for an array within a binary sample file.
+
+	Parameters
+	----------
+	offset : ``uint64_t *``
+		The offset of the first byte that has not yet been reserved. Advanced
+		past the array.
+	n_bytes : ``const uint64_t``
+		The size of the array.
+
+	Returns
+	-------
+	start : ``uint64_t``
+		The offset of the array, the first multiple of
+		:c:macro:`SAMPLE_FILE_ALIGNMENT` at or after ``*offset``.
+*/
+static uint64_t reserve_block(uint64_t *offset, const uint64_t n_bytes) {
+
+	uint64_t start = (*offset + SAMPLE_FILE_ALIGNMENT - 1ul) / (
+		SAMPLE_FILE_ALIGNMENT) * SAMPLE_FILE_ALIGNMENT;
+	*offset = start + n_bytes;
+	return start;
+
+}
+
+
+/*
+.. c:function:: static unsigned short write_block(FILE *f, const void *block, const uint64_t offset, const uint64_t n_bytes, uint64_t *position);
+
+	Write a block of memory to a binary sample file at a given offset,
+	padding the file with zeros up to that point.
+
+	Parameters
+	----------
+	f : ``FILE *``
+		The file being written.
+	block : ``const void *``
+		The memory to write.
+	offset : ``const uint64_t``
+		The offset at which to write ``block``. Must not be before
+		``*position``.
+	n_bytes : ``const uint64_t``
+		The number of bytes to write.
+	position : ``uint64_t *``
+		The number of bytes written to the file so far. Advanced past the
+		block.
+
+	Returns
+	-------
+	ok : ``unsigned short``
+		1 if every byte was written successfully, 0 otherwise.
+*/
+static unsigned short write_block(FILE *f, const void *block,
+	const uint64_t offset, const uint64_t n_bytes, uint64_t *position) {
+
+	static const char zeros[SAMPLE_FILE_ALIGNMENT] = {0};
+	while (*position < offset) {
+		uint64_t n_pad = offset - *position;
+		if (n_pad > SAMPLE_FILE_ALIGNMENT) n_pad = SAMPLE_FILE_ALIGNMENT;
+		if (fwrite(zeros, 1u, n_pad, f) != n_pad) return 0u;
+		*position += n_pad;
+	}
+	if (n_bytes && fwrite(block, 1u, n_bytes, f) != n_bytes) return 0u;
+	*position += n_bytes;
+	return 1u;
+
+}
+
+
+/*
+.. c:function:: static double *covariance_triangles(SAMPLE s, PACKED_GROUP g);
+
+	Gather the covariance matrices of the data in a group of a packed sample,
+	which the group itself does not store.
+
+	Parameters
+	----------
+	s : ``SAMPLE``
+		The sample that was packed.
+	g : ``PACKED_GROUP``
+		The group of interest.
+
+	Returns
+	-------
+	cov : ``double *``
+		The upper triangles of the covariance matrices, with components in
+		the order of the group, laid out like :c:member:`PACKED_GROUP.inv`.
+*/
+static double *covariance_triangles(SAMPLE s, PACKED_GROUP g) {
+
+	unsigned long n_tri = (unsigned long) g.dim * (g.dim + 1ul) / 2ul;
+	double *cov = (double *) malloc (g.n_data * n_tri * sizeof(double));
+	unsigned short *perm = (unsigned short *) malloc (
+		g.dim * sizeof(unsigned short));
+	double *triangle = cov;
+	for (unsigned long i = 0ul; i < g.n_data; i++) {
+		DATUM d = *s.data[g.indices[i]];
+		for (unsigned short k = 0u; k < g.dim; k++) {
+			perm[k] = (unsigned short) idindex(d.ids, g.ids[k], d.n_cols);
+		}
+		for (unsigned short k = 0u; k < g.dim; k++) {
+			for (unsigned short l = k; l < g.dim; l++) {
+				*triangle++ = (*d.cov).matrix[perm[k]][perm[l]];
+			}
+		}
+	}
+	free(perm);
+	return cov;
+
+}
+
+
+/*
+.. c:function:: extern SAMPLE *sample_load(const char *path, const unsigned short use_mmap, unsigned short *status);
+
+	Read a sample from a binary sample file written by :c:func:`sample_save`.
+
+	Parameters
+	----------
+	path : ``const char *``
+		The path to the file.
+	use_mmap : ``const unsigned short``
+		Nonzero to map the file into memory, in which case the arrays of the
+		packed sample point directly into the mapping. Zero to read the file
+		into memory instead.
+	status : ``unsigned short *``
+		A pointer to store the status code in (see
+		:c:macro:`SAMPLE_FILE_SUCCESS`).
+
+	Returns
+	-------
+	s : ``SAMPLE *``
+		The sample, whose data are owned by the C library and are freed by
+		:c:func:`sample_free_everything`. Its packed representation,
+		:c:member:`SAMPLE.packed`, is already constructed. ``NULL`` unless
+		``*status`` is :c:macro:`SAMPLE_FILE_SUCCESS`.
+
+	Notes
+	-----
+	The file is mapped read-only and private to the process, so processes
+	that load the same file share its pages through the operating system's
+	page cache. No datum is reconstructed until :c:func:`sample_datum` is
+	called for it, and its covariance matrix is not inverted again when it is.
+	The components of each datum are in the order of its group, which need not
+	be the order in which they appeared in the datum that was saved.
+
+	If any datum is subsequently modified, :c:func:`sample_invalidate`
+	releases the file, and :c:func:`sample_pack` packs the data in memory as
+	usual.
+*/
+extern SAMPLE *sample_load(const char *path, const unsigned short use_mmap,
+	unsigned short *status) {
+
+	int fd = open(path, O_RDONLY);
+	if (fd == -1) {
+		*status = SAMPLE_FILE_IO_ERROR;
+		return NULL;
+	} else {}
+
+	struct stat info;
+	void *storage = NULL;
+	uint64_t size = 0ul;
+	*status = SAMPLE_FILE_IO_ERROR;
+	if (!fstat(fd, &info)) {
+		size = (uint64_t) info.st_size;
+		if (size < sizeof(SAMPLE_FILE_HEADER)) {
+			*status = SAMPLE_FILE_FORMAT_ERROR;
+		} else if (use_mmap) {
+			storage = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (storage == MAP_FAILED) storage = NULL;
+		} else {
+			storage = aligned_malloc(size);
+			if (storage != NULL && !read_file(fd, storage, size)) {
+				free(storage);
+				storage = NULL;
+			} else {}
+		}
+	} else {}
+
+	/* close might overwrite the errno describing a failure above */
+	int error = errno;
+	close(fd);
+	errno = error;
+	if (storage == NULL) return NULL;
+
+	*status = check_file(storage, size);
+	if (*status == SAMPLE_FILE_SUCCESS) {
+		return unpack_file(storage, use_mmap ? size : 0ul);
+	} else {
+		if (use_mmap) {
+			munmap(storage, size);
+		} else {
+			free(storage);
+		}
+		return NULL;
+	}
+
+}
+
+
+/*
+.. c:function:: static unsigned short read_file(int fd, void *storage, uint64_t size);
+
+	Read the entire contents of a file into memory.
+
+	Parameters
+	----------
+	fd : ``int``
+		The file descriptor of the file, positioned at its first byte.
+	storage : ``void *``
+		The memory to read the file into.
+	size : ``uint64_t``
+		The size of the file in bytes.
+
+	Returns
+	-------
+	ok : ``unsigned short``
+		1 if every byte was read successfully, 0 otherwise.
+*/
+static unsigned short read_file(int fd, void *storage, uint64_t size) {
+
+	char *next = (char *) storage;
+	while (size) {
+		ssize_t n_read = read(fd, next, size);
+		if (n_read > 0) {
+			next += n_read;
+			size -= (uint64_t) n_read;
+		} else if (n_read == 0) {
+			/* the file was truncated after fstat */
+			errno = EIO;
+			return 0u;
+		} else if (errno != EINTR) {
+			return 0u;
+		} else {}
+	}
+	return 1u;
+
+}
+
+
+/*
+.. c:function:: static unsigned short block_fits(const uint64_t size, const uint64_t offset, const uint64_t n, const uint64_t m, const uint64_t width);
+
+	Determine if an array recorded in a binary sample file lies entirely
+	within the file, without risk of overflow in computing its extent.
+
+	Parameters
+	----------
+	size : ``const uint64_t``
+		The size of the file in bytes.
+	offset : ``const uint64_t``
+		The offset of the array.
+	n : ``const uint64_t``
+		The number of rows in the array.
+	m : ``const uint64_t``
+		The number of columns in the array.
+	width : ``const uint64_t``
+		The size of each element in bytes.
+
+	Returns
+	-------
+	fits : ``unsigned short``
+		1 if the ``n * m * width`` bytes starting at ``offset`` are within the
+		file, 0 otherwise.
+*/
+static unsigned short block_fits(const uint64_t size, const uint64_t offset,
+	const uint64_t n, const uint64_t m, const uint64_t width) {
+
+	if (offset > size) return 0u;
+	uint64_t available = (size - offset) / width;
+	if (m && n > available / m) return 0u;
+	return n * m <= available;
+
+}
+
+
+/*
+.. c:function:: static unsigned short check_file(const void *storage, const uint64_t size);
+
+	Validate the contents of a binary sample file before any of it is used.
+
+	Parameters
+	----------
+	storage : ``const void *``
+		The contents of the file.
+	size : ``const uint64_t``
+		The size of the file in bytes. At least the size of a
+		:c:type:`SAMPLE_FILE_HEADER`.
+
+	Returns
+	-------
+	status : ``unsigned short``
+		:c:macro:`SAMPLE_FILE_SUCCESS` if the file is consistent with itself,
+		and :c:macro:`SAMPLE_FILE_FORMAT_ERROR` or
+		:c:macro:`SAMPLE_FILE_VERSION_ERROR` otherwise.
+
+	Notes
+	-----
+	Beyond checking that every array lies within the file, this function
+	confirms that the label indices of each group are within the label table
+	and that every datum of the sample appears in exactly one group, such
+	that :c:func:`unpack_file` can trust the file completely.
+*/
+static unsigned short check_file(const void *storage, const uint64_t size) {
+
+	const char *bytes = (const char *) storage;
+	const SAMPLE_FILE_HEADER *h = (const SAMPLE_FILE_HEADER *) storage;
+	if (memcmp((*h).magic, SAMPLE_FILE_MAGIC, sizeof((*h).magic))) {
+		return SAMPLE_FILE_FORMAT_ERROR;
+	} else if ((*h).byte_order != 0x01020304u ||
+		(*h).version > SAMPLE_FILE_VERSION) {
+		return SAMPLE_FILE_VERSION_ERROR;
+	} else if (!(*h).version || (*h).file_size != size ||
+		!(*h).label_size || (*h).n_labels > SHRT_MAX ||
+		(*h).n_vectors > size / sizeof(uint64_t) || !block_fits(size,
+			sizeof(SAMPLE_FILE_HEADER), (*h).n_groups, 1ul,
+			sizeof(SAMPLE_FILE_GROUP))) {
+		return SAMPLE_FILE_FORMAT_ERROR;
+	} else {}
+
+	/*
+	The indices of each group are used in place as the unsigned longs of
+	PACKED_GROUP.indices.
+	*/
+	if (sizeof(unsigned long) != sizeof(uint64_t)) {
+		return SAMPLE_FILE_VERSION_ERROR;
+	} else {}
+
+	uint64_t table = sizeof(SAMPLE_FILE_HEADER) + (*h).n_groups * sizeof(
+		SAMPLE_FILE_GROUP);
+	if (!block_fits(size, table, (*h).n_labels, (*h).label_size, 1ul)) {
+		return SAMPLE_FILE_FORMAT_ERROR;
+	} else {}
+	for (uint64_t k = 0ul; k < (*h).n_labels; k++) {
+		const char *label = bytes + table + k * (*h).label_size;
+		const char *end = memchr(label, '\0', (*h).label_size);
+		if (end == NULL || end == label ||
+			(uint64_t) (end - label) >= MAX_LABEL_SIZE) {
+			return SAMPLE_FILE_FORMAT_ERROR;
+		} else {}
+		for (uint64_t l = 0ul; l < k; l++) {
+			if (!strcmp(label, bytes + table + l * (*h).label_size)) {
+				return SAMPLE_FILE_FORMAT_ERROR;
+			} else {}
+		}
+	}
+
+	const SAMPLE_FILE_GROUP *records = (const SAMPLE_FILE_GROUP *) (
+		bytes + sizeof(SAMPLE_FILE_HEADER));
+	unsigned char *found = (unsigned char *) calloc ((*h).n_vectors + 1ul,
+		sizeof(unsigned char));
+	uint64_t n_found = 0ul;
+	unsigned short status = SAMPLE_FILE_SUCCESS;
+	for (uint64_t i = 0ul; i < (*h).n_groups && !status; i++) {
+		SAMPLE_FILE_GROUP r = records[i];
+		uint64_t n_tri = r.dim * (r.dim + 1ul) / 2ul;
+		if (!r.dim || r.dim > USHRT_MAX || !r.n_data ||
+			r.n_data > (*h).n_vectors - n_found) {
+			status = SAMPLE_FILE_FORMAT_ERROR;
+		} else if ((r.labels | r.indices | r.vectors | r.cov | r.inv |
+			r.logdet | r.whitening) % SAMPLE_FILE_ALIGNMENT) {
+			status = SAMPLE_FILE_FORMAT_ERROR;
+		} else if (!block_fits(size, r.labels, r.dim, 1ul, sizeof(uint16_t)) ||
+			!block_fits(size, r.indices, r.n_data, 1ul, sizeof(uint64_t)) ||
+			!block_fits(size, r.vectors, r.n_data, r.dim, sizeof(double)) ||
+			!block_fits(size, r.cov, r.n_data, n_tri, sizeof(double)) ||
+			!block_fits(size, r.inv, r.n_data, n_tri, sizeof(double)) ||
+			!block_fits(size, r.logdet, r.n_data, 1ul, sizeof(double)) ||
+			!block_fits(size, r.whitening, r.n_data, r.dim,
+				sizeof(double))) {
+			status = SAMPLE_FILE_FORMAT_ERROR;
+		} else {
+			const uint16_t *labels = (const uint16_t *) (bytes + r.labels);
+			for (uint64_t k = 0ul; k < r.dim && !status; k++) {
+				if (labels[k] >= (*h).n_labels) {
+					status = SAMPLE_FILE_FORMAT_ERROR;
+				} else {
+					for (uint64_t l = 0ul; l < k; l++) {
+						if (labels[l] == labels[k]) {
+							status = SAMPLE_FILE_FORMAT_ERROR;
+						} else {}
+					}
+				}
+			}
+			const uint64_t *indices = (const uint64_t *) (bytes + r.indices);
+			for (uint64_t j = 0ul; j < r.n_data && !status; j++) {
+				if (indices[j] >= (*h).n_vectors || found[indices[j]]) {
+					status = SAMPLE_FILE_FORMAT_ERROR;
+				} else {
+					found[indices[j]] = 1u;
+				}
+			}
+			n_found += r.n_data;
+		}
+	}
+	free(found);
+	if (!status && n_found != (*h).n_vectors) status = SAMPLE_FILE_FORMAT_ERROR;
+	return status;
+
+}
+
+
+/*
+.. c:function:: static SAMPLE *unpack_file(void *storage, const uint64_t storage_size);
+
+	Construct a sample from the contents of a binary sample file that has
+	passed :c:func:`check_file`.
+
+	Parameters
+	----------
+	storage : ``void *``
+		The contents of the file, which become
+		:c:member:`PACKED_SAMPLE.storage`.
+	storage_size : ``const uint64_t``
+		The size of ``storage`` if it is a memory mapping of the file, 0 if
+		it was allocated with :c:func:`aligned_malloc`.
+
+	Returns
+	-------
+	s : ``SAMPLE *``
+		The sample, with its packed representation already constructed and
+		each of its data ``NULL`` until :c:func:`sample_datum` is called.
+*/
+static SAMPLE *unpack_file(void *storage, const uint64_t storage_size) {
+
+	char *bytes = (char *) storage;
+	const SAMPLE_FILE_HEADER *h = (const SAMPLE_FILE_HEADER *) storage;
+	const SAMPLE_FILE_GROUP *records = (const SAMPLE_FILE_GROUP *) (
+		bytes + sizeof(SAMPLE_FILE_HEADER));
+
+	/* label IDs are specific to this process, so labels are interned anew */
+	const char *table = bytes + sizeof(SAMPLE_FILE_HEADER) + (
+		*h).n_groups * sizeof(SAMPLE_FILE_GROUP);
+	unsigned short *ids = (unsigned short *) malloc (
+		(*h).n_labels * sizeof(unsigned short));
+	for (uint64_t k = 0ul; k < (*h).n_labels; k++) {
+		ids[k] = label_intern(table + k * (*h).label_size);
+	}
+
+	PACKED_SAMPLE *p = (PACKED_SAMPLE *) malloc (sizeof(PACKED_SAMPLE));
+	p -> groups = (PACKED_GROUP *) malloc (
+		(*h).n_groups * sizeof(PACKED_GROUP));
+	p -> n_groups = (*h).n_groups;
+	p -> n_vectors = (*h).n_vectors;
+	p -> storage = storage;
+	p -> storage_size = storage_size;
+	p -> locations = (unsigned long *) malloc (
+		2ul * (*h).n_vectors * sizeof(unsigned long));
+
+	/* the data are reconstructed by sample_datum as they're needed */
+	SAMPLE *s = sample_initialize();
+	s -> data = (DATUM **) calloc ((*h).n_vectors, sizeof(DATUM *));
+	s -> n_vectors = (*h).n_vectors;
+	s -> capacity = (*h).n_vectors;
+	s -> arena = arena_initialize();
+	for (uint64_t i = 0ul; i < (*h).n_groups; i++) {
+		SAMPLE_FILE_GROUP r = records[i];
+		PACKED_GROUP *g = &(p -> groups[i]);
+		const uint16_t *labels = (const uint16_t *) (bytes + r.labels);
+		g -> dim = (unsigned short) r.dim;
+		g -> n_data = r.n_data;
+		g -> labels = (char **) malloc ((*g).dim * sizeof(char *));
+		g -> ids = (unsigned short *) malloc (
+			(*g).dim * sizeof(unsigned short));
+		for (unsigned short k = 0u; k < (*g).dim; k++) {
+			g -> ids[k] = ids[labels[k]];
+			g -> labels[k] = label_name((*g).ids[k]);
+		}
+		g -> mask = label_mask((*g).ids, (*g).dim);
+		g -> indices = (unsigned long *) (bytes + r.indices);
+		g -> vectors = (double *) (bytes + r.vectors);
+		g -> inv = (double *) (bytes + r.inv);
+		g -> logdet = (double *) (bytes + r.logdet);
+		g -> whitening = (double *) (bytes + r.whitening);
+		g -> cov = (double *) (bytes + r.cov);
+		g -> single = NULL;
+		packed_group_whiten(g);
+		for (unsigned long j = 0ul; j < (*g).n_data; j++) {
+			p -> locations[2ul * (*g).indices[j]] = i;
+			p -> locations[2ul * (*g).indices[j] + 1ul] = j;
+		}
+	}
+	free(ids);
+	s -> packed = p;
+	return s;
+
+}
+
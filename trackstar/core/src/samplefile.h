@@ -0,0 +1,267 @@
+/*
+This file is part of the TrackStar package.
+Copyright (C) 2023 James W. Johnson (giganano9@gmail.com)
+License: MIT License. See LICENSE in top-level directory
+at: https://github.com/giganano/TrackStar.git.
+
+**Source File**: ``trackstar/core/src/samplefile.c``
+*/
+
+#ifndef SAMPLEFILE_H
+#define SAMPLEFILE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <stdint.h>
+#include "sample.h"
+
+/*
+.. c:macro:: SAMPLE_FILE_VERSION
+
+	``1u``. The version of the binary sample file format written by
+	:c:func:`sample_save`. :c:func:`sample_load` reads files of this version
+	or older.
+*/
+#define SAMPLE_FILE_VERSION 1u
+
+/*
+.. c:macro:: SAMPLE_FILE_ALIGNMENT
+
+	``64ul``. The alignment in bytes of each array within a binary sample
+	file, relative to the start of the file. As long as this is a multiple of
+	:c:macro:`CACHE_LINE_SIZE`, the arrays of a memory-mapped file are as
+	well-aligned as those constructed by :c:func:`sample_pack`. This is a
+	property of the file format, and changing it requires a new
+	:c:macro:`SAMPLE_FILE_VERSION`.
+*/
+#define SAMPLE_FILE_ALIGNMENT 64ul
+
+/*
+.. c:macro:: SAMPLE_FILE_SUCCESS
+.. c:macro:: SAMPLE_FILE_IO_ERROR
+.. c:macro:: SAMPLE_FILE_FORMAT_ERROR
+.. c:macro:: SAMPLE_FILE_VERSION_ERROR
+
+	The status codes of :c:func:`sample_save` and :c:func:`sample_load`:
+
+	- ``0u``: The file was written or read successfully.
+	- ``1u``: The file could not be opened, written, read, or mapped into
+	  memory, in which case ``errno`` describes the reason.
+	- ``2u``: The file is not a binary sample file, or it is truncated or
+	  otherwise corrupted.
+	- ``3u``: The file was written by a newer version of TrackStar or on a
+	  machine with a different byte order.
+*/
+#define SAMPLE_FILE_SUCCESS 0u
+#define SAMPLE_FILE_IO_ERROR 1u
+#define SAMPLE_FILE_FORMAT_ERROR 2u
+#define SAMPLE_FILE_VERSION_ERROR 3u
+
+typedef struct sample_file_header {
+
+	/*
+	.. c:type:: SAMPLE_FILE_HEADER
+
+		The first 64 bytes of a binary sample file. It is followed by
+		``n_groups`` records of type :c:type:`SAMPLE_FILE_GROUP`, then by the
+		label table: ``n_labels`` strings, each occupying ``label_size``
+		bytes and padded with null characters. The arrays of each group
+		follow, each located by its offset from the start of the file.
+
+		All values are stored in the byte order of the machine that wrote the
+		file, which :c:member:`byte_order` records.
+
+		.. c:member:: char magic[8]
+
+			The characters "TRKSTAR" followed by a null character.
+
+		.. c:member:: uint32_t version
+
+			The :c:macro:`SAMPLE_FILE_VERSION` that the file was written with.
+
+		.. c:member:: uint32_t byte_order
+
+			``0x01020304``, which reads differently on a machine with a
+			different byte order.
+
+		.. c:member:: uint64_t n_vectors
+
+			The number of data vectors in the sample.
+
+		.. c:member:: uint64_t n_groups
+
+			The number of groups of data that share the same set of measured
+			quantities (see :c:type:`PACKED_GROUP`).
+
+		.. c:member:: uint64_t n_labels
+
+			The number of entries in the label table.
+
+		.. c:member:: uint64_t label_size
+
+			The number of bytes occupied by each entry in the label table.
+
+		.. c:member:: uint64_t file_size
+
+			The size of the file in bytes.
+
+		.. c:member:: uint64_t reserved
+
+			Unused; 0.
+	*/
+
+	char magic[8];
+	uint32_t version;
+	uint32_t byte_order;
+	uint64_t n_vectors;
+	uint64_t n_groups;
+	uint64_t n_labels;
+	uint64_t label_size;
+	uint64_t file_size;
+	uint64_t reserved;
+
+} SAMPLE_FILE_HEADER;
+
+typedef struct sample_file_group {
+
+	/*
+	.. c:type:: SAMPLE_FILE_GROUP
+
+		The record of one :c:type:`PACKED_GROUP` within a binary sample file.
+		Every member other than :c:member:`dim` and :c:member:`n_data` is the
+		offset in bytes from the start of the file to an array, which is a
+		multiple of :c:macro:`SAMPLE_FILE_ALIGNMENT`.
+
+		.. c:member:: uint64_t dim
+
+			The number of quantities measured for each datum in the group.
+
+		.. c:member:: uint64_t n_data
+
+			The number of data vectors in the group.
+
+		.. c:member:: uint64_t labels
+
+			``dim`` values of type ``uint16_t``: the index within the label
+			table of each quantity, in the order of the components of the
+			vectors and matrices of the group.
+
+		.. c:member:: uint64_t indices
+
+			``n_data`` values of type ``uint64_t``: the index of each datum in
+			the group within the sample.
+
+		.. c:member:: uint64_t vectors
+
+			The data vectors, laid out like :c:member:`PACKED_GROUP.vectors`.
+
+		.. c:member:: uint64_t cov
+
+			The upper triangles of the covariance matrices of the data, laid
+			out like :c:member:`PACKED_GROUP.inv`.
+
+		.. c:member:: uint64_t inv
+
+			The upper triangles of the inverse covariance matrices, laid out
+			like :c:member:`PACKED_GROUP.inv`.
+
+		.. c:member:: uint64_t logdet
+
+			The log-determinants of the covariance matrices, laid out like
+			:c:member:`PACKED_GROUP.logdet`.
+
+		.. c:member:: uint64_t whitening
+
+			The whitening scale factors, laid out like
+			:c:member:`PACKED_GROUP.whitening`.
+	*/
+
+	uint64_t dim;
+	uint64_t n_data;
+	uint64_t labels;
+	uint64_t indices;
+	uint64_t vectors;
+	uint64_t cov;
+	uint64_t inv;
+	uint64_t logdet;
+	uint64_t whitening;
+
+} SAMPLE_FILE_GROUP;
+
+/*
+.. c:function:: extern unsigned short sample_save(SAMPLE *s, const char *path);
+
+	Write a sample to a binary sample file.
+
+	Parameters
+	----------
+	s : ``SAMPLE *``
+		The sample to write. It is packed by :c:func:`sample_pack` if it has
+		not been already.
+	path : ``const char *``
+		The path to the file, which is overwritten if it exists.
+
+	Returns
+	-------
+	status : ``unsigned short``
+		:c:macro:`SAMPLE_FILE_SUCCESS` or :c:macro:`SAMPLE_FILE_IO_ERROR`.
+
+	Notes
+	-----
+	The file stores the packed representation of the sample (see
+	:c:type:`PACKED_SAMPLE`) along with the covariance matrices of the data,
+	such that :c:func:`sample_load` can reconstruct each datum without
+	inverting its covariance matrix. The file is first written to ``path``
+	with ".tmp" appended and then renamed, so any process that has mapped a
+	previous version of the file into memory is unaffected.
+*/
+extern unsigned short sample_save(SAMPLE *s, const char *path);
+
+/*
+.. c:function:: extern SAMPLE *sample_load(const char *path, const unsigned short use_mmap, unsigned short *status);
+
+	Read a sample from a binary sample file written by :c:func:`sample_save`.
+
+	Parameters
+	----------
+	path : ``const char *``
+		The path to the file.
+	use_mmap : ``const unsigned short``
+		Nonzero to map the file into memory, in which case the arrays of the
+		packed sample point directly into the mapping. Zero to read the file
+		into memory instead.
+	status : ``unsigned short *``
+		A pointer to store the status code in (see
+		:c:macro:`SAMPLE_FILE_SUCCESS`).
+
+	Returns
+	-------
+	s : ``SAMPLE *``
+		The sample, whose data are owned by the C library and are freed by
+		:c:func:`sample_free_everything`. Its packed representation,
+		:c:member:`SAMPLE.packed`, is already constructed. ``NULL`` unless
+		``*status`` is :c:macro:`SAMPLE_FILE_SUCCESS`.
+
+	Notes
+	-----
+	The file is mapped read-only and private to the process, so processes
+	that load the same file share its pages through the operating system's
+	page cache. No datum is reconstructed until :c:func:`sample_datum` is
+	called for it, and its covariance matrix is not inverted again when it is.
+	The components of each datum are in the order of its group, which need not
+	be the order in which they appeared in the datum that was saved.
+
+	If any datum is subsequently modified, :c:func:`sample_invalidate`
+	releases the file, and :c:func:`sample_pack` packs the data in memory as
+	usual.
+*/
+extern SAMPLE *sample_load(const char *path, const unsigned short use_mmap,
+	unsigned short *status);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SAMPLEFILE_H */
@@ -7,11 +7,20 @@ at https://github.com/giganano/TrackStar.git.
 
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
 #include "track.h"
 #include "matrix.h"
 #include "datum.h"
+#include "labels.h"
 #include "utils.h"
 
+/* ---------- Static function comment headers not duplicated here ---------- */
+static unsigned short compress_split(const TRACK *t, const double *scale,
+	const double tolerance, const double max_length,
+	const unsigned short first, const unsigned short last);
+static double scaled_distance(const TRACK *t, const double *scale,
+	const unsigned short first, const unsigned short last);
+
 /*
 .. c:function:: extern TRACK *track_initialize(double **predictions, char **labels, double *weights, unsigned short n_vectors, unsigned short dim);
 
@@ -35,23 +44,21 @@ at https://github.com/giganano/TrackStar.git.
 */
 extern TRACK *track_initialize(unsigned short n_vectors, unsigned short dim) {
 
-	TRACK *t = (TRACK *) malloc (sizeof(TRACK));
-	t -> n_vectors = n_vectors;
-	t -> dim = dim;
+	/* the predictions are laid out like the elements of a MATRIX */
+	TRACK *t = (TRACK *) matrix_initialize(n_vectors, dim);
+	t = (TRACK *) realloc (t, sizeof(TRACK));
 	t -> n_threads = 1u;
+	t -> parallel_policy = 0u;
 	t -> normalize_weights = 1u;
 	t -> use_line_segment_corrections = 0u;
-	t -> predictions = (double **) malloc (n_vectors * sizeof(double *));
+	t -> pruning_threshold = PRUNING_OFF;
+	t -> weight_norm_factor = 1;
 	t -> labels = (char **) malloc (dim * sizeof(char *));
 	t -> weights = (double *) malloc (n_vectors * sizeof(double));
-
-	for (unsigned short i = 0u; i < n_vectors; i++) {
-		t -> predictions[i] = (double *) malloc (dim * sizeof(double));
-	}
-
+	t -> ids = (unsigned short *) malloc (dim * sizeof(unsigned short));
 	for (unsigned short i = 0u; i < dim; i++) {
-		t -> labels[i] = (char *) malloc (MAX_LABEL_SIZE * sizeof(char));
-		memset(t -> labels[i], '\0', MAX_LABEL_SIZE);
+		t -> labels[i] = NULL;
+		t -> ids[i] = 0u;
 	}
 
 	return t;
@@ -59,6 +66,30 @@ extern TRACK *track_initialize(unsigned short n_vectors, unsigned short dim) {
 }
 
 
+/*
+.. c:function:: extern void track_set_label(TRACK *t, unsigned short index, const char *label);
+
+	Assign the label of one of the axes of the observed space.
+
+	Parameters
+	----------
+	t : ``TRACK *``
+		The track whose label is to be assigned.
+	index : ``unsigned short``
+		The axis of the observed space (i.e., the column of
+		:c:member:`TRACK.predictions`) that ``label`` describes.
+	label : ``const char *``
+		The label itself, which is interned by :c:func:`label_intern`.
+*/
+extern void track_set_label(TRACK *t, unsigned short index,
+	const char *label) {
+
+	t -> ids[index] = label_intern(label);
+	t -> labels[index] = label_name((*t).ids[index]);
+
+}
+
+
 /*
 .. c:function:: extern void track_free(TRACK *t);
 
@@ -73,14 +104,304 @@ extern void track_free(TRACK *t) {
 
 	if (t != NULL) {
 
-		if ((*t).labels != NULL) {
-			unsigned short i;
-			for (i = 0u; i < (*t).dim; i++) free(t -> labels[i]);
-			free(t -> labels);
-		} else {}
+		/* The label strings themselves belong to the label registry. */
+		if ((*t).labels != NULL) free(t -> labels);
+		if ((*t).ids != NULL) free(t -> ids);
 		if ((*t).weights != NULL) free(t -> weights);
 		matrix_free( (MATRIX *) t);
 
 	} else {}
 
 }
+
+
+/*
+.. c:function:: extern TRACK *track_compress(const TRACK *t, const double *scale, const double tolerance, const double max_length);
+
+	Construct a copy of a track sampled at fewer points, omitting those that
+	lie close enough to the straight line connecting their neighbors.
+
+	Parameters
+	----------
+	t : ``const TRACK *``
+		The track to compress. It is not modified.
+	scale : ``const double *``
+		A positive scale for each axis of the observed space (i.e., each
+		column of :c:member:`TRACK.predictions`), in units of which distances
+		are measured. ``INFINITY`` excludes an axis from every distance.
+	tolerance : ``const double``
+		The largest distance that an omitted point may lie from the line
+		segment that replaces it, and the largest fractional difference
+		between the weights of the line segments that are merged.
+	max_length : ``const double``
+		The largest length of any line segment that replaces two or more
+		others. ``INFINITY`` for no limit.
+
+	Returns
+	-------
+	compressed : ``TRACK *``
+		The new track, whose first and last points are those of ``t``, and
+		whose settings and labels are copied from ``t``. The caller is
+		responsible for freeing it with :c:func:`track_free`.
+
+	Notes
+	-----
+	Points are omitted following the Douglas-Peucker algorithm, recursively
+	splitting the track at the point farthest from the line segment
+	connecting the first and last points under consideration. Spans that are
+	straight enough are also split in half if their weights vary by more than
+	``tolerance`` or if they are longer than ``max_length``.
+
+	The weight of each point of the new track is the mean of the weights of
+	the line segments it replaces, weighted by their lengths, such that the
+	product of weight and length summed along each span is unchanged. The
+	last point keeps its weight. With line segment corrections, the sum over
+	the points of the track for each datum is therefore unchanged up to the
+	deviations allowed by ``tolerance``. Normalized weights are divided by
+	their mean over the points, which differs between the two tracks unless
+	the weights are uniform, so :c:member:`TRACK.weight_norm_factor` of the
+	new track is set such that :c:func:`track_weight_norm` agrees with that
+	of ``t``. Without normalization, the sum of the weights over the points
+	is subtracted from the log-likelihood, which is smaller for the new track
+	and is not corrected.
+*/
+extern TRACK *track_compress(const TRACK *t, const double *scale,
+	const double tolerance, const double max_length) {
+
+	/* keep[i] marks the points of t that the new track retains */
+	unsigned short n = (*t).n_vectors;
+	unsigned char *keep = (unsigned char *) calloc (n, sizeof(unsigned char));
+	if (n) {
+		keep[0] = 1u;
+		keep[n - 1u] = 1u;
+	} else {}
+
+	/* each span splits into at most two, so at most n are pending at once */
+	unsigned short *spans = (unsigned short *) malloc (
+		2ul * (n + 1ul) * sizeof(unsigned short));
+	unsigned long n_spans = 0ul;
+	if (n > 2u) {
+		spans[0] = 0u;
+		spans[1] = n - 1u;
+		n_spans = 1ul;
+	} else {}
+	while (n_spans) {
+		n_spans--;
+		unsigned short first = spans[2ul * n_spans];
+		unsigned short last = spans[2ul * n_spans + 1ul];
+		unsigned short split = compress_split(t, scale, tolerance,
+			max_length, first, last);
+		if (split) {
+			keep[split] = 1u;
+			if (split > first + 1u) {
+				spans[2ul * n_spans] = first;
+				spans[2ul * n_spans + 1ul] = split;
+				n_spans++;
+			} else {}
+			if (last > split + 1u) {
+				spans[2ul * n_spans] = split;
+				spans[2ul * n_spans + 1ul] = last;
+				n_spans++;
+			} else {}
+		} else {}
+	}
+	free(spans);
+
+	unsigned short n_kept = 0u;
+	for (unsigned short i = 0u; i < n; i++) n_kept += keep[i];
+	TRACK *compressed = track_initialize(n_kept, (*t).dim);
+	compressed -> n_threads = (*t).n_threads;
+	compressed -> parallel_policy = (*t).parallel_policy;
+	compressed -> normalize_weights = (*t).normalize_weights;
+	compressed -> use_line_segment_corrections = (
+		*t).use_line_segment_corrections;
+	compressed -> pruning_threshold = (*t).pruning_threshold;
+	for (unsigned short k = 0u; k < (*t).dim; k++) {
+		compressed -> ids[k] = (*t).ids[k];
+		compressed -> labels[k] = (*t).labels[k];
+	}
+
+	unsigned short j = 0u;
+	for (unsigned short i = 0u; i < n; i++) {
+		if (keep[i]) {
+			memcpy(compressed -> predictions[j], (*t).predictions[i],
+				(*t).dim * sizeof(double));
+			compressed -> weights[j] = (*t).weights[i];
+			if (i < n - 1u) {
+				/* the product of weight and length over the omitted points */
+				unsigned short next = i + 1u;
+				double product = (*t).weights[i] * scaled_distance(t, scale,
+					i, next);
+				while (!keep[next]) {
+					product += (*t).weights[next] * scaled_distance(t, scale,
+						next, next + 1u);
+					next++;
+				}
+				double length = scaled_distance(t, scale, i, next);
+				if (length > 0) compressed -> weights[j] = product / length;
+			} else {}
+			j++;
+		} else {}
+	}
+	free(keep);
+
+	/* as if the mean weight over the points were that of t */
+	compressed -> weight_norm_factor = 1;
+	double norm = track_weight_norm(compressed);
+	if (norm > 0) {
+		compressed -> weight_norm_factor = track_weight_norm(t) / norm;
+	} else {}
+	return compressed;
+
+}
+
+
+/*
+.. c:function:: extern double track_weight_norm(const TRACK *t);
+
+	Determine the amount by which the weights of a track are divided when
+	they are normalized (see
+	:c:member:`LIKELIHOOD_CONTEXT.normalize_weights`).
+
+	Parameters
+	----------
+	t : ``const TRACK *``
+		The track in question.
+
+	Returns
+	-------
+	norm : ``double``
+		1000 times the mean of :c:member:`TRACK.weights` over the points,
+		multiplied by :c:member:`TRACK.weight_norm_factor`. Since it is
+		proportional to the sum of the weights, the normalized weights do
+		not change if they are all scaled by a common factor.
+*/
+extern double track_weight_norm(const TRACK *t) {
+
+	return (*t).weight_norm_factor * sum((*t).weights, (*t).n_vectors) *
+		1000.f / (*t).n_vectors;
+
+}
+
+
+/*
+.. c:function:: static unsigned short compress_split(const TRACK *t, const double *scale, const double tolerance, const double max_length, const unsigned short first, const unsigned short last);
+
+	Determine where, if anywhere, :c:func:`track_compress` must split a span
+	of consecutive points along a track before it can be replaced with a
+	single line segment.
+
+	Parameters
+	----------
+	t : ``const TRACK *``
+		The track being compressed.
+	scale : ``const double *``
+		The scale of each axis of the observed space, as passed to
+		:c:func:`track_compress`.
+	tolerance : ``const double``
+		The tolerance, as passed to :c:func:`track_compress`.
+	max_length : ``const double``
+		The largest length of the line segment, as passed to
+		:c:func:`track_compress`.
+	first : ``const unsigned short``
+		The index of the first point of the span.
+	last : ``const unsigned short``
+		The index of the last point of the span, at least two greater than
+		``first``.
+
+	Returns
+	-------
+	split : ``unsigned short``
+		0 if the points between ``first`` and ``last`` may be omitted. If not,
+		the index of the point farthest from the line segment connecting
+		``first`` and ``last`` if it is farther than ``tolerance``, and the
+		point halfway between them otherwise.
+*/
+static unsigned short compress_split(const TRACK *t, const double *scale,
+	const double tolerance, const double max_length,
+	const unsigned short first, const unsigned short last) {
+
+	const unsigned short dim = (*t).dim;
+	const double *start = (*t).predictions[first];
+	const double *end = (*t).predictions[last];
+	double squared_length = 0;
+	for (unsigned short k = 0u; k < dim; k++) {
+		double u = (end[k] - start[k]) / scale[k];
+		squared_length += u * u;
+	}
+
+	unsigned short farthest = 0u;
+	double largest = tolerance * tolerance;
+	double lightest = (*t).weights[first], heaviest = (*t).weights[first];
+	for (unsigned short i = first + 1u; i < last; i++) {
+		/* the position of the nearest point on the segment, from 0 to 1 */
+		const double *point = (*t).predictions[i];
+		double s = 0;
+		for (unsigned short k = 0u; k < dim; k++) {
+			s += (point[k] - start[k]) * (end[k] - start[k]) / (
+				scale[k] * scale[k]);
+		}
+		s = squared_length > 0 ? s / squared_length : 0;
+		if (s < 0) s = 0;
+		if (s > 1) s = 1;
+		double squared_distance = 0;
+		for (unsigned short k = 0u; k < dim; k++) {
+			double delta = (point[k] - start[k] - s * (end[k] - start[k])) /
+				scale[k];
+			squared_distance += delta * delta;
+		}
+		if (squared_distance > largest) {
+			largest = squared_distance;
+			farthest = i;
+		} else {}
+		if ((*t).weights[i] < lightest) lightest = (*t).weights[i];
+		if ((*t).weights[i] > heaviest) heaviest = (*t).weights[i];
+	}
+
+	if (farthest) {
+		return farthest;
+	} else if (heaviest - lightest > tolerance * heaviest ||
+		squared_length > max_length * max_length) {
+		return first + (last - first) / 2u;
+	} else {
+		return 0u;
+	}
+
+}
+
+
+/*
+.. c:function:: static double scaled_distance(const TRACK *t, const double *scale, const unsigned short first, const unsigned short last);
+
+	Compute the distance between two points along a track, in units of a
+	scale along each axis of the observed space.
+
+	Parameters
+	----------
+	t : ``const TRACK *``
+		The track.
+	scale : ``const double *``
+		The scale of each axis of the observed space, as passed to
+		:c:func:`track_compress`.
+	first : ``const unsigned short``
+		The index of one of the points.
+	last : ``const unsigned short``
+		The index of the other point.
+
+	Returns
+	-------
+	distance : ``double``
+		The distance between the two points.
+*/
+static double scaled_distance(const TRACK *t, const double *scale,
+	const unsigned short first, const unsigned short last) {
+
+	double squared = 0;
+	for (unsigned short k = 0u; k < (*t).dim; k++) {
+		double delta = ((*t).predictions[last][k] -
+			(*t).predictions[first][k]) / scale[k];
+		squared += delta * delta;
+	}
+	return sqrt(squared);
+
+}
@@ -14,6 +14,16 @@ at: https://github.com/giganano/TrackStar.git.
 extern "C" {
 #endif /* __cplusplus */
 
+/*
+.. c:macro:: PRUNING_OFF
+
+	``-1``. The default value of :c:member:`TRACK.pruning_threshold`, with
+	which the contributions of the points along the track to the likelihood
+	of observing a datum are summed in linear space. Any negative value has
+	the same effect.
+*/
+#define PRUNING_OFF -1
+
 typedef struct track {
 
 	/*
@@ -28,7 +38,9 @@ typedef struct track {
 			The vectors in the observed space themselves. The first axis of
 			indexing corresponds to different vectors, and the second axis
 			corresponds to different axes of the observed space for the same
-			vector (i.e., different vector components).
+			vector (i.e., different vector components). The vectors are
+			stored contiguously, one after another, as the elements of a
+			:c:type:`MATRIX` are (see :c:func:`matrix_elements`).
 
 		.. c:member:: unsigned short n_rows
 
@@ -47,12 +59,26 @@ typedef struct track {
 			The number of parallel processing threads to use in computing
 			likelihood functions.
 
+		.. c:member:: unsigned short parallel_policy
+
+			Which loop the likelihood calculation distributes across
+			:c:member:`n_threads` threads. One of the ``PARALLEL_POLICY_*``
+			macros defined in likelihood.h.
+
 		.. c:member:: char **labels
 
 			An array of strings describing the quantities measured (i.e., a
 			label for each axis of the observed space). This will be used to
 			match the quantities contained within each :c:type:`DATUM` object
-			to compute statistical likelihood estimates.
+			to compute statistical likelihood estimates. Each element points to
+			the interned copy of the label owned by the
+			:c:type:`LABEL_REGISTRY`, and should be assigned with
+			:c:func:`track_set_label`.
+
+		.. c:member:: unsigned short *ids
+
+			The integer ID of each element of :c:member:`labels`, as assigned
+			by :c:func:`label_intern`.
 
 		.. c:member:: double *weights
 
@@ -60,16 +86,42 @@ typedef struct track {
 			In practice, these weights should scale as the product of the
 			intrinsic density predicted by the model and the selection function
 			of the data, the latter of which may be difficult to quantify.
+
+		.. c:member:: double pruning_threshold
+
+			If non-negative, the contributions of the points along the track
+			to the likelihood of observing each datum are summed in
+			logarithmic space, and those smaller than the largest by more
+			than a factor of :math:`e^{-\text{threshold} / 2}` are skipped.
+			With equal weights, this skips points whose :math:`\chi^2`
+			exceeds the smallest by more than the threshold. If also finite,
+			whole blocks of points whose bounding boxes lie too far from a
+			datum are skipped without computing :math:`\chi^2`. Initialized
+			to :c:macro:`PRUNING_OFF`, in which case they are summed in linear
+			space.
+
+		.. c:member:: double weight_norm_factor
+
+			The factor by which the mean of :c:member:`weights` over the
+			points is multiplied to normalize them (see
+			:c:func:`track_weight_norm`). Initialized to 1.
+			:c:func:`track_compress` sets it such that a compressed track
+			normalizes its weights by the same amount as the original track,
+			whose mean weight over more closely spaced points may differ.
 	*/
 
 	double **predictions;
 	unsigned short n_vectors;
 	unsigned short dim;
 	unsigned short n_threads;
+	unsigned short parallel_policy;
 	char **labels;
+	unsigned short *ids;
 	double *weights;
 	unsigned short use_line_segment_corrections;
 	unsigned short normalize_weights;
+	double pruning_threshold;
+	double weight_norm_factor;
 
 } TRACK;
 
@@ -96,6 +148,24 @@ typedef struct track {
 */
 extern TRACK *track_initialize(unsigned short n_vectors, unsigned short dim);
 
+/*
+.. c:function:: extern void track_set_label(TRACK *t, unsigned short index, const char *label);
+
+	Assign the label of one of the axes of the observed space.
+
+	Parameters
+	----------
+	t : ``TRACK *``
+		The track whose label is to be assigned.
+	index : ``unsigned short``
+		The axis of the observed space (i.e., the column of
+		:c:member:`TRACK.predictions`) that ``label`` describes.
+	label : ``const char *``
+		The label itself, which is interned by :c:func:`label_intern`.
+*/
+extern void track_set_label(TRACK *t, unsigned short index,
+	const char *label);
+
 /*
 .. c:function:: extern void track_free(TRACK *t);
 
@@ -108,6 +178,81 @@ extern TRACK *track_initialize(unsigned short n_vectors, unsigned short dim);
 */
 extern void track_free(TRACK *t);
 
+/*
+.. c:function:: extern TRACK *track_compress(const TRACK *t, const double *scale, const double tolerance, const double max_length);
+
+	Construct a copy of a track sampled at fewer points, omitting those that
+	lie close enough to the straight line connecting their neighbors.
+
+	Parameters
+	----------
+	t : ``const TRACK *``
+		The track to compress. It is not modified.
+	scale : ``const double *``
+		A positive scale for each axis of the observed space (i.e., each
+		column of :c:member:`TRACK.predictions`), in units of which distances
+		are measured. ``INFINITY`` excludes an axis from every distance.
+	tolerance : ``const double``
+		The largest distance that an omitted point may lie from the line
+		segment that replaces it, and the largest fractional difference
+		between the weights of the line segments that are merged.
+	max_length : ``const double``
+		The largest length of any line segment that replaces two or more
+		others. ``INFINITY`` for no limit.
+
+	Returns
+	-------
+	compressed : ``TRACK *``
+		The new track, whose first and last points are those of ``t``, and
+		whose settings and labels are copied from ``t``. The caller is
+		responsible for freeing it with :c:func:`track_free`.
+
+	Notes
+	-----
+	Points are omitted following the Douglas-Peucker algorithm, recursively
+	splitting the track at the point farthest from the line segment
+	connecting the first and last points under consideration. Spans that are
+	straight enough are also split in half if their weights vary by more than
+	``tolerance`` or if they are longer than ``max_length``.
+
+	The weight of each point of the new track is the mean of the weights of
+	the line segments it replaces, weighted by their lengths, such that the
+	product of weight and length summed along each span is unchanged. The
+	last point keeps its weight. With line segment corrections, the sum over
+	the points of the track for each datum is therefore unchanged up to the
+	deviations allowed by ``tolerance``. Normalized weights are divided by
+	their mean over the points, which differs between the two tracks unless
+	the weights are uniform, so :c:member:`TRACK.weight_norm_factor` of the
+	new track is set such that :c:func:`track_weight_norm` agrees with that
+	of ``t``. Without normalization, the sum of the weights over the points
+	is subtracted from the log-likelihood, which is smaller for the new track
+	and is not corrected.
+*/
+extern TRACK *track_compress(const TRACK *t, const double *scale,
+	const double tolerance, const double max_length);
+
+/*
+.. c:function:: extern double track_weight_norm(const TRACK *t);
+
+	Determine the amount by which the weights of a track are divided when
+	they are normalized (see
+	:c:member:`LIKELIHOOD_CONTEXT.normalize_weights`).
+
+	Parameters
+	----------
+	t : ``const TRACK *``
+		The track in question.
+
+	Returns
+	-------
+	norm : ``double``
+		1000 times the mean of :c:member:`TRACK.weights` over the points,
+		multiplied by :c:member:`TRACK.weight_norm_factor`. Since it is
+		proportional to the sum of the weights, the normalized weights do
+		not change if they are all scaled by a common factor.
+*/
+extern double track_weight_norm(const TRACK *t);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
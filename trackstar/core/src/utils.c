@@ -5,6 +5,7 @@ License: MIT License. See LICENSE in top-level directory
 at: https://github.com/giganano/TrackStar.git.
 */
 
+#include <stdlib.h>
 #include <string.h>
 #include "utils.h"
 
@@ -49,19 +50,149 @@ extern signed short strindex(char **strlist, char *test,
 	----------
 	arr : ``const double *``
 		The array to be summed.
-	lentgth : ``const unsigned long``
+	length : ``const unsigned long``
 		The number of elements in ``arr``.
 
 	Returns
 	-------
 	s : ``double``
 		``arr[0]`` + ``arr[1]`` + ``arr[2]`` + ... + ``arr[length - 3]`` +
-		``arr[length - 2]`` + `arr[length - 1]``.
+		``arr[length - 2]`` + ``arr[length - 1]``.
+
+	Notes
+	-----
+	The elements are added with :c:func:`compensated_add`, so the rounding
+	error does not grow with ``length``. If the sum is not finite, it is
+	returned without the compensation.
 */
 extern double sum(const double *arr, const unsigned long length) {
 
-	double s = 0;
-	for (unsigned long i = 0ul; i < length; i++) s += arr[i];
-	return s;
+	double s = 0, compensation = 0;
+	for (unsigned long i = 0ul; i < length; i++) {
+		compensated_add(&s, &compensation, arr[i]);
+	}
+	return isfinite(s) ? s + compensation : s;
+
+}
+
+
+/*
+.. c:function:: extern void compensated_add(double *total, double *compensation, const double x);
+
+	Add a number to a running sum with compensated (Kahan-Babuska)
+	summation, which carries the rounding error of each addition along in a
+	second term so that it is not lost.
+
+	Parameters
+	----------
+	total : ``double *``
+		The running sum, which begins at zero.
+	compensation : ``double *``
+		The accumulated rounding error of ``total``, which also begins at
+		zero. The sum itself is ``*total + *compensation``.
+	x : ``const double``
+		The number to add.
+
+	Notes
+	-----
+	Unlike Kahan's original algorithm, this variant due to Neumaier remains
+	accurate when ``x`` is larger in magnitude than the running sum.
+	Partial sums accumulated separately (e.g., by different threads) are
+	combined by adding one's total to the other with this function and its
+	compensation directly to the other's compensation.
+
+	If the running sum becomes infinite or NaN (e.g., once the log-likelihood
+	of a datum far from the track is ``-inf``), it is stored as is and the
+	compensation is left untouched, since the difference between two
+	infinities is NaN. ``*total + *compensation`` is then ``*total``.
+*/
+extern void compensated_add(double *total, double *compensation,
+	const double x) {
+
+	/* the rounding error of an infinite sum would be NaN */
+	double t = *total + x;
+	if (isfinite(t)) {
+		if (fabs(*total) >= fabs(x)) {
+			*compensation += (*total - t) + x;
+		} else {
+			*compensation += (x - t) + *total;
+		}
+	} else {}
+	*total = t;
+
+}
+
+
+/*
+.. c:function:: extern void *aligned_malloc(const unsigned long size);
+
+	Allocate a block of memory aligned to :c:macro:`CACHE_LINE_SIZE`.
+
+	Parameters
+	----------
+	size : ``const unsigned long``
+		The number of bytes to allocate.
+
+	Returns
+	-------
+	ptr : ``void *``
+		A pointer to the allocated memory, which should be released with the
+		standard ``free`` function. ``NULL`` if ``size`` is zero or the
+		allocation fails.
+*/
+extern void *aligned_malloc(const unsigned long size) {
+
+	void *ptr = NULL;
+	if (size && posix_memalign(&ptr, CACHE_LINE_SIZE, size)) ptr = NULL;
+	return ptr;
+
+}
+
+
+/*
+.. c:function:: extern double erfcx(double x);
+
+	Compute the scaled complementary error function,
+	:math:`\text{erfcx}(x) = e^{x^2}\text{erfc}(x)`.
+
+	Parameters
+	----------
+	x : ``double``
+		The argument of the function.
+
+	Returns
+	-------
+	y : ``double``
+		:math:`\text{erfcx}(x)`, which decays as :math:`1 / (x\sqrt{\pi})`
+		for large positive :math:`x` rather than underflowing as
+		:math:`\text{erfc}(x)` does. Overflows for :math:`x \lesssim -26.6`.
+
+	Notes
+	-----
+	Below :math:`x = 26`, this is computed directly from the standard
+	library's ``erfc``, with :math:`e^{x^2}` split into two factors such that
+	the rounding error in :math:`x^2` does not grow with :math:`x`. Above
+	:math:`x = 26`, ``erfc`` underflows, and the asymptotic expansion
+
+	.. math:: \text{erfcx}(x) \approx \frac{1}{x\sqrt{\pi}}\sum_{n = 0}^8
+		\frac{(-1)^n (2n - 1)!!}{(2x^2)^n}
+
+	is accurate to double precision.
+*/
+extern double erfcx(double x) {
+
+	if (x < 26) {
+		/* hi * hi is exact, as is x - hi */
+		double hi = floor(16 * x) / 16;
+		return exp(hi * hi) * exp((x - hi) * (x + hi)) * erfc(x);
+	} else {
+		const double rsqrtpi = 0.56418958354775628695; /* 1 / sqrt(pi) */
+		double inv2x2 = 1 / (2 * x * x), term = 1, total = 1;
+		for (unsigned short n = 1u; n <= 8u; n++) {
+			term *= -(2 * n - 1) * inv2x2;
+			total += term;
+		}
+		return rsqrtpi * total / x;
+	}
 
 }
@@ -169,3 +169,39 @@ class TestCovarianceMatrix:
 			for j in range(standalone.n_rows):
 				assert prod[i, j] == pytest.approx(int(i == j), rel = 1e-15)
 
+
+
+	@staticmethod
+	def test_inv_from_errors():
+		r"""
+		tests that the inverse of the covariance matrix of a datum constructed
+		with measurement errors accounts for those errors.
+		"""
+		test = datum({"x": 1, "x_err": 0.1, "y": 2, "y_err": 0.5})
+		assert test.cov.inv[0, 0] == pytest.approx(100)
+		assert test.cov.inv[1, 1] == pytest.approx(4)
+		assert test.cov.logdet == pytest.approx(np.log(0.01 * 0.25))
+
+
+	@staticmethod
+	def test_logdet_standalone(standalone):
+		r"""tests trackstar.covariance_matrix.logdet as a standalone."""
+		for i in range(standalone.n_rows):
+			try:
+				standalone[i, i] = 1 + np.random.random()
+			except:
+				pytest.skip("covariance_matrix.__setitem__ failed.")
+		expected = np.log(np.linalg.det(standalone.tonumpyarray()))
+		assert standalone.logdet == pytest.approx(expected, rel = 1e-12)
+
+
+	@staticmethod
+	def test_not_positive_definite():
+		r"""
+		tests that a symmetric but indefinite covariance matrix is still
+		inverted, but is flagged with a logdet of NaN.
+		"""
+		test = covariance_matrix([[1, 2], [2, 1]])
+		assert np.isnan(test.logdet)
+		assert test.inv[0, 0] == pytest.approx(-1 / 3)
+		assert test.inv[0, 1] == pytest.approx(2 / 3)
@@ -0,0 +1,119 @@
+#!/usr/bin/env python
+#
+# This file is part of the TrackStar package.
+# Copyright (C) 2023 James W. Johnson (giganano9@gmail.com)
+# License: MIT License. See LICENSE in top-level directory
+# at: https://github.com/giganano/TrackStar.git.
+
+from trackstar import sample, track, distributed
+from .test_sample import SampleLikelihoodBase
+import numpy as np
+import subprocess
+import shutil
+import sys
+import os
+import pytest
+
+class TestDistributedSample(SampleLikelihoodBase):
+
+	r"""
+	Tests the distributed likelihood against that of the whole sample, which
+	every process holds in full. Under mpirun, the sample is split across the
+	processes of the job; otherwise, test_multiple_processes runs this module
+	under ``mpirun -np 2`` if TrackStar was linked with MPI.
+	"""
+
+	@staticmethod
+	def test_single_process():
+		r"""tests the rank, size, and shard of a job with one process"""
+		if distributed.size() == 1:
+			assert distributed.rank() == 0
+			assert distributed.shard(10) == (0, 10)
+		else: pass
+		start, stop = distributed.shard(10)
+		assert 0 <= start <= stop <= 10
+		with pytest.raises(TypeError): distributed.shard(2.5)
+
+
+	@staticmethod
+	def test_loglikelihood(case, model, settings):
+		r"""
+		tests trackstar.distributed.sample.loglikelihood against
+		trackstar.sample.loglikelihood for the whole sample, whether it is
+		split evenly or held by one process with the shards of the others
+		empty
+		"""
+		start, stop = distributed.shard(case.size)
+		even = distributed.sample.from_sample(case)
+		assert len(even.local) == stop - start
+		uneven = distributed.sample(case if distributed.rank() == 0 else (
+			sample()))
+		expected = case.loglikelihood(model, **settings)
+		for dist in [even, uneven]:
+			assert dist.loglikelihood(model, **settings) == pytest.approx(
+				expected, rel = 1e-12)
+
+
+	@staticmethod
+	def test_broadcast(case, model, settings):
+		r"""
+		tests that every process computes the likelihood with the track and
+		settings of the root process, whose track overwrites those of the
+		others
+		"""
+		q = np.linspace(0, 1, 50)
+		dist = distributed.sample.from_sample(case)
+		expected = case.loglikelihood(model, **settings)
+		for root in sorted(set([0, distributed.size() - 1])):
+			kw = dict(settings)
+			if distributed.rank() == root:
+				t = model
+			else:
+				t = track({"x": q, "y": 1.1 * q**2, "z": 0.4 * q},
+					weights = 1 + q)
+				t.pruning_threshold = 0
+				kw["normalize_weights"] = not kw.get("normalize_weights", True)
+			assert dist.loglikelihood(t, root = root, **kw) == pytest.approx(
+				expected, rel = 1e-12)
+			assert np.array_equal(np.asarray(t.predictions),
+				np.asarray(model.predictions))
+			assert [t["weights", i] for i in range(len(t))] == [
+				model["weights", i] for i in range(len(model))]
+
+
+	@staticmethod
+	def test_errors(case, model):
+		r"""
+		tests that invalid arguments raise the same error on every process
+		"""
+		dist = distributed.sample.from_sample(case)
+		with pytest.raises(ValueError):
+			dist.loglikelihood(model, root = distributed.size())
+		with pytest.raises(TypeError):
+			dist.loglikelihood(model, normalize_weights = 1)
+		q = np.linspace(0, 1, 50)
+		with pytest.raises(ValueError):
+			dist.loglikelihood(track({"x": q, "y": q}))
+		with pytest.raises(TypeError): distributed.sample([1, 2, 3])
+
+
+	@staticmethod
+	def test_multiple_processes():
+		r"""
+		runs this module under ``mpirun -np 2``, such that the comparisons
+		against the whole sample are made with it split across processes
+		"""
+		if distributed.size() != 1:
+			pytest.skip("already running under mpirun")
+		elif not distributed.mpi_linked():
+			pytest.skip("requires TrackStar to be linked with MPI")
+		elif shutil.which("mpirun") is None:
+			pytest.skip("requires mpirun")
+		else: pass
+		# the job must not inherit the MPI environment of this process
+		env = dict([(key, value) for key, value in os.environ.items() if
+			not key.startswith(("OMPI_", "PMIX_", "PMI_"))])
+		result = subprocess.run(["mpirun", "-np", "2", sys.executable, "-m",
+			"pytest", "-q", "-p", "no:cacheprovider", __file__],
+			capture_output = True, text = True, env = env)
+		assert result.returncode == 0, result.stdout + result.stderr
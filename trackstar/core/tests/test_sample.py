@@ -0,0 +1,663 @@
+#!/usr/bin/env python
+#
+# This file is part of the TrackStar package.
+# Copyright (C) 2023 James W. Johnson (giganano9@gmail.com)
+# License: MIT License. See LICENSE in top-level directory
+# at: https://github.com/giganano/TrackStar.git.
+
+from trackstar import datum, sample, track, openmp_linked, profile
+from concurrent.futures import ThreadPoolExecutor
+import numpy as np
+import pytest
+
+class SampleLikelihoodBase:
+
+	r"""Base class for testing likelihood calculations with samples."""
+
+	@staticmethod
+	@pytest.fixture
+	def model():
+		q = np.linspace(0, 1, 50)
+		return track({"x": q, "y": q**2, "z": 0.5 * q})
+
+
+	@staticmethod
+	@pytest.fixture
+	def case():
+		# a mix of measured quantities, some listed in a different order
+		test = sample()
+		test.add_datum(datum({"x": 0.3, "x_err": 0.1, "y": 0.1, "y_err": 0.1}))
+		test.add_datum(datum({"y": 0.4, "y_err": 0.1, "x": 0.6, "x_err": 0.1}))
+		test.add_datum(datum({"x": 0.8, "x_err": 0.1, "y": 0.6, "y_err": 0.1,
+			"z": 0.4, "z_err": 0.05}))
+		return test
+
+
+	@staticmethod
+	@pytest.fixture(params = [{}, dict(normalize_weights = False),
+		dict(use_line_segment_corrections = True),
+		dict(quantities = ["x", "y"])])
+	def settings(request):
+		# the keyword arguments under which alternative ways of computing the
+		# likelihood are compared against trackstar.sample.loglikelihood
+		return request.param
+
+
+class TestSampleLikelihood(SampleLikelihoodBase):
+
+	r"""
+	Tests that the sample likelihood agrees with the sum over its data and
+	tracks modifications to the data between calls.
+	"""
+
+	@staticmethod
+	def test_sum_over_data(case, model):
+		r"""tests trackstar.sample.loglikelihood against its data"""
+		logl = case.loglikelihood(model, normalize_weights = False)
+		expected = sum([case[i].loglikelihood(model,
+			normalize_weights = False) for i in range(case.size)])
+		expected -= len(model) # unnormalized weights of 1 at each point
+		assert logl == pytest.approx(expected, rel = 1e-12)
+
+
+	@staticmethod
+	def test_modified_datum(case, model):
+		r"""tests that the likelihood reflects modified data vectors"""
+		before = case.loglikelihood(model)
+		assert case.loglikelihood(model) == before
+		case[0]["x"] = 0.35
+		assert case.loglikelihood(model) != before
+
+
+	@staticmethod
+	def test_modified_covariance(case, model):
+		r"""tests that the likelihood reflects modified covariance matrices"""
+		before = case.loglikelihood(model)
+		case[1].cov["x", "y"] = 0.005
+		assert case.loglikelihood(model) != before
+
+
+	@staticmethod
+	def test_track_column_order(case, model):
+		r"""
+		tests that the likelihood does not depend on the order in which the
+		track lists its predicted quantities
+		"""
+		before = case.loglikelihood(model)
+		reordered = track({"z": model["z"], "y": model["y"], "x": model["x"]})
+		assert case.loglikelihood(reordered) == pytest.approx(before, rel = 1e-12)
+		assert case.loglikelihood(model) == pytest.approx(before, rel = 1e-12)
+
+
+	@staticmethod
+	def test_line_segment_corrections(case, model):
+		r"""
+		tests that the closed-form line segment corrections agree with those
+		computed by numerical quadrature
+		"""
+		analytic = case.loglikelihood(model, use_line_segment_corrections = True)
+		numerical = case.loglikelihood(model,
+			use_line_segment_corrections = "quad")
+		assert analytic == pytest.approx(numerical, rel = 1e-6)
+		assert analytic != case.loglikelihood(model)
+
+
+	@staticmethod
+	def test_parallel_policy(case, model):
+		r"""
+		tests that the likelihood does not depend on which loop is
+		parallelized
+		"""
+		expected = case.loglikelihood(model)
+		if openmp_linked(): model.n_threads = 3
+		for policy in ["data", "track", "collapsed", "auto"]:
+			model.parallel_policy = policy
+			assert model.parallel_policy == policy
+			assert case.loglikelihood(model) == pytest.approx(expected,
+				rel = 1e-12)
+		with pytest.raises(ValueError):
+			model.parallel_policy = "points"
+
+
+	@staticmethod
+	def test_pruning_threshold(case, model):
+		r"""
+		tests that summing the likelihood in logarithmic space agrees with
+		summing it in linear space, with and without pruning, and that it does
+		not underflow for data far from the track
+		"""
+		assert model.pruning_threshold is None
+		expected = [case.loglikelihood(model, use_line_segment_corrections = b)
+			for b in [False, True]]
+		for threshold, rel in [(float("inf"), 1e-12), (50, 1e-9)]:
+			model.pruning_threshold = threshold
+			assert model.pruning_threshold == threshold
+			assert model[:].pruning_threshold == threshold
+			assert [case.loglikelihood(model,
+				use_line_segment_corrections = b) for b in [False, True]] == (
+				pytest.approx(expected, rel = rel))
+		far = datum({"x": 50, "x_err": 0.01, "y": 50, "y_err": 0.01})
+		model.pruning_threshold = None
+		assert far.loglikelihood(model) == -float("inf")
+		model.pruning_threshold = 50
+		assert np.isfinite(far.loglikelihood(model))
+		with pytest.raises(ValueError):
+			model.pruning_threshold = -1
+		with pytest.raises(TypeError):
+			model.pruning_threshold = "50"
+
+
+	@staticmethod
+	def test_far_datum(case, model):
+		r"""
+		tests that the likelihood of a sample with a datum far from the track
+		is zero when summed in linear space, in either precision, rather than
+		NaN
+		"""
+		case.add_datum(datum({"x": 100, "x_err": 0.01, "y": 0.5,
+			"y_err": 0.01}))
+		for precision in ["double", "single"]:
+			assert case.loglikelihood(model, precision = precision) == (
+				-float("inf"))
+		model.pruning_threshold = 50
+		assert np.isfinite(case.loglikelihood(model))
+
+
+	@staticmethod
+	def test_pruning_long_track(case):
+		r"""
+		tests that skipping whole blocks of a long, narrow track agrees with
+		summing every point in linear space
+		"""
+		q = np.linspace(0, 1, 5000)
+		model = track({"x": q, "y": q**2, "z": 0.5 * q},
+			weights = 1 + np.sin(10 * q)**2)
+		for b in [False, True]:
+			expected = case.loglikelihood(model,
+				use_line_segment_corrections = b)
+			model.pruning_threshold = 50
+			assert case.loglikelihood(model,
+				use_line_segment_corrections = b) == pytest.approx(expected,
+				rel = 1e-9)
+			model.pruning_threshold = None
+
+
+	@staticmethod
+	def test_cache_kernel(case, model, settings):
+		r"""
+		tests that reusing the kernel values with new weights agrees with
+		recomputing them, and that modifying the predictions of the track or
+		the data invalidates the cache
+		"""
+		q = np.linspace(0, 1, 50)
+		for w in [np.ones(50), 1 + q, np.exp(-3 * q)]:
+			model["weights"] = w
+			assert case.loglikelihood(model, cache_kernel = True,
+				**settings) == pytest.approx(case.loglikelihood(model,
+				**settings), rel = 1e-12)
+		model["x", 10] = 0.5
+		assert case.loglikelihood(model, cache_kernel = True) == (
+			pytest.approx(case.loglikelihood(model), rel = 1e-12))
+		case[0]["x"] = 0.35
+		assert case.loglikelihood(model, cache_kernel = True) == (
+			pytest.approx(case.loglikelihood(model), rel = 1e-12))
+		with pytest.raises(TypeError):
+			case.loglikelihood(model, cache_kernel = 1)
+
+
+	@staticmethod
+	def test_return_grad(case, model, settings):
+		r"""
+		tests the derivatives returned by trackstar.sample.loglikelihood
+		against finite differences
+		"""
+		q = np.linspace(0, 1, 50)
+		model["weights"] = 1 + q
+		h = 1e-6
+		logl, grad, grad_weights = case.loglikelihood(model,
+			return_grad = True, **settings)
+		assert logl == pytest.approx(case.loglikelihood(model, **settings),
+			rel = 1e-12)
+		assert grad.shape == (len(model), len(model.keys()))
+		assert grad_weights.shape == (len(model),)
+		for i in [5, 20, 40]:
+			for j, key in enumerate(model.keys()):
+				x = model[i][key]
+				model[key, i] = x + h
+				up = case.loglikelihood(model, **settings)
+				model[key, i] = x - h
+				down = case.loglikelihood(model, **settings)
+				model[key, i] = x
+				assert grad[i, j] == pytest.approx((up - down) / (2 * h),
+					rel = 1e-4, abs = 1e-4)
+			w = model[i]["weights"]
+			model["weights", i] = w + h
+			up = case.loglikelihood(model, **settings)
+			model["weights", i] = w - h
+			down = case.loglikelihood(model, **settings)
+			model["weights", i] = w
+			assert grad_weights[i] == pytest.approx((up - down) / (2 * h),
+				rel = 1e-4, abs = 1e-4)
+		with pytest.raises(TypeError):
+			case.loglikelihood(model, return_grad = 1)
+		with pytest.raises(ValueError):
+			case.loglikelihood(model, cache_kernel = True, return_grad = True)
+
+
+	@staticmethod
+	def test_pin_threads(case, model, settings):
+		r"""
+		tests that the likelihood computed with the data partitioned among a
+		persistent team of threads agrees with the one computed without, and
+		that the partitions follow modifications to the data
+		"""
+		if openmp_linked(): model.n_threads = 3
+		assert case.loglikelihood(model, pin_threads = True, **settings) == (
+			pytest.approx(case.loglikelihood(model, **settings), rel = 1e-12))
+		q = np.linspace(0, 1, 80)
+		other = track({"z": 0.4 * q, "x": q, "y": 1.1 * q**2})
+		assert case.loglikelihood(other, pin_threads = True) == (
+			pytest.approx(case.loglikelihood(other), rel = 1e-12))
+		case[0]["x"] = 0.35
+		assert case.loglikelihood(other, pin_threads = True) == (
+			pytest.approx(case.loglikelihood(other), rel = 1e-12))
+		with pytest.raises(TypeError):
+			case.loglikelihood(model, pin_threads = 1)
+		with pytest.raises(ValueError):
+			case.loglikelihood(model, pin_threads = True, cache_kernel = True)
+		with pytest.raises(ValueError):
+			case.loglikelihood(track({"x": q, "y": q}), pin_threads = True)
+
+
+	@staticmethod
+	def test_device_backend(case, model, settings):
+		r"""
+		tests that the likelihood computed with the data kept on a device
+		(or on the CPU, if there is none) agrees with the one computed
+		without, and that the copy on the device follows modifications to the
+		data
+		"""
+		for kw in [settings, dict(use_line_segment_corrections = "quad")]:
+			assert case.loglikelihood(model, backend = "device", **kw) == (
+				pytest.approx(case.loglikelihood(model, **kw), rel = 1e-12))
+		case[0]["x"] = 0.35
+		assert case.loglikelihood(model, backend = "device") == (
+			pytest.approx(case.loglikelihood(model), rel = 1e-12))
+		with pytest.raises(TypeError):
+			case.loglikelihood(model, backend = 1)
+		with pytest.raises(ValueError):
+			case.loglikelihood(model, backend = "cuda")
+		for kw in [dict(cache_kernel = True), dict(return_grad = True),
+			dict(pin_threads = True)]:
+			with pytest.raises(ValueError):
+				case.loglikelihood(model, backend = "device", **kw)
+		q = np.linspace(0, 1, 80)
+		with pytest.raises(ValueError):
+			case.loglikelihood(track({"x": q, "y": q}), backend = "device")
+
+
+	@staticmethod
+	def test_single_precision(case, model, settings):
+		r"""
+		tests that the likelihood computed in single precision agrees with the
+		one computed in double precision to within the rounding error of
+		chi-squared, and that the single precision copy of the data follows
+		modifications to them
+		"""
+		assert case.loglikelihood(model, precision = "single", **settings) == (
+			pytest.approx(case.loglikelihood(model, **settings), rel = 1e-5))
+		case[0]["x"] = 0.35
+		assert case.loglikelihood(model, precision = "single") == (
+			pytest.approx(case.loglikelihood(model), rel = 1e-5))
+		with pytest.raises(TypeError):
+			case.loglikelihood(model, precision = 32)
+		with pytest.raises(ValueError):
+			case.loglikelihood(model, precision = "half")
+		for kw in [dict(cache_kernel = True), dict(return_grad = True),
+			dict(pin_threads = True), dict(backend = "device")]:
+			with pytest.raises(ValueError):
+				case.loglikelihood(model, precision = "single", **kw)
+
+
+	@staticmethod
+	def test_loglikelihood_many(case, model, settings):
+		r"""
+		tests trackstar.sample.loglikelihood_many against loglikelihood for
+		tracks of different lengths and column orders
+		"""
+		q = np.linspace(0, 1, 80)
+		tracks = [model, track({"z": 0.5 * q, "x": q, "y": q**2}),
+			track({"x": q, "y": 1.1 * q**2, "z": 0.4 * q, "w": q})]
+		expected = [case.loglikelihood(t, **settings) for t in tracks]
+		assert case.loglikelihood_many(tracks, **settings) == pytest.approx(
+			expected, rel = 1e-12)
+		assert case.loglikelihood_many([]) == []
+		with pytest.raises(TypeError):
+			case.loglikelihood_many(model)
+		with pytest.raises(ValueError):
+			case.loglikelihood_many([model, track({"x": q, "y": q})])
+
+
+	@staticmethod
+	def test_concurrent_threads(case, model):
+		r"""
+		tests that likelihoods with different settings computed concurrently
+		from python threads sharing a sample and a track agree with those
+		computed one at a time
+		"""
+		weights = [model[i]["weights"] for i in range(len(model))]
+		settings = [dict(normalize_weights = a,
+			use_line_segment_corrections = b) for a in [True, False]
+			for b in [True, False]]
+		expected = [case.loglikelihood(model, **kw) for kw in settings]
+		with ThreadPoolExecutor(max_workers = 4) as pool:
+			futures = [pool.submit(case.loglikelihood, model, **settings[i % 4])
+				for i in range(40)]
+			for i in range(40):
+				assert futures[i].result() == expected[i % 4]
+		assert [model[i]["weights"] for i in range(len(model))] == weights
+
+
+class TestSampleProfile(SampleLikelihoodBase):
+
+	r"""
+	Tests the timers and event counts recorded during likelihood calculations
+	when TrackStar is compiled with profiling enabled.
+	"""
+
+	@staticmethod
+	def test_profile(case, model):
+		r"""tests that trackstar.profile counts every chi-squared evaluation"""
+		try:
+			profile()
+		except RuntimeError:
+			pytest.skip("TrackStar was not compiled with profiling enabled.")
+		case.loglikelihood(model)
+		breakdown = profile()
+		assert sum(breakdown["events"]["kernel_evaluations"]) == (
+			case.size * len(model))
+		assert sum(breakdown["events"]["points_pruned"]) == 0
+		assert sum(breakdown["seconds"]["likelihood"]) > 0
+		assert sum(breakdown["seconds"]["data"]) > 0
+		model.pruning_threshold = 0
+		case.loglikelihood(model)
+		assert sum(profile(reset = False)["events"]["points_pruned"]) > 0
+		assert sum(profile()["events"]["points_pruned"]) > 0
+		assert sum(profile()["events"]["kernel_evaluations"]) == 0
+
+
+class TestSampleLabels(SampleLikelihoodBase):
+
+	r"""
+	Tests the routines that match data by the labels of their measured
+	quantities.
+	"""
+
+	@staticmethod
+	def test_filter(case):
+		r"""tests trackstar.sample.filter"""
+		assert case.filter("x", ">=", 0.6).size == 2
+		assert case.filter("z", ">", 0).size == 1
+		assert case.filter("z", ">", 0,
+			keep_missing_measurements = True).size == 3
+
+
+	@staticmethod
+	def test_filter_unknown_label(case):
+		r"""tests trackstar.sample.filter with a label no datum carries"""
+		with pytest.warns(UserWarning):
+			assert case.filter("w", "<", 1).size == 0
+		assert case.filter("w", "<", 1,
+			keep_missing_measurements = True).size == 3
+
+
+	@staticmethod
+	def test_filter_compound(case):
+		r"""tests trackstar.sample.filter with several conditions"""
+		conditions = [("x", ">", 0.5), ("y", "<", 0.5)]
+		assert case.filter(conditions).size == 1
+		assert case.filter(conditions, combine = "or").size == 3
+		assert case.filter([("x", ">", 0.7), ("y", "<", 0.2)],
+			combine = "or").size == 2
+		assert case.filter([("x", ">", 0), ("z", "<", 1)],
+			keep_missing_measurements = True).size == 3
+		sub = case.filter(conditions)
+		sub[0]["x"] = 0.65
+		assert case[1]["x"] == 0.65
+		with pytest.raises(TypeError):
+			case.filter(conditions, ">")
+		with pytest.raises(TypeError):
+			case.filter([("x", ">")])
+		with pytest.raises(ValueError):
+			case.filter([("x", "!=", 0)])
+		with pytest.raises(ValueError):
+			case.filter(conditions, combine = "xor")
+
+
+	@staticmethod
+	def test_column(case):
+		r"""tests trackstar.sample.column"""
+		assert np.array_equal(case.column("x"), [0.3, 0.6, 0.8])
+		z = case.column("z")
+		assert np.isnan(z[0]) and np.isnan(z[1]) and z[2] == 0.4
+		assert list(case["y"]) == list(case.column("y"))
+		case[0]["x"] = 0.35
+		assert case.column("x")[0] == 0.35
+		with pytest.raises(KeyError):
+			case.column("w")
+
+
+class TestSampleArrays(SampleLikelihoodBase):
+
+	r"""
+	Tests the construction of samples and tracks from contiguous arrays
+	against construction from dictionaries and data vectors.
+	"""
+
+	@staticmethod
+	def test_from_arrays(case, model):
+		r"""tests trackstar.sample.from_arrays against trackstar.sample"""
+		values = np.array([[0.3, 0.1, np.nan], [0.6, 0.4, np.nan],
+			[0.8, 0.6, 0.4]])
+		errors = np.array([[0.1, 0.1, np.nan], [0.1, 0.1, np.nan],
+			[0.1, 0.1, 0.05]])
+		test = sample.from_arrays(values, ["x", "y", "z"], errors = errors)
+		assert test.size == case.size
+		assert test.keys() == ["x", "y", "z"]
+		assert np.isnan(test["z", 0])
+		assert test.loglikelihood(model) == pytest.approx(
+			case.loglikelihood(model), rel = 1e-12)
+		mask = ~np.isnan(values)
+		values[np.isnan(values)] = 0
+		masked = sample.from_arrays(values, ["x", "y", "z"], errors = errors,
+			mask = mask)
+		assert masked.loglikelihood(model) == pytest.approx(
+			case.loglikelihood(model), rel = 1e-12)
+		expected = sample({"x": values[:, 0], "y": values[:, 1]})
+		assert sample.from_arrays(values[:, :2].copy(),
+			["x", "y"]).loglikelihood(model) == expected.loglikelihood(model)
+
+
+	@staticmethod
+	def test_from_arrays_views(case, model):
+		r"""
+		tests that the data of a sample constructed from arrays can be
+		accessed and modified like any other
+		"""
+		values = np.array([[0.3, 0.1], [0.6, 0.4]])
+		errors = np.full((2, 2), 0.1)
+		test = sample.from_arrays(values, ["x", "y"], errors = errors)
+		subset = test[:1]
+		test[0]["x"] = 0.35
+		case[0]["x"] = 0.35
+		assert subset.loglikelihood(model) == pytest.approx(
+			case[:1].loglikelihood(model), rel = 1e-12)
+		assert test.loglikelihood(model) == pytest.approx(
+			case[:2].loglikelihood(model), rel = 1e-12)
+		test.add_datum(case[2])
+		assert np.isnan(test["z", 0])
+		assert test.loglikelihood(model) == pytest.approx(
+			case.loglikelihood(model), rel = 1e-12)
+		del test
+		assert subset[0]["x"] == 0.35
+		with pytest.raises(ValueError):
+			sample.from_arrays(np.full((2, 2), np.nan), ["x", "y"])
+		with pytest.raises(ValueError):
+			sample.from_arrays(values, ["x", "x"])
+		with pytest.raises(TypeError):
+			sample.from_arrays(values.T, ["x", "y"])
+
+
+	@staticmethod
+	def test_shared_covariance(model):
+		r"""
+		tests the likelihood of a sample whose data share covariance matrices
+		against the sum of those of its data individually, before and after
+		one of them is modified to no longer do so, and of a sample mixing
+		several sets of data with different covariance matrices
+		"""
+		values = np.array([[0.3, 0.1, 0.2], [0.6, 0.4, 0.3], [0.8, 0.6, 0.4],
+			[0.5, 0.2, 0.1]])
+		test = sample.from_arrays(values, ["x", "y", "z"],
+			errors = np.full(values.shape, 0.1))
+		for i in range(test.size):
+			test[i].cov["x", "y"] = 0.005
+		for kw in [{}, dict(use_line_segment_corrections = True)]:
+			expected = sum([test[i:i + 1].loglikelihood(model, **kw)
+				for i in range(test.size)])
+			assert test.loglikelihood(model, **kw) == pytest.approx(expected,
+				rel = 1e-12)
+		test[1].cov["z", "z"] = 0.02
+		expected = sum([test[i:i + 1].loglikelihood(model)
+			for i in range(test.size)])
+		assert test.loglikelihood(model) == pytest.approx(expected,
+			rel = 1e-12)
+		# two surveys with the same quantities but different error models,
+		# each large enough for a group of its own, and one stray datum
+		q = np.linspace(0.1, 0.9, 21)
+		values = np.array([q, q**2, 0.5 * q]).T.copy()
+		test = sample.from_arrays(values, ["x", "y", "z"],
+			errors = np.full(values.shape, 0.1))
+		for i in range(test.size):
+			test[i].cov["x", "y"] = 0.005 if i % 2 else -0.003
+		test[20].cov["z", "z"] = 0.02
+		expected = sum([test[i:i + 1].loglikelihood(model)
+			for i in range(test.size)])
+		assert test.loglikelihood(model) == pytest.approx(expected,
+			rel = 1e-12)
+
+
+	@staticmethod
+	def test_track_from_array(case, model):
+		r"""tests trackstar.track.from_array against trackstar.track"""
+		q = np.linspace(0, 1, 50)
+		predictions = np.array([q, q**2, 0.5 * q]).T.copy()
+		test = track.from_array(predictions, ["x", "y", "z"])
+		assert test.keys() == model.keys()
+		assert case.loglikelihood(test) == case.loglikelihood(model)
+		weighted = track({"x": q, "y": q**2, "z": 0.5 * q}, weights = 1 + q)
+		test = track.from_array(predictions, ["x", "y", "z"], weights = 1 + q)
+		assert case.loglikelihood(test) == case.loglikelihood(weighted)
+		with pytest.raises(ValueError):
+			track.from_array(predictions, ["x", "y"])
+		with pytest.raises(TypeError):
+			track.from_array(predictions.T, ["x", "y", "z"])
+
+
+	@staticmethod
+	def test_track_compress(case):
+		r"""
+		tests that trackstar.track.compress omits the points along straight
+		stretches of a track without changing the likelihood with line segment
+		corrections by more than the tolerance allows, with weights that are
+		uniform or vary along the track
+		"""
+		q = np.linspace(0, 1, 2000)
+		dense = track({"x": q, "y": q**2, "z": 0.5 * q})
+		compressed = dense.compress(0.01, scale = case)
+		assert 2 < compressed.n_vectors < dense.n_vectors / 10
+		assert compressed.keys() == dense.keys()
+		assert compressed["x", 0] == 0 and compressed["x", -1] == 1
+		assert case.loglikelihood(compressed,
+			use_line_segment_corrections = True) == pytest.approx(
+			case.loglikelihood(dense, use_line_segment_corrections = True),
+			abs = 1e-3)
+		# normalized weights that vary along the track, whose mean over the
+		# points of the compressed track differs from that of the dense one
+		weighted = track({"x": q, "y": q**2, "z": 0.5 * q}, weights = 1 + q)
+		compressed = weighted.compress(0.01, scale = case)
+		assert compressed.n_vectors < weighted.n_vectors / 10
+		expected = case.loglikelihood(weighted,
+			use_line_segment_corrections = True)
+		for kw in [{}, dict(cache_kernel = True)]:
+			assert case.loglikelihood(compressed,
+				use_line_segment_corrections = True, **kw) == pytest.approx(
+				expected, abs = 1e-3)
+		line = track({"x": q, "y": 2 * q})
+		assert line.compress(0.01).n_vectors == 2
+		assert line.compress(0.01, max_length = 0.1).n_vectors > 20
+		assert line.compress(0.01, scale = {"x": 1}).n_vectors == 2
+		with pytest.raises(TypeError): dense.compress("0.01")
+		with pytest.raises(ValueError): dense.compress(0)
+		with pytest.raises(ValueError): dense.compress(0.01, max_length = 0)
+		with pytest.raises(KeyError): dense.compress(0.01, scale = {"w": 1})
+		with pytest.raises(ValueError):
+			dense.compress(0.01, scale = {"x": -1})
+		with pytest.raises(TypeError):
+			dense.compress(0.01, scale = [1, 1, 1])
+
+
+	@staticmethod
+	def test_track_predictions_view(model):
+		r"""tests the zero-copy view of trackstar.track predictions"""
+		view = np.asarray(model.predictions)
+		assert view.shape == (model.n_vectors, model.dim)
+		assert view.flags["C_CONTIGUOUS"] and not view.flags["WRITEABLE"]
+		for i, key in enumerate(model.keys()):
+			assert np.array_equal(view[:, i], model[key])
+		model["y", 3] = 10
+		assert view[3, 1] == 10
+		with pytest.raises(ValueError):
+			view[0, 0] = 1
+
+
+class TestSampleFile(SampleLikelihoodBase):
+
+	r"""
+	Tests writing samples to binary files and reading them back.
+	"""
+
+	@staticmethod
+	@pytest.mark.parametrize("mmap", [True, False])
+	def test_save_load(case, model, tmp_path, mmap):
+		r"""tests trackstar.sample.save and trackstar.sample.load"""
+		path = tmp_path / "case.bin"
+		case.save(path)
+		test = sample.load(path, mmap = mmap)
+		assert test.size == case.size
+		assert test.keys() == case.keys()
+		assert test.loglikelihood(model) == case.loglikelihood(model)
+		assert test.loglikelihood(model, use_line_segment_corrections = True
+			) == case.loglikelihood(model, use_line_segment_corrections = True)
+		assert test["z", 2] == case["z", 2]
+		assert np.isnan(test["z", 0])
+		test[0]["x"] = 0.35
+		case[0]["x"] = 0.35
+		assert test.loglikelihood(model) == pytest.approx(
+			case.loglikelihood(model), rel = 1e-12)
+		test.save(path)
+		assert sample.load(path).loglikelihood(model) == pytest.approx(
+			case.loglikelihood(model), rel = 1e-12)
+
+
+	@staticmethod
+	def test_load_errors(tmp_path):
+		r"""tests that invalid sample files are rejected"""
+		path = tmp_path / "invalid.bin"
+		with pytest.raises(OSError):
+			sample.load(path)
+		path.write_bytes(b"not a sample file")
+		with pytest.raises(ValueError):
+			sample.load(path)
+		with pytest.raises(TypeError):
+			sample.load(path, mmap = 1)
@@ -8,21 +8,32 @@
 from .matrix cimport MATRIX
 
 cdef extern from "./src/track.h":
+	double PRUNING_OFF
 	ctypedef struct TRACK:
 		double **predictions
 		unsigned short n_vectors
 		unsigned short dim
 		unsigned short n_threads
+		unsigned short parallel_policy
 		char **labels
+		unsigned short *ids
 		double *weights
 		unsigned short use_line_segment_corrections
 		unsigned short normalize_weights
+		double pruning_threshold
+		double weight_norm_factor
 
 	TRACK *track_initialize(unsigned short n_vectors, unsigned short dim)
+	void track_set_label(TRACK *t, unsigned short index, const char *label)
 	void track_free(TRACK *t)
+	TRACK *track_compress(const TRACK *t, const double *scale,
+		const double tolerance, const double max_length)
 
 
 cdef class track:
 	cdef MATRIX *_m
 	cdef TRACK *_t
+	cdef unsigned long _revision
+	cdef Py_ssize_t _shape[2]
+	cdef Py_ssize_t _strides[2]
 
@@ -9,14 +9,27 @@ __all__ = ["track"]
 import numbers
 import warnings
 import math as m
-from .utils import copy_array_like_object, copy_cstring
+from .utils import copy_array_like_object, copy_cstring, _UNINITIALIZED_
 from .utils cimport copy_pystring, strindex, linked_list, linked_dict
+from .utils cimport label_registry_share, shared_label_registry
+from .profiling cimport profile_share, shared_profile_counters
 from . cimport track
 from . cimport multithread
 from .multithread cimport multithreading_enabled
+from .matrix cimport MATRIX, matrix_elements
+from cpython.buffer cimport PyBUF_WRITABLE, PyBUF_FORMAT
 from libc.stdlib cimport malloc, free
+from libc.string cimport memcpy
 from libc.stdint cimport uintptr_t
-from libc.string cimport strcpy
+
+# label IDs are only comparable if they come from the same registry
+label_registry_share(shared_label_registry())
+
+# every module records to the counters reported by trackstar.profile
+profile_share(shared_profile_counters())
+
+# indexed by the PARALLEL_POLICY_* macros in ./src/likelihood.h
+_PARALLEL_POLICIES_ = ["auto", "data", "track", "collapsed"]
 
 cdef class track:
 
@@ -35,6 +48,10 @@ cdef class track:
 	"""
 
 	def __cinit__(self, predictions, weights = None, n_threads = 1):
+		# the number of times the predictions (not the weights) have been
+		# modified, which tells a sample whether its kernel cache is stale
+		self._revision = 0
+		if predictions is _UNINITIALIZED_: return
 		if not isinstance(predictions, dict): raise TypeError("""\
 Track must be initialized from type dict. Got: %s""" % (type(predictions)))
 		copy = {}
@@ -100,7 +117,7 @@ elements as track predictions.""" % (len(weights), len(copy[keys[0]])))
 		for j in range(len(keys)):
 			labelcopy = copy_pystring(keys[j])
 			try:
-				strcpy(self._t[0].labels[j], labelcopy)
+				track_set_label(self._t, j, labelcopy)
 			finally:
 				free(labelcopy)
 
@@ -115,6 +132,281 @@ elements as track predictions.""" % (len(weights), len(copy[keys[0]])))
 		track_free(self._t)
 
 
+	@staticmethod
+	def from_array(predictions, labels, weights = None, n_threads = 1):
+		r"""
+		Construct a track from a contiguous array of predictions.
+
+		Parameters
+		----------
+		predictions : ``array-like`` [2-dimensional]
+			The predictions, with one row per point along the track and one
+			column per quantity. Must support the buffer protocol with
+			C-contiguous 64-bit floating point elements (e.g., a
+			``numpy.ndarray`` of ``dtype`` ``float64``), which are read
+			without copying them into python objects.
+		labels : ``list`` or ``tuple``
+			The label of each column of ``predictions``.
+		weights : ``array-like`` [1-dimensional] [default : ``None``]
+			The weight of each point along the track, with the same buffer
+			requirements as ``predictions``. If ``None``, every point has a
+			weight of 1.
+		n_threads : ``int`` [default : 1]
+			The number of parallel processing threads to use.
+
+		Returns
+		-------
+		t : ``track``
+			The new track, equivalent to one constructed by passing the same
+			columns to ``track.__init__`` in a dictionary.
+
+		Raises
+		------
+		TypeError
+			- ``predictions`` or ``weights`` do not support the buffer
+			  protocol with C-contiguous 64-bit floating point elements.
+			- ``labels`` is not a list or tuple of strings.
+		ValueError
+			- The shapes of ``predictions``, ``weights``, and ``labels`` do
+			  not match.
+			- ``labels`` contains duplicates or the label "weights".
+			- There are more than 65535 points along the track.
+		"""
+		cdef const double[:, ::1] _predictions
+		cdef const double[::1] _weights
+		cdef char *labelcopy
+		cdef unsigned short i, j
+		cdef track result
+		try:
+			_predictions = predictions
+		except (TypeError, ValueError, BufferError):
+			raise TypeError("""\
+Argument 'predictions' must be a 2-dimensional, C-contiguous array of 64-bit \
+floating point numbers. Got: %s""" % (type(predictions)))
+		if not isinstance(labels, list) and not isinstance(labels, tuple):
+			raise TypeError("""\
+Argument 'labels' must be of type list or tuple. Got: %s""" % (type(labels)))
+		elif not all([isinstance(_, str) for _ in labels]):
+			raise TypeError("Elements of 'labels' must all be of type str.")
+		elif len(labels) != _predictions.shape[1]:
+			raise ValueError("""\
+Got %d labels for %d columns of predictions.""" % (len(labels),
+				_predictions.shape[1]))
+		elif len(set(labels)) != len(labels) or "weights" in labels:
+			raise ValueError("""\
+Argument 'labels' must not contain duplicates or the label "weights".""")
+		elif _predictions.shape[0] > 65535u:
+			raise ValueError("""\
+Tracks can have at most 65535 points. Got: %d""" % (_predictions.shape[0]))
+		else: pass
+		if weights is not None:
+			try:
+				_weights = weights
+			except (TypeError, ValueError, BufferError):
+				raise TypeError("""\
+Keyword arg 'weights' must be a 1-dimensional, C-contiguous array of 64-bit \
+floating point numbers. Got: %s""" % (type(weights)))
+			if _weights.shape[0] != _predictions.shape[0]:
+				raise ValueError("""\
+Array-length mismatch. Got: %d, %d. Weights must have the same number of \
+elements as track predictions.""" % (_weights.shape[0],
+					_predictions.shape[0]))
+			else: pass
+		else: pass
+
+		result = track.__new__(track, _UNINITIALIZED_)
+		result._t = track_initialize(_predictions.shape[0],
+			_predictions.shape[1])
+		if result._t[0].n_vectors and result._t[0].dim:
+			memcpy(matrix_elements((<MATRIX *> result._t)[0]),
+				&_predictions[0, 0],
+				result._t[0].n_vectors * result._t[0].dim * sizeof(double))
+		else: pass
+		for i in range(result._t[0].n_vectors):
+			result._t[0].weights[i] = _weights[i] if weights is not None else 1
+		for j in range(result._t[0].dim):
+			labelcopy = copy_pystring(labels[j])
+			try:
+				track_set_label(result._t, j, labelcopy)
+			finally:
+				free(labelcopy)
+		result.n_threads = n_threads
+		return result
+
+
+	def compress(self, tolerance, scale = None, max_length = None):
+		r"""
+		Construct a copy of the track sampled at fewer points, omitting those
+		along stretches that are nearly straight and over which the weights
+		vary little.
+
+		Parameters
+		----------
+		tolerance : ``float`` [positive]
+			The largest distance, in units of ``scale``, that an omitted point
+			may lie from the line segment that replaces it, and the largest
+			fractional difference between the weights of the line segments
+			that are merged.
+		scale : ``dict``, ``trackstar.sample``, or ``None`` [default : ``None``]
+			The scale of each quantity in units of which distances are
+			measured.
+
+			- ``dict`` : The scales themselves, keyed by label. Quantities
+			  not included do not limit the compression.
+			- ``trackstar.sample`` : The smallest uncertainty on each
+			  quantity among the data, with every other quantity measured for
+			  the same datum held fixed. Quantities that no datum measures do
+			  not limit the compression.
+			- ``None`` : 1 for every quantity.
+
+		max_length : ``float`` [positive] or ``None`` [default : ``None``]
+			The largest length, in units of ``scale``, of a line segment that
+			replaces two or more others. If ``None``, there is no limit.
+
+		Returns
+		-------
+		compressed : ``track``
+			The new track, whose first and last points are those of this
+			track, with the same ``n_threads``, ``parallel_policy``, and
+			``pruning_threshold``. The weight of each of its points is the
+			mean of the weights of the line segments it replaces, weighted by
+			their lengths.
+
+		Raises
+		------
+		TypeError
+			- ``tolerance`` or ``max_length`` is not a real number.
+			- ``scale`` is not a ``dict``, a ``trackstar.sample``, or
+			  ``None``, or one of its values is not a real number.
+		ValueError
+			- ``tolerance``, ``max_length``, or one of the values of
+			  ``scale`` is not positive.
+		KeyError
+			- ``scale`` has a key that is not a label of this track.
+
+		Notes
+		-----
+		Tracks from numerical integrations are often sampled far more densely
+		than their curvature and the uncertainties of the data require, and
+		the cost of computing a likelihood grows linearly with the number of
+		points. With line segment corrections, a straight line segment
+		contributes the same likelihood however many points it is split into,
+		so with ``scale`` a sample, a ``tolerance`` of order 0.01 changes the
+		log-likelihood of each datum by a small fraction of that.
+
+		Without line segment corrections, the likelihood is a sum over the
+		points, which is accurate only if they are spaced closely compared to
+		the uncertainties of the data. Pass a ``max_length`` of order 0.1 or
+		smaller to keep them so.
+
+		.. note::
+
+			Normalized weights (see ``trackstar.sample.loglikelihood``) are
+			divided by their mean over the points, which differs between the
+			two tracks unless the weights are uniform. The compressed track
+			therefore remembers the ratio of the mean weight of this track to
+			its own, and multiplies its mean by that ratio when normalizing,
+			also after its weights are modified. Without normalization, the
+			sum of the weights over the points is subtracted from the
+			log-likelihood, which is smaller for the compressed track and is
+			not corrected.
+
+		Example Code
+		------------
+		>>> import trackstar as ts
+		>>> import numpy as np
+		>>> q = np.linspace(0, 1, 10000)
+		>>> t = ts.track({"x": q, "y": 2 * q})
+		>>> len(t.compress(0.01, scale = {"x": 0.1, "y": 0.1}))
+		2
+		"""
+		from .sample import sample
+		cdef double *scales
+		cdef track result
+		keys = self.keys()
+		if not isinstance(tolerance, numbers.Number): raise TypeError("""\
+Tolerance must be a real number. Got: %s""" % (type(tolerance)))
+		elif not tolerance > 0: raise ValueError("""\
+Tolerance must be positive. Got: %g""" % (tolerance))
+		else: pass
+		if max_length is None:
+			max_length = m.inf
+		elif not isinstance(max_length, numbers.Number):
+			raise TypeError("""\
+Keyword arg 'max_length' must be a real number or None. Got: %s""" % (
+				type(max_length)))
+		elif not max_length > 0:
+			raise ValueError("""\
+Keyword arg 'max_length' must be positive. Got: %g""" % (max_length))
+		else: pass
+		if scale is None:
+			values = len(keys) * [1.]
+		elif isinstance(scale, sample):
+			values = scale._uncertainty_scale_(keys)
+		elif isinstance(scale, dict):
+			for key in scale.keys():
+				if key not in keys:
+					raise KeyError("Unrecognized quantity label: %s." % (key))
+				elif not isinstance(scale[key], numbers.Number):
+					raise TypeError("""\
+Scale of quantity %s must be a real number. Got: %s""" % (key,
+						type(scale[key])))
+				elif not scale[key] > 0:
+					raise ValueError("""\
+Scale of quantity %s must be positive. Got: %g""" % (key, scale[key]))
+				else: pass
+			values = [scale[key] if key in scale.keys() else m.inf
+				for key in keys]
+		else:
+			raise TypeError("""\
+Keyword arg 'scale' must be a dict, a trackstar.sample, or None. Got: %s""" % (
+				type(scale)))
+
+		result = track.__new__(track, _UNINITIALIZED_)
+		scales = <double *> malloc (self._t[0].dim * sizeof(double))
+		try:
+			for i in range(self._t[0].dim): scales[i] = values[i]
+			result._t = track_compress(self._t, scales, tolerance, max_length)
+		finally:
+			free(scales)
+		return result
+
+
+	def __getbuffer__(self, Py_buffer *buffer, int flags):
+		r"""
+		Exposes the predictions of the track to the buffer protocol as a
+		read-only, C-contiguous, 2-dimensional array of 64-bit floating point
+		numbers, with one row per point along the track and one column per
+		quantity in the order of ``track.keys()``. The memory is shared with
+		the track rather than copied. User access strongly discouraged; see
+		``track.predictions``.
+		"""
+		if flags & PyBUF_WRITABLE:
+			raise BufferError("""\
+Track predictions are read-only through the buffer protocol. Modify them by \
+item assignment instead.""")
+		else: pass
+		self._shape[0] = self._t[0].n_vectors
+		self._shape[1] = self._t[0].dim
+		self._strides[0] = self._t[0].dim * sizeof(double)
+		self._strides[1] = sizeof(double)
+		buffer.buf = <void *> matrix_elements((<MATRIX *> self._t)[0])
+		buffer.obj = self
+		buffer.len = self._shape[0] * self._shape[1] * sizeof(double)
+		buffer.readonly = 1
+		buffer.itemsize = sizeof(double)
+		buffer.format = "d" if flags & PyBUF_FORMAT else NULL
+		buffer.ndim = 2
+		buffer.shape = self._shape
+		buffer.strides = self._strides
+		buffer.suboffsets = NULL
+		buffer.internal = NULL
+
+
+	def __releasebuffer__(self, Py_buffer *buffer):
+		pass
+
+
 	def __enter__(self):
 		r"""Opens a with statement."""
 		return self
@@ -225,7 +517,11 @@ Track indexing accepts 1 or 2 parameters. Got: %d""" % (len(key)))
 		for label in self.keys():
 			track_subset[label] = self._getitem_str_(label)[sl]
 		weights = [self._t[0].weights[i] for i in indices]
-		return track(track_subset, weights = weights, n_threads = self.n_threads)
+		subset = track(track_subset, weights = weights,
+			n_threads = self.n_threads)
+		subset.parallel_policy = self.parallel_policy
+		subset.pruning_threshold = self.pruning_threshold
+		return subset
 
 
 	def __setitem__(self, key, value):
@@ -252,17 +548,13 @@ Item assignment via column label requires an array-like object. Got: %s""" % (
 				type(value)))
 		if len(value) == self._t[0].n_vectors:
 			if all([isinstance(_, numbers.Number) for _ in value]):
-				labelcopy = copy_pystring(label)
-				try:
-					colidx = strindex(self._t[0].labels, labelcopy,
-						self._t[0].dim)
-				finally:
-					free(labelcopy)
+				# colidx is -2 for the weights (see _indexing_handle_str_)
 				for i in range(self._t[0].n_vectors):
 					if colidx == -2:
 						self._t[0].weights[i] = value[i]
 					else:
 						self._t[0].predictions[i][colidx] = value[i]
+				if colidx != -2: self._revision += 1
 			else:
 				raise TypeError("""\
 Non-numerical value detected. Track only supports storing numerical data.""")
@@ -294,6 +586,7 @@ Array-length mismath. Got: %d for track sampled at %d points.""" % (
 						else:
 							# failsafe: should've been caught already
 							assert False, "Internal Error."
+					self._revision += 1
 				else:
 					raise TypeError("""\
 Non-numerical value detected. Track only supports storing numerical data.""")
@@ -318,6 +611,7 @@ Track item assignment via row number requires type dict. Got: %s""" % (
 						self._t[0].weights[row] = value
 					else:
 						self._t[0].predictions[row][colidx] = value
+						self._revision += 1
 				else:
 					raise TypeError("""\
 Track only supports storage of real numbers. Got: %s""" % (type(value)))
@@ -365,6 +659,30 @@ Index %d out of range for track sampled at %d points.""" % (
 Track row number must be an integer, not float.""")
 
 
+	@property
+	def predictions(self):
+		r"""
+		Type : ``memoryview`` [2-dimensional]
+
+		A read-only view of the predictions of the track, with one row per
+		point along the track and one column per quantity in the order of
+		``track.keys()``. The view shares memory with the track, so e.g.
+		``numpy.asarray(t.predictions)`` does not copy the predictions, and
+		it reflects any subsequent item assignment.
+
+		Example Code
+		------------
+		>>> import trackstar as ts
+		>>> import numpy as np
+		>>> t = ts.track.from_array(np.array([[0., 1.], [2., 3.]]),
+			["x", "y"])
+		>>> np.asarray(t.predictions)
+		array([[0., 1.],
+		       [2., 3.]])
+		"""
+		return memoryview(self)
+
+
 	@property
 	def n_vectors(self):
 		r"""
@@ -430,6 +748,100 @@ Number of parallel processing threads must be an integer. Got: %s""" % (
 				type(value)))
 
 
+	@property
+	def parallel_policy(self):
+		r"""
+		Type : ``str``
+
+		Which loop to distribute across ``n_threads`` threads in likelihood
+		calculations. Only one loop is ever parallelized.
+
+		- "auto" : Decide separately for each group of data with the same
+		  measured quantities, parallelizing over the data if there are enough
+		  of them per thread and over the combinations of data and track
+		  points otherwise. This is the default.
+		- "data" : Parallelize over the data.
+		- "track" : Parallelize over the points along the track, one datum at
+		  a time.
+		- "collapsed" : Parallelize over every combination of a datum and a
+		  point along the track.
+
+		The choice affects only performance, not the value of the likelihood.
+		"""
+		return _PARALLEL_POLICIES_[self._t[0].parallel_policy]
+
+
+	@parallel_policy.setter
+	def parallel_policy(self, value):
+		if isinstance(value, str):
+			if value.lower() in _PARALLEL_POLICIES_:
+				self._t[0].parallel_policy = _PARALLEL_POLICIES_.index(
+					value.lower())
+			else:
+				raise ValueError("""\
+Unrecognized parallel policy: %s. Must be one of: %s""" % (value,
+					", ".join(_PARALLEL_POLICIES_)))
+		else:
+			raise TypeError("""\
+Attribute 'parallel_policy' must be of type str. Got: %s""" % (type(value)))
+
+
+	@property
+	def pruning_threshold(self):
+		r"""
+		Type : ``float`` [non-negative] or ``None``
+
+		How far below the best-fitting point along the track, in units of
+		:math:`\chi^2`, a point may fall before its contribution to the
+		likelihood of observing a datum is neglected. Weights and line segment
+		lengths are taken into account, such that a point is skipped when its
+		contribution is smaller than the largest by more than a factor of
+		:math:`e^{-\text{threshold} / 2}`.
+
+		If not ``None``, the contributions are summed in logarithmic space, so
+		that the likelihood of observing a datum far from the track is small
+		but finite rather than underflowing to zero. Narrow tracks through
+		wide parameter spaces then need only a fraction of the exponentials,
+		since most points are skipped. With a finite threshold, the track is
+		also divided into blocks of consecutive points, and a block whose
+		bounding box lies too far from a datum is skipped without computing
+		:math:`\chi^2` for any of its points, so the cost per datum grows
+		more slowly than the number of points. A threshold of 50 changes the
+		likelihood by a fraction of order :math:`e^{-25}` or less per datum.
+		``float("inf")`` sums every contribution in logarithmic space.
+
+		If ``None`` (the default), the contributions are summed in linear
+		space, and none are skipped.
+
+		.. note::
+
+			With a finite threshold, points are skipped relative to the
+			largest contribution found so far by each thread, so the result
+			may depend on ``n_threads`` and ``parallel_policy`` at the level
+			of the neglected contributions.
+		"""
+		if self._t[0].pruning_threshold < 0:
+			return None
+		else:
+			return self._t[0].pruning_threshold
+
+
+	@pruning_threshold.setter
+	def pruning_threshold(self, value):
+		if value is None:
+			self._t[0].pruning_threshold = PRUNING_OFF
+		elif isinstance(value, numbers.Number):
+			if value >= 0:
+				self._t[0].pruning_threshold = value
+			else:
+				raise ValueError("""\
+Pruning threshold must be non-negative. Got: %g""" % (value))
+		else:
+			raise TypeError("""\
+Attribute 'pruning_threshold' must be a real number or None. Got: %s""" % (
+				type(value)))
+
+
 	def keys(self):
 		r"""
 		Returns a list of the labels of each quantity reported at each point
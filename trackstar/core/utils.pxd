@@ -12,6 +12,14 @@ cdef extern from "./src/utils.h":
 cdef extern from "./src/datum.h":
 	unsigned short MAX_LABEL_SIZE
 
+cdef extern from "./src/labels.h":
+	ctypedef struct LABEL_REGISTRY:
+		char **labels
+		unsigned short n_labels
+
+	LABEL_REGISTRY *label_registry()
+	void label_registry_share(LABEL_REGISTRY *r)
+
 cdef class linked_list:
 	cdef double **_arr
 	cdef unsigned long _length
@@ -22,3 +30,6 @@ cdef class linked_dict:
 	cdef unsigned short _n_elements
 
 cdef char *copy_pystring(pystr) except *
+cdef void flag_modification()
+cdef unsigned long modifications()
+cdef LABEL_REGISTRY *shared_label_registry()
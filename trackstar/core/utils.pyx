@@ -25,6 +25,16 @@ from libc.string cimport memset, strlen
 from libc.stdint cimport uintptr_t
 from libc.math cimport isnan
 
+# The number of times the vector or covariance matrix of any datum has been
+# modified from python. This lives here rather than in the C library because
+# each extension module links its own copy of the C library's static state.
+cdef unsigned long _MODIFICATIONS_ = 0
+
+# Passed to the __cinit__ of a matrix, covariance_matrix, datum, or track by
+# the cdef factories that assign the underlying C object themselves (e.g.,
+# datum._borrow_, track.from_array), in which case nothing is allocated.
+_UNINITIALIZED_ = object()
+
 cdef class linked_list:
 
 	r"""
@@ -170,6 +180,7 @@ Item assignment does not allow changing a real number to a NaN as it changes \
 the dimensionality of the data, resulting in memory errors.""")
 					else:
 						self._arr[index][0] = <double> value
+						flag_modification()
 				else:
 					raise TypeError("""\
 Item assignment requires a real number. Got: %s""" % (type(value)))
@@ -253,6 +264,7 @@ Item assignment does not allow changing a real number to a NaN as it changes \
 the dimensionality of the data, resulting in memory errors.""")
 					else:
 						self._arr[idx][0] = <double> value
+						flag_modification()
 				else:
 					raise KeyError("Unrecognized quantity label: %s" % (key))
 			else:
@@ -381,6 +393,43 @@ TrackStar does not support non-ascii characters in strings. Got: %s""" % (
 		raise TypeError("Expected a string. Got: %s" % (type(pystr)))
 
 
+cdef void flag_modification():
+	r"""
+	Record that the vector or covariance matrix of some datum has been
+	modified, which invalidates the packed copy of any sample containing it.
+
+	.. seealso:: ``sample_pack`` in ./src/sample.c
+	"""
+	global _MODIFICATIONS_
+	_MODIFICATIONS_ += 1
+
+
+cdef unsigned long modifications():
+	r"""
+	Returns
+	-------
+	n : ``unsigned long``
+		The number of times ``flag_modification`` has been called. A sample
+		whose packed copy was constructed when this value was different must
+		reconstruct it before computing a likelihood.
+	"""
+	return _MODIFICATIONS_
+
+
+cdef LABEL_REGISTRY *shared_label_registry():
+	r"""
+	Returns
+	-------
+	r : ``LABEL_REGISTRY *``
+		The label registry of this module's copy of the C library, which every
+		other module adopts at import time via ``label_registry_share`` so
+		that label IDs mean the same thing everywhere.
+
+	.. seealso:: ``label_registry_share`` in ./src/labels.c
+	"""
+	return label_registry()
+
+
 def copy_cstring(char *cstr):
 	r"""
 	Obtain a copy of a C char pointer as a python string.
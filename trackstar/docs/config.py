@@ -188,5 +188,84 @@ _CONFIG_ = {
 		"designation": "function",
 		"title": "Is Multi-Threading Enabled?",
 		"subs": []
+	},
+	trackstar.blas_linked: {
+		"name": "trackstar.blas_linked",
+		"designation": "function",
+		"title": "Is TrackStar Linked with BLAS?",
+		"subs": []
+	},
+	trackstar.offload_linked: {
+		"name": "trackstar.offload_linked",
+		"designation": "function",
+		"title": "Is Offloading to Accelerators Enabled?",
+		"subs": []
+	},
+	trackstar.profile: {
+		"name": "trackstar.profile",
+		"designation": "function",
+		"title": "Profiling the Likelihood Calculation",
+		"subs": []
+	},
+	trackstar.distributed: {
+		"name": "trackstar.distributed",
+		"designation": None,
+		"title": "Distributed Likelihood Calculations",
+		"subs": [
+			trackstar.distributed.sample,
+			trackstar.distributed.mpi_linked,
+			trackstar.distributed.rank,
+			trackstar.distributed.size,
+			trackstar.distributed.shard
+		]
+	},
+	trackstar.distributed.sample: {
+		"name": "trackstar.distributed.sample",
+		"designation": "class",
+		"title": None,
+		"subs": [
+			trackstar.distributed.sample.local,
+			trackstar.distributed.sample.from_sample,
+			trackstar.distributed.sample.loglikelihood
+		]
+	},
+	trackstar.distributed.sample.local: {
+		"designation": "attribute",
+		"title": None,
+		"subs": []
+	},
+	trackstar.distributed.sample.from_sample: {
+		"designation": "staticmethod",
+		"title": None,
+		"subs": []
+	},
+	trackstar.distributed.sample.loglikelihood: {
+		"designation": "method",
+		"title": None,
+		"subs": []
+	},
+	trackstar.distributed.mpi_linked: {
+		"name": "trackstar.distributed.mpi_linked",
+		"designation": "function",
+		"title": None,
+		"subs": []
+	},
+	trackstar.distributed.rank: {
+		"name": "trackstar.distributed.rank",
+		"designation": "function",
+		"title": None,
+		"subs": []
+	},
+	trackstar.distributed.size: {
+		"name": "trackstar.distributed.size",
+		"designation": "function",
+		"title": None,
+		"subs": []
+	},
+	trackstar.distributed.shard: {
+		"name": "trackstar.distributed.shard",
+		"designation": "function",
+		"title": None,
+		"subs": []
 	}
 }